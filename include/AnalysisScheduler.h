@@ -0,0 +1,85 @@
+﻿#pragma once
+#include <algorithm>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+#include "SpscRing.h"
+#include "FrameAnalyzer.h"
+
+// 分析线程的截止时间：超过 maxAgeNs 才能完成的帧不再计算方位，画出来也已经过时
+struct AnalysisDeadline {
+    uint64_t maxAgeNs = 150000000;     // 从采集到方位估计完成的最长时间
+    uint64_t mergeWindowNs = 20000000; // 积压时采集时间相距不超过此值的相邻帧视为同一事件，只保留能量最强的一帧
+};
+
+// 分析线程的按截止时间调度（只由消费者调用）
+// 队列仍按采集顺序出队，但每帧开始处理前检查：
+// - 已过期的帧，以及后面还有更新的帧时预计完成时间（当前时间 + 平均处理耗时）超过 采集时间 + maxAgeNs 的帧直接丢弃，把时间让给更新的帧；
+// - 后面还有帧且二者相距不超过 mergeWindowNs 时合并为一帧（保留高频能量更强的那一帧）。
+// 处理速度跟得上时队列里最多一帧，两条规则都不起作用；持续过载时事件延迟不超过 maxAgeNs 加一帧的处理耗时
+class AnalysisScheduler {
+public:
+    AnalysisDeadline deadline;
+
+    // 处理队列中当前可见的全部帧；now() 返回 steady_clock 纳秒，process(frame, ageNs) 计算并投递一帧。返回处理的帧数
+    template <typename Now, typename F>
+    size_t drain(SpscRing<AnalyzedFrame>& ring, Now&& now, F&& process) {
+        size_t processed = 0;
+        while (AnalyzedFrame* frame = ring.front()) {
+            const uint64_t start = now();
+            const uint64_t age = ageAt(*frame, start);
+            AnalyzedFrame* next = ring.peek(1);
+            // 最新的一帧只在已经过期时丢弃：处理耗时的估计偏大时仍有帧被处理，估计得以回落
+            if (age > deadline.maxAgeNs || (next && age + serviceNs_ > deadline.maxAgeNs)) {
+                ++staleDrops_;
+                ring.pop();
+                continue;
+            }
+            if (next && frame->captureNs && next->captureNs >= frame->captureNs
+                && next->captureNs - frame->captureNs <= deadline.mergeWindowNs) {
+                // 槽位归消费者所有，交换只移动 vector 的指针，不分配内存
+                if (frame->highBandEnergy > next->highBandEnergy) std::swap(*frame, *next);
+                ++merged_;
+                ring.pop();
+                continue;
+            }
+
+            process(*frame, age);
+            const uint64_t end = now();
+            const uint64_t latency = ageAt(*frame, end);
+            ring.pop();
+            ++processed;
+
+            // 处理耗时的指数滑动平均（权重 1/8），首帧直接取样
+            const uint64_t took = end - start;
+            serviceNs_ = processedTotal_ ? serviceNs_ - serviceNs_ / 8 + took / 8 : took;
+            ++processedTotal_;
+            lastLatencyNs_ = latency;
+            maxLatencyNs_ = (std::max)(maxLatencyNs_, latency);
+            if (latency > deadline.maxAgeNs) ++lateEvents_;
+        }
+        return processed;
+    }
+
+    uint64_t staleDrops() const { return staleDrops_; }      // 赶不上截止时间而丢弃的帧数
+    uint64_t mergedFrames() const { return merged_; }        // 积压时并入相邻帧的帧数
+    uint64_t lateEvents() const { return lateEvents_; }      // 开始时预计赶得上、实际完成时已超过截止时间的帧数
+    uint64_t processedFrames() const { return processedTotal_; }
+    uint64_t lastLatencyNs() const { return lastLatencyNs_; }  // 最近一帧从采集到处理完成的时间
+    uint64_t maxLatencyNs() const { return maxLatencyNs_; }    // 历史最大值
+    uint64_t serviceEstimateNs() const { return serviceNs_; }  // 平均处理耗时
+
+private:
+    // 没有时间戳的帧按刚采集处理
+    static uint64_t ageAt(const AnalyzedFrame& frame, uint64_t nowNs) {
+        return frame.captureNs && nowNs > frame.captureNs ? nowNs - frame.captureNs : 0;
+    }
+
+    uint64_t serviceNs_ = 0;
+    uint64_t staleDrops_ = 0;
+    uint64_t merged_ = 0;
+    uint64_t lateEvents_ = 0;
+    uint64_t processedTotal_ = 0;
+    uint64_t lastLatencyNs_ = 0;
+    uint64_t maxLatencyNs_ = 0;
+};
@@ -3,65 +3,90 @@
 #include <mmdeviceapi.h>
 #include <audioclient.h>
 #include <thread>
-#include <queue>
-#include <mutex>
-#include <condition_variable>
+#include <atomic>
 #include <vector>
 #include <complex>
 #include <string>
 #include <cstdint>
-
-// 保存单帧音频数据
-struct AudioFrame {
-    std::vector<uint8_t> data;  // 音频原始字节数据
-};
+#include "DetectorPipeline.h"
+#include "WavFile.h"
+#include "SpscRing.h"
+#include "AnalysisScheduler.h"
+#include "DirectionEstimator.h"
+#include "LatencyTrace.h"
+#include "PipelineMetrics.h"
+#include "EventMailbox.h"
+#include "WavRecorder.h"
+#include "ClipRecorder.h"
 
 // 音频捕获、分析与保存类，使用 WASAPI Loopback 捕获系统音频
 class AudioCapture {
 public:
     // 高频检测参数
     float highFreqMin = 10000.0f;        // 高频起始频率阈值
-    float highFreqEpsilon = 0.001f;    // 高频幅度判断阈值
+    float highFreqEpsilon = 0.001f / 480.0f;  // 高频幅度判断阈值（按窗函数之和归一化的频点幅度，见 DetectorParams）
     float highFreqRatio = 0.1f;      // 高频占比阈值
+    bool adaptiveNoiseFloor = true;  // 按频点的自适应噪声底 + 迟滞触发（持续的雨声、风声、引擎声不再逐包触发）
+    uint32_t analysisFrameSize = 256;  // 分析帧长度（采样帧）
+    uint32_t analysisHopSize = 128;    // 分析帧跳步（采样帧）
+    DirectionMode directionMode = DirectionMode::Ild;  // 方位估计模式（ILD 或 GCC-PHAT ITD+ILD）
+    AnalysisDeadline analysisDeadline;   // 分析线程的截止时间：过期的帧丢弃，积压时相邻帧合并
     std::string outputWavFile = "captured_audio.wav";  // 输出 WAV 文件名
+    bool recordAudio = false;            // 是否把触发检测的数据包写入 outputWavFile
+    WavRecorderConfig recorderConfig;    // 写盘批大小、文件头检查点间隔与分段
+    bool clipCapture = false;            // 是否为每个事件截取前后各一段写成独立 WAV 并记录事件附表
+    ClipConfig clipConfig;               // preRoll / postRoll、历史时长与输出文件名
+
+    // 延迟跟踪：开启后 stop() 时导出 Chrome trace JSON 与延迟报告
+    bool latencyTracing = false;
+    std::string latencyTraceFile = "latency_trace.json";
+    std::string latencyReportFile = "latency_report.txt";
 
-    // 高频音事件结构
-    struct AudioEvent {
-        std::vector<uint8_t> data;  // 音频帧原始数据
-        bool highFreq = false;       // 是否检测到高频
-        float angle = 0.0f;          // 枪声方位角度 [-90, +90]
-    };
+    // 运行指标统计文件（内存映射，MetricsReader 可随时读取），为空时只在进程内统计
+    std::string metricsFile = "audiocompass.stats";
 
-    HWND mainWindowHandle = nullptr; // 主窗口句柄，用于 PostMessage
+    HWND mainWindowHandle = nullptr; // 主窗口句柄，事件邮箱有新事件时向其发送唤醒消息
 
     AudioCapture();
     ~AudioCapture();
 
     void setMainWindowHandle(HWND hwnd);  // 设置主窗口句柄
-    void start();  // 启动音频捕获与分析线程
+    bool start();  // 启动音频捕获与分析线程，音频设备初始化失败时返回 false
     void stop();   // 停止音频捕获与分析线程
 
+    uint64_t modelOverflowCount() const { return modelRing.overflowCount(); }  // 分析队列满而丢弃的帧数
+    uint64_t saveOverflowCount() const { return recorder.droppedPackets(); }   // 录音缓冲满而丢弃的数据包数
+    LatencyTracer& tracer() { return latencyTracer; }  // 主线程在呈现后记录 Rendered 阶段
+    PipelineMetrics& metrics() { return pipelineMetrics; }  // 主线程记录绘制次数与耗时
+    EventMailbox& events() { return eventMailbox; }  // 主线程收到 WM_USER + 100 后 drain()
+
 private:
+    static const size_t kModelRingSlots = 64;   // 分析队列槽位数
+
     WAVEFORMATEX* pwfx = nullptr;  // 音频格式信息
     bool running = false;           // 捕获线程运行标志
+    // 捕获线程状态：Starting → Running（格式协商完成、队列槽位已分配）或 Failed（初始化失败）
+    enum class CaptureState { Starting, Running, Failed };
+    std::atomic<CaptureState> captureState{ CaptureState::Starting };
 
-    std::queue<AudioFrame> modelQueue;  // 待分析音频帧队列
-    std::mutex modelMutex;              // 分析队列互斥锁
-    std::condition_variable modelCV;    // 分析队列条件变量
+    SpscRing<AnalyzedFrame> modelRing;  // 已完成频谱分析、待计算方位的帧（捕获 → 分析）
+    HANDLE modelEvent = nullptr;        // 分析队列有新数据时置位
+    WavRecorder recorder;               // 原始数据包录音（捕获线程追加，录音自带写盘线程）
+    ClipRecorder clips;                 // 事件片段（捕获线程送数据包，分析线程送事件）
 
-    std::queue<AudioFrame> saveQueue;   // 待保存音频帧队列
-    std::mutex saveMutex;               // 保存队列互斥锁
-    std::condition_variable saveCV;     // 保存队列条件变量
+    DetectorPipeline pipeline;          // 解码、重分帧与融合分析（捕获线程使用）
+    DirectionEstimator direction;       // 方位估计（分析线程使用）
+    AnalysisScheduler scheduler;        // 按截止时间取分析队列（分析线程使用）
+    LatencyTracer latencyTracer;        // 各阶段时间戳（捕获、分析与主线程各写一个环）
+    PipelineMetrics pipelineMetrics;    // 计数与量值（各线程 relaxed 原子更新）
+    EventMailbox eventMailbox;          // 高频事件（分析 → 主线程），一批事件只发一次唤醒消息
 
     std::thread captureThreadHandle;    // 音频捕获线程
     std::thread modelThreadHandle;      // 高频分析线程
-    std::thread saveThreadHandle;       // 音频保存线程
 
     void captureThread();  // 捕获音频数据线程
     void myThread();       // 分析高频与方位角线程
-    void savePcmWavStreaming();  // 保存音频为 WAV 文件
+    void writeLatencyTrace();    // 导出延迟跟踪结果
 
-    void simpleFFT(const std::vector<float>& in, std::vector<std::complex<float>>& out);  // 简单 FFT 计算
-    bool hasHighFreqContent(const uint8_t* pData, uint32_t numFrames, WAVEFORMATEX* pwfx); // 高频检测
-    float getGunshotAngle(const uint8_t* pData, uint32_t numFrames, WAVEFORMATEX* pwfx);   // 根据左右声道计算方位
+    DirectionResult getGunshotDirection(const AnalyzedFrame& frame);                        // 根据左右声道计算方位
 };
@@ -0,0 +1,110 @@
+﻿#pragma once
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "DetectorPipeline.h"
+#include "DirectionEstimator.h"
+
+// 多组检测阈值的同时判定：频谱只算一次，按 highFreqMin 分组累计频带能量，按 (highFreqMin, highFreqEpsilon)
+// 分组统计超阈值频点，highFreqRatio 只是逐组比较；每组的结果与用同一参数运行 FrameAnalyzer 逐位相同
+// 自适应噪声底的参数组另按噪声底参数分组跟踪噪声底，迟滞状态逐组保存，因此须按流顺序连续送入各帧
+class DetectorSweep {
+public:
+    struct Decision {
+        float lowBandEnergy = 0.0f;
+        float highBandEnergy = 0.0f;
+        float highFreqRatio = 0.0f;
+        bool highFreq = false;
+    };
+
+    void configure(const std::vector<DetectorParams>& sets, uint32_t frameSize, uint32_t sampleRate, float windowSum);
+    // 按全部参数组判定一帧，返回是否有任意一组触发
+    bool evaluate(const AnalyzedFrame& frame);
+
+    size_t size() const { return sets_.size(); }
+    const DetectorParams& params(size_t set) const { return sets_[set]; }
+    const Decision& decision(size_t set) const { return decisions_[set]; }
+
+private:
+    struct Band { size_t firstBin; float low; float high; size_t bins; };   // 同一 highFreqMin 的参数组共用
+    // 同一 (highFreqMin, epsilon) 共用；自适应的参数组还须噪声底参数相同
+    struct Count {
+        size_t band = 0;
+        float threshold = 0.0f;
+        size_t above = 0;
+        bool adaptive = false;
+        DetectorParams floorParams;                 // 自适应时噪声底的参数
+        NoiseFloor floor;
+    };
+
+    std::vector<DetectorParams> sets_;
+    std::vector<size_t> setCount_;       // 每组对应的 Count
+    std::vector<Band> bands_;
+    std::vector<Count> counts_;
+    std::vector<Decision> decisions_;
+    std::vector<TriggerHysteresis> hysteresis_;
+    std::vector<float> power_;
+    size_t halfBins_ = 0;
+    uint32_t frameSize_ = 0;
+    uint32_t sampleRate_ = 0;
+    float powerScale_ = 1.0f;
+};
+
+// 批量分析参数：frameSize / hopSize 与实时检测相同，packetFrames 模拟捕获线程每个数据包的帧数
+// （每个数据包每组参数最多一个事件，取高频能量最强的触发帧，与 DetectorPipeline::processPacket 相同）
+struct BatchConfig {
+    uint32_t frameSize = 256;
+    uint32_t hopSize = 128;
+    uint32_t packetFrames = 480;            // WASAPI 共享模式 10 ms 周期（48 kHz）
+    std::vector<DetectorParams> paramSets;  // 为空时使用默认参数一组
+    DirectionMode directionMode = DirectionMode::Ild;
+    uint32_t chunkPackets = 2000;           // 每个任务处理的数据包数（48 kHz 下约 20 秒）；含自适应参数组时整个文件一块
+    unsigned threads = 0;                   // 0 为硬件线程数
+};
+
+// 一次检测事件（对应实时程序中的一次 OverlayEvent）
+struct BatchEvent {
+    uint32_t paramSet = 0;
+    uint64_t frame = 0;          // 触发分析帧的起始采样帧
+    double timeSeconds = 0.0;
+    float angle = 0.0f;
+    float confidence = 0.0f;
+    float highFreqRatio = 0.0f;
+    float highBandEnergy = 0.0f;
+    float lowBandEnergy = 0.0f;
+};
+
+struct BatchFileResult {
+    std::string path;
+    bool ok = false;
+    std::string error;
+    StreamFormat format;
+    uint64_t frames = 0;                 // 采样帧数
+    std::vector<BatchEvent> events;      // 按数据包顺序，同一数据包内按参数组顺序
+};
+
+struct BatchStats {
+    uint32_t files = 0;
+    uint32_t failed = 0;
+    uint32_t chunks = 0;
+    uint64_t inputBytes = 0;
+    double audioSeconds = 0.0;
+    double seconds = 0.0;
+    uint64_t steals = 0;                 // 工作窃取次数
+    unsigned threads = 0;
+};
+
+// 递归收集目录下的 .wav 文件（不区分大小写）；path 为文件时直接加入，结果按路径排序
+void collectWavFiles(const std::string& path, std::vector<std::string>& out);
+
+// 在工作窃取线程池上分析全部文件：每个文件一个任务，映射后按数据包边界切块并把块任务压入本线程队列，
+// 空闲线程窃取其他文件的块；一个文件的最后一块完成时按块顺序合并事件并调用 onFile（在工作线程中，可能并发）
+bool analyzeFiles(const std::vector<std::string>& paths, const BatchConfig& config,
+    const std::function<void(const BatchFileResult&)>& onFile, BatchStats* stats = nullptr);
+
+// 事件时间线：CSV（带表头）或二进制（"ACEV" 头 + 定长小端记录）
+void writeEventsCsv(std::ostream& out, const BatchFileResult& result);
+void writeEventsBinary(std::ostream& out, const BatchFileResult& result, uint32_t paramSets);
@@ -1,54 +1,51 @@
 #pragma once
 #include <windows.h>
-#include <gdiplus.h>
 #include <vector>
-#pragma comment(lib, "gdiplus.lib")
-
-using namespace Gdiplus;
+#include <cstdint>
+#include "OverlayRenderer.h"
+#include "RenderScheduler.h"
 
+// ͸Ӵڣϳƽ̨޹ص OverlayRenderer ɣֱд볣פ DIB section
+// ʱֻһ UpdateLayeredWindowΪÿ֡λͼ DC
+// ¼Ƚ RenderSchedulerɰʾˢʴĶʱϲ֡Ӱڶʱ˥
 class Canvas {
 public:
-    Canvas(HINSTANCE hInst);   // 캯ʼ GDI+ ʹ
+    Canvas(HINSTANCE hInst);   // 캯ʼ
     ~Canvas();                 // ͷԴ
 
+    static const UINT_PTR kRenderTimerId = 1;  // ȾĶʱWM_TIMER  wParam
+
     HWND getHwnd() const { return hwnd_; } // ȡھ
-    void drawArc(float angleDeg);          // ָǶȵĻκ
-    void clear();
+    // ύһ¼һĺϳɣ true ʾմӿתΪ÷Ӧ onRenderTimer() һ֡
+    bool submitArc(float angleDeg, uint64_t eventId);
+    bool onRenderTimer();                  // Ⱦʱڣϳɲ֣Ƿһ֡
+    const std::vector<uint64_t>& presentedEvents() const { return scheduler_.frameEvents(); }  // һ֡¼
+    uint64_t eventsCoalesced() const { return scheduler_.eventsCoalesced(); }
     void show();                           // ʾ
     void destroy();                        // ٴںͷԴ
 
     static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wp, LPARAM lp); // ڻص
 
-    // ûò
-    float trailAngleThreshold = 10.0f;      // Ӱֵȣ
-    float trailBaseDuration = 0.2f;// Ӱʱ䣨룩
-    float trailMaxDuration = 1.0f;// Ӱʱ䣨룩
-    Color liveColor = Color(255, 255, 255, 0);   // ʵʱɫ
-    Color trailColor = Color(255, 255, 0, 0);    // Ӱʼɫ
-    float arcSpan = 2.0f;                   // ߿ȣȣ
-    Color textColor = Color(255, 255, 255, 0); // ɫĬϰɫ
+    // ûòӰֵʱ / Ӱ / ɫ߿ȣ
+    OverlayStyle& style() { return renderer_.style; }
 
 private:
     void initWindow(HINSTANCE hInst);      // ʼ͸Ӵ
+    bool ensureSurface();                  // פ DIB section ڴ DC󶨵Ⱦ
+    void releaseSurface();                 // ͷ DIB section ڴ DC
+    bool present();                        // ѵǰϴӴ
+    void stopTimer();                      // ʱֹͣȾʱ
 
     HWND hwnd_ = nullptr;                  // ھ
-    bool hasContent_ = false;              // ǰǷл
-    Bitmap* bmp_ = nullptr;                // ͼ Bitmap
-    Graphics* g_ = nullptr;                // ͼ
-    Pen* pen_ = nullptr;                   // ʵʱ߻
-    Font* font_ = nullptr;                 // 
-    SolidBrush* brush_ = nullptr;          // ֻˢ
-    int cachedSize_ = 0;                   //  Bitmap ߴ
     float radius_ = 0;                     // ߰뾶
     float penWidth_ = 0;                   // ʿ
 
-    struct ArcTrail {
-        float angle;        // νǶ
-        ULONGLONG ts;       // ʱ䣨룩
-        float duration;     // ̬Ӱʱ
-    };
-
-
-    std::vector<ArcTrail> arcTrails_;  // Ӱ
+    OverlayRenderer renderer_;             // ΡӰֵĺϳ
+    RenderScheduler scheduler_{ renderer_ };  // ¼ϲ֡
+    UINT timerMs_ = 16;                    // ʱڣ룬ˢʣ
+    bool timerRunning_ = false;
+    HDC memDC_ = nullptr;                  // ѡ DIB section ڴ DCפ
+    HBITMAP dib_ = nullptr;                // Ԥ ARGB  DIB sectionؼȾĻ
+    HGDIOBJ oldBitmap_ = nullptr;          // memDC_ ԭѡλͼ
+    int surfaceSize_ = 0;                  // DIB section ߳
 };
-
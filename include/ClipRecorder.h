@@ -0,0 +1,107 @@
+﻿#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "SpscRing.h"
+#include "EventMailbox.h"
+#include "PipelineMetrics.h"
+
+// 事件片段参数
+struct ClipConfig {
+    double preRollSeconds = 0.5;     // 触发帧之前保留的时长（起音与上下文）
+    double postRollSeconds = 1.0;    // 触发帧之后保留的时长（尾音）
+    double historySeconds = 5.0;     // 连续历史缓冲的时长，必须覆盖 preRoll + postRoll 与分析延迟
+    double maxClipSeconds = 4.0;     // 相邻事件合并后单个片段的最长时长
+    std::string pathPrefix = "clip_";            // 片段文件名前缀，文件为 <prefix><编号>.wav
+    std::string sidecarPath = "clip_events.csv"; // 事件附表：每个事件一行（方位、时间戳、频带能量、所在片段）
+    size_t packetSlots = 512;        // 捕获线程 → 片段线程的数据包队列槽位数
+};
+
+// 事件片段录制：捕获线程把全部数据包送入队列，片段线程维护最近 historySeconds 的连续历史；
+// 分析线程提交事件后，片段线程等到 postRoll 的数据到齐，把 [触发 - preRoll, 触发 + postRoll) 写成独立 WAV，
+// 并在附表中记录事件。窗口重叠的相邻事件合并为一个片段。两条输入都是无锁队列，满时丢弃并计数
+class ClipRecorder {
+public:
+    ClipRecorder() = default;
+    ~ClipRecorder() { stop(); }
+
+    ClipRecorder(const ClipRecorder&) = delete;
+    ClipRecorder& operator=(const ClipRecorder&) = delete;
+
+    // fmt 为 fmt 块内容（与 WAVEFORMATEX 布局相同）；maxPacketFrames 为单个数据包的最大采样帧数
+    bool start(const uint8_t* fmt, size_t fmtSize, uint32_t maxPacketFrames,
+        const ClipConfig& config = ClipConfig());
+    // 写出所有未完成的片段（postRoll 不足时按已有数据截断）并停止片段线程
+    void stop();
+    bool isRunning() const { return thread_.joinable(); }
+
+    // 捕获线程：数据包及其首帧在流中的位置；data 为 nullptr 时按静音处理
+    bool pushAudio(const void* data, uint32_t frames, uint64_t streamFrame);
+    // 分析线程：事件的 streamOffset 为触发帧在流中的位置
+    bool pushEvent(const OverlayEvent& event);
+
+    void attachMetrics(PipelineMetrics* metrics) { metrics_ = metrics; }
+
+    uint64_t clipsWritten() const { return clipsWritten_.load(std::memory_order_acquire); }
+    uint64_t truncatedClips() const { return truncated_.load(std::memory_order_relaxed); }  // 历史不足 preRoll 等原因缺了部分数据
+    uint64_t audioDrops() const { return audio_.overflowCount(); }
+    uint64_t eventDrops() const { return events_.overflowCount(); }
+    size_t queuedPackets() const { return audio_.size(); }  // 队列中尚未并入历史的数据包
+
+    static std::string clipPath(const std::string& prefix, uint64_t clipId);
+
+private:
+    struct Packet {
+        std::vector<uint8_t> data;
+        uint32_t frames = 0;
+        uint64_t streamFrame = 0;
+        bool silent = false;
+    };
+
+    struct Clip {
+        uint64_t id = 0;
+        uint64_t begin = 0;              // 流中的采样帧位置 [begin, end)
+        uint64_t end = 0;
+        std::vector<OverlayEvent> events;
+    };
+
+    ClipConfig config_;
+    std::vector<uint8_t> fmt_;
+    uint32_t blockAlign_ = 1;
+    uint64_t preFrames_ = 0, postFrames_ = 0, maxClipFrames_ = 0;
+    PipelineMetrics* metrics_ = nullptr;
+
+    SpscRing<Packet> audio_;
+    SpscRing<OverlayEvent> events_;
+
+    // 片段线程状态
+    std::vector<uint8_t> history_;       // 连续历史（按采样帧取模存放）
+    uint64_t historyFrames_ = 0;         // 历史容量（采样帧）
+    uint64_t historyBegin_ = 0;          // 收到的第一个采样帧的流位置
+    uint64_t historyEnd_ = 0;            // 历史中最新数据之后的流位置
+    bool haveHistory_ = false;
+    std::deque<Clip> pending_;
+    uint64_t nextClipId_ = 0;
+    std::ofstream sidecar_;
+    std::vector<uint8_t> header_;
+
+    std::thread thread_;
+    std::mutex mutex_;                   // 只用于片段线程的条件变量等待
+    std::condition_variable wake_;
+    std::atomic<bool> stopping_{ false };
+    std::atomic<uint64_t> clipsWritten_{ 0 };
+    std::atomic<uint64_t> truncated_{ 0 };
+
+    void worker();
+    void appendHistory(const Packet& packet);
+    void addEvent(const OverlayEvent& event);
+    void writeClip(const Clip& clip, uint64_t availableEnd);
+    void writeHistory(std::ofstream& out, uint64_t begin, uint64_t end) const;  // 写出历史中 [begin, end) 的采样帧
+};
@@ -0,0 +1,63 @@
+﻿#pragma once
+#include <vector>
+#include <cstdint>
+#include "SampleFormat.h"
+#include "StftFramer.h"
+#include "FrameAnalyzer.h"
+#include "HighPassGate.h"
+
+// 检测流水线：数据包解码 → 重分帧 → 静音跳过 → 时域高通门限 → 融合分析与频谱判定 → 包内最强触发帧
+// 与平台无关，实时捕获线程、离线工具和基准测试共用同一份实现
+class DetectorPipeline {
+public:
+    // 按流格式配置并预分配缓冲；格式不支持时返回 false（之后数据包按静音处理）
+    bool configure(const StreamFormat& fmt, uint32_t frameSize, uint32_t hopSize,
+        const DetectorParams& params, uint32_t maxPacketFrames);
+
+    // 处理一个交错 PCM 数据包；包内有分析帧触发时返回高频能量最强的一帧，否则返回 nullptr
+    // 静音包只推进分帧器保持流位置连续，完全落在静音区间内的分析帧不做分析；
+    // 未通过时域高通门限的帧不可能触发，同样不做变换
+    const AnalyzedFrame* processPacket(const uint8_t* data, uint32_t frames, bool silent);
+
+    // 离线分析：处理一个交错 PCM 数据包，对每个分析帧（包括静音帧）调用 onFrame(const AnalyzedFrame&)
+    // 与 processPacket 使用同一套解码、分帧与分析，特征提取与批量分析的结果与实时检测一致
+    template <typename OnFrame>
+    void analyzePacket(const uint8_t* data, uint32_t frames, OnFrame&& onFrame) {
+        auto analyze = [&](const AnalysisFrame& frame) {
+            analyzer_.analyze(frame, format_.sampleRate, analyzed_);
+            onFrame(static_cast<const AnalyzedFrame&>(analyzed_));
+        };
+        if (decodePacket(data, frames)) framer_.push(left_.data(), right_.data(), frames, analyze);
+        else framer_.pushSilence(frames, analyze);
+    }
+
+    const StreamFormat& format() const { return format_; }
+    uint32_t frameSize() const { return static_cast<uint32_t>(framer_.frameSize()); }
+    uint64_t streamPosition() const { return framer_.samplesWritten(); }  // 已处理的采样帧总数
+    uint64_t framesAnalyzed() const { return analyzer_.transformCount(); }  // 已分析的分析帧数
+    uint64_t framesSkipped() const { return framesSkipped_; }               // 全静音而跳过的分析帧数
+    uint64_t framesGated() const { return framesGated_; }                   // 未通过时域门限的分析帧数
+    uint64_t framesTriggered() const { return framesTriggered_; }           // 通过频谱判定的分析帧数
+    const std::vector<float>& window() const { return framer_.window(); }    // 分析窗
+    FrameAnalyzer& analyzer() { return analyzer_; }
+
+private:
+    bool decodePacket(const uint8_t* data, uint32_t frames);  // 解码到 left_ / right_，无法解码时返回 false
+
+    StreamFormat format_;
+    DecodeStereoFn decode_ = nullptr;   // 按采样类型与声道数特化的解码函数
+    StftFramer framer_;
+    FrameAnalyzer analyzer_;
+    HighPassGate gate_;
+    std::vector<float> left_;           // 当前数据包的左声道样本
+    std::vector<float> right_;          // 当前数据包的右声道样本
+    AnalyzedFrame analyzed_;            // 当前分析帧的结果（复用）
+    AnalyzedFrame strongest_;           // 当前数据包内高频能量最强的触发帧
+    uint64_t audibleEnd_ = 0;           // 最近一个非静音数据包的结束位置，之后的样本全为静音
+    uint64_t framesSkipped_ = 0;
+    uint64_t framesGated_ = 0;
+    uint64_t framesTriggered_ = 0;
+};
+
+// 按帧长预分配 AnalyzedFrame 的各个缓冲，之后复制赋值不再分配内存
+void reserveAnalyzedFrame(AnalyzedFrame& frame, uint32_t frameSize);
@@ -0,0 +1,62 @@
+﻿#pragma once
+#include <vector>
+#include <complex>
+#include <cstddef>
+#include "FrameAnalyzer.h"
+
+// 方位估计模式
+enum class DirectionMode {
+    Ild,      // 仅左右声道能量差（ILD）
+    ItdIld,   // GCC-PHAT 耳间时间差（ITD）与能量差融合
+};
+
+// 按频点声像分离出的一个声源
+struct SourceDirection {
+    float angle = 0.0f;        // 方位角 [-90, +90]
+    float confidence = 0.0f;   // 峰附近的能量占参与统计的频点总能量的比例 [0, 1]
+};
+
+// 单帧方位估计结果，角度范围 [-90, +90]，正值表示偏右
+struct DirectionResult {
+    static const size_t kMaxSources = 4;
+
+    float angle = 0.0f;        // 最终方位角
+    float ildAngle = 0.0f;     // 能量差得到的角度
+    float itdAngle = 0.0f;     // 时间差得到的角度
+    float itdSamples = 0.0f;   // 左声道相对右声道的延迟（采样，含亚采样插值）
+    float confidence = 0.0f;   // GCC-PHAT 归一化峰值 [0, 1]
+    size_t sourceCount = 0;    // 频点声像直方图中的峰数（按能量从强到弱），maxSources 为 0 时不统计
+    SourceDirection sources[kMaxSources];
+};
+
+// 方位估计：直接使用 AnalyzedFrame 中检测阶段已算好的左右声道频谱，不重新变换 PCM
+class DirectionEstimator {
+public:
+    DirectionMode mode = DirectionMode::Ild;
+    float maxItdSeconds = 0.0008f;   // 最大耳间时间差（秒），对应 ±90°
+    float itdWeight = 0.7f;          // 置信度为 1 时 ITD 在融合中的权重
+
+    // 多声源：逐频点计算左右声像，按能量加权累积到 1° 一格的方位直方图，取至多 maxSources 个峰。
+    // 两侧同时开火时宽带 RMS 只得到中间的一个无意义角度，而各频点多由其中一个声源主导，直方图呈多峰
+    size_t maxSources = 3;              // 0 时不做频点声像统计（不超过 DirectionResult::kMaxSources）
+    float sourceMinFrequency = 1000.0f; // 参与统计的最低频率，低频的音乐与环境声不计入
+    float sourceMinFraction = 0.1f;     // 峰（平滑后）能量低于总能量的该比例时不再取峰
+    float sourceSeparationDeg = 12.0f;  // 两峰的最小间隔；峰的角度与置信度按其 ±一半范围计算
+
+    void prepare(size_t frameSize);  // 预分配互相关与频点声像缓冲
+    DirectionResult estimate(const AnalyzedFrame& frame);
+
+private:
+    float gccPhat(const AnalyzedFrame& frame, float maxLag, float& confidence);  // 返回延迟（采样）
+    void findSources(const AnalyzedFrame& frame, DirectionResult& result);
+
+    static const uint32_t kPanLevels = 1025;  // 声像量化级数（中间值为等功率）
+    static const int kAngleBins = 181;        // -90° ~ +90°，每 1° 一格
+
+    std::vector<std::complex<float>> cross_;  // PHAT 加权互功率谱 / 互相关
+    std::vector<float> binEnergy_;            // 各频点的左右总功率
+    std::vector<int32_t> binPan_;             // 各频点的声像量化值
+    std::vector<uint8_t> panToBin_;           // 声像量化值 → 方位直方图格（与 ildAngle 的映射一致）
+    std::vector<float> histogram_;            // 能量加权的方位直方图（两端各补 2 格零）
+    std::vector<float> smoothed_;             // ±2° 滑动和，用于找候选峰
+};
@@ -0,0 +1,81 @@
+﻿#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "SpscRing.h"
+
+// 同一帧中按频点声像分离出的一个声源：角度取整到 1°（与残影直方图的桶宽一致），置信度量化到 0 ~ 255
+struct EventSource {
+    int8_t angle = 0;
+    uint8_t confidence = 0;
+};
+
+// 分析线程 → 界面线程的事件记录：定长、不含音频数据，按值在邮箱中传递
+struct OverlayEvent {
+    static const size_t kMaxSources = 4;
+
+
+    uint64_t sequence = 0;        // 邮箱分配的序号（连续递增，界面线程可据此发现丢弃）
+    uint64_t streamOffset = 0;    // 触发帧在采集流中的位置（也是延迟跟踪的事件标识）
+    uint64_t timeNs = 0;          // 方位估计完成的时间（steady_clock 纳秒）
+    float angle = 0.0f;           // 方位角 [-90, +90]
+    float confidence = 0.0f;      // 方位置信度（GCC-PHAT 归一化峰值，ILD 模式为 0）
+    float lowBandEnergy = 0.0f;   // 低频段能量
+    float highBandEnergy = 0.0f;  // 高频段能量
+    float highFreqRatio = 0.0f;   // 高频段中超过阈值的频点占比
+    bool highFreq = false;        // 是否判定为高频事件
+    uint8_t sourceCount = 0;      // 同时发声的声源数（按能量从强到弱存放在 sources 中）
+    EventSource sources[kMaxSources];
+};
+
+static_assert(sizeof(OverlayEvent) <= 64, "OverlayEvent should stay within one cache line");
+
+// 有界无锁邮箱：单生产者写入，单消费者批量取出；一批事件只需要一次唤醒消息
+// 生产者：push() 返回 true 时由调用方发送唤醒（如 PostMessage），发送失败时调用 cancelWake()
+// 消费者：收到唤醒后 drain()，先清除唤醒标志再取空队列，之后到达的事件会触发新的唤醒
+class EventMailbox {
+public:
+    explicit EventMailbox(size_t capacity = 256) : ring_(capacity) {}
+
+    // 只能在生产者与消费者都未运行时调用
+    void reset(size_t capacity) {
+        ring_.reset(capacity);
+        nextSequence_ = 0;
+        wakePending_.store(false, std::memory_order_relaxed);
+    }
+
+    // 生产者：写入一条事件，序号由邮箱分配并写回 event.sequence；邮箱满时丢弃并计数。返回是否需要发送唤醒
+    bool push(OverlayEvent& event) {
+        event.sequence = nextSequence_++;
+        OverlayEvent* slot = ring_.acquire();
+        if (!slot) return false;  // 满：消费者必然还有一个未处理的唤醒
+        *slot = event;
+        ring_.publish();
+        return !wakePending_.exchange(true, std::memory_order_acq_rel);
+    }
+
+    // 生产者：唤醒消息没有发出去（窗口已销毁等），允许下一条事件重新尝试
+    void cancelWake() { wakePending_.store(false, std::memory_order_release); }
+
+    // 消费者：取出当前全部事件，返回条数
+    template <typename F>
+    size_t drain(F&& f) {
+        // 读-改-写：与生产者 push 中的 exchange 同步，之前发布的事件在下面一定可见
+        wakePending_.exchange(false, std::memory_order_acq_rel);
+        size_t n = 0;
+        while (OverlayEvent* e = ring_.front()) {
+            f(*e);
+            ring_.pop();
+            ++n;
+        }
+        return n;
+    }
+
+    size_t capacity() const { return ring_.capacity(); }
+    uint64_t droppedCount() const { return ring_.overflowCount(); }  // 邮箱满而丢弃的事件数
+
+private:
+    SpscRing<OverlayEvent> ring_;
+    uint64_t nextSequence_ = 0;              // 生产者私有
+    alignas(64) std::atomic<bool> wakePending_{ false };  // 已发出、尚未被消费者处理的唤醒
+};
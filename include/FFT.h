@@ -0,0 +1,44 @@
+﻿#pragma once
+#include <vector>
+#include <complex>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+// 预计算的 FFT 计划：按变换长度缓存旋转因子、位反转表和 Bluestein 卷积核
+// 2 的幂长度走基 2 迭代 FFT，其他长度走 Bluestein（线性调频 Z 变换）
+class FFTPlan {
+public:
+    explicit FFTPlan(size_t n);
+
+    size_t size() const { return n_; }
+
+    // 复数正变换（原地），不缩放
+    void forward(std::complex<float>* data) const;
+    // 复数逆变换（原地），结果已除以 n
+    void inverse(std::complex<float>* data) const;
+    // 实数输入正变换，输出前 n/2+1 个频点（其余由共轭对称得到）
+    void forwardReal(const float* in, std::complex<float>* out) const;
+    // 两路实数输入共用一次 n 点复数变换（z = a + i·b），各输出前 n/2+1 个频点
+    void forwardRealPair(const float* a, const float* b, std::complex<float>* outA, std::complex<float>* outB) const;
+
+    // 获取指定长度的计划，首次调用时构建，之后复用（线程安全）
+    static std::shared_ptr<const FFTPlan> get(size_t n);
+
+private:
+    void forwardPow2(std::complex<float>* data) const;
+    void forwardBluestein(std::complex<float>* data) const;
+
+    size_t n_ = 0;
+    bool pow2_ = false;
+
+    std::vector<uint32_t> bitrev_;                // 位反转下标（仅 2 的幂）
+    std::vector<std::complex<float>> twiddle_;    // exp(-2πik/n)，k < n/2
+
+    std::vector<std::complex<float>> chirp_;      // Bluestein 调频因子 exp(-iπk²/n)
+    std::vector<std::complex<float>> chirpFFT_;   // 卷积核的频域形式（长度 m）
+    std::shared_ptr<const FFTPlan> convPlan_;     // 长度 m 的 2 的幂计划
+
+    std::vector<std::complex<float>> realTwiddle_; // 实数拆分用 exp(-2πik/n)，k <= n/2
+    std::shared_ptr<const FFTPlan> halfPlan_;      // 偶数长度实数变换使用的 n/2 复数计划
+};
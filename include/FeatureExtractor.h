@@ -0,0 +1,98 @@
+﻿#pragma once
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "DetectorPipeline.h"
+#include "DirectionEstimator.h"
+#include "MappedFile.h"
+
+// 离线特征提取参数；frameSize / hopSize / params 与实时检测相同时，逐帧特征与实时检测一致
+struct FeatureConfig {
+    uint32_t frameSize = 256;        // 分析帧长度（采样帧）
+    uint32_t hopSize = 128;          // 分析帧跳步（采样帧）
+    uint32_t melBands = 24;          // log-mel 频带数
+    float melMinHz = 0.0f;           // mel 滤波器组的频率范围，melMaxHz 为 0 时取奈奎斯特频率
+    float melMaxHz = 0.0f;
+    DetectorParams params;           // 高频判定参数（high_freq / high_freq_ratio 列）
+    DirectionMode directionMode = DirectionMode::ItdIld;
+    uint32_t chunkFrames = 4096;     // 每个任务处理的分析帧数（长录音切块并行；自适应噪声底时整个文件一块）
+    unsigned threads = 0;            // 工作线程数，0 为硬件线程数
+};
+
+// 单帧特征：log-mel 频谱 + 频带能量 + ILD / ITD，全部由检测阶段的 AnalyzedFrame 计算，不重新变换
+// 列顺序见 columnNames()：log_mel_0 ... log_mel_{melBands-1}，之后是 kScalarColumns 个标量
+class FrameFeatures {
+public:
+    static const uint32_t kScalarColumns = 12;
+
+    // 按采样率与分析窗生成 mel 滤波器组并预分配缓冲
+    void configure(const FeatureConfig& config, uint32_t sampleRate, const std::vector<float>& window);
+    uint32_t dimension() const { return melBands_ + kScalarColumns; }
+    uint32_t sampleRate() const { return sampleRate_; }
+
+    // 写出 dimension() 个 float
+    void compute(const AnalyzedFrame& frame, float* out);
+
+    static std::vector<std::string> columnNames(const FeatureConfig& config);
+
+private:
+    uint32_t melBands_ = 0;
+    uint32_t sampleRate_ = 0;
+    float powerScale_ = 1.0f;          // 与 FrameAnalyzer 相同的按窗函数之和归一化
+    std::vector<uint32_t> melFirst_;   // 每个 mel 频带的第一个频点
+    std::vector<float> melWeights_;    // 每个频带从 melFirst_ 起的三角权重，按 melOffset_ 分段存放
+    std::vector<uint32_t> melOffset_;  // melBands_ + 1 个分段边界
+    DirectionEstimator direction_;
+};
+
+// 特征张量文件（小端）：64 字节文件头 | 文件索引 | 字符串表 | 64 字节对齐的 float32 行数据 [rows][dimension]
+// 每个输入文件的分析帧占连续的行，第 r 行对应该文件第 (r - firstRow) * hopSize 个采样帧起的分析帧
+struct FeatureFileEntry {
+    std::string path;
+    uint64_t firstRow = 0;
+    uint64_t rows = 0;
+    uint32_t sampleRate = 0;
+    uint32_t channels = 0;
+};
+
+struct FeatureExportStats {
+    uint32_t files = 0;              // 写入的输入文件数（无法读取的文件跳过并计入 skipped）
+    uint32_t skipped = 0;
+    uint64_t rows = 0;
+    uint64_t inputBytes = 0;         // 处理的 PCM 字节数
+    uint32_t chunks = 0;             // 并行任务数
+    double seconds = 0.0;
+};
+
+// 在线程池上提取全部输入 WAV 的特征并写入 output：先扫描文件头确定每个文件的行范围，
+// 输出文件按总大小一次创建并映射，各线程把自己的块直接写进对应的行，不经过合并
+bool exportFeatures(const std::vector<std::string>& inputs, const std::string& output, const FeatureConfig& config,
+    FeatureExportStats* stats = nullptr, std::string* error = nullptr);
+
+// 只读映射特征张量文件，训练加载器可以直接按行取数据
+class FeatureDataset {
+public:
+    bool open(const std::string& path, std::string* error = nullptr);
+    void close();
+
+    uint32_t dimension() const { return dimension_; }
+    uint64_t rows() const { return rows_; }
+    uint32_t frameSize() const { return frameSize_; }
+    uint32_t hopSize() const { return hopSize_; }
+    const std::vector<std::string>& columns() const { return columns_; }
+    const std::vector<FeatureFileEntry>& files() const { return files_; }
+    int column(const std::string& name) const;   // 列号，不存在时返回 -1
+
+    const float* row(uint64_t index) const { return data_ + index * dimension_; }
+
+private:
+    MappedFile file_;
+    uint32_t dimension_ = 0;
+    uint64_t rows_ = 0;
+    uint32_t frameSize_ = 0;
+    uint32_t hopSize_ = 0;
+    std::vector<std::string> columns_;
+    std::vector<FeatureFileEntry> files_;
+    const float* data_ = nullptr;
+};
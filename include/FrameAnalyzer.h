@@ -0,0 +1,71 @@
+﻿#pragma once
+#include <vector>
+#include <complex>
+#include <cstdint>
+#include "StftFramer.h"
+#include "PcmKernels.h"
+#include "NoiseFloor.h"
+
+// 高频检测参数
+struct DetectorParams {
+    float highFreqMin = 10000.0f;    // 高频起始频率阈值
+    // 高频幅度判断阈值，按窗函数之和归一化的频点幅度（幅度 A 的正弦约为 A/2），与帧长、窗型无关；
+    // 默认值等效于旧版 480 点不加窗数据包 FFT 上的原始幅度 0.001
+    float highFreqEpsilon = 0.001f / 480.0f;
+    float highFreqRatio = 0.1f;      // 高频占比阈值
+
+    // 自适应噪声底：频点需同时超过 highFreqEpsilon 与该频点噪声底 floorMarginDb 才计入占比，
+    // 并按迟滞触发（占比回落到 highFreqRatio × releaseRatio 以下才重新触发）；关闭时为固定阈值逐帧判定
+    bool adaptiveFloor = false;
+    float floorMarginDb = 12.0f;     // 高出噪声底的幅度（功率 dB）
+    float floorRiseSeconds = 4.0f;   // 噪声底上升的时间常数，持续声音约在数秒内被吸收
+    float floorFallSeconds = 0.25f;  // 噪声底下降的时间常数，环境变安静后迅速恢复灵敏度
+    float releaseRatio = 0.5f;       // 迟滞释放比例
+
+    // 检测级联：先用时域高通能量门限（HighPassGate）排除不可能触发的帧，通过的帧才做 FFT 与频谱判定
+    bool highPassGate = true;
+    float gateMarginDb = 3.0f;       // 门限相对理论下限的余量，覆盖窗函数的频谱泄漏
+};
+
+// 单次融合分析的结果，下游（方位、保存、界面）直接使用，不再重新解码或变换
+struct AnalyzedFrame {
+    uint64_t offset = 0;                         // 帧首样本在采集流中的位置
+    uint64_t captureNs = 0;                      // 帧首样本被采集的时间（steady_clock 纳秒），0 表示没有时间戳
+    uint32_t sampleRate = 0;                     // 采样率
+    std::vector<float> mono;                     // 左右下混单声道（已加窗）
+    std::vector<std::complex<float>> spectrumLeft;   // 左声道前 N/2+1 个频点
+    std::vector<std::complex<float>> spectrumRight;  // 右声道前 N/2+1 个频点
+    std::vector<std::complex<float>> spectrum;       // mono 频谱，由左右频谱线性合成
+    float lowBandEnergy = 0.0f;                  // highFreqMin 以下的频谱能量（已按窗函数之和归一化）
+    float highBandEnergy = 0.0f;                 // highFreqMin 及以上的频谱能量（已按窗函数之和归一化）
+    float highFreqRatio = 0.0f;                  // 高频段中超过阈值（自适应时为超过噪声底）的频点占比
+    float rmsLeft = 0.0f;                        // 左声道 RMS（加窗后）
+    float rmsRight = 0.0f;                       // 右声道 RMS（加窗后）
+    bool highFreq = false;                       // 是否判定为高频事件
+};
+
+// 分析帧 → AnalyzedFrame：一次遍历完成下混与 RMS，一次复数 FFT 同时得到左右声道频谱，
+// mono 频谱与频带能量由其线性合成，方位估计直接复用左右频谱
+class FrameAnalyzer {
+public:
+    DetectorParams params;
+
+    // 预分配自适应噪声底的缓冲并清空其状态与迟滞，格式协商时调用
+    void prepare(uint32_t frameSize);
+    void analyze(const AnalysisFrame& frame, uint32_t sampleRate, AnalyzedFrame& out);
+    // 跳过不可能触发的帧（全静音或未通过时域门限）时调用：不做变换，噪声底与迟滞按全零帧推进
+    void skipFrame(const AnalysisFrame& frame, uint32_t sampleRate);
+
+    uint64_t transformCount() const { return transforms_; }  // 已执行的 FFT 次数
+    void resetCounters() { transforms_ = 0; }
+
+private:
+    const PcmKernels* kernels_ = &PcmKernels::best();  // 运行时选定的 SIMD 内核
+    uint64_t transforms_ = 0;
+    NoiseFloor floor_;
+    TriggerHysteresis hysteresis_;
+    std::vector<float> highPower_;   // 本帧高频段各频点的功率，供噪声底比较
+};
+
+// 根据左右声道 RMS 的分贝差计算方位角 [-90, +90]
+float ildAngle(float rmsLeft, float rmsRight);
@@ -0,0 +1,49 @@
+﻿#pragma once
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+struct DetectorParams;
+
+// 检测级联的第一级：时域高通能量门限
+// 下混单声道经八阶 Butterworth 高通（四节双二阶，截止频率为 highFreqMin 的 0.9 倍，每样本 20 次乘法），
+// 按跳步长度分块累计输出能量。由 Parseval 定理，分析帧高频段的归一化频谱能量不超过
+// N / (2 × 窗函数之和² × 高通在 highFreqMin 处的功率增益) × 帧所覆盖各块的能量之和；
+// 频谱判定至少需要 m 个频点超过 ε²（m 为达到 highFreqRatio 的最少频点数），即高频段能量 > m × ε²，
+// 上界都达不到（再留 gateMarginDb 余量覆盖频谱泄漏）的帧不可能触发，不必做 FFT
+class HighPassGate {
+public:
+    // frameSize / hopSize / windowSum 与分帧器相同；按 maxPacketFrames 预分配分块能量的环形缓冲
+    void configure(const DetectorParams& params, uint32_t sampleRate, uint32_t frameSize, uint32_t hopSize,
+        float windowSum, uint32_t maxPacketFrames);
+
+    bool enabled() const { return enabled_; }
+
+    // 推送与分帧器相同的样本（left / right 为空时按静音处理），须在分帧器输出本包的帧之前调用
+    void process(const float* left, const float* right, uint32_t frames);
+
+    // 起始于 frameOffset 的分析帧是否可能通过频谱判定
+    bool mayTrigger(uint64_t frameOffset) const;
+
+private:
+    void reserve(uint32_t packetFrames);   // 保证环形缓冲能容纳一个数据包内输出的全部帧所覆盖的块
+
+    // 一节双二阶，转置直接 II 型（系数已按 a0 归一化）
+    struct Section {
+        float b0 = 0.0f, b1 = 0.0f, b2 = 0.0f, a1 = 0.0f, a2 = 0.0f;
+        float z1 = 0.0f, z2 = 0.0f;
+    };
+
+    static const int kSections = 4;
+
+    bool enabled_ = false;
+    Section sections_[kSections];
+    float threshold_ = 0.0f;          // 帧覆盖各块能量之和的下限
+    uint32_t frameSize_ = 0;
+    uint32_t hopSize_ = 0;
+    uint32_t blocksPerFrame_ = 0;     // 一帧覆盖的块数
+    uint32_t maxPacketFrames_ = 0;
+    uint64_t position_ = 0;           // 已处理的采样帧数（与分帧器的流位置相同）
+    std::vector<float> blocks_;       // 按块号取模存放的块能量
+    size_t mask_ = 0;
+};
@@ -0,0 +1,100 @@
+﻿#pragma once
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <functional>
+#include <ostream>
+#include <cstddef>
+#include <cstdint>
+#include "SpscRing.h"
+
+// 事件在流水线中经过的阶段（按时间先后）
+enum class TraceStage : uint8_t {
+    DeviceCapture,  // 音频引擎采集到数据包（GetBuffer 的 QPC 位置）
+    Detected,       // 捕获线程判定高频并入队
+    Dequeued,       // 分析线程取出
+    Located,        // 方位估计完成
+    Posted,         // 已投递到主窗口
+    Rendered,       // 叠加窗口已呈现（UpdateLayeredWindow 返回）
+    Count,
+};
+
+const char* traceStageName(TraceStage stage);
+
+// 单条跟踪记录
+struct TraceRecord {
+    uint64_t eventId = 0;        // 事件标识（触发帧在流中的样本位置）
+    uint64_t timeNs = 0;         // 时间戳（纳秒，与 QPC 同一时间基准）
+    uint32_t thread = 0;         // 记录线程的序号（按注册顺序）
+    TraceStage stage = TraceStage::DeviceCapture;
+};
+
+// 延迟跟踪：每个线程写入自己的无锁环形缓冲，导出时由单个线程汇总
+// 时钟可注入，默认 steady_clock（MSVC 上基于 QPC，与 GetBuffer 返回的 QPC 位置同一基准）
+class LatencyTracer {
+public:
+    typedef std::function<uint64_t()> Clock;
+
+    explicit LatencyTracer(size_t ringCapacity = 4096);
+    ~LatencyTracer();
+
+    LatencyTracer(const LatencyTracer&) = delete;
+    LatencyTracer& operator=(const LatencyTracer&) = delete;
+
+    void setClock(Clock clock);   // 只能在没有线程记录时调用
+    uint64_t now() const { return clock_(); }
+
+    bool enabled = true;          // 关闭后 mark 直接返回
+
+    // 用当前时钟记录一个阶段
+    void mark(uint64_t eventId, TraceStage stage) {
+        if (enabled) markAt(eventId, stage, clock_());
+    }
+    // 用外部时间戳记录（如设备 QPC 位置）；环满时丢弃并计数
+    void markAt(uint64_t eventId, TraceStage stage, uint64_t timeNs);
+
+    // 取出所有线程已写入的记录（同一时刻只能有一个线程调用）
+    void collect(std::vector<TraceRecord>& out);
+    uint64_t droppedCount() const;  // 环满或线程数超出上限而丢弃的记录数
+
+    static const size_t kMaxThreads = 8;  // 可记录的线程数上限
+
+    static uint64_t steadyNowNs();  // 默认时钟
+
+private:
+    struct ThreadRing {
+        SpscRing<TraceRecord> ring;
+        uint32_t index = 0;           // 线程序号（Chrome trace 中的 tid）
+        std::thread::id owner;
+    };
+    ThreadRing* ringForThisThread();
+
+    Clock clock_;
+    size_t ringCapacity_;
+    uint64_t generation_;                               // 区分先后创建的跟踪器实例
+    mutable std::mutex ringsMutex_;                     // 只在线程首次记录与导出时加锁
+    ThreadRing rings_[kMaxThreads];                     // 内嵌数组：SpscRing 按缓存行对齐，C++14 下不宜逐个 new
+    size_t ringCount_ = 0;                              // 已注册的线程数（受 ringsMutex_ 保护）
+    std::atomic<uint64_t> unregistered_{ 0 };           // 超出线程上限而丢弃的记录
+};
+
+// 两个阶段之间的延迟统计（毫秒）
+struct LatencyStats {
+    TraceStage from = TraceStage::DeviceCapture;
+    TraceStage to = TraceStage::DeviceCapture;
+    size_t count = 0;
+    double p50Ms = 0.0;
+    double p99Ms = 0.0;
+    double maxMs = 0.0;
+    std::vector<uint64_t> histogram;  // 按 2 的幂微秒分桶：桶 i 覆盖 [2^(i-1), 2^i) 微秒，桶 0 为 < 1 微秒
+};
+
+// 按事件汇总：相邻阶段之间以及 DeviceCapture → 最后阶段的端到端延迟
+std::vector<LatencyStats> computeLatencyStats(const std::vector<TraceRecord>& records);
+
+// Chrome trace-event JSON（chrome://tracing / Perfetto 可直接打开）
+void writeChromeTrace(std::ostream& os, const std::vector<TraceRecord>& records);
+
+// 文本报告：每段延迟的 p50 / p99 / max 与直方图
+void writeLatencyReport(std::ostream& os, const std::vector<LatencyStats>& stats);
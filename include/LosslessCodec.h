@@ -0,0 +1,109 @@
+﻿#pragma once
+#include <ostream>
+#include <istream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "SampleFormat.h"
+
+// 无损压缩（类似 FLAC）：每个块独立编码，块内每个声道选取定阶多项式或量化 LPC 预测，
+// 残差按分区用 Rice 码编码；立体声可选 mid/side 去相关。浮点采样若全部是 2^-23 的整数倍则按整数编码，
+// 否则按保序的位模式编码，均可逐位还原
+struct LosslessConfig {
+    uint32_t blockFrames = 4096;   // 每块的采样帧数（最后一块或检查点刷出的块可以更短，不超过 kMaxBlockFrames）
+    uint32_t maxLpcOrder = 8;      // LPC 最大阶数（1 ~ 32）
+};
+
+// 单块编解码器：持有可复用的工作缓冲，编码与解码过程中不再分配内存
+class LosslessBlockCodec {
+public:
+    static const uint32_t kMaxOrder = 32;
+    static const uint32_t kMaxBlockFrames = 65536;
+    static const uint32_t kMaxChannels = 32;
+
+    // 格式协商时调用一次；不支持的采样类型、块长或声道数超出上限时返回 false
+    bool configure(const StreamFormat& format, const LosslessConfig& config = LosslessConfig());
+
+    // 编码 frames 个交错采样帧，结果追加到 out
+    void encode(const uint8_t* pcm, uint32_t frames, std::vector<uint8_t>& out);
+    // 解码一块为 frames 个交错采样帧；数据损坏或截断时返回 false
+    bool decode(const uint8_t* data, size_t size, uint32_t frames, uint8_t* pcm);
+
+    const StreamFormat& format() const { return format_; }
+
+private:
+    StreamFormat format_;
+    LosslessConfig config_;
+    std::vector<int64_t> channels_;    // 各声道的整数采样（声道 c 位于 c * blockFrames 起）
+    std::vector<int64_t> residual_;    // 候选预测器的残差
+    std::vector<int64_t> best_;        // 当前最优预测器的残差
+    std::vector<double> window_;       // LPC 自相关用的窗函数
+    std::vector<double> windowed_;
+};
+
+// 压缩文件写入：文件头 + 独立的块（每块带长度与帧数）+ 文件尾的块索引（按帧定位）
+// 文件头中的总帧数在 checkpoint() 时回填；进程中途被结束时没有索引，解码器按块头顺序扫描重建
+class LosslessEncoder {
+public:
+    bool open(std::ostream& out, const StreamFormat& format, const LosslessConfig& config = LosslessConfig());
+    // 追加交错 PCM 字节（可以不是整数个采样帧），凑满一块时编码写出
+    bool write(const uint8_t* pcm, size_t bytes);
+    // 把不足一块的数据也编码写出，并回填文件头
+    bool checkpoint();
+    // 写出剩余数据与块索引，回填文件头
+    bool finish();
+
+    uint64_t framesWritten() const { return frames_; }
+    uint64_t bytesIn() const { return bytesIn_; }
+    uint64_t bytesOut() const { return bytesOut_; }
+
+private:
+    struct IndexEntry { uint64_t frame; uint64_t offset; };
+
+    std::ostream* out_ = nullptr;
+    LosslessBlockCodec codec_;
+    LosslessConfig config_;
+    std::vector<uint8_t> pending_;     // 尚未凑满一块的 PCM
+    std::vector<uint8_t> encoded_;
+    std::vector<IndexEntry> index_;
+    uint64_t frames_ = 0;
+    uint64_t bytesIn_ = 0;
+    uint64_t bytesOut_ = 0;
+
+    bool flushBlock();
+    bool writeHeader(uint64_t indexOffset);
+};
+
+// 压缩文件读取：支持按采样帧定位
+class LosslessDecoder {
+public:
+    bool open(const std::string& path, std::string* error = nullptr);
+    const StreamFormat& format() const { return codec_.format(); }
+    uint64_t totalFrames() const { return totalFrames_; }
+    bool hadIndex() const { return hadIndex_; }  // false 表示文件未正常结束，索引由扫描重建
+
+    // 定位到第 frame 个采样帧，之后的 read() 从这里开始
+    bool seek(uint64_t frame);
+    // 读取最多 frames 个交错采样帧，返回实际读取数；到达文件尾或数据损坏时返回较少
+    size_t read(uint8_t* pcm, size_t frames);
+
+private:
+    struct Block { uint64_t frame; uint64_t offset; uint32_t frames; uint32_t size; };
+
+    std::ifstream in_;
+    LosslessBlockCodec codec_;
+    std::vector<Block> blocks_;
+    uint64_t totalFrames_ = 0;
+    bool hadIndex_ = false;
+    size_t current_ = 0;               // 当前块
+    uint32_t consumed_ = 0;            // 当前块中已读出的采样帧
+    bool loaded_ = false;              // decoded_ 中是否为当前块
+    std::vector<uint8_t> payload_;
+    std::vector<uint8_t> decoded_;
+};
+
+// 一次性编码 / 解码整段 PCM（测试与基准测试用）
+bool encodeLosslessFile(const std::string& path, const StreamFormat& format, const uint8_t* pcm, size_t bytes,
+    const LosslessConfig& config = LosslessConfig());
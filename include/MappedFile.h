@@ -0,0 +1,34 @@
+﻿#pragma once
+#include <string>
+#include <cstddef>
+
+// 文件内存映射（Windows: CreateFileMapping / MapViewOfFile，POSIX: mmap）
+// 可写映射供进程内直接写入，只读映射供其他进程轮询；析构时自动解除映射
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // 创建（或截断）文件为 size 字节并以读写方式映射，内容清零
+    bool create(const std::string& path, size_t size);
+    // 以只读方式映射已有文件的全部内容
+    bool openReadOnly(const std::string& path);
+    void close();
+
+    void* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool isOpen() const { return data_ != nullptr; }
+
+private:
+    void* data_ = nullptr;
+    size_t size_ = 0;
+#if defined(_WIN32)
+    void* file_ = nullptr;     // HANDLE
+    void* mapping_ = nullptr;  // HANDLE
+#else
+    int fd_ = -1;
+#endif
+};
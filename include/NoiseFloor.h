@@ -0,0 +1,41 @@
+﻿#pragma once
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+struct DetectorParams;
+
+// 按频点的自适应噪声底：每个频点的功率按不对称指数平滑跟踪（上升慢、下降快，近似最小值统计），
+// 持续的雨声、风声、引擎声会被噪声底吸收，短促的瞬态不会明显抬高噪声底；每帧 O(频点数)
+class NoiseFloor {
+public:
+    void prepare(size_t bins);   // 预分配并清空状态（格式协商时调用，之后不再分配内存）
+    void reset() { primed_ = false; }
+
+    // 统计 power[0..bins) 中超过 max(threshold, 噪声底 × floorMargin) 的频点数，然后用本帧更新噪声底
+    // offset 为帧在流中的位置，平滑系数按与上一帧的实际间隔换算（最多按一个帧长计，跳过的静音不会冲掉噪声底）
+    size_t countAbove(const float* power, size_t bins, float threshold, uint64_t offset, uint32_t sampleRate,
+        uint32_t frameSize, const DetectorParams& params);
+
+    const std::vector<float>& floor() const { return floor_; }
+
+private:
+    std::vector<float> floor_;
+    uint64_t lastOffset_ = 0;
+    bool primed_ = false;        // 第一帧直接作为初始噪声底
+};
+
+// 迟滞触发：占比达到 on 时触发一次，回落到 off 以下后才重新准备触发
+// 同一个持续的声音只产生一个事件，连续的多次枪声之间占比回落，每次都会触发
+struct TriggerHysteresis {
+    bool active = false;
+
+    bool update(float ratio, float on, float off) {
+        if (active) {
+            if (ratio < off) active = false;
+            return false;
+        }
+        active = ratio >= on;
+        return active;
+    }
+};
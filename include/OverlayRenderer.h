@@ -0,0 +1,104 @@
+﻿#pragma once
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "PolarHistogram.h"
+
+// 非预乘颜色（与 Gdiplus::Color(a, r, g, b) 的参数顺序相同）
+struct OverlayColor {
+    uint8_t a = 255;
+    uint8_t r = 255;
+    uint8_t g = 255;
+    uint8_t b = 255;
+
+    OverlayColor() = default;
+    OverlayColor(uint8_t a_, uint8_t r_, uint8_t g_, uint8_t b_) : a(a_), r(r_), g(g_), b(b_) {}
+};
+
+// 叠加层的用户可配置参数
+struct OverlayStyle {
+    float trailAngleThreshold = 10.0f;            // 残影触发阈值（度）
+    float trailBaseDuration = 0.2f;               // 残影基础持续时间（秒，正前方方向的能量衰减到不可见的时间）
+    float trailMaxDuration = 1.0f;                // 残影最大持续时间（秒，±90° 方向）
+    float liveDuration = 1.0f;                    // 实时弧形与角度文字在最后一个事件后保留的时间（秒）
+    OverlayColor liveColor{ 255, 255, 255, 0 };   // 实时弧形颜色
+    OverlayColor trailColor{ 255, 255, 0, 0 };    // 残影颜色（单次事件的能量；同一方向反复命中时向 liveColor 过渡）
+    float arcSpan = 2.0f;                         // 弧线跨度（度）
+    OverlayColor textColor{ 255, 255, 255, 0 };   // 文字颜色
+};
+
+// 平台无关的叠加层光栅化：抗锯齿弧形、残影热度环与角度文字直接合成到常驻的预乘 ARGB 缓冲
+// 像素为 32 位 0xAARRGGBB（小端内存顺序 B, G, R, A，与 32 位 DIB section 相同）
+// 缓冲可由调用方提供（Windows 上为长期复用的 DIB section），也可由渲染器自行分配
+class OverlayRenderer {
+public:
+    OverlayStyle style;
+
+    // 正方形画布边长（弧线半径 + 线宽决定）
+    static int surfaceSize(float radius, float penWidth);
+
+    // 配置几何参数并绑定像素缓冲；pixels 为空时内部分配（stride 以字节计，为 0 时紧密排列）
+    void configure(float radius, float penWidth, uint32_t* pixels = nullptr, size_t strideBytes = 0);
+
+    int size() const { return size_; }
+    size_t strideBytes() const { return stride_ * sizeof(uint32_t); }
+    const uint32_t* pixels() const { return pixels_; }
+    uint32_t pixel(int x, int y) const { return pixels_[static_cast<size_t>(y) * stride_ + x]; }
+
+    // ---------------- 光栅化原语 ----------------
+
+    void clear();  // 只清空上次绘制过的区域
+    // 以 color * alpha 叠加一段弧形；angleDeg 为方位角（0 为正上方，正值向右），按 1° 量化
+    void drawArc(float angleDeg, OverlayColor color, float alpha);
+    // 5×7 点阵字体，按 scale 整数放大；支持 ASCII 数字、"Angle:"、'-' 与 UTF-8 的 "°"
+    void drawText(int x, int y, const char* utf8, OverlayColor color, int scale);
+
+    // ---------------- 合成 ----------------
+
+    // 记录一个事件：超过阈值时把能量加到方位直方图，并成为新的实时弧形（不绘制）
+    void addEvent(float angleDeg, uint64_t nowMs);
+    // 按 nowMs 重绘残影热度环（每个可见的方位桶一段弧，开销与事件数无关）、实时弧形与角度文字；
+    // 返回画面上是否还有内容
+    bool render(uint64_t nowMs);
+    // addEvent + render
+    void composeEvent(float angleDeg, uint64_t nowMs);
+    void reset();  // 移除全部残影与实时弧形（不清空画布）
+    size_t trailBins(uint64_t nowMs) const { return trails_.activeBins(nowMs); }  // 可见的残影方位桶数
+    const PolarHistogram& trails() const { return trails_; }
+
+private:
+    struct ArcSprite {
+        int x;              // 精灵左上角在画布中的 x
+        int y;              // 精灵左上角在画布中的 y
+    };
+
+    void buildArcAtlas();
+    void blend(int x, int y, int sa, OverlayColor color);
+    void markDirty(int x0, int y0, int x1, int y1);
+    void syncTrailDecay();
+
+    // 弧形精灵图集：每 1° 一格，只存覆盖率，颜色与透明度在贴图时调制
+    static const int kAtlasMinAngle = -90;  // 图集起始角度（度）
+    static const int kAtlasSteps = 181;     // 图集格数（-90° ~ +90°）
+
+    int size_ = 0;
+    size_t stride_ = 0;                    // 行跨度（像素）
+    uint32_t* pixels_ = nullptr;
+    std::vector<uint32_t> ownPixels_;      // 未提供外部缓冲时使用
+    float radius_ = 0;
+    float penWidth_ = 0;
+
+    std::vector<uint8_t> arcAtlas_;        // 覆盖率图集（kAtlasSteps 格横向排列）
+    std::vector<ArcSprite> arcSprites_;    // 每格精灵的画布位置
+    int spriteSize_ = 0;                   // 精灵边长（像素）
+    float atlasSpan_ = 0;                  // 生成图集时的弧线跨度
+
+    int dirtyX0_ = 0, dirtyY0_ = 0, dirtyX1_ = 0, dirtyY1_ = 0;  // 待清空区域 [x0, x1) × [y0, y1)
+
+    PolarHistogram trails_;                // 残影：按方位累积、随时间衰减的能量
+    float trailBase_ = -1.0f;              // 生成衰减常数时的 trailBaseDuration
+    float trailMax_ = -1.0f;               // 生成衰减常数时的 trailMaxDuration
+    bool hasLive_ = false;                 // 是否有实时弧形
+    float liveAngle_ = 0;                  // 最近一个事件的角度
+    uint64_t liveTs_ = 0;                  // 最近一个事件的时间（毫秒）
+};
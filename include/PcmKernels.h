@@ -0,0 +1,48 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// 指令集级别
+enum class PcmIsa {
+    Scalar,
+    SSE2,
+    AVX2,
+};
+
+// PCM 处理内核函数表：解交错、格式转换、下混与能量统计
+// 运行时按 CPU 特性选择 SSE2/AVX2 实现，不支持时回退到标量实现
+//
+// 精度约定：
+//   - 解交错、int16 <-> float 转换：各实现逐位一致（含 NaN / ±Inf 输入）
+//   - 峰值：有限输入时各实现逐位一致
+//   - 平方和（downmixEnergy / sumSquares）：累加顺序不同，相对误差 < 1e-5（n <= 65536）
+//   - 频点声像（panBins）：逐频点独立计算，各实现逐位一致
+struct PcmKernels {
+    PcmIsa isa;
+    const char* name;
+
+    // 交错 int16 → 左右声道 float（声道 0/1，单声道时右声道复制左声道），除以 32768
+    void (*deinterleaveS16)(const int16_t* src, uint32_t channels, size_t frames, float* left, float* right);
+    // 交错 float32 → 左右声道 float（声道 0/1，单声道时右声道复制左声道）
+    void (*deinterleaveF32)(const float* src, uint32_t channels, size_t frames, float* left, float* right);
+    // int16 → float，除以 32768
+    void (*s16ToFloat)(const int16_t* src, size_t count, float* dst);
+    // float → int16，乘以 32768 后饱和到 [-32768, 32767]，就近舍入；NaN 输出 -32768
+    void (*floatToS16)(const float* src, size_t count, int16_t* dst);
+    // 左右声道下混 mono = (l + r) / 2，同时输出左右声道平方和
+    void (*downmixEnergy)(const float* left, const float* right, size_t n, float* mono, float* sumSqLeft, float* sumSqRight);
+    // 平方和
+    float (*sumSquares)(const float* src, size_t n);
+    // 峰值 max|x|
+    float (*peak)(const float* src, size_t n);
+    // 频点声像：left / right 为 bins 个交错复数（re, im, ...），energy = |L|² + |R|²，
+    // index = 声像 (|R|² - |L|²) / (|L|² + |R|²) 从 [-1, 1] 线性量化到 [0, levels - 1]（就近）；全零频点为中间值
+    void (*panBins)(const float* left, const float* right, size_t bins, uint32_t levels, float* energy, int32_t* index);
+
+    static const PcmKernels& best();              // 当前 CPU 支持的最优实现（首次调用时检测）
+    static const PcmKernels& forIsa(PcmIsa isa);  // 指定实现，CPU 不支持时退回更低级别
+    static bool supported(PcmIsa isa);            // CPU 是否支持
+};
+
+// RMS = sqrt(平方和 / n)
+float pcmRms(const PcmKernels& k, const float* src, size_t n);
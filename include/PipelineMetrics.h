@@ -0,0 +1,105 @@
+﻿#pragma once
+#include <atomic>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include "MappedFile.h"
+
+// 流水线运行指标（编号即统计页中的槽位，只能在末尾追加）
+enum class Metric : uint32_t {
+    PacketsCaptured,      // 计数：捕获的数据包
+    SilentPackets,        // 计数：带 SILENT 标志的数据包
+    Discontinuities,      // 计数：带 DATA_DISCONTINUITY 标志的数据包（音频引擎丢数据）
+    DetectorHits,         // 计数：有分析帧触发的数据包
+    ModelQueueDepth,      // 量值：分析队列当前深度
+    ModelQueueHighWater,  // 量值：分析队列深度的历史最大值
+    ModelQueueDrops,      // 计数：分析队列满而丢弃的帧
+    CaptureBusyNs,        // 耗时：捕获线程解码与分析的累计纳秒
+    AnalysisBusyNs,       // 耗时：分析线程方位估计的累计纳秒
+    EventsPosted,         // 计数：投递到主窗口的事件
+    RenderBusyNs,         // 耗时：主线程绘制的累计纳秒
+    RenderCount,          // 计数：叠加窗口重绘次数
+    RenderCoalesced,      // 计数：与同帧其他事件合并而省去的重绘
+    MailboxDrops,         // 计数：事件邮箱满（界面线程未及时取走）而丢弃的事件
+    RecorderBytes,        // 计数：录音写入文件的字节
+    RecorderBacklog,      // 量值：录音缓冲中尚未写盘的字节
+    RecorderBacklogHighWater,  // 量值：录音缓冲积压的历史最大值
+    RecorderDrops,        // 计数：录音缓冲满而丢弃的数据包
+    RecorderWriteNs,      // 耗时：写盘线程写文件的累计纳秒
+    ClipsWritten,         // 计数：写出的事件片段
+    ClipDrops,            // 计数：片段录制队列满而丢弃的数据包与事件
+    FramesSilent,         // 计数：检测级联第 0 级，全静音而跳过的分析帧
+    FramesGated,          // 计数：检测级联第 1 级，未通过时域高通门限的分析帧
+    FramesAnalyzed,       // 计数：检测级联第 2 级，做了 FFT 与频谱判定的分析帧
+    FramesTriggered,      // 计数：通过频谱判定的分析帧
+    StaleDrops,           // 计数：分析线程赶不上截止时间而丢弃的帧
+    FramesMerged,         // 计数：分析队列积压时并入相邻帧的帧
+    LateEvents,           // 计数：完成时已超过截止时间的事件
+    EventLatencyUs,       // 量值：最近一个事件从采集到方位估计完成的微秒数
+    EventLatencyMaxUs,    // 量值：上述延迟的历史最大值
+    Count,
+};
+
+enum class MetricKind : uint8_t { Counter, Gauge, TimeNs };
+
+const char* metricName(Metric m);
+MetricKind metricKind(Metric m);
+
+// 独占一个缓存行的指标槽，不同线程写入的槽之间没有伪共享
+struct alignas(64) MetricCell {
+    std::atomic<uint64_t> value{ 0 };
+};
+
+// 统计页：内存映射文件的完整内容，读取工具按相同布局解析
+struct MetricsPage {
+    static const uint32_t kMagic = 0x534D4341;  // "ACMS"
+    static const uint32_t kVersion = 1;
+    static const size_t kNameLength = 24;
+    static const size_t kMetricCount = static_cast<size_t>(Metric::Count);
+
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    uint32_t metricCount = 0;
+    uint32_t processId = 0;
+    uint64_t startTimeNs = 0;                    // 发布时的 steady_clock 时间
+    char names[kMetricCount][kNameLength] = {};  // 指标名，读取工具无需与写入方同一版本的枚举
+    uint8_t kinds[kMetricCount] = {};
+    MetricCell cells[kMetricCount];
+};
+
+// 指标集合：更新只是一次 relaxed 原子操作；publish 之后直接写在内存映射的统计页上，
+// 其他进程映射同一文件即可轮询，热路径上没有额外的复制或系统调用
+class PipelineMetrics {
+public:
+    PipelineMetrics();
+
+    PipelineMetrics(const PipelineMetrics&) = delete;
+    PipelineMetrics& operator=(const PipelineMetrics&) = delete;
+
+    // 创建统计文件并把当前值迁移过去；只能在没有线程更新时调用，失败时继续使用进程内页
+    bool publish(const std::string& path);
+    bool isPublished() const { return page_ != &local_; }
+
+    void add(Metric m, uint64_t n = 1) { cell(m).fetch_add(n, std::memory_order_relaxed); }
+    void set(Metric m, uint64_t v) { cell(m).store(v, std::memory_order_relaxed); }
+    // 单写者的最大值量值：只在超过当前值时写入
+    void raise(Metric m, uint64_t v) {
+        if (v > cell(m).load(std::memory_order_relaxed)) cell(m).store(v, std::memory_order_relaxed);
+    }
+    uint64_t get(Metric m) const { return page_->cells[static_cast<size_t>(m)].value.load(std::memory_order_relaxed); }
+
+    const MetricsPage& page() const { return *page_; }
+
+    static uint64_t nowNs();  // 阶段计时用的单调时钟
+
+private:
+    std::atomic<uint64_t>& cell(Metric m) { return page_->cells[static_cast<size_t>(m)].value; }
+    static void initPage(MetricsPage& page);
+
+    MetricsPage local_;        // 发布前（或发布失败时）使用的进程内页
+    MetricsPage* page_;
+    MappedFile file_;
+};
+
+// 校验映射内容是否为可识别的统计页（读取工具使用）
+const MetricsPage* metricsPageFromMapping(const void* data, size_t size);
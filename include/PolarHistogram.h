@@ -0,0 +1,53 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// 方位能量直方图：-90° ~ +90° 每 1° 一个桶，事件把能量加到所在的桶，能量按时间指数衰减
+// 衰减在读取时按时间戳惰性计算，桶数固定，内存与每帧绘制开销都与事件频率无关
+class PolarHistogram {
+public:
+    static const int kMinAngle = -90;  // 第一个桶的角度（度）
+    static const int kBins = 181;      // 桶数
+
+    PolarHistogram() { configure(0.2f, 1.0f); }
+
+    // 可见时长：正前方为 baseDuration，±90° 为 maxDuration，中间线性插值（与旧版残影时长一致）；
+    // 单位能量在可见时长后衰减到 cutoff 以下，视为消失
+    void configure(float baseDuration, float maxDuration, float cutoff = 1.0f / 32.0f);
+
+    // 把 energy 加到 angleDeg 所在的桶；单桶能量以 maxEnergy 封顶
+    void add(float angleDeg, uint64_t nowMs, float energy = 1.0f);
+
+    // 桶在 nowMs 时的能量，低于 cutoff 时为 0
+    float energy(int bin, uint64_t nowMs) const;
+    static float binAngle(int bin) { return static_cast<float>(kMinAngle + bin); }
+    static int binOf(float angleDeg);
+
+    // 依次回调可见的桶：f(angleDeg, energy)
+    template <typename F>
+    void forEachActive(uint64_t nowMs, F&& f) const {
+        for (int i = 0; i < kBins; ++i) {
+            float e = energy(i, nowMs);
+            if (e > 0.0f) f(binAngle(i), e);
+        }
+    }
+
+    size_t activeBins(uint64_t nowMs) const;  // 可见的桶数
+    void clear();
+
+    float maxEnergy = 4.0f;  // 单桶能量上限（频繁命中同一方向时不无限累积）
+
+private:
+    struct Bin {
+        float energy = 0.0f;  // ts 时刻的能量
+        uint64_t ts = 0;      // 最近一次写入的时间（毫秒）
+    };
+
+    float decayed(const Bin& b, int bin, uint64_t nowMs) const;
+
+    Bin bins_[kBins];
+    float invTau_[kBins] = {};  // 各桶衰减时间常数的倒数（1/毫秒）
+    float cutoff_ = 1.0f / 32.0f;
+    float baseDuration_ = 0.0f;
+    float maxDuration_ = 0.0f;
+};
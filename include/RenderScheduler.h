@@ -0,0 +1,50 @@
+﻿#pragma once
+#include <vector>
+#include <cstdint>
+#include "OverlayRenderer.h"
+
+// 叠加层渲染调度：按显示刷新率的固定节拍合成，两个节拍之间到达的事件合并为一帧，
+// 残影按单调时钟衰减，画面完全消失后转为空闲（停止定时器），直到下一个事件到达
+// 时间全部由调用方传入（纳秒，单调递增），可在无窗口的环境下用假时钟测试
+class RenderScheduler {
+public:
+    explicit RenderScheduler(OverlayRenderer& renderer, uint64_t frameIntervalNs = 16666667);
+
+    void setFrameInterval(uint64_t ns);
+    uint64_t frameInterval() const { return frameIntervalNs_; }
+
+    // 事件到达：记入待合成队列；返回 true 表示调度器从空闲转为活动，调用方需启动定时器
+    bool submit(float angleDeg, uint64_t eventId, uint64_t nowNs);
+
+    // 定时器触发：未到帧时刻或没有变化时返回 false；否则把待合成事件一次性交给渲染器并重绘，
+    // 返回 true 表示画布已更新、需要呈现（最后一帧可能是清空后的透明画面）
+    bool tick(uint64_t nowNs);
+
+    // 无待合成事件且画面已为空：调用方可停止定时器
+    bool idle() const { return !active_; }
+
+    // 立即丢弃待合成事件、残影与实时弧形并清空画布，转为空闲
+    void reset();
+
+    uint64_t nextFrameTime() const { return nextFrameNs_; }
+    const std::vector<uint64_t>& frameEvents() const { return frameEvents_; }  // 最近一帧合成的事件
+    uint64_t framesRendered() const { return framesRendered_; }
+    uint64_t eventsCoalesced() const { return eventsCoalesced_; }  // 与同帧其他事件合并而省去的重绘次数
+
+private:
+    struct PendingEvent {
+        float angle;
+        uint64_t id;
+        uint64_t timeNs;    // 到达时间，残影从此开始衰减
+    };
+
+    OverlayRenderer& renderer_;
+    uint64_t frameIntervalNs_;
+    uint64_t nextFrameNs_ = 0;       // 下一帧的最早时刻
+    bool active_ = false;            // 有待合成事件或画面上仍有内容
+    bool visible_ = false;           // 上一帧画面是否有内容
+    std::vector<PendingEvent> pending_;
+    std::vector<uint64_t> frameEvents_;
+    uint64_t framesRendered_ = 0;
+    uint64_t eventsCoalesced_ = 0;
+};
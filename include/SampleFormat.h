@@ -0,0 +1,31 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// 采样格式
+enum class SampleType {
+    Unknown,
+    Int16,      // 16 位整数
+    Int24,      // 24 位整数（3 字节紧密排列）
+    Int32,      // 32 位整数（含 24 位有效位左对齐在 32 位容器中的情况）
+    Float32,    // 32 位浮点
+};
+
+// 与平台无关的流格式描述，由 WAVEFORMATEX / WAV 文件头解析得到
+struct StreamFormat {
+    SampleType type = SampleType::Unknown;
+    uint32_t channels = 0;      // 声道数
+    uint32_t sampleRate = 0;    // 采样率
+    uint32_t blockAlign = 0;    // 每个采样帧的字节数
+};
+
+// 解码函数：交错 PCM → 左右声道 float [-1, 1)（声道 0/1，单声道时右声道复制左声道）
+typedef void (*DecodeStereoFn)(const uint8_t* src, size_t frames, float* left, float* right);
+
+// 根据 wFormatTag / 位深 / 有效位 / 是否浮点推断采样类型
+SampleType sampleTypeFrom(uint32_t bitsPerSample, uint32_t validBits, bool isFloat);
+
+// 选择按采样类型和声道数特化的解码函数，格式协商时调用一次；不支持的格式返回 nullptr
+DecodeStereoFn selectStereoDecoder(const StreamFormat& fmt);
+
+const char* sampleTypeName(SampleType type);
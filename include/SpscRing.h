@@ -0,0 +1,101 @@
+﻿#pragma once
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// 单生产者/单消费者无锁环形队列，槽位在 reset 时一次性分配
+// 生产者：acquire() 取空槽 → 填充 → publish()；满时 acquire() 返回 nullptr 并计入溢出
+// 消费者：front() 取最早的槽 → 读取 → pop()
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity = 0) { reset(capacity); }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // 重新分配槽位（容量向上取 2 的幂），只能在生产者与消费者都未运行时调用
+    void reset(size_t capacity) {
+        size_t n = 1;
+        while (n < capacity) n <<= 1;
+        slots_.clear();
+        slots_.resize(capacity ? n : 0);
+        mask_ = capacity ? n - 1 : 0;
+        head_.store(0, std::memory_order_relaxed);
+        tail_.store(0, std::memory_order_relaxed);
+        tailCache_ = 0;
+        headCache_ = 0;
+        overflow_.store(0, std::memory_order_relaxed);
+    }
+
+    size_t capacity() const { return slots_.size(); }
+
+    // 遍历所有槽位做预分配，只能在生产者与消费者都未运行时调用
+    template <typename F>
+    void forEachSlot(F&& f) {
+        for (auto& slot : slots_) f(slot);
+    }
+
+    // 生产者：获取下一个可写槽位，队列满时返回 nullptr
+    T* acquire() {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (slots_.empty() || head - tailCache_ >= slots_.size()) {
+            tailCache_ = tail_.load(std::memory_order_acquire);
+            if (slots_.empty() || head - tailCache_ >= slots_.size()) {
+                overflow_.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+        }
+        return &slots_[head & mask_];
+    }
+
+    // 生产者：发布 acquire() 取得的槽位
+    void publish() {
+        head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // 消费者：最早的未读槽位，队列空时返回 nullptr
+    T* front() {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == headCache_) {
+            headCache_ = head_.load(std::memory_order_acquire);
+            if (tail == headCache_) return nullptr;
+        }
+        return &slots_[tail & mask_];
+    }
+
+    // 消费者：front() 之后第 i 个未读槽位（i = 0 即 front()），不存在时返回 nullptr
+    T* peek(size_t i) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (headCache_ - tail <= i) {
+            headCache_ = head_.load(std::memory_order_acquire);
+            if (headCache_ - tail <= i) return nullptr;
+        }
+        return &slots_[(tail + i) & mask_];
+    }
+
+    // 消费者：释放 front() 返回的槽位
+    void pop() {
+        tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // 近似深度（任意线程可读）
+    size_t size() const {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+    bool empty() const { return size() == 0; }
+
+    uint64_t overflowCount() const { return overflow_.load(std::memory_order_relaxed); }
+
+private:
+    std::vector<T> slots_;
+    size_t mask_ = 0;
+
+    alignas(64) std::atomic<size_t> head_{ 0 };  // 生产者写位置
+    size_t tailCache_ = 0;                       // 生产者缓存的读位置
+    alignas(64) std::atomic<size_t> tail_{ 0 };  // 消费者读位置
+    size_t headCache_ = 0;                       // 消费者缓存的写位置
+    alignas(64) std::atomic<uint64_t> overflow_{ 0 };  // 队列满而丢弃的次数
+};
@@ -0,0 +1,60 @@
+﻿#pragma once
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// 分析帧：固定长度、已加窗，并记录在采集流中的样本位置
+struct AnalysisFrame {
+    uint64_t offset = 0;        // 帧首样本在流中的位置（按采样帧计）
+    std::vector<float> left;    // 加窗后的左声道（声道 0）
+    std::vector<float> right;   // 加窗后的右声道（单声道输入时与左声道相同）
+    float windowSum = 0.0f;     // 窗函数之和（相干增益 × 帧长），0 表示未加窗（按帧长计）
+};
+
+// STFT 重分帧：把任意长度的数据包重组为固定长度、固定跳步的重叠分析帧
+// 环形缓冲在 configure 时一次性分配，之后推送数据不再分配内存
+class StftFramer {
+public:
+    StftFramer(size_t frameSize = 256, size_t hopSize = 128);
+
+    void configure(size_t frameSize, size_t hopSize);  // 重新设置帧长与跳步（会清空状态）
+    void reset();                                      // 清空缓冲，流位置归零
+
+    size_t frameSize() const { return frameSize_; }
+    size_t hopSize() const { return hopSize_; }
+    uint64_t samplesWritten() const { return written_; }  // 已推送的样本总数
+    const std::vector<float>& window() const { return window_; }
+
+    // 推送平面格式的左右声道样本，每凑满一帧调用一次 onFrame(const AnalysisFrame&)
+    template <typename OnFrame>
+    void push(const float* left, const float* right, size_t count, OnFrame&& onFrame) {
+        while (count > 0) {
+            size_t n = write(left, right, count);
+            if (left) left += n;
+            if (right) right += n;
+            count -= n;
+            while (written_ - nextOffset_ >= frameSize_) onFrame(emit());
+        }
+    }
+
+    // 推送静音（全零）样本，保持流位置连续
+    template <typename OnFrame>
+    void pushSilence(size_t count, OnFrame&& onFrame) {
+        push(nullptr, nullptr, count, onFrame);
+    }
+
+private:
+    size_t write(const float* left, const float* right, size_t count);  // 写入环形缓冲，返回实际写入数量
+    const AnalysisFrame& emit();                                        // 取出下一帧并加窗
+
+    size_t frameSize_ = 0;
+    size_t hopSize_ = 0;
+    size_t mask_ = 0;                 // 环形缓冲容量 - 1（容量为 2 的幂）
+    uint64_t written_ = 0;            // 已写入样本总数
+    uint64_t nextOffset_ = 0;         // 下一帧的起始位置
+
+    std::vector<float> ringLeft_;     // 左声道环形缓冲
+    std::vector<float> ringRight_;    // 右声道环形缓冲
+    std::vector<float> window_;       // Hann 窗
+    AnalysisFrame frame_;             // 复用的输出帧
+};
@@ -0,0 +1,94 @@
+﻿#pragma once
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "SampleFormat.h"
+#include "FrameAnalyzer.h"
+#include "DirectionEstimator.h"
+
+// 合成声学场景：已知方位的高频脉冲（枪声）叠加背景噪声、音乐与重叠事件，用于回归检测率、方位误差与检测延迟
+// 同一 seed 生成相同的场景：随机数只取 mt19937 的原始输出（序列由标准规定），不使用各标准库实现不同的分布
+
+// 场景中的一个脉冲事件（真值）
+struct SceneEvent {
+    uint64_t start = 0;        // 起始采样帧
+    uint32_t length = 0;       // 持续采样帧数
+    float angle = 0.0f;        // 方位角 [-90, +90]，正值表示偏右
+    float peakDb = 0.0f;       // 包络峰值处的 RMS 电平（dBFS，较响的一侧）
+    float tilt = 0.0f;         // 频谱倾斜 y[n] = x[n] + tilt·x[n-1]，负值偏亮、正值偏暗
+};
+
+struct SceneConfig {
+    uint32_t sampleRate = 48000;
+    double seconds = 20.0;
+    uint32_t seed = 1;
+    uint32_t events = 40;              // 均匀分布在整个场景中的脉冲事件数
+    float maxAngle = 80.0f;            // 方位在 ±maxAngle 内均匀分布
+    float minPeakDb = -30.0f;          // 脉冲包络峰值处的 RMS 电平范围（dBFS，较响的一侧）
+    float maxPeakDb = -12.0f;
+    float decaySeconds = 0.02f;        // 脉冲的指数衰减时间常数，持续 5 倍时间常数
+    float overlapProbability = 0.0f;   // 事件伴随另一侧第二个事件（2 ms 内开始）的概率
+    float noiseDb = -120.0f;           // 宽带白噪声 RMS（dBFS），左右独立；-120 及以下不生成
+    float musicDb = -120.0f;           // 音乐（低频和弦，含谐波至约 3.5 kHz）RMS（dBFS）；-120 及以下不生成
+    float maxItdSeconds = 0.0008f;     // ±90° 对应的耳间时间差，与 DirectionEstimator 相同
+};
+
+// 声像与 DirectionEstimator 的映射互逆：ILD = angle / 90 × 20 dB（与 ildAngle 相同，较响的一侧增益为 1），
+// ITD = maxItdSeconds × sin(angle)，偏右时左声道滞后；分数延迟左右各承担一半并对称线性插值，两侧的高频衰减相同，ILD 不受影响
+struct SyntheticScene {
+    uint32_t sampleRate = 0;
+    std::vector<float> left;
+    std::vector<float> right;
+    std::vector<SceneEvent> events;    // 按起始位置排序
+};
+
+void renderScene(const SceneConfig& config, SyntheticScene& scene);
+
+// 编码为双声道交错 PCM（Int16 / Int24 / Int32 / Float32，整数格式就近舍入并饱和），返回对应的流格式
+StreamFormat encodeScene(const SyntheticScene& scene, SampleType type, std::vector<uint8_t>& pcm);
+
+// 按实时程序的方式回放场景：固定大小的数据包送入 DetectorPipeline，包内最强触发帧交给 DirectionEstimator
+struct SceneRunConfig {
+    uint32_t frameSize = 256;
+    uint32_t hopSize = 128;
+    uint32_t packetFrames = 480;
+    DetectorParams params;             // 默认与 AudioCapture 相同（自适应噪声底）
+    DirectionMode mode = DirectionMode::Ild;
+    size_t maxSources = 3;
+
+    SceneRunConfig() { params.adaptiveFloor = true; }
+};
+
+// 一次检测（对应实时程序中的一次 OverlayEvent）
+struct SceneDetection {
+    uint64_t frameOffset = 0;          // 触发帧首样本的流位置
+    uint64_t reportedAt = 0;           // 所在数据包结束时的流位置，捕获线程最早在此时投递事件
+    float angle = 0.0f;
+    size_t sourceCount = 0;
+    float sources[DirectionResult::kMaxSources] = {};
+};
+
+// 解码失败（格式不支持）时返回 false
+bool runScene(const StreamFormat& fmt, const std::vector<uint8_t>& pcm, const SceneRunConfig& config,
+    std::vector<SceneDetection>& detections);
+
+// 评分：检测的触发帧与事件 [start, start + length) 有重叠即命中该事件；每个事件取最早命中的检测，
+// 同一事件之后的检测计为重复，不与任何事件重叠的检测计为误报。
+// 角度误差：检测有两个及以上声源时取离真值最近的声源，否则取融合角度；延迟 = reportedAt - start（采样帧）
+struct SceneScore {
+    size_t events = 0;
+    size_t detected = 0;               // 被命中的事件数
+    size_t detections = 0;
+    size_t falseAlarms = 0;
+    size_t duplicates = 0;
+    double recall = 0.0;               // detected / events
+    double precision = 0.0;            // 命中至少一个事件的检测 / detections
+    double angleErrorMean = 0.0;       // 度
+    double angleErrorP90 = 0.0;
+    double angleErrorMax = 0.0;
+    double latencyMean = 0.0;          // 采样帧
+    double latencyMax = 0.0;
+};
+
+SceneScore scoreScene(const std::vector<SceneEvent>& events, const std::vector<SceneDetection>& detections,
+    uint32_t frameSize);
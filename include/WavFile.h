@@ -0,0 +1,23 @@
+﻿#pragma once
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "SampleFormat.h"
+
+// WAV 格式码（与 mmreg.h 中的 WAVE_FORMAT_* 相同）
+const uint16_t kWaveFormatPcm = 0x0001;
+const uint16_t kWaveFormatIeeeFloat = 0x0003;
+const uint16_t kWaveFormatExtensible = 0xFFFE;
+
+// 解析 fmt 块（内存布局与 WAVEFORMATEX / WAVEFORMATEXTENSIBLE 相同）为流格式
+// 支持 PCM、IEEE 浮点以及子格式为 PCM / 浮点的 EXTENSIBLE；不支持时 type 为 Unknown
+StreamFormat streamFormatFromFmtChunk(const uint8_t* fmt, size_t size);
+
+// 读取 WAV / RF64 文件的流格式与全部 PCM 数据（data 块），失败时返回 false 并写入 error
+bool readWavFile(const std::string& path, StreamFormat& format, std::vector<uint8_t>& data, std::string* error = nullptr);
+
+// 在内存中的 WAV / RF64 映像（如 MappedFile 映射的整个文件）中定位 data 块，不复制数据
+// dataOffset / dataSize 为 PCM 在映像中的位置与长度（整数个采样帧），长度规则与 readWavFile 相同
+bool locateWavData(const uint8_t* image, size_t size, StreamFormat& format, size_t& dataOffset, size_t& dataSize,
+    std::string* error = nullptr);
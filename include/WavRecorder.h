@@ -0,0 +1,101 @@
+﻿#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "PipelineMetrics.h"
+#include "LosslessCodec.h"
+
+// 录音参数
+struct WavRecorderConfig {
+    size_t bufferBytes = 16u << 20;  // 生产者与写盘线程之间的环形缓冲（向上取为 batchBytes 的 2 的幂倍）
+    size_t batchBytes = 1u << 20;    // 每次写盘的批大小（向上取为 4 KiB 的倍数，缓冲按 4 KiB 对齐）
+    uint32_t checkpointMs = 1000;    // 回填文件头的间隔：进程被强制结束时最多丢失这段时间的数据
+    uint64_t segmentBytes = 0;       // 每个文件的最大 data 字节数，0 为不分段（超过 4 GiB 时升级为 RF64）
+    uint32_t segmentSeconds = 0;     // 每个文件的最长时长（秒），0 为不限
+    bool lossless = false;           // 写盘线程用 LosslessEncoder 压缩后写入（.aclc 文件），检查点时刷出不足一块的数据
+    LosslessConfig losslessConfig;
+};
+
+// 生成 WAV 文件头：RIFF + 预留的 JUNK 块 + fmt + data 块头，长度与 dataBytes 无关
+// RIFF 长度超出 32 位时生成 RF64 头（JUNK 改为 ds64，32 位长度字段写 0xFFFFFFFF），已写入的数据无需移动
+void buildWavHeader(const uint8_t* fmt, size_t fmtSize, uint64_t dataBytes, std::vector<uint8_t>& out);
+
+// 异步 WAV 录音：生产者线程把数据包复制进无锁环形缓冲，专用写盘线程按批写入并定期回填文件头
+// append() 从不阻塞也不分配内存，缓冲满时整包丢弃并计数；写盘线程不持有生产者需要的任何锁
+class WavRecorder {
+public:
+    WavRecorder() = default;
+    ~WavRecorder() { stop(); }
+
+    WavRecorder(const WavRecorder&) = delete;
+    WavRecorder& operator=(const WavRecorder&) = delete;
+
+    // 创建第一个文件并启动写盘线程；fmt 为 fmt 块内容（与 WAVEFORMATEX 布局相同）
+    bool start(const std::string& path, const uint8_t* fmt, size_t fmtSize,
+        const WavRecorderConfig& config = WavRecorderConfig());
+    // 写完缓冲中的全部数据、回填文件头并关闭文件；调用前生产者必须已停止 append()
+    void stop();
+    bool isRecording() const { return thread_.joinable(); }
+
+    // 生产者：追加整数个采样帧；缓冲空间不足时丢弃整个数据包并返回 false
+    bool append(const void* data, size_t bytes);
+
+    // 可选：把写盘量、积压与丢弃同步到运行指标（start() 之前设置）
+    void attachMetrics(PipelineMetrics* metrics) { metrics_ = metrics; }
+
+    uint64_t bytesWritten() const { return tail_.load(std::memory_order_acquire); }   // 已写入文件的数据字节
+    uint64_t droppedPackets() const { return dropped_.load(std::memory_order_relaxed); }
+    size_t backlogHighWater() const { return highWater_.load(std::memory_order_relaxed); }  // 缓冲积压的最大字节数
+    uint32_t segmentCount() const { return segments_.load(std::memory_order_acquire); }    // 已创建的文件数
+    bool failed() const { return failed_.load(std::memory_order_acquire); }               // 发生过写入错误
+
+    // 第 index 个分段的文件名：0 为 base 本身，之后在扩展名前插入 _1、_2 ...
+    static std::string segmentPath(const std::string& base, uint32_t index);
+
+private:
+    WavRecorderConfig config_;
+    std::string basePath_;
+    std::vector<uint8_t> fmt_;
+    uint32_t blockAlign_ = 1;
+    uint64_t segmentLimit_ = 0;       // 每个文件的 data 上限（整数个采样帧），0 为不限
+    PipelineMetrics* metrics_ = nullptr;
+
+    std::vector<uint8_t> storage_;    // 环形缓冲的底层内存（含对齐余量）
+    uint8_t* buffer_ = nullptr;       // 4 KiB 对齐的缓冲起点
+    size_t capacity_ = 0;             // 2 的幂
+    size_t batch_ = 0;
+
+    // 写盘线程状态
+    std::ofstream file_;
+    uint32_t segmentIndex_ = 0;
+    uint64_t segmentData_ = 0;        // 当前文件已写入的 data 字节
+    uint64_t headerData_ = 0;         // 当前文件头中记录的 data 字节
+    std::vector<uint8_t> header_;
+    StreamFormat format_;             // lossless 模式下的编码格式
+    LosslessEncoder encoder_;
+
+    std::thread thread_;
+    std::mutex mutex_;                // 只用于写盘线程的条件变量等待，生产者不加锁
+    std::condition_variable wake_;
+    std::atomic<bool> stopping_{ false };
+    std::atomic<bool> failed_{ false };
+    std::atomic<uint32_t> segments_{ 0 };
+
+    alignas(64) std::atomic<uint64_t> head_{ 0 };  // 生产者写入的累计字节
+    uint64_t tailCache_ = 0;                       // 生产者缓存的写盘位置
+    alignas(64) std::atomic<uint64_t> tail_{ 0 };  // 写盘线程写出的累计字节
+    alignas(64) std::atomic<uint64_t> dropped_{ 0 };
+    std::atomic<size_t> highWater_{ 0 };
+
+    void ioThread();
+    bool openSegment();
+    void closeSegment();              // 写出文件尾（WAV 文件头或压缩文件的块索引）并关闭
+    bool writeHeader();               // 按 segmentData_ 回填文件头并把数据交给操作系统
+    bool writeChunk(const uint8_t* data, size_t bytes);
+};
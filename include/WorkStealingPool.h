@@ -0,0 +1,53 @@
+﻿#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstdint>
+
+// 工作窃取线程池：每个工作线程有自己的任务队列，自己从队尾取（后进先出，刚拆出的子任务数据还在缓存中），
+// 空闲时从其他线程的队头窃取（先进先出，取走最早、通常最大的任务）
+// 工作线程内提交的任务进入自己的队列，其他线程提交的任务轮流分配
+class WorkStealingPool {
+public:
+    typedef std::function<void()> Task;
+
+    explicit WorkStealingPool(unsigned threads = 0);  // 0 为硬件线程数
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    void submit(Task task);
+    // 等待已提交的任务（包括执行中再提交的任务）全部完成；不能在工作线程内调用
+    void wait();
+
+    unsigned threadCount() const { return static_cast<unsigned>(threads_.size()); }
+    uint64_t executed() const { return executed_.load(std::memory_order_relaxed); }
+    uint64_t steals() const { return steals_.load(std::memory_order_relaxed); }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void run(unsigned index);
+    bool take(unsigned index, Task& task);
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> threads_;
+    std::mutex sleepMutex_;
+    std::condition_variable wake_;             // 有新任务或停止
+    std::condition_variable idle_;             // 全部任务完成
+    std::atomic<uint64_t> queued_{ 0 };        // 队列中等待执行的任务数
+    std::atomic<uint64_t> pending_{ 0 };       // 已提交但尚未完成的任务数
+    std::atomic<uint32_t> nextQueue_{ 0 };
+    std::atomic<uint64_t> executed_{ 0 };
+    std::atomic<uint64_t> steals_{ 0 };
+    bool stopping_ = false;                    // 由 sleepMutex_ 保护
+};
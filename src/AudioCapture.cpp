@@ -1,92 +1,96 @@
 #include "AudioCapture.h"
+#include <algorithm>
+#include <cmath>
 #include <fstream>
-#include <iostream>
 
-AudioCapture::AudioCapture() {}
+// 캯л¼Զλ
+AudioCapture::AudioCapture() {
+	modelEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+}
 
-// ͷ WAVEFORMATEX ڴ
+// ͷ WAVEFORMATEX ڴ¼
 AudioCapture::~AudioCapture() {
 	if (pwfx) CoTaskMemFree(pwfx);
+	if (modelEvent) CloseHandle(modelEvent);
 }
 
-// Ƶ߳
-void AudioCapture::start() {
+// Ƶ̣̳߳߳ʼʧʱ false
+bool AudioCapture::start() {
+	latencyTracer.enabled = latencyTracing;
+	if (!metricsFile.empty() && !pipelineMetrics.isPublished() && !pipelineMetrics.publish(metricsFile)) {
+		OutputDebugStringW(L"[AudioCapture] cannot create metrics file, metrics stay in-process\n");
+	}
 	running = true;
+	captureState = CaptureState::Starting;
 	captureThreadHandle = std::thread(&AudioCapture::captureThread, this);
 
-	// ȴ pwfx ʼ
-	while (pwfx == nullptr) Sleep(10);
+	// ȴʽЭвλɣ߳ǰ˳ʱٵȴ
+	while (captureState == CaptureState::Starting) Sleep(10);
+	if (captureState != CaptureState::Running) {
+		running = false;
+		captureThreadHandle.join();
+		return false;
+	}
 
 	modelThreadHandle = std::thread(&AudioCapture::myThread, this);
-	//saveThreadHandle = std::thread(&AudioCapture::savePcmWavStreaming, this);//ʱر
+	return true;
 }
 
 // ֹͣƵ
 void AudioCapture::stop() {
 	running = false;
-	modelCV.notify_all();
-	saveCV.notify_all();
+	SetEvent(modelEvent);
 
 	if (captureThreadHandle.joinable()) captureThreadHandle.join();
+	recorder.stop();  // ߳˳дʣݲļͷ
 	if (modelThreadHandle.joinable()) modelThreadHandle.join();
-	if (saveThreadHandle.joinable()) saveThreadHandle.join();
-}
+	clips.stop();  // ߳˳дδɵƬ
 
-//  FFT ʵ
-void AudioCapture::simpleFFT(const std::vector<float>& in, std::vector<std::complex<float>>& out) {
-	size_t N = in.size();
-	out.resize(N);
-	const float PI2 = 2.0f * 3.14159265359f;
-	for (size_t k = 0; k < N; ++k) {
-		std::complex<float> sum(0.0f, 0.0f);
-		for (size_t n = 0; n < N; ++n) {
-			float angle = -PI2 * k * n / N;
-			sum += std::complex<float>(in[n] * std::cos(angle), in[n] * std::sin(angle));
-		}
-		out[k] = sum;
-	}
+	if (latencyTracing) writeLatencyTrace();
 }
 
-// жǷиƵ
-bool AudioCapture::hasHighFreqContent(const uint8_t* pData, uint32_t numFrames, WAVEFORMATEX* pwfx) {
-	std::vector<float> mono(numFrames);
-
-	if (pwfx->wBitsPerSample == 16) {
-		const int16_t* src = reinterpret_cast<const int16_t*>(pData);
-		for (uint32_t i = 0; i < numFrames; ++i)
-			mono[i] = src[i * pwfx->nChannels] / 32768.0f;
-	}
-	else if (pwfx->wBitsPerSample == 32) {
-		const float* src = reinterpret_cast<const float*>(pData);
-		for (uint32_t i = 0; i < numFrames; ++i)
-			mono[i] = src[i * pwfx->nChannels];
-	}
+// ӳٸ٣Chrome trace JSON  p50/p99/max 
+void AudioCapture::writeLatencyTrace() {
+	std::vector<TraceRecord> records;
+	latencyTracer.collect(records);
+	if (records.empty()) return;
 
-	std::vector<std::complex<float>> spectrum;
-	simpleFFT(mono, spectrum);
+	std::ofstream trace(latencyTraceFile);
+	if (trace.is_open()) writeChromeTrace(trace, records);
 
-	float freqStep = static_cast<float>(pwfx->nSamplesPerSec) / numFrames;
-	size_t highFreqCount = 0;
-	size_t aboveThresholdCount = 0;
-
-	// ƵףͳƸƵ
-	for (size_t i = 0; i < spectrum.size() / 2; ++i) {
-		float freq = i * freqStep;
-		if (freq >= highFreqMin) {
-			++highFreqCount;
-			float mag = std::abs(spectrum[i]);
-			if (mag > highFreqEpsilon) ++aboveThresholdCount;
-		}
+	std::ofstream report(latencyReportFile);
+	if (report.is_open()) {
+		writeLatencyReport(report, computeLatencyStats(records));
+		report << "\ndropped records: " << latencyTracer.droppedCount() << "\n";
 	}
+}
 
-	if (highFreqCount == 0) return false;
+//  WAVEFORMATEX WAVE_FORMAT_EXTENSIBLEΪƽ̨޹صʽ֧ʱ type Ϊ Unknown
+static StreamFormat streamFormatFromWave(const WAVEFORMATEX* wfx) {
+	// WAVEFORMATEX  WAV ļ fmt 鲼ͬ߹߹ͬһݽ
+	size_t size = sizeof(WAVEFORMATEX) + (wfx->wFormatTag == WAVE_FORMAT_PCM ? 0 : wfx->cbSize);
+	return streamFormatFromFmtChunk(reinterpret_cast<const uint8_t*>(wfx), size);
+}
 
-	float ratio = static_cast<float>(aboveThresholdCount) / highFreqCount;
-	return (ratio >= highFreqRatio);
+// ֡Ĳɼʱ䣺ݰʱ䰴λ֮㣨֡ʼһݰ
+static uint64_t frameCaptureNs(uint64_t packetNs, uint64_t packetPosition, uint64_t frameOffset, uint32_t sampleRate) {
+	if (sampleRate == 0) return packetNs;
+	if (frameOffset >= packetPosition) return packetNs + (frameOffset - packetPosition) * 1000000000ull / sampleRate;
+	const uint64_t back = (packetPosition - frameOffset) * 1000000000ull / sampleRate;
+	return packetNs > back ? packetNs - back : 1;
 }
 
 // ̣߳ѭȡƵ
 void AudioCapture::captureThread() {
+	// κǰض״̬Ϊʧܣstart() ݴ˽ȴ
+	struct StateGuard {
+		std::atomic<CaptureState>& state;
+		~StateGuard() {
+			CaptureState expected = CaptureState::Starting;
+			state.compare_exchange_strong(expected, CaptureState::Failed);
+		}
+	} stateGuard{ captureState };
+
 	HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
 	if (FAILED(hr)) return;
 
@@ -113,6 +117,46 @@ void AudioCapture::captureThread() {
 	if (FAILED(hr)) return;
 
 	IAudioCaptureClient* pCaptureClient = nullptr;
+	UINT32 bufferFrames = 0;
+	hr = pAudioClient->GetBufferSize(&bufferFrames);
+	if (FAILED(hr)) return;
+
+	// Э̸ʽüˮߣѡ뺯Ԥ仺壩֮ÿݰֻһκָ
+	DetectorParams params;
+	params.highFreqMin = highFreqMin;
+	params.highFreqEpsilon = highFreqEpsilon;
+	params.highFreqRatio = highFreqRatio;
+	params.adaptiveFloor = adaptiveNoiseFloor;
+	if (!pipeline.configure(streamFormatFromWave(pwfx), analysisFrameSize, analysisHopSize, params, bufferFrames)) {
+		wchar_t buf[128];
+		swprintf_s(buf, L"[AudioCapture] unsupported mix format: tag=%u bits=%u channels=%u\n",
+			pwfx->wFormatTag, pwfx->wBitsPerSample, pwfx->nChannels);
+		OutputDebugStringW(buf);
+	}
+
+	// Э̸ʽԤвλڼ䲻ٷڴ
+	modelRing.reset(kModelRingSlots);
+	modelRing.forEachSlot([&](AnalyzedFrame& slot) {
+		reserveAnalyzedFrame(slot, analysisFrameSize);
+	});
+
+	// ¼fmt ֱʹûʽEXTENSIBLE ʱӸʽд¼Լ߳н
+	if (recordAudio) {
+		size_t fmtSize = sizeof(WAVEFORMATEX) + (pwfx->wFormatTag == WAVE_FORMAT_PCM ? 0 : pwfx->cbSize);
+		recorder.attachMetrics(&pipelineMetrics);
+		if (!recorder.start(outputWavFile, reinterpret_cast<const uint8_t*>(pwfx), fmtSize, recorderConfig)) {
+			OutputDebugStringW(L"[AudioCapture] cannot create recording file, recording disabled\n");
+		}
+	}
+	// ¼ƬΣȫݰƬ̵߳ʷ¼ʱȡǰһ
+	if (clipCapture) {
+		size_t fmtSize = sizeof(WAVEFORMATEX) + (pwfx->wFormatTag == WAVE_FORMAT_PCM ? 0 : pwfx->cbSize);
+		clips.attachMetrics(&pipelineMetrics);
+		if (!clips.start(reinterpret_cast<const uint8_t*>(pwfx), fmtSize, bufferFrames, clipConfig)) {
+			OutputDebugStringW(L"[AudioCapture] cannot create clip sidecar, clip capture disabled\n");
+		}
+	}
+
 	hr = pAudioClient->GetService(__uuidof(IAudioCaptureClient),
 		reinterpret_cast<void**>(&pCaptureClient));
 	if (FAILED(hr)) return;
@@ -120,8 +164,7 @@ void AudioCapture::captureThread() {
 	hr = pAudioClient->Start();
 	if (FAILED(hr)) return;
 
-	const int kEmptyThreshold = 300;  // ۼƿֵ֡
-	int _emptyCount = 0;               // ֡
+	captureState = CaptureState::Running;
 
 	while (running) {
 		UINT32 packetLength = 0;
@@ -132,39 +175,56 @@ void AudioCapture::captureThread() {
 			BYTE* pData = nullptr;
 			UINT32 numFrames = 0;
 			DWORD flags = 0;
+			UINT64 qpcPosition = 0;  // Ƶɼʱ QPC100 뵥λ
 
-			hr = pCaptureClient->GetBuffer(&pData, &numFrames, &flags, nullptr, nullptr);
+			hr = pCaptureClient->GetBuffer(&pData, &numFrames, &flags, nullptr, &qpcPosition);
 			if (FAILED(hr)) break;
 
-			if (numFrames > 0 && !(flags & AUDCLNT_BUFFERFLAGS_SILENT)) {
-				if (hasHighFreqContent(pData, numFrames, pwfx)) {
-					AudioFrame frame;
-					frame.data.resize(numFrames * pwfx->nBlockAlign);
-					memcpy(frame.data.data(), pData, numFrames * pwfx->nBlockAlign);
-
-					// ͵ģͷ
-					{
-						std::lock_guard<std::mutex> lock(modelMutex);
-						modelQueue.push(frame);
-					}
-					modelCV.notify_one();
-
-					// ͵
-					{
-						std::lock_guard<std::mutex> lock(saveMutex);
-						saveQueue.push(frame);
-					}
-					saveCV.notify_one();
-				}
-			}
+			pipelineMetrics.add(Metric::PacketsCaptured);
+			if (flags & AUDCLNT_BUFFERFLAGS_SILENT) pipelineMetrics.add(Metric::SilentPackets);
+			if (flags & AUDCLNT_BUFFERFLAGS_DATA_DISCONTINUITY) pipelineMetrics.add(Metric::Discontinuities);
 
-			if (!(flags & AUDCLNT_BUFFERFLAGS_SILENT)) {
-				_emptyCount++;
+			// Ƭʷȫݰݣ
+			const uint64_t packetPosition = pipeline.streamPosition();
+			if (clips.isRunning()) {
+				clips.pushAudio((flags & AUDCLNT_BUFFERFLAGS_SILENT) ? nullptr : pData, numFrames, packetPosition);
 			}
-			if (_emptyCount >= kEmptyThreshold) {
-				// ֪֡ͨ,
-				PostMessage(mainWindowHandle, WM_USER + 101, 0, 0);
-				_emptyCount=0;
+
+			// 롢֡֡ʱǿһ֡
+			uint64_t busyStart = PipelineMetrics::nowNs();
+			const AnalyzedFrame* strongest = pipeline.processPacket(pData, numFrames,
+				(flags & AUDCLNT_BUFFERFLAGS_SILENT) != 0);
+			pipelineMetrics.add(Metric::CaptureBusyNs, PipelineMetrics::nowNs() - busyStart);
+			pipelineMetrics.set(Metric::FramesSilent, pipeline.framesSkipped());
+			pipelineMetrics.set(Metric::FramesGated, pipeline.framesGated());
+			pipelineMetrics.set(Metric::FramesAnalyzed, pipeline.framesAnalyzed());
+			pipelineMetrics.set(Metric::FramesTriggered, pipeline.framesTriggered());
+
+			// λ㣬ԭʼݰУʱ߳
+			if (strongest) {
+				pipelineMetrics.add(Metric::DetectorHits);
+				if (latencyTracer.enabled) {
+					// steady_clock  MSVC ϻ QPC豸ʱͬһ׼δṩʱ˻Ϊǰʱ
+					latencyTracer.markAt(strongest->offset, TraceStage::DeviceCapture,
+						qpcPosition ? qpcPosition * 100 : latencyTracer.now());
+					latencyTracer.mark(strongest->offset, TraceStage::Detected);
+				}
+				if (AnalyzedFrame* slot = modelRing.acquire()) {
+					*slot = *strongest;
+					slot->captureNs = frameCaptureNs(qpcPosition ? qpcPosition * 100 : PipelineMetrics::nowNs(),
+						packetPosition, strongest->offset, pwfx->nSamplesPerSec);
+					modelRing.publish();
+					SetEvent(modelEvent);
+					size_t depth = modelRing.size();
+					pipelineMetrics.set(Metric::ModelQueueDepth, depth);
+					pipelineMetrics.raise(Metric::ModelQueueHighWater, depth);
+				}
+				else {
+					pipelineMetrics.add(Metric::ModelQueueDrops);
+				}
+
+				// ƽ¼أʱ
+				if (recorder.isRecording()) recorder.append(pData, static_cast<size_t>(numFrames) * pwfx->nBlockAlign);
 			}
 
 			hr = pCaptureClient->ReleaseBuffer(numFrames);
@@ -187,31 +247,59 @@ void AudioCapture::captureThread() {
 
 // ģ̣߳Ƶ & λ
 void AudioCapture::myThread() {
-
-	while (running || !modelQueue.empty()) {
-		std::unique_lock<std::mutex> lock(modelMutex);
-
-		modelCV.wait(lock, [this] { return !modelQueue.empty() || !running; });
-
-		if (!modelQueue.empty()) {
-			auto frame = std::move(modelQueue.front());
-			modelQueue.pop();
-			lock.unlock();
-
-			AudioEvent event;
-			event.data = frame.data;
-			event.highFreq = hasHighFreqContent(event.data.data(),
-				static_cast<uint32_t>(event.data.size() / pwfx->nBlockAlign),
-				pwfx);
-			event.angle = getGunshotAngle(event.data.data(),
-				static_cast<uint32_t>(event.data.size() / pwfx->nBlockAlign),
-				pwfx);
-
-			// Ƶ¼֪ͨ
-			if (event.highFreq) {
-				PostMessage(mainWindowHandle, WM_USER + 100, 0, reinterpret_cast<LPARAM>(new AudioEvent(event)));
+	direction.mode = directionMode;
+	direction.prepare(analysisFrameSize);
+	scheduler.deadline = analysisDeadline;
+
+	// Ƶ RMS ڲ߳ãֻλ
+	auto locate = [&](const AnalyzedFrame& frame, uint64_t) {
+		OverlayEvent event;
+		event.streamOffset = frame.offset;
+		latencyTracer.mark(event.streamOffset, TraceStage::Dequeued);
+		uint64_t busyStart = PipelineMetrics::nowNs();
+		DirectionResult result = getGunshotDirection(frame);
+		event.angle = result.angle;
+		event.confidence = result.confidence;
+		event.lowBandEnergy = frame.lowBandEnergy;
+		event.highBandEnergy = frame.highBandEnergy;
+		event.highFreqRatio = frame.highFreqRatio;
+		event.highFreq = frame.highFreq;
+		event.sourceCount = static_cast<uint8_t>((std::min)(result.sourceCount, static_cast<size_t>(OverlayEvent::kMaxSources)));
+		for (size_t i = 0; i < event.sourceCount; ++i) {
+			event.sources[i].angle = static_cast<int8_t>(std::lround(result.sources[i].angle));
+			event.sources[i].confidence = static_cast<uint8_t>(std::lround(result.sources[i].confidence * 255.0f));
+		}
+		event.timeNs = PipelineMetrics::nowNs();
+		pipelineMetrics.add(Metric::AnalysisBusyNs, event.timeNs - busyStart);
+		latencyTracer.mark(event.streamOffset, TraceStage::Located);
+
+		// Ƶ¼д䣻ֻɿձΪǿգ߳ûдĻѣʱŷϢ
+		if (event.highFreq) {
+			latencyTracer.mark(event.streamOffset, TraceStage::Posted);
+			pipelineMetrics.add(Metric::EventsPosted);
+			if (eventMailbox.push(event) && !PostMessage(mainWindowHandle, WM_USER + 100, 0, 0)) {
+				eventMailbox.cancelWake();
 			}
+			pipelineMetrics.set(Metric::MailboxDrops, eventMailbox.droppedCount());
+			if (clips.isRunning()) clips.pushEvent(event);
 		}
+	};
+
+	while (true) {
+		if (modelRing.empty()) {
+			if (!running) break;
+			WaitForSingleObject(modelEvent, 10);
+			continue;
+		}
+
+		// ڵ֡ѹ֡ϲֻΪϵϽֹʱ֡㷽λ
+		scheduler.drain(modelRing, &PipelineMetrics::nowNs, locate);
+		pipelineMetrics.set(Metric::ModelQueueDepth, modelRing.size());
+		pipelineMetrics.set(Metric::StaleDrops, scheduler.staleDrops());
+		pipelineMetrics.set(Metric::FramesMerged, scheduler.mergedFrames());
+		pipelineMetrics.set(Metric::LateEvents, scheduler.lateEvents());
+		pipelineMetrics.set(Metric::EventLatencyUs, scheduler.lastLatencyNs() / 1000);
+		pipelineMetrics.set(Metric::EventLatencyMaxUs, scheduler.maxLatencyNs() / 1000);
 	}
 }
 
@@ -223,107 +311,10 @@ void AudioCapture::setMainWindowHandle(HWND hwnd) {
 	mainWindowHandle = hwnd;
 }
 
-// 㷽λ
-float AudioCapture::getGunshotAngle(const uint8_t* pData, uint32_t numFrames, WAVEFORMATEX* pwfx) {
-	if (!pData || !pwfx || pwfx->nChannels < 2 || numFrames == 0) return 0.0f;
-
-	double sumSqLeft = 0.0, sumSqRight = 0.0;
-	if (pwfx->wBitsPerSample == 16) {
-		const int16_t* src = reinterpret_cast<const int16_t*>(pData);
-		for (uint32_t i = 0; i < numFrames; ++i) {
-			float l = static_cast<float>(src[i * pwfx->nChannels + 0]) / 32768.0f;
-			float r = static_cast<float>(src[i * pwfx->nChannels + 1]) / 32768.0f;
-			sumSqLeft += l * l;
-			sumSqRight += r * r;
-		}
-	}
-	else if (pwfx->wBitsPerSample == 32) {
-		const float* src = reinterpret_cast<const float*>(pData);
-		for (uint32_t i = 0; i < numFrames; ++i) {
-			float l = src[i * pwfx->nChannels + 0];
-			float r = src[i * pwfx->nChannels + 1];
-			sumSqLeft += l * l;
-			sumSqRight += r * r;
-		}
-	}
-
-	double rmsLeft = std::sqrt(sumSqLeft / numFrames);
-	double rmsRight = std::sqrt(sumSqRight / numFrames);
-	if (rmsLeft < 1e-6 && rmsRight < 1e-6) return 0.0f;
-
-	double dbDiff = 20.0 * std::log10((rmsRight + 1e-9) / (rmsLeft + 1e-9));
-	double maxDb = 20.0;
-	double angle = (dbDiff / maxDb) * 90.0;
-	angle = (angle < -90.0) ? -90.0 : ((angle > 90.0) ? 90.0 : angle);
-	return static_cast<float>(angle);
-}
-
-//  WAV ļʽд룩
-void AudioCapture::savePcmWavStreaming() {
-	if (!pwfx) return;
-
-	std::ofstream ofs(outputWavFile, std::ios::binary);
-	if (!ofs.is_open()) return;
-
-	uint16_t wFormatTag = pwfx->wFormatTag;
-	if (pwfx->wFormatTag == WAVE_FORMAT_EXTENSIBLE) {
-		WAVEFORMATEXTENSIBLE* pExt = reinterpret_cast<WAVEFORMATEXTENSIBLE*>(pwfx);
-		if (pExt->SubFormat == KSDATAFORMAT_SUBTYPE_PCM) wFormatTag = WAVE_FORMAT_PCM;
-		else if (pExt->SubFormat == KSDATAFORMAT_SUBTYPE_IEEE_FLOAT) wFormatTag = WAVE_FORMAT_IEEE_FLOAT;
-		else return;
-	}
-
-	uint16_t blockAlign = pwfx->nChannels * pwfx->wBitsPerSample / 8;
-	uint32_t avgBytesPerSec = blockAlign * pwfx->nSamplesPerSec;
-
-	uint32_t fmtChunkSize = 16;
-	uint32_t dataSize = 0;
-	uint32_t riffChunkSize = 4 + (8 + fmtChunkSize) + (8 + dataSize);
-
-	// д WAV ͷ
-	ofs.write("RIFF", 4);
-	ofs.write(reinterpret_cast<const char*>(&riffChunkSize), 4);
-	ofs.write("WAVE", 4);
-
-	ofs.write("fmt ", 4);
-	ofs.write(reinterpret_cast<const char*>(&fmtChunkSize), 4);
-	ofs.write(reinterpret_cast<const char*>(&wFormatTag), 2);
-	ofs.write(reinterpret_cast<const char*>(&pwfx->nChannels), 2);
-	ofs.write(reinterpret_cast<const char*>(&pwfx->nSamplesPerSec), 4);
-	ofs.write(reinterpret_cast<const char*>(&avgBytesPerSec), 4);
-	ofs.write(reinterpret_cast<const char*>(&blockAlign), 2);
-	ofs.write(reinterpret_cast<const char*>(&pwfx->wBitsPerSample), 2);
-
-	ofs.write("data", 4);
-	ofs.write(reinterpret_cast<const char*>(&dataSize), 4);
-
-	uint32_t totalDataSize = 0;
-
-	// ѭд PCM 
-	while (running || !saveQueue.empty()) {
-		std::unique_lock<std::mutex> lock(saveMutex);
-		saveCV.wait(lock, [this] { return !saveQueue.empty() || !running; });
-
-		if (!saveQueue.empty()) {
-			auto frame = std::move(saveQueue.front());
-			saveQueue.pop();
-			lock.unlock();
-
-			ofs.write(reinterpret_cast<const char*>(frame.data.data()), frame.data.size());
-			totalDataSize += static_cast<uint32_t>(frame.data.size());
-		}
-	}
-
-	//  WAV ļͷ
-	ofs.seekp(4, std::ios::beg);
-	uint32_t riffSize = 4 + (8 + fmtChunkSize) + (8 + totalDataSize);
-	ofs.write(reinterpret_cast<const char*>(&riffSize), 4);
-
-	ofs.seekp(40, std::ios::beg);
-	ofs.write(reinterpret_cast<const char*>(&totalDataSize), 4);
-
-	ofs.close();
-	std::cout << "Saved WAV file: " << outputWavFile << " (streaming mode)" << std::endl;
+// Լ ItdIld ģʽµ GCC-PHAT ʱ㷽λ
+DirectionResult AudioCapture::getGunshotDirection(const AnalyzedFrame& frame) {
+	if (!pwfx || pwfx->nChannels < 2 || frame.mono.empty()) return DirectionResult();
+	return direction.estimate(frame);
 }
 
 
@@ -0,0 +1,409 @@
+﻿#include "BatchAnalyzer.h"
+#include "MappedFile.h"
+#include "WavFile.h"
+#include "WorkStealingPool.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <memory>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX   // std::min / std::max 不被 windows.h 的宏替换
+#endif
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+namespace {
+	const uint32_t kDecodeFrames = 4096;  // 每次送入流水线的采样帧数（与模拟的数据包大小无关）
+
+	void put32(uint8_t* p, uint32_t x) {
+		for (int i = 0; i < 4; ++i) p[i] = static_cast<uint8_t>(x >> (8 * i));
+	}
+
+	void putFloat(uint8_t* p, float f) {
+		uint32_t x;
+		std::memcpy(&x, &f, 4);
+		put32(p, x);
+	}
+
+	bool hasWavExtension(const std::string& name) {
+		if (name.size() < 4) return false;
+		std::string ext = name.substr(name.size() - 4);
+		for (char& c : ext) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+		return ext == ".wav";
+	}
+
+	// 一个输入文件：映射在所有块完成前保持有效，块结果按块号存放，最后完成的块负责合并
+	struct FileJob {
+		BatchFileResult result;
+		MappedFile source;
+		const uint8_t* pcm = nullptr;
+		std::vector<std::vector<BatchEvent>> chunks;
+		std::atomic<uint32_t> remaining{ 0 };
+	};
+
+	// 每组参数在当前数据包内的最强触发帧
+	struct Candidate {
+		bool valid = false;
+		BatchEvent event;
+	};
+}
+
+#if defined(_WIN32)
+
+namespace {
+	std::wstring widen(const std::string& s) {
+		int n = MultiByteToWideChar(CP_UTF8, 0, s.c_str(), -1, nullptr, 0);
+		std::wstring w(n > 0 ? n : 0, L'\0');
+		if (n > 0) MultiByteToWideChar(CP_UTF8, 0, s.c_str(), -1, &w[0], n);
+		if (!w.empty()) w.pop_back();
+		return w;
+	}
+
+	std::string narrow(const wchar_t* w) {
+		int n = WideCharToMultiByte(CP_UTF8, 0, w, -1, nullptr, 0, nullptr, nullptr);
+		std::string s(n > 0 ? n : 0, '\0');
+		if (n > 0) WideCharToMultiByte(CP_UTF8, 0, w, -1, &s[0], n, nullptr, nullptr);
+		if (!s.empty()) s.pop_back();
+		return s;
+	}
+
+	void collect(const std::string& path, std::vector<std::string>& out) {
+		DWORD attributes = GetFileAttributesW(widen(path).c_str());
+		if (attributes == INVALID_FILE_ATTRIBUTES) return;
+		if (!(attributes & FILE_ATTRIBUTE_DIRECTORY)) {
+			out.push_back(path);
+			return;
+		}
+		WIN32_FIND_DATAW data;
+		HANDLE find = FindFirstFileW(widen(path + "\\*").c_str(), &data);
+		if (find == INVALID_HANDLE_VALUE) return;
+		do {
+			std::string name = narrow(data.cFileName);
+			if (name == "." || name == "..") continue;
+			std::string child = path + "\\" + name;
+			if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) collect(child, out);
+			else if (hasWavExtension(name)) out.push_back(child);
+		} while (FindNextFileW(find, &data));
+		FindClose(find);
+	}
+}
+
+#else
+
+namespace {
+	void collect(const std::string& path, std::vector<std::string>& out) {
+		struct stat st;
+		if (stat(path.c_str(), &st) != 0) return;
+		if (!S_ISDIR(st.st_mode)) {
+			out.push_back(path);
+			return;
+		}
+		DIR* dir = opendir(path.c_str());
+		if (!dir) return;
+		while (dirent* entry = readdir(dir)) {
+			std::string name = entry->d_name;
+			if (name == "." || name == "..") continue;
+			std::string child = path + "/" + name;
+			if (stat(child.c_str(), &st) != 0) continue;
+			if (S_ISDIR(st.st_mode)) collect(child, out);
+			else if (hasWavExtension(name)) out.push_back(child);
+		}
+		closedir(dir);
+	}
+}
+
+#endif
+
+void collectWavFiles(const std::string& path, std::vector<std::string>& out) {
+	size_t start = out.size();
+	collect(path, out);
+	std::sort(out.begin() + start, out.end());
+}
+
+void DetectorSweep::configure(const std::vector<DetectorParams>& sets, uint32_t frameSize, uint32_t sampleRate,
+	float windowSum) {
+	sets_ = sets;
+	halfBins_ = frameSize / 2;
+	frameSize_ = frameSize;
+	sampleRate_ = sampleRate;
+	power_.assign(halfBins_, 0.0f);
+	decisions_.assign(sets.size(), Decision());
+	hysteresis_.assign(sets.size(), TriggerHysteresis());
+	bands_.clear();
+	counts_.clear();
+	setCount_.assign(sets.size(), 0);
+	if (windowSum <= 0.0f) windowSum = static_cast<float>(frameSize);
+	powerScale_ = 1.0f / (windowSum * windowSum);
+
+	// 与 FrameAnalyzer 相同的表达式求频点频率与阈值，分组边界与逐组运行时完全一致
+	const float freqStep = static_cast<float>(sampleRate) / frameSize;
+	for (size_t s = 0; s < sets.size(); ++s) {
+		size_t first = 0;
+		while (first < halfBins_ && first * freqStep < sets[s].highFreqMin) ++first;
+		size_t band = 0;
+		while (band < bands_.size() && bands_[band].firstBin != first) ++band;
+		if (band == bands_.size()) {
+			Band b = { first, 0.0f, 0.0f, halfBins_ - first };
+			bands_.push_back(b);
+		}
+		const float threshold = sets[s].highFreqEpsilon * sets[s].highFreqEpsilon;
+		const bool adaptive = sets[s].adaptiveFloor;
+		auto sameFloor = [&](const Count& c) {
+			if (!c.adaptive || !adaptive) return c.adaptive == adaptive;
+			return c.floorParams.floorMarginDb == sets[s].floorMarginDb
+				&& c.floorParams.floorRiseSeconds == sets[s].floorRiseSeconds
+				&& c.floorParams.floorFallSeconds == sets[s].floorFallSeconds;
+		};
+		size_t count = 0;
+		while (count < counts_.size() && (counts_[count].band != band || counts_[count].threshold != threshold
+			|| !sameFloor(counts_[count]))) ++count;
+		if (count == counts_.size()) {
+			counts_.emplace_back();
+			counts_.back().band = band;
+			counts_.back().threshold = threshold;
+			counts_.back().adaptive = adaptive;
+			counts_.back().floorParams = sets[s];
+			if (adaptive) counts_.back().floor.prepare(halfBins_ - first);
+		}
+		setCount_[s] = count;
+	}
+}
+
+bool DetectorSweep::evaluate(const AnalyzedFrame& frame) {
+	const size_t n = std::min(halfBins_, frame.spectrum.size());
+	for (size_t i = 0; i < n; ++i) power_[i] = std::norm(frame.spectrum[i]) * powerScale_;
+	for (size_t i = n; i < halfBins_; ++i) power_[i] = 0.0f;
+
+	// 低频与高频能量各自按频点升序累加，求和顺序与 FrameAnalyzer 相同
+	for (Band& b : bands_) {
+		float low = 0.0f, high = 0.0f;
+		for (size_t i = 0; i < b.firstBin; ++i) low += power_[i];
+		for (size_t i = b.firstBin; i < halfBins_; ++i) high += power_[i];
+		b.low = low;
+		b.high = high;
+	}
+	for (Count& c : counts_) {
+		const size_t first = bands_[c.band].firstBin;
+		if (c.adaptive) {
+			if (first < halfBins_) {
+				c.above = c.floor.countAbove(power_.data() + first, halfBins_ - first, c.threshold, frame.offset,
+					sampleRate_, frameSize_, c.floorParams);
+			}
+			continue;
+		}
+		size_t above = 0;
+		for (size_t i = first; i < halfBins_; ++i) above += power_[i] > c.threshold;
+		c.above = above;
+	}
+
+	bool any = false;
+	for (size_t s = 0; s < sets_.size(); ++s) {
+		const Count& c = counts_[setCount_[s]];
+		const Band& b = bands_[c.band];
+		Decision& d = decisions_[s];
+		d.lowBandEnergy = b.low;
+		d.highBandEnergy = b.high;
+		d.highFreqRatio = b.bins ? static_cast<float>(c.above) / b.bins : 0.0f;
+		if (sets_[s].adaptiveFloor) {
+			const float on = sets_[s].highFreqRatio;
+			d.highFreq = b.bins && hysteresis_[s].update(d.highFreqRatio, on, on * sets_[s].releaseRatio);
+		}
+		else {
+			d.highFreq = b.bins && d.highFreqRatio >= sets_[s].highFreqRatio;
+		}
+		any = any || d.highFreq;
+	}
+	return any;
+}
+
+bool analyzeFiles(const std::vector<std::string>& paths, const BatchConfig& config,
+	const std::function<void(const BatchFileResult&)>& onFile, BatchStats* stats) {
+	typedef std::chrono::steady_clock Clock;
+	Clock::time_point startTime = Clock::now();
+	const uint32_t F = config.frameSize, H = config.hopSize, P = config.packetFrames;
+	if (F < 4 || H == 0 || H > F || P == 0 || config.chunkPackets == 0) return false;
+	const std::vector<DetectorParams> sets = config.paramSets.empty()
+		? std::vector<DetectorParams>(1) : config.paramSets;
+	// 噪声底与迟滞依赖此前的全部帧，含自适应参数组时不在文件内切块（仍按文件并行）
+	bool adaptive = false;
+	for (const DetectorParams& p : sets) adaptive = adaptive || p.adaptiveFloor;
+
+	std::atomic<uint32_t> files{ 0 }, failed{ 0 }, chunks{ 0 };
+	std::atomic<uint64_t> inputBytes{ 0 }, audioMicros{ 0 };
+
+	auto finish = [&](FileJob& job) {
+		for (std::vector<BatchEvent>& c : job.chunks) {
+			job.result.events.insert(job.result.events.end(), c.begin(), c.end());
+			std::vector<BatchEvent>().swap(c);
+		}
+		job.source.close();
+		if (job.result.ok) ++files;
+		else ++failed;
+		if (onFile) onFile(job.result);
+	};
+
+	// 一块：packetBegin ~ packetEnd 的数据包内输出的全部分析帧（帧的最后一个样本所在的数据包即输出它的数据包）
+	auto runChunk = [&](FileJob& job, uint32_t index, uint64_t packetBegin, uint64_t packetEnd) {
+		const StreamFormat& fmt = job.result.format;
+		const uint64_t total = job.result.frames;
+		uint64_t firstFrame = packetBegin * P + 1 > F ? (packetBegin * P + 1 - F + H - 1) / H : 0;
+		uint64_t limit = std::min<uint64_t>(packetEnd * P, total);
+		uint64_t endFrame = limit >= F ? (limit - F) / H + 1 : 0;
+		std::vector<BatchEvent>& events = job.chunks[index];
+		if (firstFrame >= endFrame) return;
+
+		// 判定全部由 sweep 完成，流水线的分析器不必跟踪噪声底
+		DetectorParams pipelineParams = sets[0];
+		pipelineParams.adaptiveFloor = false;
+		DetectorPipeline pipeline;
+		pipeline.configure(fmt, F, H, pipelineParams, kDecodeFrames);
+		double windowSum = 0.0;
+		for (float w : pipeline.window()) windowSum += w;
+		DetectorSweep sweep;
+		sweep.configure(sets, F, fmt.sampleRate, static_cast<float>(windowSum));
+		DirectionEstimator direction;
+		direction.mode = config.directionMode;
+		direction.prepare(F);
+
+		std::vector<Candidate> candidates(sets.size());
+		uint64_t packet = (firstFrame * H + F - 1) / P;
+		auto flush = [&]() {
+			for (Candidate& c : candidates) {
+				if (c.valid) events.push_back(c.event);
+				c.valid = false;
+			}
+		};
+		const uint64_t base = firstFrame * H;
+		auto onFrame = [&](const AnalyzedFrame& frame) {
+			uint64_t offset = base + frame.offset;
+			uint64_t framePacket = (offset + F - 1) / P;
+			if (framePacket != packet) {
+				flush();
+				packet = framePacket;
+			}
+			if (!sweep.evaluate(frame)) return;
+			DirectionResult dir = direction.estimate(frame);
+			for (size_t s = 0; s < sweep.size(); ++s) {
+				const DetectorSweep::Decision& d = sweep.decision(s);
+				if (!d.highFreq) continue;
+				Candidate& c = candidates[s];
+				if (c.valid && !(d.highBandEnergy > c.event.highBandEnergy)) continue;
+				c.valid = true;
+				c.event.paramSet = static_cast<uint32_t>(s);
+				c.event.frame = offset;
+				c.event.timeSeconds = fmt.sampleRate ? static_cast<double>(offset) / fmt.sampleRate : 0.0;
+				c.event.angle = dir.angle;
+				c.event.confidence = dir.confidence;
+				c.event.highFreqRatio = d.highFreqRatio;
+				c.event.highBandEnergy = d.highBandEnergy;
+				c.event.lowBandEnergy = d.lowBandEnergy;
+			}
+		};
+
+		const uint64_t samples = (endFrame - 1 - firstFrame) * H + F;
+		const uint8_t* pcm = job.pcm + static_cast<size_t>(base) * fmt.blockAlign;
+		for (uint64_t pos = 0; pos < samples; pos += kDecodeFrames) {
+			uint32_t n = static_cast<uint32_t>(std::min<uint64_t>(kDecodeFrames, samples - pos));
+			pipeline.analyzePacket(pcm + static_cast<size_t>(pos) * fmt.blockAlign, n, onFrame);
+		}
+		flush();
+	};
+
+	WorkStealingPool pool(config.threads);
+	for (const std::string& path : paths) {
+		pool.submit([&, path]() {
+			std::shared_ptr<FileJob> job = std::make_shared<FileJob>();
+			job->result.path = path;
+			size_t offset = 0, size = 0;
+			if (!job->source.openReadOnly(path)) {
+				job->result.error = "cannot open file";
+				finish(*job);
+				return;
+			}
+			if (!locateWavData(static_cast<const uint8_t*>(job->source.data()), job->source.size(),
+				job->result.format, offset, size, &job->result.error)) {
+				finish(*job);
+				return;
+			}
+			job->result.ok = true;
+			job->pcm = static_cast<const uint8_t*>(job->source.data()) + offset;
+			job->result.frames = size / job->result.format.blockAlign;
+			inputBytes += size;
+			audioMicros += job->result.frames * 1000000ull / std::max<uint32_t>(job->result.format.sampleRate, 1);
+
+			const uint64_t packets = (job->result.frames + P - 1) / P;
+			const uint64_t chunkPackets = adaptive ? std::max<uint64_t>(packets, 1) : config.chunkPackets;
+			const uint32_t count = static_cast<uint32_t>((packets + chunkPackets - 1) / chunkPackets);
+			if (count == 0) {
+				finish(*job);
+				return;
+			}
+			job->chunks.resize(count);
+			job->remaining.store(count);
+			chunks += count;
+			// 块任务压入本线程队列：本线程按后进先出处理，其他线程空闲时从队头窃取
+			for (uint32_t i = 0; i < count; ++i) {
+				uint64_t begin = static_cast<uint64_t>(i) * chunkPackets;
+				uint64_t end = std::min<uint64_t>(packets, begin + chunkPackets);
+				pool.submit([&, job, i, begin, end]() {
+					runChunk(*job, i, begin, end);
+					if (job->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) finish(*job);
+				});
+			}
+		});
+	}
+	pool.wait();
+
+	if (stats) {
+		stats->files = files;
+		stats->failed = failed;
+		stats->chunks = chunks;
+		stats->inputBytes = inputBytes;
+		stats->audioSeconds = audioMicros / 1e6;
+		stats->seconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+		stats->steals = pool.steals();
+		stats->threads = pool.threadCount();
+	}
+	return true;
+}
+
+void writeEventsCsv(std::ostream& out, const BatchFileResult& result) {
+	out << "param_set,frame,time_s,angle,confidence,high_freq_ratio,high_band_energy,low_band_energy\n";
+	for (const BatchEvent& e : result.events) {
+		out << e.paramSet << ',' << e.frame << ',' << e.timeSeconds << ',' << e.angle << ',' << e.confidence << ','
+			<< e.highFreqRatio << ',' << e.highBandEnergy << ',' << e.lowBandEnergy << '\n';
+	}
+}
+
+// 头：magic | version | sampleRate | paramSets | eventCount(8)
+// 记录（32 字节）：paramSet | frame(8) | angle | confidence | highFreqRatio | highBandEnergy | lowBandEnergy
+void writeEventsBinary(std::ostream& out, const BatchFileResult& result, uint32_t paramSets) {
+	uint8_t header[24];
+	std::memcpy(header, "ACEV", 4);
+	put32(header + 4, 1);
+	put32(header + 8, result.format.sampleRate);
+	put32(header + 12, paramSets);
+	put32(header + 16, static_cast<uint32_t>(result.events.size()));
+	put32(header + 20, static_cast<uint32_t>(static_cast<uint64_t>(result.events.size()) >> 32));
+	out.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+	uint8_t record[32];
+	for (const BatchEvent& e : result.events) {
+		put32(record, e.paramSet);
+		put32(record + 4, static_cast<uint32_t>(e.frame));
+		put32(record + 8, static_cast<uint32_t>(e.frame >> 32));
+		putFloat(record + 12, e.angle);
+		putFloat(record + 16, e.confidence);
+		putFloat(record + 20, e.highFreqRatio);
+		putFloat(record + 24, e.highBandEnergy);
+		putFloat(record + 28, e.lowBandEnergy);
+		out.write(reinterpret_cast<const char*>(record), sizeof(record));
+	}
+}
@@ -0,0 +1,232 @@
+﻿#include "ClipRecorder.h"
+#include "WavRecorder.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+	uint32_t readU16(const uint8_t* p) {
+		return static_cast<uint32_t>(p[0] | (p[1] << 8));
+	}
+
+	uint32_t readU32(const uint8_t* p) {
+		return readU16(p) | (readU16(p + 2) << 16);
+	}
+
+	const size_t kEventSlots = 256;
+}
+
+std::string ClipRecorder::clipPath(const std::string& prefix, uint64_t clipId) {
+	char id[32];
+	std::snprintf(id, sizeof(id), "%06llu", static_cast<unsigned long long>(clipId));
+	return prefix + id + ".wav";
+}
+
+bool ClipRecorder::start(const uint8_t* fmt, size_t fmtSize, uint32_t maxPacketFrames, const ClipConfig& config) {
+	stop();
+	if (!fmt || fmtSize < 16 || maxPacketFrames == 0) return false;
+
+	config_ = config;
+	fmt_.assign(fmt, fmt + fmtSize);
+	blockAlign_ = std::max<uint32_t>(1, readU16(fmt + 12));
+	double rate = readU32(fmt + 4);
+	preFrames_ = static_cast<uint64_t>(std::max(0.0, config.preRollSeconds) * rate);
+	postFrames_ = static_cast<uint64_t>(std::max(0.0, config.postRollSeconds) * rate);
+	maxClipFrames_ = std::max<uint64_t>(static_cast<uint64_t>(std::max(0.0, config.maxClipSeconds) * rate), preFrames_ + postFrames_);
+
+	// 历史至少容纳一个最长片段与一个数据包，否则 preRoll 在片段写出前就被覆盖
+	historyFrames_ = std::max<uint64_t>(static_cast<uint64_t>(std::max(0.0, config.historySeconds) * rate),
+		maxClipFrames_ + maxPacketFrames);
+	history_.assign(static_cast<size_t>(historyFrames_ * blockAlign_), 0);
+	historyBegin_ = historyEnd_ = 0;
+	haveHistory_ = false;
+	pending_.clear();
+	nextClipId_ = 0;
+
+	sidecar_.open(config.sidecarPath, std::ios::trunc);
+	if (!sidecar_.is_open()) return false;
+	sidecar_ << "clip,file,sequence,trigger_frame,trigger_time_s,clip_begin_frame,clip_frames,time_ns,"
+		"angle,confidence,low_band_energy,high_band_energy,high_freq_ratio\n";
+	sidecar_.flush();
+
+	audio_.reset(config.packetSlots);
+	audio_.forEachSlot([&](Packet& slot) {
+		slot.data.resize(static_cast<size_t>(maxPacketFrames) * blockAlign_);
+	});
+	events_.reset(kEventSlots);
+	clipsWritten_.store(0, std::memory_order_relaxed);
+	truncated_.store(0, std::memory_order_relaxed);
+	stopping_.store(false, std::memory_order_relaxed);
+
+	thread_ = std::thread(&ClipRecorder::worker, this);
+	return true;
+}
+
+void ClipRecorder::stop() {
+	if (!thread_.joinable()) return;
+	stopping_.store(true, std::memory_order_release);
+	wake_.notify_one();
+	thread_.join();
+	sidecar_.close();
+	history_.clear();
+	history_.shrink_to_fit();
+}
+
+bool ClipRecorder::pushAudio(const void* data, uint32_t frames, uint64_t streamFrame) {
+	Packet* slot = audio_.acquire();
+	size_t bytes = static_cast<size_t>(frames) * blockAlign_;
+	if (!slot || bytes > slot->data.size()) {
+		if (metrics_) metrics_->add(Metric::ClipDrops);
+		return false;
+	}
+	slot->silent = data == nullptr;
+	if (data) std::memcpy(slot->data.data(), data, bytes);
+	slot->frames = frames;
+	slot->streamFrame = streamFrame;
+	audio_.publish();
+	return true;
+}
+
+bool ClipRecorder::pushEvent(const OverlayEvent& event) {
+	OverlayEvent* slot = events_.acquire();
+	if (!slot) {
+		if (metrics_) metrics_->add(Metric::ClipDrops);
+		return false;
+	}
+	*slot = event;
+	events_.publish();
+	wake_.notify_one();
+	return true;
+}
+
+// 片段线程：逐个数据包并入历史；每个数据包之前先取事件，写完结束位置已到齐的片段，历史不会先于片段被覆盖
+void ClipRecorder::worker() {
+	auto takeEvents = [&]() {
+		while (OverlayEvent* event = events_.front()) {
+			addEvent(*event);
+			events_.pop();
+		}
+	};
+	// 事件按触发顺序到达，pending_ 中片段的结束位置单调递增
+	auto flushReady = [&](bool all) {
+		while (!pending_.empty() && (all || pending_.front().end <= historyEnd_)) {
+			writeClip(pending_.front(), std::min(pending_.front().end, historyEnd_));
+			pending_.pop_front();
+		}
+	};
+
+	while (true) {
+		bool stopping = stopping_.load(std::memory_order_acquire);  // 先读停止标志，再取空队列
+		while (Packet* packet = audio_.front()) {
+			takeEvents();
+			appendHistory(*packet);
+			audio_.pop();
+			flushReady(false);
+		}
+		takeEvents();
+		flushReady(stopping);
+		if (stopping) break;
+		std::unique_lock<std::mutex> lock(mutex_);
+		wake_.wait_for(lock, std::chrono::milliseconds(10));
+	}
+}
+
+// 数据包并入历史：重复部分跳过，队列丢包造成的缺口补静音
+void ClipRecorder::appendHistory(const Packet& packet) {
+	if (!haveHistory_) {
+		historyBegin_ = historyEnd_ = packet.streamFrame;
+		haveHistory_ = true;
+	}
+	uint64_t packetEnd = packet.streamFrame + packet.frames;
+	if (packetEnd <= historyEnd_) return;
+
+	auto put = [&](const uint8_t* src, uint64_t frames) {
+		while (frames) {
+			uint64_t pos = historyEnd_ % historyFrames_;
+			uint64_t n = std::min(frames, historyFrames_ - pos);
+			uint8_t* dst = history_.data() + pos * blockAlign_;
+			size_t bytes = static_cast<size_t>(n * blockAlign_);
+			if (src) {
+				std::memcpy(dst, src, bytes);
+				src += bytes;
+			}
+			else {
+				std::memset(dst, 0, bytes);
+			}
+			historyEnd_ += n;
+			frames -= n;
+		}
+	};
+
+	if (packet.streamFrame > historyEnd_) {
+		uint64_t gap = packet.streamFrame - historyEnd_;
+		if (gap > historyFrames_) historyEnd_ = packet.streamFrame - historyFrames_;  // 整个历史都被缺口覆盖
+		put(nullptr, packet.streamFrame - historyEnd_);
+	}
+	uint64_t skip = historyEnd_ - packet.streamFrame;
+	put(packet.silent ? nullptr : packet.data.data() + skip * blockAlign_, packet.frames - skip);
+}
+
+// 新事件的窗口与上一个未写出的片段重叠、且合并后不超过最长时长时并入该片段（晚到的更早事件单独成片段）
+void ClipRecorder::addEvent(const OverlayEvent& event) {
+	uint64_t trigger = event.streamOffset;
+	uint64_t begin = trigger > preFrames_ ? trigger - preFrames_ : 0;
+	uint64_t end = trigger + postFrames_;
+	if (!pending_.empty()) {
+		Clip& last = pending_.back();
+		if (begin >= last.begin && begin < last.end && std::max(end, last.end) - last.begin <= maxClipFrames_) {
+			last.end = std::max(end, last.end);
+			last.events.push_back(event);
+			return;
+		}
+	}
+	Clip clip;
+	clip.id = nextClipId_++;
+	clip.begin = begin;
+	clip.end = end;
+	clip.events.push_back(event);
+	pending_.push_back(std::move(clip));
+}
+
+void ClipRecorder::writeHistory(std::ofstream& out, uint64_t begin, uint64_t end) const {
+	while (begin < end) {
+		uint64_t pos = begin % historyFrames_;
+		uint64_t n = std::min(end - begin, historyFrames_ - pos);
+		out.write(reinterpret_cast<const char*>(history_.data() + pos * blockAlign_),
+			static_cast<std::streamsize>(n * blockAlign_));
+		begin += n;
+	}
+}
+
+// 写出片段：历史中已没有的 preRoll 或停止时尚未到达的 postRoll 截掉，并计入 truncatedClips
+void ClipRecorder::writeClip(const Clip& clip, uint64_t availableEnd) {
+	uint64_t oldest = std::max(historyBegin_, historyEnd_ > historyFrames_ ? historyEnd_ - historyFrames_ : 0);
+	uint64_t begin = std::max(clip.begin, oldest);
+	uint64_t end = std::min(clip.end, availableEnd);
+	if (!haveHistory_ || end <= begin) {
+		truncated_.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+	if (begin != clip.begin || end != clip.end) truncated_.fetch_add(1, std::memory_order_relaxed);
+
+	std::string path = clipPath(config_.pathPrefix, clip.id);
+	std::ofstream out(path, std::ios::binary | std::ios::trunc);
+	if (!out.is_open()) return;
+	buildWavHeader(fmt_.data(), fmt_.size(), (end - begin) * blockAlign_, header_);
+	out.write(reinterpret_cast<const char*>(header_.data()), header_.size());
+	writeHistory(out, begin, end);
+	out.close();
+
+	double rate = readU32(fmt_.data() + 4);
+	for (const OverlayEvent& e : clip.events) {
+		sidecar_ << clip.id << ',' << path << ',' << e.sequence << ',' << e.streamOffset << ','
+			<< (rate > 0 ? e.streamOffset / rate : 0.0) << ',' << begin << ',' << (end - begin) << ','
+			<< e.timeNs << ',' << e.angle << ',' << e.confidence << ',' << e.lowBandEnergy << ','
+			<< e.highBandEnergy << ',' << e.highFreqRatio << '\n';
+	}
+	sidecar_.flush();
+
+	clipsWritten_.fetch_add(1, std::memory_order_release);
+	if (metrics_) metrics_->add(Metric::ClipsWritten);
+}
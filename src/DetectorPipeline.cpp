@@ -0,0 +1,80 @@
+﻿#include "DetectorPipeline.h"
+#include <algorithm>
+
+void reserveAnalyzedFrame(AnalyzedFrame& frame, uint32_t frameSize) {
+	const size_t bins = frameSize / 2 + 1;
+	frame.mono.resize(frameSize);
+	frame.spectrumLeft.resize(bins);
+	frame.spectrumRight.resize(bins);
+	frame.spectrum.resize(bins);
+}
+
+// 配置流水线，所有缓冲在此一次性分配
+bool DetectorPipeline::configure(const StreamFormat& fmt, uint32_t frameSize, uint32_t hopSize,
+	const DetectorParams& params, uint32_t maxPacketFrames) {
+	format_ = fmt;
+	decode_ = selectStereoDecoder(fmt);
+	framer_.configure(frameSize, hopSize);
+	analyzer_.params = params;
+	analyzer_.resetCounters();
+	analyzer_.prepare(frameSize);
+	double windowSum = 0.0;
+	for (float w : framer_.window()) windowSum += w;
+	gate_.configure(params, fmt.sampleRate, frameSize, hopSize, static_cast<float>(windowSum), maxPacketFrames);
+	audibleEnd_ = 0;
+	framesSkipped_ = 0;
+	framesGated_ = 0;
+	framesTriggered_ = 0;
+	left_.assign(maxPacketFrames, 0.0f);
+	right_.assign(maxPacketFrames, 0.0f);
+	reserveAnalyzedFrame(analyzed_, frameSize);
+	reserveAnalyzedFrame(strongest_, frameSize);
+	return decode_ != nullptr;
+}
+
+// 处理一个数据包；静音包写入全零保持流位置连续，全静音的分析帧不做变换
+const AnalyzedFrame* DetectorPipeline::processPacket(const uint8_t* data, uint32_t frames, bool silent) {
+	// 同一数据包内多个分析帧触发时，只保留高频能量最强的一帧
+	bool triggered = false;
+	auto onFrame = [&](const AnalysisFrame& frame) {
+		// 整帧都在最近一次有声数据之后：全零帧不会触发，跳过变换
+		if (frame.offset >= audibleEnd_) {
+			++framesSkipped_;
+			analyzer_.skipFrame(frame, format_.sampleRate);
+			return;
+		}
+		// 高通能量的上界达不到频谱判定所需的最小能量：不可能触发，跳过变换
+		if (!gate_.mayTrigger(frame.offset)) {
+			++framesGated_;
+			analyzer_.skipFrame(frame, format_.sampleRate);
+			return;
+		}
+		analyzer_.analyze(frame, format_.sampleRate, analyzed_);
+		if (!analyzed_.highFreq) return;
+		++framesTriggered_;
+		if (!triggered || analyzed_.highBandEnergy > strongest_.highBandEnergy) strongest_ = analyzed_;
+		triggered = true;
+	};
+
+	if (!silent && decodePacket(data, frames)) {
+		audibleEnd_ = framer_.samplesWritten() + frames;
+		gate_.process(left_.data(), right_.data(), frames);
+		framer_.push(left_.data(), right_.data(), frames, onFrame);
+	}
+	else {
+		gate_.process(nullptr, nullptr, frames);
+		framer_.pushSilence(frames, onFrame);
+	}
+
+	return triggered ? &strongest_ : nullptr;
+}
+
+bool DetectorPipeline::decodePacket(const uint8_t* data, uint32_t frames) {
+	if (!decode_ || !data || frames == 0) return false;
+	if (left_.size() < frames) {
+		left_.resize(frames);
+		right_.resize(frames);
+	}
+	decode_(data, frames, left_.data(), right_.data());
+	return true;
+}
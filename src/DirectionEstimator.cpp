@@ -0,0 +1,171 @@
+﻿#include "DirectionEstimator.h"
+#include "FFT.h"
+#include "PcmKernels.h"
+#include <algorithm>
+#include <cmath>
+
+void DirectionEstimator::prepare(size_t frameSize) {
+	cross_.resize(frameSize);
+	binEnergy_.resize(frameSize / 2 + 1);
+	binPan_.resize(frameSize / 2 + 1);
+	histogram_.assign(kAngleBins + 4, 0.0f);   // 两端各补 2 格零，平滑时不必判断边界
+	smoothed_.assign(kAngleBins, 0.0f);
+	if (panToBin_.empty()) {
+		// 声像 p 对应左右功率比 (1 + p) / (1 - p)，与宽带 RMS 使用同一个 ildAngle 映射
+		panToBin_.resize(kPanLevels);
+		for (uint32_t q = 0; q < kPanLevels; ++q) {
+			const float p = 2.0f * q / (kPanLevels - 1) - 1.0f;
+			const float angle = ildAngle(std::sqrt(std::max(1.0f - p, 0.0f)), std::sqrt(std::max(1.0f + p, 0.0f)));
+			panToBin_[q] = static_cast<uint8_t>(std::lround(angle) + 90);
+		}
+	}
+}
+
+// 估计方位：ILD 模式只用左右 RMS；ItdIld 模式按 GCC-PHAT 置信度融合 ITD 与 ILD；maxSources > 0 时另按频点声像分离多个声源
+DirectionResult DirectionEstimator::estimate(const AnalyzedFrame& frame) {
+	DirectionResult result;
+	result.ildAngle = ildAngle(frame.rmsLeft, frame.rmsRight);
+	result.angle = result.ildAngle;
+	if (maxSources > 0) findSources(frame, result);
+	if (mode == DirectionMode::Ild || frame.spectrumLeft.size() < 3 || frame.sampleRate == 0) return result;
+
+	const float kPi = 3.14159265f;
+	float maxLag = maxItdSeconds * frame.sampleRate;
+	if (maxLag <= 0.0f) return result;
+
+	float confidence = 0.0f;
+	float lag = gccPhat(frame, maxLag, confidence);
+
+	float s = lag / maxLag;
+	s = (s < -1.0f) ? -1.0f : ((s > 1.0f) ? 1.0f : s);
+	result.itdSamples = lag;
+	result.itdAngle = std::asin(s) * 180.0f / kPi;
+	result.confidence = confidence;
+
+	float w = itdWeight * ((confidence < 0.0f) ? 0.0f : ((confidence > 1.0f) ? 1.0f : confidence));
+	result.angle = w * result.itdAngle + (1.0f - w) * result.ildAngle;
+	return result;
+}
+
+// 频点声像直方图：向量化内核一次算出各频点的总功率与声像，标量只做查表累加与取峰（与频点数和 181 格成正比的固定开销）
+void DirectionEstimator::findSources(const AnalyzedFrame& frame, DirectionResult& result) {
+	if (frame.spectrumLeft.size() < 3 || frame.spectrumRight.size() != frame.spectrumLeft.size() || frame.sampleRate == 0) return;
+	const size_t half = frame.spectrumLeft.size() - 1;
+	const size_t N = half * 2;
+	if (binEnergy_.size() < half + 1 || panToBin_.empty()) prepare(N);
+
+	// 直流与奈奎斯特频点不参与
+	const size_t first = std::max<size_t>(1, static_cast<size_t>(std::ceil(sourceMinFrequency * N / frame.sampleRate)));
+	if (first >= half) return;
+	const size_t count = half - first;
+	PcmKernels::best().panBins(reinterpret_cast<const float*>(frame.spectrumLeft.data() + first),
+		reinterpret_cast<const float*>(frame.spectrumRight.data() + first), count, kPanLevels, binEnergy_.data(), binPan_.data());
+
+	std::fill(histogram_.begin(), histogram_.end(), 0.0f);
+	float* hist = histogram_.data() + 2;
+	float total = 0.0f;
+	for (size_t k = 0; k < count; ++k) {
+		hist[panToBin_[binPan_[k]]] += binEnergy_[k];
+		total += binEnergy_[k];
+	}
+	if (!(total > 1e-20f)) return;
+
+	// ±2° 的滑动和用于取峰，峰的角度与置信度在原始直方图上按 ±halfWidth 计算
+	for (int i = 0; i < kAngleBins; ++i) smoothed_[i] = hist[i - 2] + hist[i - 1] + hist[i] + hist[i + 1] + hist[i + 2];
+
+	// 候选峰：平滑直方图中不低于 sourceMinFraction 的局部极大（一次遍历，条件几乎总不成立，分支可预测）
+	const float minPeak = sourceMinFraction * total;
+	int candidates[kAngleBins];
+	size_t candidateCount = 0;
+	for (int i = 0; i < kAngleBins; ++i) {
+		const float v = smoothed_[i];
+		if (v >= minPeak && (i == 0 || v > smoothed_[i - 1]) && (i + 1 == kAngleBins || v >= smoothed_[i + 1])) {
+			candidates[candidateCount++] = i;
+		}
+	}
+
+	// 从强到弱取峰，与已取的峰相距不足 sourceSeparationDeg 的候选跳过
+	const int separation = std::max(1, static_cast<int>(std::lround(sourceSeparationDeg)));
+	const int halfWidth = std::max(1, separation / 2);
+	const size_t limit = std::min(maxSources, static_cast<size_t>(DirectionResult::kMaxSources));
+	int taken[DirectionResult::kMaxSources];
+	while (result.sourceCount < limit) {
+		int peak = -1;
+		for (size_t c = 0; c < candidateCount; ++c) {
+			const int i = candidates[c];
+			bool clear = peak < 0 || smoothed_[i] > smoothed_[peak];
+			for (size_t t = 0; t < result.sourceCount && clear; ++t) clear = std::abs(i - taken[t]) >= separation;
+			if (clear) peak = i;
+		}
+		if (peak < 0) break;
+		float energy = 0.0f, moment = 0.0f;
+		for (int j = std::max(peak - halfWidth, 0); j <= std::min(peak + halfWidth, kAngleBins - 1); ++j) {
+			energy += hist[j];
+			moment += hist[j] * (j - 90);
+		}
+		if (!(energy > 0.0f)) break;
+		taken[result.sourceCount] = peak;
+		SourceDirection& source = result.sources[result.sourceCount++];
+		source.angle = moment / energy;
+		source.confidence = std::min(energy / total, 1.0f);
+	}
+}
+
+// GCC-PHAT：互功率谱按幅度归一化后逆变换，在 ±maxLag 内找峰并做抛物线插值
+float DirectionEstimator::gccPhat(const AnalyzedFrame& frame, float maxLag, float& confidence) {
+	const size_t half = frame.spectrumLeft.size() - 1;
+	const size_t N = half * 2;
+	if (cross_.size() != N) cross_.resize(N);
+
+	// 直流与奈奎斯特频点不参与
+	size_t used = 0;
+	cross_[0] = std::complex<float>(0.0f, 0.0f);
+	cross_[half] = std::complex<float>(0.0f, 0.0f);
+	for (size_t k = 1; k < half; ++k) {
+		std::complex<float> g = frame.spectrumLeft[k] * std::conj(frame.spectrumRight[k]);
+		float mag = std::abs(g);
+		if (mag > 1e-12f) {
+			g /= mag;
+			used += 2;
+		}
+		else {
+			g = std::complex<float>(0.0f, 0.0f);
+		}
+		cross_[k] = g;
+		cross_[N - k] = std::conj(g);
+	}
+	if (used == 0) {
+		confidence = 0.0f;
+		return 0.0f;
+	}
+
+	FFTPlan::get(N)->inverse(cross_.data());
+
+	// c[τ] = Σ l[n+τ]·r[n]，τ > 0 表示左声道滞后（声源偏右）
+	int lagLimit = static_cast<int>(std::ceil(maxLag));
+	if (lagLimit > static_cast<int>(half) - 1) lagLimit = static_cast<int>(half) - 1;
+
+	auto at = [&](int tau) { return cross_[static_cast<size_t>((tau + static_cast<int>(N)) % static_cast<int>(N))].real(); };
+
+	int best = 0;
+	float bestVal = at(0);
+	for (int tau = -lagLimit; tau <= lagLimit; ++tau) {
+		float v = at(tau);
+		if (v > bestVal) {
+			bestVal = v;
+			best = tau;
+		}
+	}
+
+	float delta = 0.0f;
+	if (best > -lagLimit && best < lagLimit) {
+		float ym = at(best - 1), y0 = bestVal, yp = at(best + 1);
+		float denom = ym - 2.0f * y0 + yp;
+		if (denom < 0.0f) delta = 0.5f * (ym - yp) / denom;
+		delta = (delta < -0.5f) ? -0.5f : ((delta > 0.5f) ? 0.5f : delta);
+	}
+
+	// 理想纯延迟时峰值为 used / N
+	confidence = bestVal * N / used;
+	return best + delta;
+}
@@ -0,0 +1,201 @@
+﻿#include "FFT.h"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+	const double kPi = 3.14159265358979323846;
+
+	bool isPow2(size_t n) { return n && !(n & (n - 1)); }
+
+	size_t nextPow2(size_t n) {
+		size_t m = 1;
+		while (m < n) m <<= 1;
+		return m;
+	}
+
+	// 每个线程独立的工作缓冲，只在长度增长时分配
+	std::vector<std::complex<float>>& realScratch() {
+		thread_local std::vector<std::complex<float>> buf;
+		return buf;
+	}
+	std::vector<std::complex<float>>& convScratch() {
+		thread_local std::vector<std::complex<float>> buf;
+		return buf;
+	}
+}
+
+// 构建计划：预计算所有三角函数值
+FFTPlan::FFTPlan(size_t n) : n_(n), pow2_(isPow2(n)) {
+	if (n_ < 2) return;
+
+	if (pow2_) {
+		size_t bits = 0;
+		while ((size_t(1) << bits) < n_) ++bits;
+		bitrev_.resize(n_);
+		for (size_t i = 0; i < n_; ++i) {
+			uint32_t r = 0;
+			for (size_t b = 0; b < bits; ++b)
+				if (i & (size_t(1) << b)) r |= 1u << (bits - 1 - b);
+			bitrev_[i] = r;
+		}
+		twiddle_.resize(n_ / 2);
+		for (size_t k = 0; k < n_ / 2; ++k) {
+			double a = -2.0 * kPi * k / n_;
+			twiddle_[k] = std::complex<float>(float(std::cos(a)), float(std::sin(a)));
+		}
+	}
+	else {
+		// Bluestein：X[k] = w[k] * Σ (x[j] w[j]) conj(w[k-j])，w[k] = exp(-iπk²/n)
+		size_t m = nextPow2(2 * n_ - 1);
+		convPlan_ = get(m);
+		chirp_.resize(n_);
+		for (size_t k = 0; k < n_; ++k) {
+			// k² 对 2n 取模，避免大下标时相位精度损失
+			unsigned long long k2 = (static_cast<unsigned long long>(k) * k) % (2 * n_);
+			double a = -kPi * double(k2) / n_;
+			chirp_[k] = std::complex<float>(float(std::cos(a)), float(std::sin(a)));
+		}
+		chirpFFT_.assign(m, std::complex<float>(0.0f, 0.0f));
+		chirpFFT_[0] = std::conj(chirp_[0]);
+		for (size_t k = 1; k < n_; ++k) {
+			chirpFFT_[k] = std::conj(chirp_[k]);
+			chirpFFT_[m - k] = std::conj(chirp_[k]);
+		}
+		convPlan_->forward(chirpFFT_.data());
+	}
+
+	// 偶数长度的实数变换：打包为 n/2 点复数变换后拆分
+	if (n_ % 2 == 0 && n_ >= 4) {
+		halfPlan_ = get(n_ / 2);
+		realTwiddle_.resize(n_ / 2 + 1);
+		for (size_t k = 0; k <= n_ / 2; ++k) {
+			double a = -2.0 * kPi * k / n_;
+			realTwiddle_[k] = std::complex<float>(float(std::cos(a)), float(std::sin(a)));
+		}
+	}
+}
+
+// 全局计划缓存
+std::shared_ptr<const FFTPlan> FFTPlan::get(size_t n) {
+	static std::mutex cacheMutex;
+	static std::unordered_map<size_t, std::shared_ptr<const FFTPlan>> cache;
+
+	{
+		std::lock_guard<std::mutex> lock(cacheMutex);
+		auto it = cache.find(n);
+		if (it != cache.end()) return it->second;
+	}
+
+	// 在锁外构建，构造函数内部可能递归获取子计划
+	auto plan = std::make_shared<const FFTPlan>(n);
+
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	return cache.emplace(n, plan).first->second;
+}
+
+// 基 2 迭代 FFT
+void FFTPlan::forwardPow2(std::complex<float>* data) const {
+	for (size_t i = 0; i < n_; ++i) {
+		size_t j = bitrev_[i];
+		if (i < j) std::swap(data[i], data[j]);
+	}
+
+	for (size_t len = 2; len <= n_; len <<= 1) {
+		size_t half = len >> 1;
+		size_t step = n_ / len;
+		for (size_t base = 0; base < n_; base += len) {
+			for (size_t k = 0; k < half; ++k) {
+				std::complex<float> t = data[base + k + half] * twiddle_[k * step];
+				std::complex<float> u = data[base + k];
+				data[base + k] = u + t;
+				data[base + k + half] = u - t;
+			}
+		}
+	}
+}
+
+// Bluestein 任意长度 FFT
+void FFTPlan::forwardBluestein(std::complex<float>* data) const {
+	size_t m = convPlan_->size();
+	auto& buf = convScratch();
+	if (buf.size() < m) buf.resize(m);
+
+	for (size_t k = 0; k < n_; ++k) buf[k] = data[k] * chirp_[k];
+	std::fill(buf.begin() + n_, buf.begin() + m, std::complex<float>(0.0f, 0.0f));
+
+	convPlan_->forward(buf.data());
+	for (size_t k = 0; k < m; ++k) buf[k] *= chirpFFT_[k];
+	convPlan_->inverse(buf.data());
+
+	for (size_t k = 0; k < n_; ++k) data[k] = buf[k] * chirp_[k];
+}
+
+// 复数正变换
+void FFTPlan::forward(std::complex<float>* data) const {
+	if (n_ < 2) return;
+	if (pow2_) forwardPow2(data);
+	else forwardBluestein(data);
+}
+
+// 复数逆变换：conj(FFT(conj(x))) / n
+void FFTPlan::inverse(std::complex<float>* data) const {
+	if (n_ < 2) return;
+	for (size_t i = 0; i < n_; ++i) data[i] = std::conj(data[i]);
+	forward(data);
+	float scale = 1.0f / n_;
+	for (size_t i = 0; i < n_; ++i) data[i] = std::conj(data[i]) * scale;
+}
+
+// 实数输入正变换，输出 n/2+1 个频点
+void FFTPlan::forwardReal(const float* in, std::complex<float>* out) const {
+	if (n_ == 0) return;
+	if (n_ == 1) {
+		out[0] = std::complex<float>(in[0], 0.0f);
+		return;
+	}
+
+	if (!halfPlan_) {
+		// 奇数长度（或 n == 2）：直接做复数变换
+		auto& buf = realScratch();
+		if (buf.size() < n_) buf.resize(n_);
+		for (size_t i = 0; i < n_; ++i) buf[i] = std::complex<float>(in[i], 0.0f);
+		forward(buf.data());
+		for (size_t k = 0; k <= n_ / 2; ++k) out[k] = buf[k];
+		return;
+	}
+
+	// z[k] = x[2k] + i·x[2k+1]，做 n/2 点复数变换
+	size_t h = n_ / 2;
+	auto& z = realScratch();
+	if (z.size() < h) z.resize(h);
+	for (size_t k = 0; k < h; ++k) z[k] = std::complex<float>(in[2 * k], in[2 * k + 1]);
+	halfPlan_->forward(z.data());
+
+	// 拆分奇偶部分：X[k] = E[k] + W^k·O[k]
+	for (size_t k = 0; k <= h; ++k) {
+		std::complex<float> zk = z[k % h];
+		std::complex<float> zc = std::conj(z[(h - k) % h]);
+		std::complex<float> even = 0.5f * (zk + zc);
+		std::complex<float> odd = std::complex<float>(0.0f, -0.5f) * (zk - zc);
+		out[k] = even + realTwiddle_[k] * odd;
+	}
+}
+
+// 两路实数输入正变换：A[k] = (Z[k] + conj(Z[n-k])) / 2，B[k] = (Z[k] - conj(Z[n-k])) / 2i
+void FFTPlan::forwardRealPair(const float* a, const float* b, std::complex<float>* outA, std::complex<float>* outB) const {
+	if (n_ == 0) return;
+
+	auto& z = realScratch();
+	if (z.size() < n_) z.resize(n_);
+	for (size_t i = 0; i < n_; ++i) z[i] = std::complex<float>(a[i], b[i]);
+	forward(z.data());
+
+	for (size_t k = 0; k <= n_ / 2; ++k) {
+		std::complex<float> zk = z[k];
+		std::complex<float> zc = std::conj(z[(n_ - k) % n_]);
+		outA[k] = 0.5f * (zk + zc);
+		outB[k] = std::complex<float>(0.0f, -0.5f) * (zk - zc);
+	}
+}
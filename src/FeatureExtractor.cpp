@@ -0,0 +1,379 @@
+﻿#include "FeatureExtractor.h"
+#include "WavFile.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+
+namespace {
+	const char kMagic[4] = { 'A', 'C', 'F', 'T' };
+	const uint32_t kVersion = 1;
+	const size_t kHeaderSize = 64;
+	const size_t kEntrySize = 32;
+	const size_t kDataAlign = 64;
+	const uint32_t kPacketFrames = 4096;   // 每次送入流水线的采样帧数
+
+	const char* const kScalarNames[FrameFeatures::kScalarColumns] = {
+		"low_band_energy", "high_band_energy", "high_freq_ratio", "high_freq", "rms_left", "rms_right",
+		"ild_db", "ild_angle", "itd_samples", "itd_angle", "itd_confidence", "angle",
+	};
+
+	void put32(uint8_t* p, uint32_t x) {
+		for (int i = 0; i < 4; ++i) p[i] = static_cast<uint8_t>(x >> (8 * i));
+	}
+
+	void put64(uint8_t* p, uint64_t x) {
+		put32(p, static_cast<uint32_t>(x));
+		put32(p + 4, static_cast<uint32_t>(x >> 32));
+	}
+
+	uint32_t read32(const uint8_t* p) {
+		return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+	}
+
+	uint64_t read64(const uint8_t* p) {
+		return read32(p) | (static_cast<uint64_t>(read32(p + 4)) << 32);
+	}
+
+	void setError(std::string* error, const std::string& message) {
+		if (error) *error = message;
+	}
+
+	float hzToMel(float hz) {
+		return 2595.0f * std::log10(1.0f + hz / 700.0f);
+	}
+
+	float melToHz(float mel) {
+		return 700.0f * (std::pow(10.0f, mel / 2595.0f) - 1.0f);
+	}
+
+	// samples 个采样帧能切出的分析帧数（与 StftFramer 相同：凑满一帧才输出，末尾不足一帧的样本丢弃）
+	uint64_t analysisFrames(uint64_t samples, uint32_t frameSize, uint32_t hopSize) {
+		return samples < frameSize ? 0 : (samples - frameSize) / hopSize + 1;
+	}
+
+	struct Input {
+		FeatureFileEntry entry;
+		StreamFormat format;
+		size_t dataOffset = 0;
+		size_t dataSize = 0;
+	};
+
+	// 一个并行任务：某个文件中从 firstFrame 起的 frames 个分析帧
+	struct Job {
+		uint32_t input;
+		uint64_t firstFrame;
+		uint64_t frames;
+	};
+}
+
+void FrameFeatures::configure(const FeatureConfig& config, uint32_t sampleRate, const std::vector<float>& window) {
+	melBands_ = config.melBands;
+	sampleRate_ = sampleRate;
+	const size_t N = window.size();
+	const size_t bins = N / 2 + 1;
+
+	// 与 StftFramer 相同按 double 累加，功率归一化与 FrameAnalyzer 逐位一致
+	double sum = 0.0;
+	for (float w : window) sum += w;
+	float windowSum = sum > 0.0 ? static_cast<float>(sum) : static_cast<float>(N);
+	powerScale_ = 1.0f / (windowSum * windowSum);
+
+	// 三角滤波器组：mel 刻度上等间隔的 melBands + 2 个边界点；过窄而没有覆盖任何频点的频带取离中心最近的频点
+	float nyquist = sampleRate * 0.5f;
+	float maxHz = config.melMaxHz > 0.0f ? std::min(config.melMaxHz, nyquist) : nyquist;
+	float minHz = std::min(std::max(config.melMinHz, 0.0f), maxHz);
+	float melLo = hzToMel(minHz), melHi = hzToMel(maxHz);
+	float binHz = N ? static_cast<float>(sampleRate) / N : 0.0f;
+
+	melFirst_.assign(melBands_, 0);
+	melOffset_.assign(melBands_ + 1, 0);
+	melWeights_.clear();
+	for (uint32_t b = 0; b < melBands_; ++b) {
+		float lo = melToHz(melLo + (melHi - melLo) * b / (melBands_ + 1));
+		float center = melToHz(melLo + (melHi - melLo) * (b + 1) / (melBands_ + 1));
+		float hi = melToHz(melLo + (melHi - melLo) * (b + 2) / (melBands_ + 1));
+		size_t first = bins, last = 0;
+		for (size_t k = 0; k < bins; ++k) {
+			float f = k * binHz;
+			if (f > lo && f < hi) {
+				first = std::min(first, k);
+				last = k;
+			}
+		}
+		melOffset_[b] = static_cast<uint32_t>(melWeights_.size());
+		if (first > last) {
+			size_t nearest = binHz > 0.0f ? std::min(bins - 1, static_cast<size_t>(center / binHz + 0.5f)) : 0;
+			melFirst_[b] = static_cast<uint32_t>(nearest);
+			melWeights_.push_back(1.0f);
+			continue;
+		}
+		melFirst_[b] = static_cast<uint32_t>(first);
+		for (size_t k = first; k <= last; ++k) {
+			float f = k * binHz;
+			melWeights_.push_back(f <= center ? (f - lo) / (center - lo) : (hi - f) / (hi - center));
+		}
+	}
+	melOffset_[melBands_] = static_cast<uint32_t>(melWeights_.size());
+
+	direction_.mode = config.directionMode;
+	direction_.prepare(N);
+}
+
+void FrameFeatures::compute(const AnalyzedFrame& frame, float* out) {
+	const std::vector<std::complex<float>>& spectrum = frame.spectrum;
+	for (uint32_t b = 0; b < melBands_; ++b) {
+		float energy = 0.0f;
+		uint32_t k = melFirst_[b];
+		for (uint32_t w = melOffset_[b]; w < melOffset_[b + 1] && k < spectrum.size(); ++w, ++k)
+			energy += melWeights_[w] * std::norm(spectrum[k]);
+		*out++ = std::log(energy * powerScale_ + 1e-10f);
+	}
+
+	DirectionResult dir = direction_.estimate(frame);
+	*out++ = frame.lowBandEnergy;
+	*out++ = frame.highBandEnergy;
+	*out++ = frame.highFreqRatio;
+	*out++ = frame.highFreq ? 1.0f : 0.0f;
+	*out++ = frame.rmsLeft;
+	*out++ = frame.rmsRight;
+	*out++ = static_cast<float>(20.0 * std::log10((frame.rmsRight + 1e-9) / (frame.rmsLeft + 1e-9)));
+	*out++ = dir.ildAngle;
+	*out++ = dir.itdSamples;
+	*out++ = dir.itdAngle;
+	*out++ = dir.confidence;
+	*out++ = dir.angle;
+}
+
+std::vector<std::string> FrameFeatures::columnNames(const FeatureConfig& config) {
+	std::vector<std::string> names;
+	for (uint32_t b = 0; b < config.melBands; ++b) names.push_back("log_mel_" + std::to_string(b));
+	names.insert(names.end(), kScalarNames, kScalarNames + kScalarColumns);
+	return names;
+}
+
+// 文件头：magic | version | dimension | fileCount | rows(8) | indexOffset(8) | stringsOffset(8) | stringsSize(8)
+//        | dataOffset(8) | frameSize | hopSize
+// 索引项：firstRow(8) | rows(8) | sampleRate | channels | 路径在字符串表中的偏移 | 保留
+// 字符串表：各列名，之后是各文件路径，均以 NUL 结尾
+bool exportFeatures(const std::vector<std::string>& inputs, const std::string& output, const FeatureConfig& config,
+	FeatureExportStats* stats, std::string* error) {
+	typedef std::chrono::steady_clock Clock;
+	Clock::time_point startTime = Clock::now();
+	FeatureExportStats local;
+	if (!stats) stats = &local;
+	*stats = FeatureExportStats();
+
+	const uint32_t F = config.frameSize, H = config.hopSize;
+	if (F < 4 || H == 0 || H > F || config.chunkFrames == 0) {
+		setError(error, "invalid frame size or hop size");
+		return false;
+	}
+
+	// 扫描文件头：确定格式、data 位置与每个文件的行范围
+	std::vector<Input> files;
+	uint64_t rows = 0;
+	for (const std::string& path : inputs) {
+		MappedFile source;
+		Input in;
+		if (!source.openReadOnly(path) || !locateWavData(static_cast<const uint8_t*>(source.data()), source.size(),
+			in.format, in.dataOffset, in.dataSize)) {
+			++stats->skipped;
+			continue;
+		}
+		in.entry.path = path;
+		in.entry.sampleRate = in.format.sampleRate;
+		in.entry.channels = in.format.channels;
+		in.entry.firstRow = rows;
+		in.entry.rows = analysisFrames(in.dataSize / in.format.blockAlign, F, H);
+		rows += in.entry.rows;
+		stats->inputBytes += in.dataSize;
+		files.push_back(in);
+	}
+
+	const std::vector<std::string> columns = FrameFeatures::columnNames(config);
+	const uint32_t dimension = static_cast<uint32_t>(columns.size());
+	std::vector<uint8_t> strings;
+	for (const std::string& name : columns) strings.insert(strings.end(), name.c_str(), name.c_str() + name.size() + 1);
+	std::vector<uint32_t> pathOffsets;
+	for (const Input& in : files) {
+		pathOffsets.push_back(static_cast<uint32_t>(strings.size()));
+		strings.insert(strings.end(), in.entry.path.c_str(), in.entry.path.c_str() + in.entry.path.size() + 1);
+	}
+
+	const size_t indexOffset = kHeaderSize;
+	const size_t stringsOffset = indexOffset + files.size() * kEntrySize;
+	const size_t dataOffset = (stringsOffset + strings.size() + kDataAlign - 1) / kDataAlign * kDataAlign;
+	const size_t totalSize = dataOffset + static_cast<size_t>(rows) * dimension * sizeof(float);
+
+	MappedFile out;
+	if (!out.create(output, totalSize)) {
+		setError(error, "cannot create " + output);
+		return false;
+	}
+	uint8_t* base = static_cast<uint8_t*>(out.data());
+	std::memcpy(base, kMagic, 4);
+	put32(base + 4, kVersion);
+	put32(base + 8, dimension);
+	put32(base + 12, static_cast<uint32_t>(files.size()));
+	put64(base + 16, rows);
+	put64(base + 24, indexOffset);
+	put64(base + 32, stringsOffset);
+	put64(base + 40, strings.size());
+	put64(base + 48, dataOffset);
+	put32(base + 56, F);
+	put32(base + 60, H);
+	for (size_t i = 0; i < files.size(); ++i) {
+		uint8_t* e = base + indexOffset + i * kEntrySize;
+		put64(e, files[i].entry.firstRow);
+		put64(e + 8, files[i].entry.rows);
+		put32(e + 16, files[i].entry.sampleRate);
+		put32(e + 20, files[i].entry.channels);
+		put32(e + 24, pathOffsets[i]);
+	}
+	if (!strings.empty()) std::memcpy(base + stringsOffset, strings.data(), strings.size());
+	float* data = reinterpret_cast<float*>(base + dataOffset);
+
+	// 长文件切成 chunkFrames 个分析帧一块：块起点是跳步的整数倍，独立分帧得到的帧与整段分帧完全相同
+	// 自适应噪声底依赖此前的全部帧，此时每个文件一块
+	const uint64_t chunkFrames = config.params.adaptiveFloor ? UINT64_MAX : config.chunkFrames;
+	std::vector<Job> jobs;
+	for (uint32_t i = 0; i < files.size(); ++i) {
+		for (uint64_t first = 0; first < files[i].entry.rows;) {
+			Job job = { i, first, std::min<uint64_t>(chunkFrames, files[i].entry.rows - first) };
+			jobs.push_back(job);
+			first += job.frames;
+		}
+	}
+
+	// 任务按文件顺序领取，每个线程只映射当前所在的文件
+	std::atomic<size_t> next{ 0 };
+	std::atomic<bool> failed{ false };
+	auto worker = [&]() {
+		DetectorPipeline pipeline;
+		FrameFeatures features;
+		MappedFile source;
+		uint32_t mapped = UINT32_MAX;
+		for (size_t j = next.fetch_add(1); j < jobs.size(); j = next.fetch_add(1)) {
+			const Job& job = jobs[j];
+			const Input& in = files[job.input];
+			if (mapped != job.input) {
+				mapped = job.input;
+				if (!source.openReadOnly(in.entry.path) || source.size() < in.dataOffset + in.dataSize) {
+					source.close();
+					failed.store(true);
+				}
+			}
+			if (!source.isOpen()) continue;
+
+			pipeline.configure(in.format, F, H, config.params, kPacketFrames);
+			if (features.sampleRate() != in.format.sampleRate) features.configure(config, in.format.sampleRate, pipeline.window());
+
+			const uint64_t samples = (job.frames - 1) * H + F;
+			const uint8_t* pcm = static_cast<const uint8_t*>(source.data()) + in.dataOffset +
+				static_cast<size_t>(job.firstFrame * H) * in.format.blockAlign;
+			float* row = data + static_cast<size_t>(in.entry.firstRow + job.firstFrame) * dimension;
+			auto onFrame = [&](const AnalyzedFrame& frame) {
+				features.compute(frame, row);
+				row += dimension;
+			};
+			for (uint64_t pos = 0; pos < samples; pos += kPacketFrames) {
+				uint32_t n = static_cast<uint32_t>(std::min<uint64_t>(kPacketFrames, samples - pos));
+				pipeline.analyzePacket(pcm + static_cast<size_t>(pos) * in.format.blockAlign, n, onFrame);
+			}
+		}
+	};
+
+	unsigned threads = config.threads ? config.threads : std::max(1u, std::thread::hardware_concurrency());
+	threads = static_cast<unsigned>(std::max<size_t>(1, std::min<size_t>(threads, jobs.size())));
+	std::vector<std::thread> pool;
+	for (unsigned t = 1; t < threads; ++t) pool.emplace_back(worker);
+	worker();
+	for (std::thread& t : pool) t.join();
+	out.close();
+
+	stats->files = static_cast<uint32_t>(files.size());
+	stats->rows = rows;
+	stats->chunks = static_cast<uint32_t>(jobs.size());
+	stats->seconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+	if (failed.load()) {
+		setError(error, "input file changed or became unreadable during export");
+		return false;
+	}
+	return true;
+}
+
+bool FeatureDataset::open(const std::string& path, std::string* error) {
+	close();
+	if (!file_.openReadOnly(path)) {
+		setError(error, "cannot open " + path);
+		return false;
+	}
+	const uint8_t* base = static_cast<const uint8_t*>(file_.data());
+	const size_t size = file_.size();
+	if (size < kHeaderSize || std::memcmp(base, kMagic, 4) != 0 || read32(base + 4) != kVersion) {
+		setError(error, "not a feature tensor file (or another version)");
+		close();
+		return false;
+	}
+
+	dimension_ = read32(base + 8);
+	uint32_t fileCount = read32(base + 12);
+	rows_ = read64(base + 16);
+	uint64_t indexOffset = read64(base + 24);
+	uint64_t stringsOffset = read64(base + 32);
+	uint64_t stringsSize = read64(base + 40);
+	uint64_t dataOffset = read64(base + 48);
+	frameSize_ = read32(base + 56);
+	hopSize_ = read32(base + 60);
+	if (indexOffset + static_cast<uint64_t>(fileCount) * kEntrySize > size || stringsOffset + stringsSize > size ||
+		dataOffset % kDataAlign != 0 || dataOffset + rows_ * dimension_ * sizeof(float) > size) {
+		setError(error, "truncated feature tensor file");
+		close();
+		return false;
+	}
+
+	// 字符串表按 NUL 切分：前 dimension 个是列名
+	const char* strings = reinterpret_cast<const char*>(base + stringsOffset);
+	const char* stringsEnd = strings + stringsSize;
+	auto stringAt = [&](uint64_t offset) {
+		const char* s = strings + std::min(offset, stringsSize);
+		return std::string(s, std::find(s, stringsEnd, '\0'));
+	};
+	uint64_t at = 0;
+	for (uint32_t c = 0; c < dimension_; ++c) {
+		columns_.push_back(stringAt(at));
+		at += columns_.back().size() + 1;
+	}
+	for (uint32_t i = 0; i < fileCount; ++i) {
+		const uint8_t* e = base + indexOffset + i * kEntrySize;
+		FeatureFileEntry entry;
+		entry.firstRow = read64(e);
+		entry.rows = read64(e + 8);
+		entry.sampleRate = read32(e + 16);
+		entry.channels = read32(e + 20);
+		entry.path = stringAt(read32(e + 24));
+		files_.push_back(entry);
+	}
+	data_ = reinterpret_cast<const float*>(base + dataOffset);
+	return true;
+}
+
+void FeatureDataset::close() {
+	file_.close();
+	dimension_ = 0;
+	rows_ = 0;
+	columns_.clear();
+	files_.clear();
+	data_ = nullptr;
+}
+
+int FeatureDataset::column(const std::string& name) const {
+	for (size_t c = 0; c < columns_.size(); ++c) {
+		if (columns_[c] == name) return static_cast<int>(c);
+	}
+	return -1;
+}
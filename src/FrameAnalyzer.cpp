@@ -0,0 +1,108 @@
+﻿#include "FrameAnalyzer.h"
+#include "FFT.h"
+#include <algorithm>
+#include <cmath>
+
+void FrameAnalyzer::prepare(uint32_t frameSize) {
+	highPower_.assign(frameSize / 2, 0.0f);
+	floor_.prepare(frameSize / 2);
+	hysteresis_ = TriggerHysteresis();
+}
+
+// 融合分析：下混、RMS、频谱、频带能量与高频判定
+void FrameAnalyzer::analyze(const AnalysisFrame& frame, uint32_t sampleRate, AnalyzedFrame& out) {
+	const size_t N = frame.left.size();
+	out.offset = frame.offset;
+	out.sampleRate = sampleRate;
+	out.highFreq = false;
+	if (N == 0) return;
+
+	// 一次遍历：下混单声道并累计左右声道能量（向量化内核）
+	out.mono.resize(N);
+	float sumSqLeft = 0.0f, sumSqRight = 0.0f;
+	kernels_->downmixEnergy(frame.left.data(), frame.right.data(), N, out.mono.data(), &sumSqLeft, &sumSqRight);
+	out.rmsLeft = std::sqrt(sumSqLeft / N);
+	out.rmsRight = std::sqrt(sumSqRight / N);
+
+	// 每帧只做一次变换：左右声道打包为一次复数 FFT，mono 频谱 = (L + R) / 2
+	const size_t bins = N / 2 + 1;
+	out.spectrumLeft.resize(bins);
+	out.spectrumRight.resize(bins);
+	out.spectrum.resize(bins);
+	FFTPlan::get(N)->forwardRealPair(frame.left.data(), frame.right.data(),
+		out.spectrumLeft.data(), out.spectrumRight.data());
+	++transforms_;
+	for (size_t k = 0; k < bins; ++k)
+		out.spectrum[k] = 0.5f * (out.spectrumLeft[k] + out.spectrumRight[k]);
+
+	// 功率按窗函数之和的平方归一化，阈值不随帧长和窗型变化
+	const float windowSum = frame.windowSum > 0.0f ? frame.windowSum : static_cast<float>(N);
+	const float powerScale = 1.0f / (windowSum * windowSum);
+	const float threshold = params.highFreqEpsilon * params.highFreqEpsilon;
+
+	float freqStep = static_cast<float>(sampleRate) / N;
+	size_t highFreqCount = 0;
+	size_t aboveThresholdCount = 0;
+	float lowEnergy = 0.0f, highEnergy = 0.0f;
+	if (params.adaptiveFloor && highPower_.size() < N / 2) highPower_.resize(N / 2);
+
+	// 遍历频谱，统计高频数量与频带能量
+	for (size_t i = 0; i < N / 2; ++i) {
+		float power = std::norm(out.spectrum[i]) * powerScale;
+		float freq = i * freqStep;
+		if (freq >= params.highFreqMin) {
+			++highFreqCount;
+			highEnergy += power;
+			if (params.adaptiveFloor) highPower_[highFreqCount - 1] = power;
+			else if (power > threshold) ++aboveThresholdCount;
+		}
+		else {
+			lowEnergy += power;
+		}
+	}
+	out.lowBandEnergy = lowEnergy;
+	out.highBandEnergy = highEnergy;
+
+	if (highFreqCount == 0) {
+		out.highFreqRatio = 0.0f;
+		return;
+	}
+
+	if (params.adaptiveFloor) {
+		aboveThresholdCount = floor_.countAbove(highPower_.data(), highFreqCount, threshold, frame.offset, sampleRate,
+			static_cast<uint32_t>(N), params);
+		out.highFreqRatio = static_cast<float>(aboveThresholdCount) / highFreqCount;
+		out.highFreq = hysteresis_.update(out.highFreqRatio, params.highFreqRatio, params.highFreqRatio * params.releaseRatio);
+		return;
+	}
+
+	out.highFreqRatio = static_cast<float>(aboveThresholdCount) / highFreqCount;
+	out.highFreq = (out.highFreqRatio >= params.highFreqRatio);
+}
+
+void FrameAnalyzer::skipFrame(const AnalysisFrame& frame, uint32_t sampleRate) {
+	if (!params.adaptiveFloor) return;
+	const size_t N = frame.left.size();
+	float freqStep = static_cast<float>(sampleRate) / N;
+	size_t highFreqCount = 0;
+	for (size_t i = 0; i < N / 2; ++i) {
+		if (i * freqStep >= params.highFreqMin) ++highFreqCount;
+	}
+	if (highFreqCount == 0) return;
+	if (highPower_.size() < highFreqCount) highPower_.resize(highFreqCount);
+	std::fill(highPower_.begin(), highPower_.begin() + highFreqCount, 0.0f);
+	const float threshold = params.highFreqEpsilon * params.highFreqEpsilon;
+	floor_.countAbove(highPower_.data(), highFreqCount, threshold, frame.offset, sampleRate, static_cast<uint32_t>(N), params);
+	hysteresis_.update(0.0f, params.highFreqRatio, params.highFreqRatio * params.releaseRatio);
+}
+
+// 分贝差线性映射到 ±90°，20 dB 对应 90°
+float ildAngle(float rmsLeft, float rmsRight) {
+	if (rmsLeft < 1e-6 && rmsRight < 1e-6) return 0.0f;
+
+	double dbDiff = 20.0 * std::log10((rmsRight + 1e-9) / (rmsLeft + 1e-9));
+	double maxDb = 20.0;
+	double angle = (dbDiff / maxDb) * 90.0;
+	angle = (angle < -90.0) ? -90.0 : ((angle > 90.0) ? 90.0 : angle);
+	return static_cast<float>(angle);
+}
@@ -0,0 +1,153 @@
+﻿#include "HighPassGate.h"
+#include "FrameAnalyzer.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+	size_t nextPowerOfTwo(size_t n) {
+		size_t p = 1;
+		while (p < n) p <<= 1;
+		return p;
+	}
+}
+
+void HighPassGate::configure(const DetectorParams& params, uint32_t sampleRate, uint32_t frameSize, uint32_t hopSize,
+	float windowSum, uint32_t maxPacketFrames) {
+	frameSize_ = frameSize;
+	hopSize_ = hopSize;
+	position_ = 0;
+	blocks_.clear();
+	mask_ = 0;
+	maxPacketFrames_ = 0;
+	// 截止频率过低时高通滤不掉低频段，上界不再成立，不启用门限
+	enabled_ = params.highPassGate && frameSize >= 4 && hopSize > 0 && hopSize <= frameSize && sampleRate > 0
+		&& params.highFreqMin >= 1000.0f;
+	if (!enabled_) return;
+
+	// 与 FrameAnalyzer 相同的表达式求高频段频点数与触发所需的最少频点数
+	const size_t N = frameSize;
+	const float freqStep = static_cast<float>(sampleRate) / N;
+	size_t highFreqCount = 0;
+	for (size_t i = 0; i < N / 2; ++i) {
+		if (i * freqStep >= params.highFreqMin) ++highFreqCount;
+	}
+	size_t required = highFreqCount + 1;
+	for (size_t a = 0; a <= highFreqCount && highFreqCount > 0; ++a) {
+		if (static_cast<float>(a) / highFreqCount >= params.highFreqRatio) {
+			required = a;
+			break;
+		}
+	}
+	if (required == 0) {
+		enabled_ = false;   // 占比阈值为 0 时每帧都触发
+		return;
+	}
+
+	if (required > highFreqCount) {
+		threshold_ = std::numeric_limits<float>::infinity();   // 不可能触发
+	}
+	else {
+		const double W = windowSum > 0.0f ? windowSum : static_cast<double>(N);
+		const double epsilon2 = static_cast<double>(params.highFreqEpsilon) * params.highFreqEpsilon;
+		const double margin = std::pow(10.0, params.gateMarginDb / 10.0);
+		threshold_ = static_cast<float>(required * epsilon2 * 2.0 * W * W / (N * margin));
+	}
+
+	// 八阶 Butterworth 高通 = 四节 RBJ 双二阶，第 k 节 Q = 1 / (2cos((2k+1)π/16))
+	const double kPi = 3.14159265358979323846;
+	const double cutoff = std::min(0.9 * params.highFreqMin, 0.45 * sampleRate);
+	const double w0 = 2.0 * kPi * cutoff / sampleRate;
+	// 滤波器在 highFreqMin 处的功率增益（双线性变换的高通在其上单调递增），上界按它放大
+	const double wMin = 2.0 * kPi * std::min<double>(params.highFreqMin, 0.5 * sampleRate) / sampleRate;
+	double gain = 1.0;
+	for (int k = 0; k < kSections; ++k) {
+		const double q = 1.0 / (2.0 * std::cos((2 * k + 1) * kPi / (4 * kSections)));
+		const double alpha = std::sin(w0) / (2.0 * q);
+		const double c = std::cos(w0);
+		const double a0 = 1.0 + alpha;
+		const double b[3] = { (1.0 + c) / 2.0 / a0, -(1.0 + c) / a0, (1.0 + c) / 2.0 / a0 };
+		const double a[3] = { 1.0, -2.0 * c / a0, (1.0 - alpha) / a0 };
+		Section& sec = sections_[k];
+		sec.b0 = static_cast<float>(b[0]);
+		sec.b1 = static_cast<float>(b[1]);
+		sec.b2 = static_cast<float>(b[2]);
+		sec.a1 = static_cast<float>(a[1]);
+		sec.a2 = static_cast<float>(a[2]);
+		sec.z1 = sec.z2 = 0.0f;
+		// |H(e^jw)|²
+		double nr = b[0] + b[1] * std::cos(wMin) + b[2] * std::cos(2 * wMin), ni = -b[1] * std::sin(wMin) - b[2] * std::sin(2 * wMin);
+		double dr = a[0] + a[1] * std::cos(wMin) + a[2] * std::cos(2 * wMin), di = -a[1] * std::sin(wMin) - a[2] * std::sin(2 * wMin);
+		gain *= (nr * nr + ni * ni) / (dr * dr + di * di);
+	}
+	threshold_ = static_cast<float>(threshold_ * std::min(gain, 1.0));
+
+	blocksPerFrame_ = (frameSize - 1) / hopSize + 1;
+	reserve(maxPacketFrames);
+}
+
+void HighPassGate::reserve(uint32_t packetFrames) {
+	if (packetFrames <= maxPacketFrames_ && !blocks_.empty()) return;
+	// 本包输出的帧起点不早于包首之前 frameSize 个样本，终点不晚于包尾
+	const size_t needed = nextPowerOfTwo((frameSize_ + packetFrames) / hopSize_ + 3);
+	if (needed > blocks_.size()) {
+		std::vector<float> grown(needed, 0.0f);
+		const uint64_t current = position_ / hopSize_;
+		for (uint64_t i = 0; i < blocks_.size() && i <= current; ++i) {
+			const uint64_t block = current - i;
+			grown[block & (needed - 1)] = blocks_[block & mask_];
+		}
+		blocks_.swap(grown);
+		mask_ = needed - 1;
+	}
+	maxPacketFrames_ = std::max(maxPacketFrames_, packetFrames);
+}
+
+void HighPassGate::process(const float* left, const float* right, uint32_t frames) {
+	if (!enabled_) return;
+	if (frames > maxPacketFrames_) reserve(frames);   // 数据包超过协商大小时才会分配
+
+	Section sec[kSections];
+	std::copy(sections_, sections_ + kSections, sec);
+	uint32_t done = 0;
+	while (done < frames) {
+		const uint64_t block = position_ / hopSize_;
+		const uint32_t inBlock = static_cast<uint32_t>(position_ - block * hopSize_);
+		const uint32_t n = std::min(frames - done, hopSize_ - inBlock);
+		bool idle = true;
+		for (const Section& s : sec) idle = idle && s.z1 == 0.0f && s.z2 == 0.0f;
+		float energy = 0.0f;
+		if (left || !idle) {   // 静音且滤波器已无余响时整块能量为零
+			for (uint32_t i = done; i < done + n; ++i) {
+				float x = left ? 0.5f * (left[i] + right[i]) : 0.0f;
+				for (Section& s : sec) {
+					const float y = s.b0 * x + s.z1;
+					s.z1 = s.b1 * x - s.a1 * y + s.z2;
+					s.z2 = s.b2 * x - s.a2 * y;
+					x = y;
+				}
+				energy += x * x;
+			}
+			// 余响衰减到非规格化数之前清零
+			float residual = 0.0f;
+			for (const Section& s : sec) residual += std::fabs(s.z1) + std::fabs(s.z2);
+			if (!left && residual < 1e-20f) {
+				for (Section& s : sec) s.z1 = s.z2 = 0.0f;
+			}
+		}
+
+		float& slot = blocks_[block & mask_];
+		slot = inBlock == 0 ? energy : slot + energy;
+		position_ += n;
+		done += n;
+	}
+	std::copy(sec, sec + kSections, sections_);
+}
+
+bool HighPassGate::mayTrigger(uint64_t frameOffset) const {
+	if (!enabled_) return true;
+	const uint64_t first = frameOffset / hopSize_;
+	float energy = 0.0f;
+	for (uint32_t i = 0; i < blocksPerFrame_; ++i) energy += blocks_[(first + i) & mask_];
+	return energy >= threshold_;
+}
@@ -0,0 +1,278 @@
+﻿#include "LatencyTrace.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <string>
+
+namespace {
+	const size_t kStageCount = static_cast<size_t>(TraceStage::Count);
+	const size_t kHistogramBuckets = 24;  // 最高桶覆盖到约 8 秒
+
+	std::atomic<uint64_t> g_nextGeneration{ 1 };
+
+	// 线程本地缓存：最近一次使用的跟踪器及其环，命中时不加锁
+	struct RingCache {
+		uint64_t generation = 0;
+		void* ring = nullptr;
+	};
+	thread_local RingCache t_ringCache;
+
+	size_t bucketOf(uint64_t ns) {
+		uint64_t us = ns / 1000;
+		size_t b = 0;
+		while (us && b + 1 < kHistogramBuckets) {
+			us >>= 1;
+			++b;
+		}
+		return b;
+	}
+
+	// 最近秩百分位
+	double percentileMs(const std::vector<uint64_t>& sorted, double p) {
+		if (sorted.empty()) return 0.0;
+		size_t rank = static_cast<size_t>(std::ceil(p * sorted.size()));
+		rank = std::max<size_t>(rank, 1);
+		return sorted[std::min(rank, sorted.size()) - 1] / 1e6;
+	}
+
+	// 每个事件各阶段的时间戳
+	struct EventTimes {
+		uint64_t time[kStageCount] = {};
+		uint32_t thread[kStageCount] = {};
+		uint32_t present = 0;  // 位掩码
+		bool has(size_t s) const { return (present >> s) & 1u; }
+	};
+
+	std::map<uint64_t, EventTimes> groupByEvent(const std::vector<TraceRecord>& records) {
+		std::map<uint64_t, EventTimes> events;
+		for (const TraceRecord& r : records) {
+			size_t s = static_cast<size_t>(r.stage);
+			if (s >= kStageCount) continue;
+			EventTimes& e = events[r.eventId];
+			// 同一阶段重复记录时保留最早的一次
+			if (!e.has(s) || r.timeNs < e.time[s]) {
+				e.time[s] = r.timeNs;
+				e.thread[s] = r.thread;
+			}
+			e.present |= 1u << s;
+		}
+		return events;
+	}
+
+	LatencyStats makeStats(TraceStage from, TraceStage to, std::vector<uint64_t>& durations) {
+		LatencyStats st;
+		st.from = from;
+		st.to = to;
+		st.count = durations.size();
+		st.histogram.assign(kHistogramBuckets, 0);
+		std::sort(durations.begin(), durations.end());
+		for (uint64_t d : durations) ++st.histogram[bucketOf(d)];
+		st.p50Ms = percentileMs(durations, 0.50);
+		st.p99Ms = percentileMs(durations, 0.99);
+		st.maxMs = durations.empty() ? 0.0 : durations.back() / 1e6;
+		return st;
+	}
+}
+
+const char* traceStageName(TraceStage stage) {
+	switch (stage) {
+	case TraceStage::DeviceCapture: return "DeviceCapture";
+	case TraceStage::Detected: return "Detected";
+	case TraceStage::Dequeued: return "Dequeued";
+	case TraceStage::Located: return "Located";
+	case TraceStage::Posted: return "Posted";
+	case TraceStage::Rendered: return "Rendered";
+	default: return "Unknown";
+	}
+}
+
+const size_t LatencyTracer::kMaxThreads;
+
+LatencyTracer::LatencyTracer(size_t ringCapacity)
+	: clock_(&LatencyTracer::steadyNowNs), ringCapacity_(ringCapacity), generation_(g_nextGeneration.fetch_add(1)) {
+}
+
+// 线程本地缓存可能仍指向本实例的环，但按 generation 判定，不会被后续实例误用
+LatencyTracer::~LatencyTracer() {
+}
+
+uint64_t LatencyTracer::steadyNowNs() {
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void LatencyTracer::setClock(Clock clock) {
+	clock_ = clock ? clock : Clock(&LatencyTracer::steadyNowNs);
+}
+
+// 当前线程的环：缓存命中直接返回，否则加锁查找或注册；超出线程上限时返回 nullptr
+LatencyTracer::ThreadRing* LatencyTracer::ringForThisThread() {
+	if (t_ringCache.generation == generation_) return static_cast<ThreadRing*>(t_ringCache.ring);
+
+	std::lock_guard<std::mutex> lock(ringsMutex_);
+	std::thread::id self = std::this_thread::get_id();
+	ThreadRing* found = nullptr;
+	for (size_t i = 0; i < ringCount_; ++i) {
+		if (rings_[i].owner == self) {
+			found = &rings_[i];
+			break;
+		}
+	}
+	if (!found) {
+		if (ringCount_ == kMaxThreads) return nullptr;
+		found = &rings_[ringCount_];
+		found->ring.reset(ringCapacity_);
+		found->index = static_cast<uint32_t>(ringCount_);
+		found->owner = self;
+		++ringCount_;
+	}
+	t_ringCache.generation = generation_;
+	t_ringCache.ring = found;
+	return found;
+}
+
+void LatencyTracer::markAt(uint64_t eventId, TraceStage stage, uint64_t timeNs) {
+	if (!enabled) return;
+	ThreadRing* r = ringForThisThread();
+	if (!r) {
+		unregistered_.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+	if (TraceRecord* slot = r->ring.acquire()) {
+		slot->eventId = eventId;
+		slot->timeNs = timeNs;
+		slot->thread = r->index;
+		slot->stage = stage;
+		r->ring.publish();
+	}
+}
+
+void LatencyTracer::collect(std::vector<TraceRecord>& out) {
+	std::lock_guard<std::mutex> lock(ringsMutex_);
+	for (size_t i = 0; i < ringCount_; ++i) {
+		SpscRing<TraceRecord>& ring = rings_[i].ring;
+		while (TraceRecord* rec = ring.front()) {
+			out.push_back(*rec);
+			ring.pop();
+		}
+	}
+}
+
+uint64_t LatencyTracer::droppedCount() const {
+	std::lock_guard<std::mutex> lock(ringsMutex_);
+	uint64_t dropped = unregistered_.load(std::memory_order_relaxed);
+	for (size_t i = 0; i < ringCount_; ++i) dropped += rings_[i].ring.overflowCount();
+	return dropped;
+}
+
+// 相邻阶段（跳过缺失的阶段）与 DeviceCapture → 最后阶段的端到端延迟
+std::vector<LatencyStats> computeLatencyStats(const std::vector<TraceRecord>& records) {
+	std::map<uint64_t, EventTimes> events = groupByEvent(records);
+	std::vector<uint64_t> pair[kStageCount][kStageCount];
+	for (const auto& kv : events) {
+		const EventTimes& e = kv.second;
+		size_t prev = kStageCount;
+		for (size_t s = 0; s < kStageCount; ++s) {
+			if (!e.has(s)) continue;
+			if (prev < kStageCount) {
+				uint64_t d = e.time[s] > e.time[prev] ? e.time[s] - e.time[prev] : 0;
+				pair[prev][s].push_back(d);
+			}
+			prev = s;
+		}
+	}
+
+	std::vector<LatencyStats> stats;
+	for (size_t a = 0; a < kStageCount; ++a) {
+		for (size_t b = a + 1; b < kStageCount; ++b) {
+			if (!pair[a][b].empty()) stats.push_back(makeStats(static_cast<TraceStage>(a), static_cast<TraceStage>(b), pair[a][b]));
+		}
+	}
+
+	// 端到端：从设备采集到最后一个阶段（通常为 Rendered）
+	const size_t first = static_cast<size_t>(TraceStage::DeviceCapture);
+	for (size_t last = kStageCount - 1; last > first; --last) {
+		std::vector<uint64_t> total;
+		for (const auto& kv : events) {
+			const EventTimes& e = kv.second;
+			if (e.has(first) && e.has(last)) total.push_back(e.time[last] > e.time[first] ? e.time[last] - e.time[first] : 0);
+		}
+		if (!total.empty()) {
+			// 与某一对相邻阶段重复时不再重复输出
+			if (last != first + 1) stats.push_back(makeStats(TraceStage::DeviceCapture, static_cast<TraceStage>(last), total));
+			break;
+		}
+	}
+	return stats;
+}
+
+// 每个阶段一条即时事件，相邻阶段之间一条持续事件；时间以首条记录为零点（微秒）
+void writeChromeTrace(std::ostream& os, const std::vector<TraceRecord>& records) {
+	uint64_t origin = UINT64_MAX;
+	for (const TraceRecord& r : records) origin = std::min(origin, r.timeNs);
+	auto us = [&](uint64_t ns) { return (ns - origin) / 1000.0; };
+
+	char buf[256];
+	bool first = true;
+	auto emit = [&](const char* text) {
+		os << (first ? "\n    " : ",\n    ") << text;
+		first = false;
+	};
+
+	os << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+	for (const TraceRecord& r : records) {
+		std::snprintf(buf, sizeof(buf),
+			"{\"name\": \"%s\", \"ph\": \"i\", \"s\": \"t\", \"ts\": %.3f, \"pid\": 1, \"tid\": %u, \"args\": {\"event\": %llu}}",
+			traceStageName(r.stage), us(r.timeNs), r.thread, static_cast<unsigned long long>(r.eventId));
+		emit(buf);
+	}
+
+	std::map<uint64_t, EventTimes> events = groupByEvent(records);
+	for (const auto& kv : events) {
+		const EventTimes& e = kv.second;
+		size_t prev = kStageCount;
+		for (size_t s = 0; s < kStageCount; ++s) {
+			if (!e.has(s)) continue;
+			if (prev < kStageCount) {
+				uint64_t begin = e.time[prev];
+				uint64_t end = std::max(e.time[s], begin);
+				std::snprintf(buf, sizeof(buf),
+					"{\"name\": \"%s -> %s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": 1, \"tid\": %u, \"args\": {\"event\": %llu}}",
+					traceStageName(static_cast<TraceStage>(prev)), traceStageName(static_cast<TraceStage>(s)),
+					us(begin), (end - begin) / 1000.0, e.thread[s], static_cast<unsigned long long>(kv.first));
+				emit(buf);
+			}
+			prev = s;
+		}
+	}
+	os << "\n]}\n";
+}
+
+void writeLatencyReport(std::ostream& os, const std::vector<LatencyStats>& stats) {
+	char buf[256];
+	std::snprintf(buf, sizeof(buf), "%-32s %8s %10s %10s %10s\n", "latency (ms)", "count", "p50", "p99", "max");
+	os << buf;
+	for (const LatencyStats& st : stats) {
+		std::snprintf(buf, sizeof(buf), "%-14s -> %-14s %8zu %10.3f %10.3f %10.3f\n",
+			traceStageName(st.from), traceStageName(st.to), st.count, st.p50Ms, st.p99Ms, st.maxMs);
+		os << buf;
+	}
+
+	// 直方图：每段延迟的非空桶
+	for (const LatencyStats& st : stats) {
+		uint64_t peak = 0;
+		for (uint64_t c : st.histogram) peak = std::max(peak, c);
+		if (!peak) continue;
+		os << "\n" << traceStageName(st.from) << " -> " << traceStageName(st.to) << "\n";
+		for (size_t b = 0; b < st.histogram.size(); ++b) {
+			if (!st.histogram[b]) continue;
+			unsigned long long lo = b ? (1ull << (b - 1)) : 0;
+			unsigned long long hi = 1ull << b;
+			int bar = static_cast<int>(40 * st.histogram[b] / peak);
+			std::snprintf(buf, sizeof(buf), "  [%8llu, %8llu) us %8llu ", lo, hi, static_cast<unsigned long long>(st.histogram[b]));
+			os << buf << std::string(static_cast<size_t>(std::max(bar, 1)), '#') << "\n";
+		}
+	}
+}
@@ -0,0 +1,799 @@
+﻿#include "LosslessCodec.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+	const char kMagic[4] = { 'A', 'C', 'L', 'C' };
+	const char kIndexMagic[4] = { 'A', 'C', 'I', 'X' };
+	const uint32_t kVersion = 1;
+	const size_t kHeaderSize = 40;
+	const size_t kBlockHeaderSize = 8;    // payload 字节数 + 采样帧数
+	const uint32_t kPartitionSize = 256;  // Rice 参数的分区长度
+	const uint32_t kEscape = 24;          // 商达到该值时改为直接写 64 位原值（保序浮点位模式的大残差）
+	const unsigned kWarmupBits = 40;      // 预测器起始采样（mid/side 后为 33 位有符号）
+	const unsigned kMaxRice = 40;
+	const unsigned kLpcPrecision = 15;    // LPC 系数量化位数（含符号）
+	const uint32_t kFixedOrders = 5;      // 定阶多项式预测 0 ~ 4 阶
+
+	// 块内整数化方式
+	enum Transform : uint32_t {
+		kTransformInt = 0,        // 整数采样
+		kTransformFloatExact = 1, // 浮点采样全部是 2^-23 的整数倍（16 / 24 位源经混音器转换的常见情况）
+		kTransformFloatBits = 2,  // 其他浮点：按保序映射的 32 位位模式
+	};
+
+	const double kFloatScale = 8388608.0;  // 2^23
+
+	class BitWriter {
+	public:
+		explicit BitWriter(std::vector<uint8_t>& out) : out_(out) {}
+
+		// n ≤ 32
+		void put(uint64_t v, unsigned n) {
+			acc_ = (acc_ << n) | (v & ((1ull << n) - 1));
+			bits_ += n;
+			while (bits_ >= 8) {
+				bits_ -= 8;
+				out_.push_back(static_cast<uint8_t>(acc_ >> bits_));
+			}
+		}
+
+		void put64(uint64_t v, unsigned n) {
+			if (n > 32) {
+				put(v >> 32, n - 32);
+				put(v, 32);
+			}
+			else {
+				put(v, n);
+			}
+		}
+
+		void putRice(uint64_t u, unsigned k) {
+			uint64_t q = u >> k;
+			if (q < kEscape) {
+				put(((1ull << q) - 1) << 1, static_cast<unsigned>(q) + 1);
+				put64(u, k);
+			}
+			else {
+				put((1ull << kEscape) - 1, kEscape);
+				put64(u, 64);
+			}
+		}
+
+		void finish() {
+			if (bits_) out_.push_back(static_cast<uint8_t>(acc_ << (8 - bits_)));
+			bits_ = 0;
+		}
+
+	private:
+		std::vector<uint8_t>& out_;
+		uint64_t acc_ = 0;
+		unsigned bits_ = 0;
+	};
+
+	class BitReader {
+	public:
+		BitReader(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+		uint64_t get(unsigned n) {
+			while (bits_ < n) {
+				if (pos_ >= size_) {
+					ok_ = false;
+					return 0;
+				}
+				acc_ = (acc_ << 8) | data_[pos_++];
+				bits_ += 8;
+			}
+			bits_ -= n;
+			return (acc_ >> bits_) & ((1ull << n) - 1);
+		}
+
+		uint64_t get64(unsigned n) {
+			if (n > 32) {
+				uint64_t hi = get(n - 32);
+				return (hi << 32) | get(32);
+			}
+			return get(n);
+		}
+
+		int64_t getSigned(unsigned n) {
+			uint64_t v = get64(n);
+			if (n < 64 && ((v >> (n - 1)) & 1)) v |= ~0ull << n;
+			return static_cast<int64_t>(v);
+		}
+
+		uint64_t getRice(unsigned k) {
+			uint32_t q = 0;
+			while (q < kEscape && ok_ && get(1)) ++q;
+			if (q == kEscape) return get64(64);
+			return (static_cast<uint64_t>(q) << k) | get64(k);
+		}
+
+		bool ok() const { return ok_; }
+
+	private:
+		const uint8_t* data_;
+		size_t size_;
+		size_t pos_ = 0;
+		uint64_t acc_ = 0;
+		unsigned bits_ = 0;
+		bool ok_ = true;
+	};
+
+	uint64_t zigzag(int64_t v) {
+		return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+	}
+
+	int64_t unzigzag(uint64_t u) {
+		return static_cast<int64_t>(u >> 1) ^ -static_cast<int64_t>(u & 1);
+	}
+
+	// 预测与重建按 2^64 取模（无符号）计算：合法数据的中间值不会溢出，结果与有符号运算相同；
+	// 损坏的块只会解出错误的采样，不会发生有符号溢出
+	uint64_t u64(int64_t v) { return static_cast<uint64_t>(v); }
+
+	int64_t wrapAdd(int64_t a, int64_t b) { return static_cast<int64_t>(u64(a) + u64(b)); }
+
+	// 定阶多项式预测（FLAC 的 fixed predictor）
+	int64_t fixedPredict(const int64_t* x, size_t i, uint32_t order) {
+		switch (order) {
+		case 1: return x[i - 1];
+		case 2: return static_cast<int64_t>(2 * u64(x[i - 1]) - u64(x[i - 2]));
+		case 3: return static_cast<int64_t>(3 * u64(x[i - 1]) - 3 * u64(x[i - 2]) + u64(x[i - 3]));
+		case 4: return static_cast<int64_t>(4 * u64(x[i - 1]) - 6 * u64(x[i - 2]) + 4 * u64(x[i - 3]) - u64(x[i - 4]));
+		default: return 0;
+		}
+	}
+
+	int64_t lpcPredict(const int64_t* x, size_t i, const int32_t* coefs, uint32_t order, uint32_t shift) {
+		uint64_t sum = 0;
+		for (uint32_t j = 0; j < order; ++j) sum += u64(coefs[j]) * u64(x[i - 1 - j]);
+		return static_cast<int64_t>(sum) >> shift;
+	}
+
+	// 分区 Rice 参数：使 count*(k+1) + sum>>k 最小
+	unsigned bestRice(uint64_t sum, uint64_t count, uint64_t& bits) {
+		unsigned best = 0;
+		bits = ~0ull;
+		for (unsigned k = 0; k <= kMaxRice; ++k) {
+			uint64_t b = count * (k + 1) + (sum >> k);
+			if (b < bits) {
+				bits = b;
+				best = k;
+			}
+			else if (k > 0) {
+				break;  // 代价对 k 为单峰
+			}
+		}
+		return best;
+	}
+
+	// 残差（从 order 开始）的估计编码位数
+	uint64_t residualBits(const int64_t* res, size_t n, uint32_t order) {
+		uint64_t total = 0;
+		for (size_t start = 0; start < n; start += kPartitionSize) {
+			size_t end = std::min<size_t>(n, start + kPartitionSize);
+			size_t begin = std::max<size_t>(start, order);
+			uint64_t sum = 0;
+			for (size_t i = begin; i < end; ++i) sum += zigzag(res[i]);
+			uint64_t bits = 0;
+			bestRice(sum, end - begin, bits);
+			total += 6 + bits;
+		}
+		return total;
+	}
+
+	void put16(uint8_t* p, uint32_t x) {
+		p[0] = static_cast<uint8_t>(x);
+		p[1] = static_cast<uint8_t>(x >> 8);
+	}
+
+	void put32(uint8_t* p, uint32_t x) {
+		put16(p, x & 0xFFFF);
+		put16(p + 2, x >> 16);
+	}
+
+	void put64(uint8_t* p, uint64_t x) {
+		put32(p, static_cast<uint32_t>(x));
+		put32(p + 4, static_cast<uint32_t>(x >> 32));
+	}
+
+	uint32_t get16(const uint8_t* p) {
+		return static_cast<uint32_t>(p[0] | (p[1] << 8));
+	}
+
+	uint32_t get32(const uint8_t* p) {
+		return get16(p) | (get16(p + 2) << 16);
+	}
+
+	uint64_t get64(const uint8_t* p) {
+		return get32(p) | (static_cast<uint64_t>(get32(p + 4)) << 32);
+	}
+
+	uint32_t bytesPerSample(SampleType type) {
+		switch (type) {
+		case SampleType::Int16: return 2;
+		case SampleType::Int24: return 3;
+		case SampleType::Int32: return 4;
+		case SampleType::Float32: return 4;
+		default: return 0;
+		}
+	}
+}
+
+const uint32_t LosslessBlockCodec::kMaxOrder;
+const uint32_t LosslessBlockCodec::kMaxBlockFrames;
+const uint32_t LosslessBlockCodec::kMaxChannels;
+
+bool LosslessBlockCodec::configure(const StreamFormat& format, const LosslessConfig& config) {
+	uint32_t bps = bytesPerSample(format.type);
+	if (!bps || format.channels == 0 || format.channels > kMaxChannels || format.blockAlign != bps * format.channels) return false;
+	if (config.blockFrames > kMaxBlockFrames) return false;
+	format_ = format;
+	config_ = config;
+	config_.blockFrames = std::max<uint32_t>(config.blockFrames, 1);
+	config_.maxLpcOrder = std::min(std::max<uint32_t>(config.maxLpcOrder, 1), kMaxOrder);
+
+	size_t n = config_.blockFrames;
+	channels_.assign(n * format.channels, 0);
+	residual_.assign(n, 0);
+	best_.assign(n, 0);
+	windowed_.assign(n, 0.0);
+	window_.assign(n, 1.0);
+	// Welch 窗：自相关估计的边缘效应更小
+	for (size_t i = 0; i < n; ++i) {
+		double t = (static_cast<double>(i) - (n - 1) * 0.5) / ((n + 1) * 0.5);
+		window_[i] = 1.0 - t * t;
+	}
+	return true;
+}
+
+// 块布局（按位）：transform(2) midSide(1)，每个声道：wasted(6) kind(1) order(6)
+// [LPC: shift(5) coefs(15 × order)] warmup(40 × order) 分区 { k(6) Rice 残差 }
+void LosslessBlockCodec::encode(const uint8_t* pcm, uint32_t frames, std::vector<uint8_t>& out) {
+	const uint32_t channels = format_.channels;
+	const size_t stride = config_.blockFrames;
+	frames = std::min(frames, config_.blockFrames);
+
+	// 整数化：浮点块先判断能否按 2^-23 的整数倍精确表示
+	uint32_t transform = kTransformInt;
+	if (format_.type == SampleType::Float32) {
+		transform = kTransformFloatExact;
+		for (size_t i = 0; i < static_cast<size_t>(frames) * channels; ++i) {
+			uint32_t bits;
+			std::memcpy(&bits, pcm + i * 4, 4);
+			float f;
+			std::memcpy(&f, &bits, 4);
+			double d = static_cast<double>(f) * kFloatScale;
+			if (bits == 0x80000000u || !(std::fabs(d) < 2147483648.0) || d != std::floor(d)) {
+				transform = kTransformFloatBits;
+				break;
+			}
+		}
+	}
+	for (uint32_t c = 0; c < channels; ++c) {
+		int64_t* x = &channels_[c * stride];
+		for (uint32_t i = 0; i < frames; ++i) {
+			const uint8_t* p = pcm + (static_cast<size_t>(i) * channels + c) * bytesPerSample(format_.type);
+			switch (format_.type) {
+			case SampleType::Int16: {
+				int16_t v;
+				std::memcpy(&v, p, 2);
+				x[i] = v;
+				break;
+			}
+			case SampleType::Int24:
+				x[i] = static_cast<int32_t>((p[0] << 8) | (p[1] << 16) | (static_cast<uint32_t>(p[2]) << 24)) >> 8;
+				break;
+			case SampleType::Int32: {
+				int32_t v;
+				std::memcpy(&v, p, 4);
+				x[i] = v;
+				break;
+			}
+			default: {
+				uint32_t bits;
+				std::memcpy(&bits, p, 4);
+				if (transform == kTransformFloatExact) {
+					float f;
+					std::memcpy(&f, &bits, 4);
+					x[i] = static_cast<int64_t>(static_cast<double>(f) * kFloatScale);
+				}
+				else {
+					int32_t s = static_cast<int32_t>(bits);
+					x[i] = s ^ ((s >> 31) & 0x7FFFFFFF);  // 保序：负数按绝对值反向
+				}
+				break;
+			}
+			}
+		}
+	}
+
+	// 立体声去相关：按二阶差分的绝对值之和比较 L/R 与 M/S
+	bool midSide = false;
+	if (channels >= 2 && frames > 2) {
+		int64_t* l = &channels_[0];
+		int64_t* r = &channels_[stride];
+		uint64_t costLr = 0, costMs = 0;
+		for (uint32_t i = 2; i < frames; ++i) {
+			int64_t dl = l[i] - 2 * l[i - 1] + l[i - 2];
+			int64_t dr = r[i] - 2 * r[i - 1] + r[i - 2];
+			costLr += static_cast<uint64_t>(std::llabs(dl)) + static_cast<uint64_t>(std::llabs(dr));
+			costMs += static_cast<uint64_t>(std::llabs((dl + dr) >> 1)) + static_cast<uint64_t>(std::llabs(dl - dr));
+		}
+		if (costMs < costLr) {
+			midSide = true;
+			for (uint32_t i = 0; i < frames; ++i) {
+				int64_t mid = (l[i] + r[i]) >> 1;
+				int64_t side = l[i] - r[i];
+				l[i] = mid;
+				r[i] = side;
+			}
+		}
+	}
+
+	BitWriter bw(out);
+	bw.put(transform, 2);
+	bw.put(midSide ? 1 : 0, 1);
+
+	for (uint32_t c = 0; c < channels; ++c) {
+		int64_t* x = &channels_[c * stride];
+
+		// 所有采样共有的低位零（如 16 位源的浮点采样）先移出
+		uint64_t any = 0;
+		for (uint32_t i = 0; i < frames; ++i) any |= static_cast<uint64_t>(x[i]);
+		uint32_t wasted = 0;
+		if (any) {
+			while (!((any >> wasted) & 1) && wasted < 63) ++wasted;
+		}
+		if (wasted) {
+			for (uint32_t i = 0; i < frames; ++i) x[i] >>= wasted;
+		}
+
+		// 候选：定阶 0 ~ 4，LPC maxOrder 与 maxOrder / 2；取估计位数最小者
+		uint32_t bestKind = 0, bestOrder = 0, bestShift = 0;
+		int32_t bestCoefs[kMaxOrder] = {};
+		uint64_t bestBits = ~0ull;
+		for (uint32_t order = 0; order < kFixedOrders && order <= frames; ++order) {
+			for (uint32_t i = order; i < frames; ++i) residual_[i] = x[i] - fixedPredict(x, i, order);
+			uint64_t bits = residualBits(residual_.data(), frames, order) + order * kWarmupBits;
+			if (bits < bestBits) {
+				bestBits = bits;
+				bestKind = 0;
+				bestOrder = order;
+				std::swap(residual_, best_);
+			}
+		}
+
+		uint32_t maxOrder = std::min(config_.maxLpcOrder, frames > 1 ? frames - 1 : 0);
+		if (maxOrder >= 1 && frames > 2 * maxOrder) {
+			// 加窗自相关 + Levinson-Durbin
+			double mean = 0.0;
+			for (uint32_t i = 0; i < frames; ++i) mean += static_cast<double>(x[i]);
+			mean /= frames;
+			double scale = static_cast<double>(frames) / config_.blockFrames;
+			for (uint32_t i = 0; i < frames; ++i) {
+				size_t w = static_cast<size_t>(i / scale);
+				windowed_[i] = (static_cast<double>(x[i]) - mean) * window_[std::min(w, window_.size() - 1)];
+			}
+			double autoc[kMaxOrder + 1];
+			for (uint32_t lag = 0; lag <= maxOrder; ++lag) {
+				double s = 0.0;
+				for (uint32_t i = lag; i < frames; ++i) s += windowed_[i] * windowed_[i - lag];
+				autoc[lag] = s;
+			}
+			if (autoc[0] > 0.0) {
+				double lpc[kMaxOrder + 1][kMaxOrder] = {};
+				double a[kMaxOrder] = {};
+				double err = autoc[0] * (1.0 + 1e-9);
+				uint32_t solved = 0;
+				for (uint32_t m = 0; m < maxOrder; ++m) {
+					double acc = autoc[m + 1];
+					for (uint32_t j = 0; j < m; ++j) acc -= a[j] * autoc[m - j];
+					double k = acc / err;
+					double tmp[kMaxOrder];
+					for (uint32_t j = 0; j < m; ++j) tmp[j] = a[j] - k * a[m - 1 - j];
+					for (uint32_t j = 0; j < m; ++j) a[j] = tmp[j];
+					a[m] = k;
+					err *= (1.0 - k * k);
+					for (uint32_t j = 0; j <= m; ++j) lpc[m + 1][j] = a[j];
+					solved = m + 1;
+					if (err <= 0.0) break;
+				}
+
+				const uint32_t orders[2] = { solved, std::max<uint32_t>(1, solved / 2) };
+				for (uint32_t t = 0; t < 2; ++t) {
+					uint32_t order = orders[t];
+					if (order == 0 || (t == 1 && order == orders[0])) continue;
+					// 量化：最大系数占满 kLpcPrecision - 1 位
+					double cmax = 0.0;
+					for (uint32_t j = 0; j < order; ++j) cmax = std::max(cmax, std::fabs(lpc[order][j]));
+					if (cmax <= 0.0) continue;
+					int exponent = 0;
+					std::frexp(cmax, &exponent);
+					int shift = static_cast<int>(kLpcPrecision) - 1 - exponent;
+					shift = std::min(std::max(shift, 0), 31);
+					const int32_t qmax = (1 << (kLpcPrecision - 1)) - 1;
+					int32_t coefs[kMaxOrder];
+					double errorFeedback = 0.0;
+					for (uint32_t j = 0; j < order; ++j) {
+						double v = lpc[order][j] * std::ldexp(1.0, shift) + errorFeedback;
+						long q = std::lround(v);
+						q = std::min<long>(std::max<long>(q, -qmax - 1), qmax);
+						errorFeedback = v - static_cast<double>(q);
+						coefs[j] = static_cast<int32_t>(q);
+					}
+					for (uint32_t i = order; i < frames; ++i) {
+						residual_[i] = x[i] - lpcPredict(x, i, coefs, order, static_cast<uint32_t>(shift));
+					}
+					uint64_t bits = residualBits(residual_.data(), frames, order) + order * (kWarmupBits + kLpcPrecision) + 5;
+					if (bits < bestBits) {
+						bestBits = bits;
+						bestKind = 1;
+						bestOrder = order;
+						bestShift = static_cast<uint32_t>(shift);
+						std::copy(coefs, coefs + order, bestCoefs);
+						std::swap(residual_, best_);
+					}
+				}
+			}
+		}
+
+		bw.put(wasted, 6);
+		bw.put(bestKind, 1);
+		bw.put(bestOrder, 6);
+		if (bestKind == 1) {
+			bw.put(bestShift, 5);
+			for (uint32_t j = 0; j < bestOrder; ++j) bw.put(static_cast<uint32_t>(bestCoefs[j]), kLpcPrecision);
+		}
+		for (uint32_t i = 0; i < bestOrder; ++i) bw.put64(static_cast<uint64_t>(x[i]), kWarmupBits);
+		for (size_t start = 0; start < frames; start += kPartitionSize) {
+			size_t end = std::min<size_t>(frames, start + kPartitionSize);
+			size_t begin = std::max<size_t>(start, bestOrder);
+			uint64_t sum = 0;
+			for (size_t i = begin; i < end; ++i) sum += zigzag(best_[i]);
+			uint64_t bits = 0;
+			unsigned k = bestRice(sum, end - begin, bits);
+			bw.put(k, 6);
+			for (size_t i = begin; i < end; ++i) bw.putRice(zigzag(best_[i]), k);
+		}
+	}
+	bw.finish();
+}
+
+bool LosslessBlockCodec::decode(const uint8_t* data, size_t size, uint32_t frames, uint8_t* pcm) {
+	if (frames > config_.blockFrames || format_.channels == 0) return false;
+	const uint32_t channels = format_.channels;
+	const size_t stride = config_.blockFrames;
+	BitReader br(data, size);
+	uint32_t transform = static_cast<uint32_t>(br.get(2));
+	bool midSide = br.get(1) != 0;
+	if (transform > kTransformFloatBits || (transform != kTransformInt) != (format_.type == SampleType::Float32)) return false;
+	if (midSide && channels < 2) return false;
+
+	for (uint32_t c = 0; c < channels; ++c) {
+		int64_t* x = &channels_[c * stride];
+		uint32_t wasted = static_cast<uint32_t>(br.get(6));
+		uint32_t kind = static_cast<uint32_t>(br.get(1));
+		uint32_t order = static_cast<uint32_t>(br.get(6));
+		if (order > kMaxOrder || (order > frames && frames) || (kind == 0 && order >= kFixedOrders)) return false;
+		uint32_t shift = 0;
+		int32_t coefs[kMaxOrder] = {};
+		if (kind == 1) {
+			shift = static_cast<uint32_t>(br.get(5));
+			for (uint32_t j = 0; j < order; ++j) coefs[j] = static_cast<int32_t>(br.getSigned(kLpcPrecision));
+		}
+		for (uint32_t i = 0; i < order; ++i) x[i] = br.getSigned(kWarmupBits);
+		for (size_t start = 0; start < frames; start += kPartitionSize) {
+			size_t end = std::min<size_t>(frames, start + kPartitionSize);
+			size_t begin = std::max<size_t>(start, order);
+			unsigned k = static_cast<unsigned>(br.get(6));
+			if (k > kMaxRice) return false;
+			for (size_t i = begin; i < end; ++i) {
+				int64_t r = unzigzag(br.getRice(k));
+				x[i] = wrapAdd(r, kind == 1 ? lpcPredict(x, i, coefs, order, shift) : fixedPredict(x, i, order));
+			}
+			if (!br.ok()) return false;
+		}
+		if (wasted) {
+			for (uint32_t i = 0; i < frames; ++i) x[i] = static_cast<int64_t>(static_cast<uint64_t>(x[i]) << wasted);
+		}
+	}
+	if (!br.ok()) return false;
+
+	if (midSide) {
+		int64_t* l = &channels_[0];
+		int64_t* r = &channels_[stride];
+		for (uint32_t i = 0; i < frames; ++i) {
+			int64_t side = r[i];
+			int64_t sum = static_cast<int64_t>(static_cast<uint64_t>(l[i]) << 1) | (side & 1);
+			l[i] = wrapAdd(sum, side) >> 1;
+			r[i] = static_cast<int64_t>(u64(sum) - u64(side)) >> 1;
+		}
+	}
+
+	uint32_t bps = bytesPerSample(format_.type);
+	for (uint32_t c = 0; c < channels; ++c) {
+		const int64_t* x = &channels_[c * stride];
+		for (uint32_t i = 0; i < frames; ++i) {
+			uint8_t* p = pcm + (static_cast<size_t>(i) * channels + c) * bps;
+			switch (format_.type) {
+			case SampleType::Int16: {
+				int16_t v = static_cast<int16_t>(x[i]);
+				std::memcpy(p, &v, 2);
+				break;
+			}
+			case SampleType::Int24: {
+				uint32_t v = static_cast<uint32_t>(x[i]);
+				p[0] = static_cast<uint8_t>(v);
+				p[1] = static_cast<uint8_t>(v >> 8);
+				p[2] = static_cast<uint8_t>(v >> 16);
+				break;
+			}
+			case SampleType::Int32: {
+				int32_t v = static_cast<int32_t>(x[i]);
+				std::memcpy(p, &v, 4);
+				break;
+			}
+			default: {
+				uint32_t bits;
+				if (transform == kTransformFloatExact) {
+					float f = static_cast<float>(static_cast<double>(x[i]) / kFloatScale);
+					std::memcpy(&bits, &f, 4);
+				}
+				else {
+					int32_t s = static_cast<int32_t>(x[i]);
+					bits = static_cast<uint32_t>(s ^ ((s >> 31) & 0x7FFFFFFF));
+				}
+				std::memcpy(p, &bits, 4);
+				break;
+			}
+			}
+		}
+	}
+	return true;
+}
+
+bool LosslessEncoder::open(std::ostream& out, const StreamFormat& format, const LosslessConfig& config) {
+	if (!codec_.configure(format, config)) return false;
+	out_ = &out;
+	config_ = config;
+	config_.blockFrames = std::max<uint32_t>(config.blockFrames, 1);
+	pending_.clear();
+	pending_.reserve(static_cast<size_t>(config_.blockFrames) * format.blockAlign);
+	index_.clear();
+	frames_ = 0;
+	bytesIn_ = 0;
+	bytesOut_ = kHeaderSize;
+	return writeHeader(0);
+}
+
+bool LosslessEncoder::write(const uint8_t* pcm, size_t bytes) {
+	if (!out_) return false;
+	bytesIn_ += bytes;
+	const size_t blockBytes = static_cast<size_t>(config_.blockFrames) * codec_.format().blockAlign;
+	while (bytes) {
+		size_t n = std::min(bytes, blockBytes - pending_.size());
+		pending_.insert(pending_.end(), pcm, pcm + n);
+		pcm += n;
+		bytes -= n;
+		if (pending_.size() == blockBytes && !flushBlock()) return false;
+	}
+	return true;
+}
+
+bool LosslessEncoder::flushBlock() {
+	const uint32_t blockAlign = codec_.format().blockAlign;
+	uint32_t frames = static_cast<uint32_t>(pending_.size() / blockAlign);
+	if (frames == 0) return true;
+
+	encoded_.assign(kBlockHeaderSize, 0);
+	codec_.encode(pending_.data(), frames, encoded_);
+	put32(encoded_.data(), static_cast<uint32_t>(encoded_.size() - kBlockHeaderSize));
+	put32(encoded_.data() + 4, frames);
+	out_->write(reinterpret_cast<const char*>(encoded_.data()), static_cast<std::streamsize>(encoded_.size()));
+
+	IndexEntry entry = { frames_, bytesOut_ };
+	index_.push_back(entry);
+	frames_ += frames;
+	bytesOut_ += encoded_.size();
+	pending_.erase(pending_.begin(), pending_.begin() + static_cast<size_t>(frames) * blockAlign);
+	return out_->good();
+}
+
+bool LosslessEncoder::writeHeader(uint64_t indexOffset) {
+	const StreamFormat& f = codec_.format();
+	uint8_t header[kHeaderSize] = {};
+	std::memcpy(header, kMagic, 4);
+	put16(header + 4, kVersion);
+	header[6] = static_cast<uint8_t>(f.type);
+	put16(header + 8, f.channels);
+	put32(header + 12, f.sampleRate);
+	put32(header + 16, f.blockAlign);
+	put32(header + 20, config_.blockFrames);
+	put64(header + 24, frames_);
+	put64(header + 32, indexOffset);
+
+	std::streampos end = out_->tellp();
+	if (end > 0) out_->seekp(0, std::ios::beg);
+	out_->write(reinterpret_cast<const char*>(header), kHeaderSize);
+	if (end > 0) out_->seekp(end);
+	return out_->good();
+}
+
+bool LosslessEncoder::checkpoint() {
+	if (!out_) return false;
+	bool ok = flushBlock() && writeHeader(0);
+	out_->flush();
+	return ok && out_->good();
+}
+
+bool LosslessEncoder::finish() {
+	if (!out_) return false;
+	bool ok = flushBlock();
+	uint64_t indexOffset = bytesOut_;
+	std::vector<uint8_t> index(8 + index_.size() * 16);
+	std::memcpy(index.data(), kIndexMagic, 4);
+	put32(index.data() + 4, static_cast<uint32_t>(index_.size()));
+	for (size_t i = 0; i < index_.size(); ++i) {
+		put64(index.data() + 8 + i * 16, index_[i].frame);
+		put64(index.data() + 16 + i * 16, index_[i].offset);
+	}
+	out_->write(reinterpret_cast<const char*>(index.data()), static_cast<std::streamsize>(index.size()));
+	bytesOut_ += index.size();
+	ok = ok && writeHeader(indexOffset);
+	out_->flush();
+	ok = ok && out_->good();
+	out_ = nullptr;
+	return ok;
+}
+
+bool LosslessDecoder::open(const std::string& path, std::string* error) {
+	auto fail = [&](const char* message) {
+		if (error) *error = message;
+		in_.close();
+		return false;
+	};
+	in_.close();
+	in_.clear();
+	in_.open(path, std::ios::binary);
+	if (!in_.is_open()) return fail("cannot open file");
+	uint8_t header[kHeaderSize];
+	if (!in_.read(reinterpret_cast<char*>(header), kHeaderSize) || std::memcmp(header, kMagic, 4) != 0) {
+		return fail("not a lossless capture file");
+	}
+	if (get16(header + 4) != kVersion) return fail("unsupported version");
+
+	StreamFormat f;
+	f.type = static_cast<SampleType>(header[6]);
+	f.channels = get16(header + 8);
+	f.sampleRate = get32(header + 12);
+	f.blockAlign = get32(header + 16);
+	LosslessConfig config;
+	config.blockFrames = get32(header + 20);
+	uint64_t headerFrames = get64(header + 24);
+	uint64_t indexOffset = get64(header + 32);
+	// 块长与声道数决定工作缓冲的大小，超出上限的文件头按损坏处理，不按其分配内存
+	if (config.blockFrames == 0 || config.blockFrames > LosslessBlockCodec::kMaxBlockFrames ||
+		f.channels > LosslessBlockCodec::kMaxChannels) {
+		return fail("corrupt header");
+	}
+	if (!codec_.configure(f, config)) return fail("unsupported sample format");
+
+	in_.seekg(0, std::ios::end);
+	uint64_t fileSize = static_cast<uint64_t>(in_.tellg());
+	blocks_.clear();
+	hadIndex_ = false;
+
+	// 正常结束的文件：读索引（块长度由相邻偏移得到）；否则按块头顺序扫描到最后一个完整的块
+	uint8_t indexHead[8];
+	if (indexOffset >= kHeaderSize && indexOffset + 8 <= fileSize) {
+		in_.seekg(static_cast<std::streamoff>(indexOffset));
+		if (in_.read(reinterpret_cast<char*>(indexHead), 8) && std::memcmp(indexHead, kIndexMagic, 4) == 0) {
+			uint32_t count = get32(indexHead + 4);
+			// 先按文件剩余长度检查条目数，再分配
+			std::vector<uint8_t> entries;
+			if (count <= (fileSize - indexOffset - 8) / 16) entries.resize(static_cast<size_t>(count) * 16);
+			if (entries.size() == static_cast<size_t>(count) * 16 &&
+				in_.read(reinterpret_cast<char*>(entries.data()), static_cast<std::streamsize>(entries.size()))) {
+				hadIndex_ = true;
+				for (uint32_t i = 0; i < count && hadIndex_; ++i) {
+					Block b;
+					b.frame = get64(&entries[i * 16]);
+					b.offset = get64(&entries[i * 16 + 8]);
+					uint64_t nextFrame = i + 1 < count ? get64(&entries[(i + 1) * 16]) : headerFrames;
+					uint64_t nextOffset = i + 1 < count ? get64(&entries[(i + 1) * 16 + 8]) : indexOffset;
+					if (nextFrame <= b.frame || nextFrame - b.frame > config.blockFrames ||
+						nextOffset < b.offset + kBlockHeaderSize || (i == 0 && b.frame != 0)) {
+						hadIndex_ = false;
+						break;
+					}
+					b.frames = static_cast<uint32_t>(nextFrame - b.frame);
+					b.size = static_cast<uint32_t>(nextOffset - b.offset - kBlockHeaderSize);
+					blocks_.push_back(b);
+				}
+			}
+		}
+		if (!hadIndex_) blocks_.clear();
+	}
+	if (!hadIndex_) {
+		uint64_t offset = kHeaderSize;
+		uint64_t frame = 0;
+		uint8_t head[kBlockHeaderSize];
+		while (offset + kBlockHeaderSize <= fileSize) {
+			in_.clear();
+			in_.seekg(static_cast<std::streamoff>(offset));
+			if (!in_.read(reinterpret_cast<char*>(head), kBlockHeaderSize)) break;
+			Block b;
+			b.size = get32(head);
+			b.frames = get32(head + 4);
+			if (b.frames == 0 || b.frames > config.blockFrames || offset + kBlockHeaderSize + b.size > fileSize) break;
+			if (std::memcmp(head, kIndexMagic, 4) == 0) break;
+			b.frame = frame;
+			b.offset = offset;
+			blocks_.push_back(b);
+			frame += b.frames;
+			offset += kBlockHeaderSize + b.size;
+		}
+	}
+	totalFrames_ = blocks_.empty() ? 0 : blocks_.back().frame + blocks_.back().frames;
+	in_.clear();
+	decoded_.assign(static_cast<size_t>(config.blockFrames) * f.blockAlign, 0);
+	current_ = 0;
+	consumed_ = 0;
+	loaded_ = false;
+	return true;
+}
+
+bool LosslessDecoder::seek(uint64_t frame) {
+	if (frame >= totalFrames_) {
+		current_ = blocks_.size();
+		consumed_ = 0;
+		loaded_ = false;
+		return frame == totalFrames_;
+	}
+	auto it = std::upper_bound(blocks_.begin(), blocks_.end(), frame,
+		[](uint64_t f, const Block& b) { return f < b.frame; });
+	size_t index = static_cast<size_t>(it - blocks_.begin()) - 1;
+	loaded_ = loaded_ && index == current_;
+	current_ = index;
+	consumed_ = static_cast<uint32_t>(frame - blocks_[index].frame);
+	return true;
+}
+
+size_t LosslessDecoder::read(uint8_t* pcm, size_t frames) {
+	const uint32_t blockAlign = codec_.format().blockAlign;
+	size_t done = 0;
+	while (done < frames && current_ < blocks_.size()) {
+		const Block& b = blocks_[current_];
+		if (!loaded_) {
+			payload_.resize(b.size);
+			in_.clear();
+			in_.seekg(static_cast<std::streamoff>(b.offset + kBlockHeaderSize));
+			if (!in_.read(reinterpret_cast<char*>(payload_.data()), b.size) ||
+				!codec_.decode(payload_.data(), payload_.size(), b.frames, decoded_.data())) {
+				break;
+			}
+			loaded_ = true;
+		}
+		size_t n = std::min<size_t>(frames - done, b.frames - consumed_);
+		std::memcpy(pcm + done * blockAlign, decoded_.data() + static_cast<size_t>(consumed_) * blockAlign, n * blockAlign);
+		done += n;
+		consumed_ += static_cast<uint32_t>(n);
+		if (consumed_ == b.frames) {
+			++current_;
+			consumed_ = 0;
+			loaded_ = false;
+		}
+	}
+	return done;
+}
+
+bool encodeLosslessFile(const std::string& path, const StreamFormat& format, const uint8_t* pcm, size_t bytes,
+	const LosslessConfig& config) {
+	std::ofstream out(path, std::ios::binary | std::ios::trunc);
+	if (!out.is_open()) return false;
+	LosslessEncoder encoder;
+	return encoder.open(out, format, config) && encoder.write(pcm, bytes) && encoder.finish();
+}
@@ -0,0 +1,134 @@
+﻿#include "MappedFile.h"
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX   // std::min / std::max 不被 windows.h 的宏替换
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+
+namespace {
+	std::wstring widen(const std::string& path) {
+		int n = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, nullptr, 0);
+		std::wstring w(n > 0 ? n : 0, L'\0');
+		if (n > 0) MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, &w[0], n);
+		if (!w.empty()) w.pop_back();
+		return w;
+	}
+}
+
+bool MappedFile::create(const std::string& path, size_t size) {
+	close();
+	// 允许其他进程同时打开读取
+	HANDLE file = CreateFileW(widen(path).c_str(), GENERIC_READ | GENERIC_WRITE,
+		FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) return false;
+	ULARGE_INTEGER len;
+	len.QuadPart = size;
+	HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READWRITE, len.HighPart, len.LowPart, nullptr);
+	void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size) : nullptr;
+	if (!view) {
+		if (mapping) CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+	file_ = file;
+	mapping_ = mapping;
+	data_ = view;
+	size_ = size;
+	return true;
+}
+
+bool MappedFile::openReadOnly(const std::string& path) {
+	close();
+	HANDLE file = CreateFileW(widen(path).c_str(), GENERIC_READ,
+		FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) return false;
+	LARGE_INTEGER len;
+	if (!GetFileSizeEx(file, &len) || len.QuadPart == 0) {
+		CloseHandle(file);
+		return false;
+	}
+	HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (!view) {
+		if (mapping) CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+	file_ = file;
+	mapping_ = mapping;
+	data_ = view;
+	size_ = static_cast<size_t>(len.QuadPart);
+	return true;
+}
+
+void MappedFile::close() {
+	if (data_) UnmapViewOfFile(data_);
+	if (mapping_) CloseHandle(mapping_);
+	if (file_) CloseHandle(file_);
+	data_ = nullptr;
+	mapping_ = nullptr;
+	file_ = nullptr;
+	size_ = 0;
+}
+
+#else
+
+bool MappedFile::create(const std::string& path, size_t size) {
+	close();
+	int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) return false;
+	// 截断为 0 后再扩展，保证内容全零
+	if (size == 0 || ::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+		::close(fd);
+		return false;
+	}
+	void* view = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (view == MAP_FAILED) {
+		::close(fd);
+		return false;
+	}
+	fd_ = fd;
+	data_ = view;
+	size_ = size;
+	return true;
+}
+
+bool MappedFile::openReadOnly(const std::string& path) {
+	close();
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) return false;
+	struct stat st;
+	if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+		::close(fd);
+		return false;
+	}
+	size_t size = static_cast<size_t>(st.st_size);
+	void* view = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+	if (view == MAP_FAILED) {
+		::close(fd);
+		return false;
+	}
+	fd_ = fd;
+	data_ = view;
+	size_ = size;
+	return true;
+}
+
+void MappedFile::close() {
+	if (data_) ::munmap(data_, size_);
+	if (fd_ >= 0) ::close(fd_);
+	data_ = nullptr;
+	fd_ = -1;
+	size_ = 0;
+}
+
+#endif
@@ -0,0 +1,37 @@
+﻿#include "NoiseFloor.h"
+#include "FrameAnalyzer.h"
+#include <algorithm>
+#include <cmath>
+
+void NoiseFloor::prepare(size_t bins) {
+	floor_.assign(bins, 0.0f);
+	primed_ = false;
+	lastOffset_ = 0;
+}
+
+size_t NoiseFloor::countAbove(const float* power, size_t bins, float threshold, uint64_t offset, uint32_t sampleRate,
+	uint32_t frameSize, const DetectorParams& params) {
+	if (floor_.size() < bins) floor_.resize(bins, 0.0f);
+	if (!primed_ || offset <= lastOffset_) {
+		std::copy(power, power + bins, floor_.begin());
+		primed_ = true;
+		lastOffset_ = offset;
+		return 0;
+	}
+
+	const double seconds = static_cast<double>(std::min<uint64_t>(offset - lastOffset_, frameSize)) / std::max(sampleRate, 1u);
+	lastOffset_ = offset;
+	const float rise = params.floorRiseSeconds > 0.0f ? static_cast<float>(1.0 - std::exp(-seconds / params.floorRiseSeconds)) : 1.0f;
+	const float fall = params.floorFallSeconds > 0.0f ? static_cast<float>(1.0 - std::exp(-seconds / params.floorFallSeconds)) : 1.0f;
+	const float margin = std::pow(10.0f, params.floorMarginDb / 10.0f);
+
+	size_t above = 0;
+	float* floor = floor_.data();
+	for (size_t k = 0; k < bins; ++k) {
+		const float p = power[k];
+		const float f = floor[k];
+		above += (p > threshold) & (p > margin * f);
+		floor[k] = f + (p > f ? rise : fall) * (p - f);
+	}
+	return above;
+}
@@ -0,0 +1,283 @@
+﻿#include "OverlayRenderer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+	const float kPi = 3.14159265f;
+
+	// 5×7 点阵，每行低 5 位从左到右
+	struct Glyph {
+		unsigned code;
+		uint8_t rows[7];
+	};
+
+	const unsigned kDegreeSign = 0xB0;
+
+	const Glyph kGlyphs[] = {
+		{ 'A', { 0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 } },
+		{ 'n', { 0x00, 0x00, 0x16, 0x19, 0x11, 0x11, 0x11 } },
+		{ 'g', { 0x00, 0x0F, 0x11, 0x11, 0x0F, 0x01, 0x0E } },
+		{ 'l', { 0x0C, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E } },
+		{ 'e', { 0x00, 0x00, 0x0E, 0x11, 0x1F, 0x10, 0x0E } },
+		{ ':', { 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00 } },
+		{ '-', { 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00 } },
+		{ '0', { 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E } },
+		{ '1', { 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E } },
+		{ '2', { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F } },
+		{ '3', { 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E } },
+		{ '4', { 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 } },
+		{ '5', { 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E } },
+		{ '6', { 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E } },
+		{ '7', { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 } },
+		{ '8', { 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E } },
+		{ '9', { 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C } },
+		{ kDegreeSign, { 0x0C, 0x12, 0x12, 0x0C, 0x00, 0x00, 0x00 } },
+	};
+
+	const Glyph* findGlyph(unsigned code) {
+		for (const Glyph& g : kGlyphs) {
+			if (g.code == code) return &g;
+		}
+		return nullptr;  // 未收录的字符（含空格）只前进一格
+	}
+
+	// 点到以原点为圆心、半径 r、中心角 mid ± halfSpan（弧度）的圆弧中线的距离，端点外按圆头处理
+	float distanceToArc(float dx, float dy, float r, float mid, float halfSpan) {
+		float delta = std::atan2(dy, dx) - mid;
+		while (delta > kPi) delta -= 2.0f * kPi;
+		while (delta < -kPi) delta += 2.0f * kPi;
+		if (std::fabs(delta) <= halfSpan) return std::fabs(std::sqrt(dx * dx + dy * dy) - r);
+		float end = mid + (delta > 0 ? halfSpan : -halfSpan);
+		float ex = dx - r * std::cos(end);
+		float ey = dy - r * std::sin(end);
+		return std::sqrt(ex * ex + ey * ey);
+	}
+}
+
+int OverlayRenderer::surfaceSize(float radius, float penWidth) {
+	return static_cast<int>(radius + penWidth) * 2;
+}
+
+void OverlayRenderer::configure(float radius, float penWidth, uint32_t* pixels, size_t strideBytes) {
+	radius_ = radius;
+	penWidth_ = penWidth;
+	size_ = surfaceSize(radius, penWidth);
+	stride_ = strideBytes ? strideBytes / sizeof(uint32_t) : static_cast<size_t>(size_);
+	if (pixels) {
+		ownPixels_.clear();
+		ownPixels_.shrink_to_fit();
+		pixels_ = pixels;
+	}
+	else {
+		ownPixels_.assign(stride_ * size_, 0);
+		pixels_ = ownPixels_.data();
+	}
+
+	// 外部缓冲的初始内容未知，首次清空整个画布
+	dirtyX0_ = 0;
+	dirtyY0_ = 0;
+	dirtyX1_ = size_;
+	dirtyY1_ = size_;
+	clear();
+	arcAtlas_.clear();
+}
+
+// 预渲染弧形图集：每个量化角度按到圆弧中线的距离解析计算覆盖率（线宽外 0.5 像素过渡）
+void OverlayRenderer::buildArcAtlas() {
+	const float span = style.arcSpan * kPi / 180.0f;
+	float halfChord = radius_ * std::sin(span * 0.5f);
+	spriteSize_ = static_cast<int>(std::ceil(2.0f * (halfChord + penWidth_))) + 4;
+	const int atlasW = spriteSize_ * kAtlasSteps;
+	const float center = penWidth_ / 2 + radius_;
+	const float halfPen = penWidth_ / 2;
+
+	arcAtlas_.assign(static_cast<size_t>(atlasW) * spriteSize_, 0);
+	arcSprites_.resize(kAtlasSteps);
+	for (int i = 0; i < kAtlasSteps; ++i) {
+		float rad = (270.0f + kAtlasMinAngle + i) * kPi / 180.0f;
+		int x0 = static_cast<int>(std::floor(center + radius_ * std::cos(rad) - spriteSize_ * 0.5f));
+		int y0 = static_cast<int>(std::floor(center + radius_ * std::sin(rad) - spriteSize_ * 0.5f));
+		arcSprites_[i] = { x0, y0 };
+
+		for (int sy = 0; sy < spriteSize_; ++sy) {
+			uint8_t* cov = &arcAtlas_[static_cast<size_t>(sy) * atlasW + i * spriteSize_];
+			float dy = y0 + sy + 0.5f - center;
+			for (int sx = 0; sx < spriteSize_; ++sx) {
+				float dx = x0 + sx + 0.5f - center;
+				float c = halfPen + 0.5f - distanceToArc(dx, dy, radius_, rad, span * 0.5f);
+				c = std::min(std::max(c, 0.0f), 1.0f);
+				cov[sx] = static_cast<uint8_t>(c * 255.0f + 0.5f);
+			}
+		}
+	}
+	atlasSpan_ = style.arcSpan;
+}
+
+void OverlayRenderer::markDirty(int x0, int y0, int x1, int y1) {
+	x0 = std::max(x0, 0);
+	y0 = std::max(y0, 0);
+	x1 = std::min(x1, size_);
+	y1 = std::min(y1, size_);
+	if (x0 >= x1 || y0 >= y1) return;
+	if (dirtyX0_ >= dirtyX1_ || dirtyY0_ >= dirtyY1_) {
+		dirtyX0_ = x0;
+		dirtyY0_ = y0;
+		dirtyX1_ = x1;
+		dirtyY1_ = y1;
+		return;
+	}
+	dirtyX0_ = std::min(dirtyX0_, x0);
+	dirtyY0_ = std::min(dirtyY0_, y0);
+	dirtyX1_ = std::max(dirtyX1_, x1);
+	dirtyY1_ = std::max(dirtyY1_, y1);
+}
+
+void OverlayRenderer::clear() {
+	if (!pixels_ || dirtyX0_ >= dirtyX1_ || dirtyY0_ >= dirtyY1_) return;
+	const size_t bytes = static_cast<size_t>(dirtyX1_ - dirtyX0_) * sizeof(uint32_t);
+	for (int y = dirtyY0_; y < dirtyY1_; ++y) {
+		std::memset(pixels_ + static_cast<size_t>(y) * stride_ + dirtyX0_, 0, bytes);
+	}
+	dirtyX0_ = dirtyY0_ = dirtyX1_ = dirtyY1_ = 0;
+}
+
+// 预乘 alpha 的 source-over，sa 为本像素的最终不透明度 [0, 255]
+void OverlayRenderer::blend(int x, int y, int sa, OverlayColor color) {
+	uint32_t& p = pixels_[static_cast<size_t>(y) * stride_ + x];
+	const int inv = 255 - sa;
+	int pb = p & 0xFF;
+	int pg = (p >> 8) & 0xFF;
+	int pr = (p >> 16) & 0xFF;
+	int pa = p >> 24;
+	pb = (color.b * sa + pb * inv + 127) / 255;
+	pg = (color.g * sa + pg * inv + 127) / 255;
+	pr = (color.r * sa + pr * inv + 127) / 255;
+	pa = sa + (pa * inv + 127) / 255;
+	p = (static_cast<uint32_t>(pa) << 24) | (static_cast<uint32_t>(pr) << 16) | (static_cast<uint32_t>(pg) << 8) | static_cast<uint32_t>(pb);
+}
+
+// 把量化角度对应的精灵以 color * alpha 叠加到画布上
+void OverlayRenderer::drawArc(float angleDeg, OverlayColor color, float alpha) {
+	if (!pixels_) return;
+	if (arcAtlas_.empty() || atlasSpan_ != style.arcSpan) buildArcAtlas();
+
+	int idx = static_cast<int>(std::lround(angleDeg)) - kAtlasMinAngle;
+	if (idx < 0) idx = 0;
+	if (idx >= kAtlasSteps) idx = kAtlasSteps - 1;
+
+	int a = static_cast<int>(color.a * alpha + 0.5f);
+	if (a <= 0) return;
+	if (a > 255) a = 255;
+
+	const ArcSprite& sprite = arcSprites_[idx];
+	const int atlasW = spriteSize_ * kAtlasSteps;
+	markDirty(sprite.x, sprite.y, sprite.x + spriteSize_, sprite.y + spriteSize_);
+
+	for (int sy = 0; sy < spriteSize_; ++sy) {
+		int dy = sprite.y + sy;
+		if (dy < 0 || dy >= size_) continue;
+
+		const uint8_t* cov = &arcAtlas_[static_cast<size_t>(sy) * atlasW + idx * spriteSize_];
+		for (int sx = 0; sx < spriteSize_; ++sx) {
+			int dx = sprite.x + sx;
+			if (!cov[sx] || dx < 0 || dx >= size_) continue;
+			blend(dx, dy, (a * cov[sx] + 127) / 255, color);
+		}
+	}
+}
+
+void OverlayRenderer::drawText(int x, int y, const char* utf8, OverlayColor color, int scale) {
+	if (!pixels_ || !utf8 || scale <= 0 || color.a == 0) return;
+	const int advance = 6 * scale;
+	int penX = x;
+	for (const unsigned char* s = reinterpret_cast<const unsigned char*>(utf8); *s; ++s) {
+		unsigned code = *s;
+		// 只解码两字节 UTF-8（足够覆盖 "°"），其余多字节字符按未收录处理
+		if ((code & 0xE0) == 0xC0 && (s[1] & 0xC0) == 0x80) {
+			code = ((code & 0x1F) << 6) | (s[1] & 0x3F);
+			++s;
+		}
+		const Glyph* glyph = findGlyph(code);
+		if (glyph) {
+			markDirty(penX, y, penX + 5 * scale, y + 7 * scale);
+			for (int row = 0; row < 7; ++row) {
+				for (int col = 0; col < 5; ++col) {
+					if (!((glyph->rows[row] >> (4 - col)) & 1)) continue;
+					for (int py = y + row * scale; py < y + (row + 1) * scale; ++py) {
+						if (py < 0 || py >= size_) continue;
+						for (int px = penX + col * scale; px < penX + (col + 1) * scale; ++px) {
+							if (px >= 0 && px < size_) blend(px, py, color.a, color);
+						}
+					}
+				}
+			}
+		}
+		penX += advance;
+	}
+}
+
+// 残影时长参数变化时重新计算各方位桶的衰减常数
+void OverlayRenderer::syncTrailDecay() {
+	if (trailBase_ == style.trailBaseDuration && trailMax_ == style.trailMaxDuration) return;
+	trails_.configure(style.trailBaseDuration, style.trailMaxDuration);
+	trailBase_ = style.trailBaseDuration;
+	trailMax_ = style.trailMaxDuration;
+}
+
+void OverlayRenderer::addEvent(float angleDeg, uint64_t nowMs) {
+	// 只在角度超过阈值时留下残影
+	if (std::fabs(angleDeg) > style.trailAngleThreshold) {
+		syncTrailDecay();
+		trails_.add(angleDeg, nowMs);
+	}
+	hasLive_ = true;
+	liveAngle_ = angleDeg;
+	liveTs_ = nowMs;
+}
+
+// 绘制残影热度环、实时弧形与文字
+bool OverlayRenderer::render(uint64_t nowMs) {
+	clear();
+	syncTrailDecay();
+
+	// 每个可见的方位桶画一段弧：能量 ≤ 1 时按能量调制 trailColor 的透明度，
+	// 同一方向反复命中（能量 > 1）时颜色向 liveColor 过渡
+	bool trailsVisible = false;
+	const float hotRange = std::max(trails_.maxEnergy - 1.0f, 1e-3f);
+	trails_.forEachActive(nowMs, [&](float angle, float energy) {
+		OverlayColor color = style.trailColor;
+		if (energy > 1.0f) {
+			float t = std::min((energy - 1.0f) / hotRange, 1.0f);
+			auto mix = [t](uint8_t a, uint8_t b) { return static_cast<uint8_t>(a + (b - a) * t + 0.5f); };
+			color = OverlayColor(mix(color.a, style.liveColor.a), mix(color.r, style.liveColor.r),
+				mix(color.g, style.liveColor.g), mix(color.b, style.liveColor.b));
+		}
+		drawArc(angle, color, std::min(energy, 1.0f));
+		trailsVisible = true;
+	});
+
+	// 实时弧形与文字保留到 liveDuration 之后
+	if (hasLive_ && nowMs > liveTs_ && static_cast<float>(nowMs - liveTs_) / 1000.0f > style.liveDuration) hasLive_ = false;
+	if (hasLive_) {
+		drawArc(liveAngle_, style.liveColor, 1.0f);
+
+		// 绘制文字（字高约为半径的 8%）
+		char text[32];
+		std::snprintf(text, sizeof(text), "Angle: %d\xC2\xB0", static_cast<int>(liveAngle_));
+		int scale = std::max(1, static_cast<int>(std::lround(radius_ * 0.08f / 7.0f)));
+		drawText(static_cast<int>(radius_ - 40), 10, text, style.textColor, scale);
+	}
+	return hasLive_ || trailsVisible;
+}
+
+void OverlayRenderer::composeEvent(float angleDeg, uint64_t nowMs) {
+	addEvent(angleDeg, nowMs);
+	render(nowMs);
+}
+
+void OverlayRenderer::reset() {
+	trails_.clear();
+	hasLive_ = false;
+}
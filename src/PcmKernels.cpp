@@ -0,0 +1,477 @@
+﻿#include "PcmKernels.h"
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define PCM_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define PCM_TARGET_AVX2
+#else
+#define PCM_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace {
+	const float kS16Scale = 1.0f / 32768.0f;
+	const float kPanTiny = 1e-30f;   // 全零频点的分母下限，声像为 0
+
+	// ---------------- 标量实现 ----------------
+
+	void deinterleaveS16Scalar(const int16_t* src, uint32_t channels, size_t frames, float* left, float* right) {
+		const uint32_t rightCh = channels >= 2 ? 1 : 0;
+		for (size_t i = 0; i < frames; ++i) {
+			left[i] = src[i * channels] * kS16Scale;
+			right[i] = src[i * channels + rightCh] * kS16Scale;
+		}
+	}
+
+	void deinterleaveF32Scalar(const float* src, uint32_t channels, size_t frames, float* left, float* right) {
+		const uint32_t rightCh = channels >= 2 ? 1 : 0;
+		for (size_t i = 0; i < frames; ++i) {
+			left[i] = src[i * channels];
+			right[i] = src[i * channels + rightCh];
+		}
+	}
+
+	void s16ToFloatScalar(const int16_t* src, size_t count, float* dst) {
+		for (size_t i = 0; i < count; ++i) dst[i] = src[i] * kS16Scale;
+	}
+
+	// 比较顺序与 maxps/minps 一致：NaN 与下限比较为假，落到 -32768，各实现结果相同
+	int16_t floatToS16One(float x) {
+		float v = x * 32768.0f;
+		v = v > -32768.0f ? v : -32768.0f;
+		v = v < 32767.0f ? v : 32767.0f;
+		return static_cast<int16_t>(std::lrintf(v));
+	}
+
+	void floatToS16Scalar(const float* src, size_t count, int16_t* dst) {
+		for (size_t i = 0; i < count; ++i) dst[i] = floatToS16One(src[i]);
+	}
+
+	void downmixEnergyScalar(const float* left, const float* right, size_t n, float* mono, float* sumSqLeft, float* sumSqRight) {
+		float sl = 0.0f, sr = 0.0f;
+		for (size_t i = 0; i < n; ++i) {
+			float l = left[i], r = right[i];
+			mono[i] = 0.5f * (l + r);
+			sl += l * l;
+			sr += r * r;
+		}
+		*sumSqLeft = sl;
+		*sumSqRight = sr;
+	}
+
+	float sumSquaresScalar(const float* src, size_t n) {
+		float s = 0.0f;
+		for (size_t i = 0; i < n; ++i) s += src[i] * src[i];
+		return s;
+	}
+
+	float peakScalar(const float* src, size_t n) {
+		float p = 0.0f;
+		for (size_t i = 0; i < n; ++i) {
+			float a = std::fabs(src[i]);
+			if (a > p) p = a;
+		}
+		return p;
+	}
+
+	// 运算顺序与向量实现一致（先各自求模方再相加，不合并乘加），结果逐位相同
+	void panBinsScalar(const float* left, const float* right, size_t bins, uint32_t levels, float* energy, int32_t* index) {
+		const float scale = 0.5f * static_cast<float>(levels - 1);
+		for (size_t i = 0; i < bins; ++i) {
+			const float lr = left[2 * i], li = left[2 * i + 1];
+			const float rr = right[2 * i], ri = right[2 * i + 1];
+			const float pl = lr * lr + li * li;
+			const float pr = rr * rr + ri * ri;
+			const float sum = pl + pr;
+			energy[i] = sum;
+			const float pan = (pr - pl) / (sum > kPanTiny ? sum : kPanTiny);
+			index[i] = static_cast<int32_t>((pan + 1.0f) * scale + 0.5f);
+		}
+	}
+
+#ifdef PCM_X86
+	// ---------------- SSE2 实现 ----------------
+
+	float hsum128(__m128 v) {
+		__m128 shuf = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+		__m128 sums = _mm_add_ps(v, shuf);
+		shuf = _mm_movehl_ps(shuf, sums);
+		sums = _mm_add_ss(sums, shuf);
+		return _mm_cvtss_f32(sums);
+	}
+
+	float hmax128(__m128 v) {
+		v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+		v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+		return _mm_cvtss_f32(v);
+	}
+
+	void s16ToFloatSSE2(const int16_t* src, size_t count, float* dst) {
+		const __m128 scale = _mm_set1_ps(kS16Scale);
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8) {
+			__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+			__m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+			__m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+			_mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+			_mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+		}
+		s16ToFloatScalar(src + i, count - i, dst + i);
+	}
+
+	void floatToS16SSE2(const float* src, size_t count, int16_t* dst) {
+		const __m128 scale = _mm_set1_ps(32768.0f);
+		const __m128 lo = _mm_set1_ps(-32768.0f);
+		const __m128 hi = _mm_set1_ps(32767.0f);
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8) {
+			__m128 a = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src + i), scale), lo), hi);
+			__m128 b = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src + i + 4), scale), lo), hi);
+			__m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), packed);
+		}
+		floatToS16Scalar(src + i, count - i, dst + i);
+	}
+
+	void deinterleaveS16SSE2(const int16_t* src, uint32_t channels, size_t frames, float* left, float* right) {
+		if (channels == 1) {
+			s16ToFloatSSE2(src, frames, left);
+			std::memcpy(right, left, frames * sizeof(float));
+			return;
+		}
+		if (channels != 2) {
+			deinterleaveS16Scalar(src, channels, frames, left, right);
+			return;
+		}
+
+		// 每个 32 位元素恰好是一帧 L|R，移位即可分离并做符号扩展
+		const __m128 scale = _mm_set1_ps(kS16Scale);
+		size_t i = 0;
+		for (; i + 4 <= frames; i += 4) {
+			__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2));
+			__m128i l = _mm_srai_epi32(_mm_slli_epi32(v, 16), 16);
+			__m128i r = _mm_srai_epi32(v, 16);
+			_mm_storeu_ps(left + i, _mm_mul_ps(_mm_cvtepi32_ps(l), scale));
+			_mm_storeu_ps(right + i, _mm_mul_ps(_mm_cvtepi32_ps(r), scale));
+		}
+		deinterleaveS16Scalar(src + i * 2, channels, frames - i, left + i, right + i);
+	}
+
+	void deinterleaveF32SSE2(const float* src, uint32_t channels, size_t frames, float* left, float* right) {
+		if (channels == 1) {
+			std::memcpy(left, src, frames * sizeof(float));
+			std::memcpy(right, src, frames * sizeof(float));
+			return;
+		}
+		if (channels != 2) {
+			deinterleaveF32Scalar(src, channels, frames, left, right);
+			return;
+		}
+
+		size_t i = 0;
+		for (; i + 4 <= frames; i += 4) {
+			__m128 a = _mm_loadu_ps(src + i * 2);      // L0 R0 L1 R1
+			__m128 b = _mm_loadu_ps(src + i * 2 + 4);  // L2 R2 L3 R3
+			_mm_storeu_ps(left + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+			_mm_storeu_ps(right + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+		}
+		deinterleaveF32Scalar(src + i * 2, channels, frames - i, left + i, right + i);
+	}
+
+	void downmixEnergySSE2(const float* left, const float* right, size_t n, float* mono, float* sumSqLeft, float* sumSqRight) {
+		const __m128 half = _mm_set1_ps(0.5f);
+		__m128 accL = _mm_setzero_ps(), accR = _mm_setzero_ps();
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4) {
+			__m128 l = _mm_loadu_ps(left + i);
+			__m128 r = _mm_loadu_ps(right + i);
+			_mm_storeu_ps(mono + i, _mm_mul_ps(_mm_add_ps(l, r), half));
+			accL = _mm_add_ps(accL, _mm_mul_ps(l, l));
+			accR = _mm_add_ps(accR, _mm_mul_ps(r, r));
+		}
+		float tailL = 0.0f, tailR = 0.0f;
+		downmixEnergyScalar(left + i, right + i, n - i, mono + i, &tailL, &tailR);
+		*sumSqLeft = hsum128(accL) + tailL;
+		*sumSqRight = hsum128(accR) + tailR;
+	}
+
+	float sumSquaresSSE2(const float* src, size_t n) {
+		__m128 acc = _mm_setzero_ps();
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4) {
+			__m128 v = _mm_loadu_ps(src + i);
+			acc = _mm_add_ps(acc, _mm_mul_ps(v, v));
+		}
+		return hsum128(acc) + sumSquaresScalar(src + i, n - i);
+	}
+
+	float peakSSE2(const float* src, size_t n) {
+		const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+		__m128 acc = _mm_setzero_ps();
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4)
+			acc = _mm_max_ps(acc, _mm_and_ps(_mm_loadu_ps(src + i), absMask));
+		float p = hmax128(acc);
+		float tail = peakScalar(src + i, n - i);
+		return tail > p ? tail : p;
+	}
+
+	void panBinsSSE2(const float* left, const float* right, size_t bins, uint32_t levels, float* energy, int32_t* index) {
+		const __m128 scale = _mm_set1_ps(0.5f * static_cast<float>(levels - 1));
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 half = _mm_set1_ps(0.5f);
+		const __m128 tiny = _mm_set1_ps(kPanTiny);
+		size_t i = 0;
+		for (; i + 4 <= bins; i += 4) {
+			__m128 la = _mm_loadu_ps(left + 2 * i), lb = _mm_loadu_ps(left + 2 * i + 4);    // re0 im0 re1 im1 | re2 im2 re3 im3
+			__m128 ra = _mm_loadu_ps(right + 2 * i), rb = _mm_loadu_ps(right + 2 * i + 4);
+			__m128 lre = _mm_shuffle_ps(la, lb, _MM_SHUFFLE(2, 0, 2, 0)), lim = _mm_shuffle_ps(la, lb, _MM_SHUFFLE(3, 1, 3, 1));
+			__m128 rre = _mm_shuffle_ps(ra, rb, _MM_SHUFFLE(2, 0, 2, 0)), rim = _mm_shuffle_ps(ra, rb, _MM_SHUFFLE(3, 1, 3, 1));
+			__m128 pl = _mm_add_ps(_mm_mul_ps(lre, lre), _mm_mul_ps(lim, lim));
+			__m128 pr = _mm_add_ps(_mm_mul_ps(rre, rre), _mm_mul_ps(rim, rim));
+			__m128 sum = _mm_add_ps(pl, pr);
+			_mm_storeu_ps(energy + i, sum);
+			__m128 pan = _mm_div_ps(_mm_sub_ps(pr, pl), _mm_max_ps(sum, tiny));
+			__m128i q = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_add_ps(pan, one), scale), half));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(index + i), q);
+		}
+		panBinsScalar(left + 2 * i, right + 2 * i, bins - i, levels, energy + i, index + i);
+	}
+
+	// ---------------- AVX2 实现 ----------------
+
+	PCM_TARGET_AVX2 float hsum256(__m256 v) {
+		__m128 lo = _mm256_castps256_ps128(v);
+		__m128 hi = _mm256_extractf128_ps(v, 1);
+		return hsum128(_mm_add_ps(lo, hi));
+	}
+
+	PCM_TARGET_AVX2 void s16ToFloatAVX2(const int16_t* src, size_t count, float* dst) {
+		const __m256 scale = _mm256_set1_ps(kS16Scale);
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8) {
+			__m256i v = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+			_mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), scale));
+		}
+		s16ToFloatScalar(src + i, count - i, dst + i);
+	}
+
+	PCM_TARGET_AVX2 void floatToS16AVX2(const float* src, size_t count, int16_t* dst) {
+		const __m256 scale = _mm256_set1_ps(32768.0f);
+		const __m256 lo = _mm256_set1_ps(-32768.0f);
+		const __m256 hi = _mm256_set1_ps(32767.0f);
+		size_t i = 0;
+		for (; i + 16 <= count; i += 16) {
+			__m256 a = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(src + i), scale), lo), hi);
+			__m256 b = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(src + i + 8), scale), lo), hi);
+			// packs 按 128 位通道交错，需要再按 64 位重排
+			__m256i packed = _mm256_packs_epi32(_mm256_cvtps_epi32(a), _mm256_cvtps_epi32(b));
+			packed = _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), packed);
+		}
+		floatToS16SSE2(src + i, count - i, dst + i);
+	}
+
+	PCM_TARGET_AVX2 void deinterleaveS16AVX2(const int16_t* src, uint32_t channels, size_t frames, float* left, float* right) {
+		if (channels == 1) {
+			s16ToFloatAVX2(src, frames, left);
+			std::memcpy(right, left, frames * sizeof(float));
+			return;
+		}
+		if (channels != 2) {
+			deinterleaveS16Scalar(src, channels, frames, left, right);
+			return;
+		}
+
+		const __m256 scale = _mm256_set1_ps(kS16Scale);
+		size_t i = 0;
+		for (; i + 8 <= frames; i += 8) {
+			__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 2));
+			__m256i l = _mm256_srai_epi32(_mm256_slli_epi32(v, 16), 16);
+			__m256i r = _mm256_srai_epi32(v, 16);
+			_mm256_storeu_ps(left + i, _mm256_mul_ps(_mm256_cvtepi32_ps(l), scale));
+			_mm256_storeu_ps(right + i, _mm256_mul_ps(_mm256_cvtepi32_ps(r), scale));
+		}
+		deinterleaveS16SSE2(src + i * 2, channels, frames - i, left + i, right + i);
+	}
+
+	PCM_TARGET_AVX2 void deinterleaveF32AVX2(const float* src, uint32_t channels, size_t frames, float* left, float* right) {
+		if (channels == 1) {
+			std::memcpy(left, src, frames * sizeof(float));
+			std::memcpy(right, src, frames * sizeof(float));
+			return;
+		}
+
+		size_t i = 0;
+		if (channels == 2) {
+			for (; i + 8 <= frames; i += 8) {
+				__m256 a = _mm256_loadu_ps(src + i * 2);      // L0 R0 L1 R1 | L2 R2 L3 R3
+				__m256 b = _mm256_loadu_ps(src + i * 2 + 8);  // L4 R4 L5 R5 | L6 R6 L7 R7
+				__m256 l = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));  // L0 L1 L4 L5 | L2 L3 L6 L7
+				__m256 r = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+				l = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(l), _MM_SHUFFLE(3, 1, 2, 0)));
+				r = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(r), _MM_SHUFFLE(3, 1, 2, 0)));
+				_mm256_storeu_ps(left + i, l);
+				_mm256_storeu_ps(right + i, r);
+			}
+		}
+		else {
+			// 多声道：按声道步长 gather
+			const int c = static_cast<int>(channels);
+			const __m256i idx = _mm256_setr_epi32(0, c, 2 * c, 3 * c, 4 * c, 5 * c, 6 * c, 7 * c);
+			for (; i + 8 <= frames; i += 8) {
+				const float* base = src + i * channels;
+				_mm256_storeu_ps(left + i, _mm256_i32gather_ps(base, idx, 4));
+				_mm256_storeu_ps(right + i, _mm256_i32gather_ps(base + 1, idx, 4));
+			}
+		}
+		deinterleaveF32Scalar(src + i * channels, channels, frames - i, left + i, right + i);
+	}
+
+	PCM_TARGET_AVX2 void downmixEnergyAVX2(const float* left, const float* right, size_t n, float* mono, float* sumSqLeft, float* sumSqRight) {
+		const __m256 half = _mm256_set1_ps(0.5f);
+		__m256 accL = _mm256_setzero_ps(), accR = _mm256_setzero_ps();
+		size_t i = 0;
+		for (; i + 8 <= n; i += 8) {
+			__m256 l = _mm256_loadu_ps(left + i);
+			__m256 r = _mm256_loadu_ps(right + i);
+			_mm256_storeu_ps(mono + i, _mm256_mul_ps(_mm256_add_ps(l, r), half));
+			accL = _mm256_add_ps(accL, _mm256_mul_ps(l, l));
+			accR = _mm256_add_ps(accR, _mm256_mul_ps(r, r));
+		}
+		float tailL = 0.0f, tailR = 0.0f;
+		downmixEnergyScalar(left + i, right + i, n - i, mono + i, &tailL, &tailR);
+		*sumSqLeft = hsum256(accL) + tailL;
+		*sumSqRight = hsum256(accR) + tailR;
+	}
+
+	PCM_TARGET_AVX2 float sumSquaresAVX2(const float* src, size_t n) {
+		__m256 acc = _mm256_setzero_ps();
+		size_t i = 0;
+		for (; i + 8 <= n; i += 8) {
+			__m256 v = _mm256_loadu_ps(src + i);
+			acc = _mm256_add_ps(acc, _mm256_mul_ps(v, v));
+		}
+		return hsum256(acc) + sumSquaresScalar(src + i, n - i);
+	}
+
+	PCM_TARGET_AVX2 float peakAVX2(const float* src, size_t n) {
+		const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+		__m256 acc = _mm256_setzero_ps();
+		size_t i = 0;
+		for (; i + 8 <= n; i += 8)
+			acc = _mm256_max_ps(acc, _mm256_and_ps(_mm256_loadu_ps(src + i), absMask));
+		float p = hmax128(_mm_max_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1)));
+		float tail = peakScalar(src + i, n - i);
+		return tail > p ? tail : p;
+	}
+
+	PCM_TARGET_AVX2 void panBinsAVX2(const float* left, const float* right, size_t bins, uint32_t levels, float* energy, int32_t* index) {
+		const __m256 scale = _mm256_set1_ps(0.5f * static_cast<float>(levels - 1));
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256 half = _mm256_set1_ps(0.5f);
+		const __m256 tiny = _mm256_set1_ps(kPanTiny);
+		size_t i = 0;
+		for (; i + 8 <= bins; i += 8) {
+			__m256 la = _mm256_loadu_ps(left + 2 * i), lb = _mm256_loadu_ps(left + 2 * i + 8);
+			__m256 ra = _mm256_loadu_ps(right + 2 * i), rb = _mm256_loadu_ps(right + 2 * i + 8);
+			// 按 128 位通道分离实部与虚部，频点顺序为 0 1 4 5 | 2 3 6 7，存储前再按 64 位重排
+			__m256 lre = _mm256_shuffle_ps(la, lb, _MM_SHUFFLE(2, 0, 2, 0)), lim = _mm256_shuffle_ps(la, lb, _MM_SHUFFLE(3, 1, 3, 1));
+			__m256 rre = _mm256_shuffle_ps(ra, rb, _MM_SHUFFLE(2, 0, 2, 0)), rim = _mm256_shuffle_ps(ra, rb, _MM_SHUFFLE(3, 1, 3, 1));
+			__m256 pl = _mm256_add_ps(_mm256_mul_ps(lre, lre), _mm256_mul_ps(lim, lim));
+			__m256 pr = _mm256_add_ps(_mm256_mul_ps(rre, rre), _mm256_mul_ps(rim, rim));
+			__m256 sum = _mm256_add_ps(pl, pr);
+			__m256 pan = _mm256_div_ps(_mm256_sub_ps(pr, pl), _mm256_max_ps(sum, tiny));
+			__m256i q = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(_mm256_add_ps(pan, one), scale), half));
+			sum = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(sum), _MM_SHUFFLE(3, 1, 2, 0)));
+			q = _mm256_permute4x64_epi64(q, _MM_SHUFFLE(3, 1, 2, 0));
+			_mm256_storeu_ps(energy + i, sum);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(index + i), q);
+		}
+		// 尾部交给 SSE2 实现；尾调用时编译器不插入 vzeroupper，需手动清除 YMM 高半部分，避免 SSE 指令的状态切换开销
+		_mm256_zeroupper();
+		panBinsSSE2(left + 2 * i, right + 2 * i, bins - i, levels, energy + i, index + i);
+	}
+
+	bool cpuHasAvx2() {
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7) return false;
+		__cpuid(info, 1);
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		bool avx = (info[2] & (1 << 28)) != 0;
+		if (!osxsave || !avx) return false;
+		if ((_xgetbv(0) & 6) != 6) return false;  // 操作系统保存 YMM 状态
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2") != 0;
+#endif
+	}
+#endif
+
+	const PcmKernels kScalar = {
+		PcmIsa::Scalar, "scalar",
+		deinterleaveS16Scalar, deinterleaveF32Scalar, s16ToFloatScalar, floatToS16Scalar,
+		downmixEnergyScalar, sumSquaresScalar, peakScalar, panBinsScalar,
+	};
+
+#ifdef PCM_X86
+	const PcmKernels kSSE2 = {
+		PcmIsa::SSE2, "sse2",
+		deinterleaveS16SSE2, deinterleaveF32SSE2, s16ToFloatSSE2, floatToS16SSE2,
+		downmixEnergySSE2, sumSquaresSSE2, peakSSE2, panBinsSSE2,
+	};
+
+	const PcmKernels kAVX2 = {
+		PcmIsa::AVX2, "avx2",
+		deinterleaveS16AVX2, deinterleaveF32AVX2, s16ToFloatAVX2, floatToS16AVX2,
+		downmixEnergyAVX2, sumSquaresAVX2, peakAVX2, panBinsAVX2,
+	};
+#endif
+}
+
+// CPU 是否支持指定实现（x86 上 SSE2 视为基线）
+bool PcmKernels::supported(PcmIsa isa) {
+	switch (isa) {
+	case PcmIsa::Scalar:
+		return true;
+#ifdef PCM_X86
+	case PcmIsa::SSE2:
+		return true;
+	case PcmIsa::AVX2: {
+		static const bool hasAvx2 = cpuHasAvx2();
+		return hasAvx2;
+	}
+#endif
+	default:
+		return false;
+	}
+}
+
+// 指定实现，不支持时逐级回退
+const PcmKernels& PcmKernels::forIsa(PcmIsa isa) {
+#ifdef PCM_X86
+	if (isa == PcmIsa::AVX2 && supported(PcmIsa::AVX2)) return kAVX2;
+	if (isa != PcmIsa::Scalar) return kSSE2;
+#endif
+	(void)isa;
+	return kScalar;
+}
+
+// 当前 CPU 最优实现
+const PcmKernels& PcmKernels::best() {
+	static const PcmKernels& k = forIsa(PcmIsa::AVX2);
+	return k;
+}
+
+float pcmRms(const PcmKernels& k, const float* src, size_t n) {
+	if (n == 0) return 0.0f;
+	return std::sqrt(k.sumSquares(src, n) / n);
+}
@@ -0,0 +1,123 @@
+﻿#include "PipelineMetrics.h"
+#include <chrono>
+#include <cstring>
+#include <new>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX   // std::min / std::max 不被 windows.h 的宏替换
+#endif
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+static_assert(sizeof(MetricCell) == 64, "MetricCell must occupy exactly one cache line");
+static_assert(sizeof(std::atomic<uint64_t>) == 8, "metrics page requires plain 64-bit atomics");
+
+const uint32_t MetricsPage::kMagic;
+const uint32_t MetricsPage::kVersion;
+const size_t MetricsPage::kNameLength;
+const size_t MetricsPage::kMetricCount;
+
+namespace {
+	struct MetricInfo {
+		const char* name;
+		MetricKind kind;
+	};
+
+	const MetricInfo kMetricInfo[MetricsPage::kMetricCount] = {
+		{ "packets_captured", MetricKind::Counter },
+		{ "silent_packets", MetricKind::Counter },
+		{ "discontinuities", MetricKind::Counter },
+		{ "detector_hits", MetricKind::Counter },
+		{ "model_queue_depth", MetricKind::Gauge },
+		{ "model_queue_high_water", MetricKind::Gauge },
+		{ "model_queue_drops", MetricKind::Counter },
+		{ "capture_busy_ns", MetricKind::TimeNs },
+		{ "analysis_busy_ns", MetricKind::TimeNs },
+		{ "events_posted", MetricKind::Counter },
+		{ "render_busy_ns", MetricKind::TimeNs },
+		{ "render_count", MetricKind::Counter },
+		{ "render_coalesced", MetricKind::Counter },
+		{ "mailbox_drops", MetricKind::Counter },
+		{ "recorder_bytes", MetricKind::Counter },
+		{ "recorder_backlog", MetricKind::Gauge },
+		{ "recorder_backlog_high", MetricKind::Gauge },
+		{ "recorder_drops", MetricKind::Counter },
+		{ "recorder_write_ns", MetricKind::TimeNs },
+		{ "clips_written", MetricKind::Counter },
+		{ "clip_drops", MetricKind::Counter },
+		{ "frames_silent", MetricKind::Counter },
+		{ "frames_gated", MetricKind::Counter },
+		{ "frames_analyzed", MetricKind::Counter },
+		{ "frames_triggered", MetricKind::Counter },
+		{ "stale_drops", MetricKind::Counter },
+		{ "frames_merged", MetricKind::Counter },
+		{ "late_events", MetricKind::Counter },
+		{ "event_latency_us", MetricKind::Gauge },
+		{ "event_latency_max_us", MetricKind::Gauge },
+	};
+
+	uint32_t currentProcessId() {
+#if defined(_WIN32)
+		return static_cast<uint32_t>(GetCurrentProcessId());
+#else
+		return static_cast<uint32_t>(getpid());
+#endif
+	}
+}
+
+const char* metricName(Metric m) {
+	size_t i = static_cast<size_t>(m);
+	return i < MetricsPage::kMetricCount ? kMetricInfo[i].name : "unknown";
+}
+
+MetricKind metricKind(Metric m) {
+	size_t i = static_cast<size_t>(m);
+	return i < MetricsPage::kMetricCount ? kMetricInfo[i].kind : MetricKind::Counter;
+}
+
+uint64_t PipelineMetrics::nowNs() {
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void PipelineMetrics::initPage(MetricsPage& page) {
+	page.version = MetricsPage::kVersion;
+	page.metricCount = static_cast<uint32_t>(MetricsPage::kMetricCount);
+	page.processId = currentProcessId();
+	page.startTimeNs = nowNs();
+	for (size_t i = 0; i < MetricsPage::kMetricCount; ++i) {
+		std::strncpy(page.names[i], kMetricInfo[i].name, MetricsPage::kNameLength - 1);
+		page.kinds[i] = static_cast<uint8_t>(kMetricInfo[i].kind);
+	}
+}
+
+PipelineMetrics::PipelineMetrics() : page_(&local_) {
+	initPage(local_);
+	local_.magic = MetricsPage::kMagic;
+}
+
+bool PipelineMetrics::publish(const std::string& path) {
+	if (!file_.create(path, sizeof(MetricsPage))) return false;
+
+	// 在映射内存上构造统计页，magic 最后写入，读取方看到 magic 时其余字段已就绪
+	MetricsPage* mapped = new (file_.data()) MetricsPage();
+	initPage(*mapped);
+	for (size_t i = 0; i < MetricsPage::kMetricCount; ++i) {
+		mapped->cells[i].value.store(page_->cells[i].value.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	}
+	std::atomic_thread_fence(std::memory_order_release);
+	mapped->magic = MetricsPage::kMagic;
+	page_ = mapped;
+	return true;
+}
+
+const MetricsPage* metricsPageFromMapping(const void* data, size_t size) {
+	if (!data || size < sizeof(MetricsPage)) return nullptr;
+	const MetricsPage* page = static_cast<const MetricsPage*>(data);
+	if (page->magic != MetricsPage::kMagic || page->version != MetricsPage::kVersion) return nullptr;
+	if (page->metricCount == 0 || page->metricCount > MetricsPage::kMetricCount) return nullptr;
+	return page;
+}
@@ -0,0 +1,57 @@
+﻿#include "PolarHistogram.h"
+#include <algorithm>
+#include <cmath>
+
+const int PolarHistogram::kMinAngle;
+const int PolarHistogram::kBins;
+
+void PolarHistogram::configure(float baseDuration, float maxDuration, float cutoff) {
+	baseDuration_ = baseDuration;
+	maxDuration_ = maxDuration;
+	cutoff_ = std::min(std::max(cutoff, 1e-6f), 0.999f);
+	// e^(-T/τ) = cutoff → τ = T / ln(1/cutoff)
+	const float logCutoff = std::log(1.0f / cutoff_);
+	for (int i = 0; i < kBins; ++i) {
+		float normalizedAngle = std::min(std::fabs(binAngle(i)), 90.0f) / 90.0f;  // 0~1
+		float duration = baseDuration + normalizedAngle * (maxDuration - baseDuration);
+		float tauMs = std::max(duration, 1e-3f) * 1000.0f / logCutoff;
+		invTau_[i] = 1.0f / tauMs;
+	}
+}
+
+int PolarHistogram::binOf(float angleDeg) {
+	int bin = static_cast<int>(std::lround(angleDeg)) - kMinAngle;
+	return std::min(std::max(bin, 0), kBins - 1);
+}
+
+float PolarHistogram::decayed(const Bin& b, int bin, uint64_t nowMs) const {
+	if (b.energy <= 0.0f) return 0.0f;
+	float age = nowMs > b.ts ? static_cast<float>(nowMs - b.ts) : 0.0f;
+	return b.energy * std::exp(-age * invTau_[bin]);
+}
+
+void PolarHistogram::add(float angleDeg, uint64_t nowMs, float e) {
+	int bin = binOf(angleDeg);
+	Bin& b = bins_[bin];
+	// 先把旧能量衰减到当前时刻，再累加
+	b.energy = std::min(decayed(b, bin, nowMs) + e, maxEnergy);
+	b.ts = std::max(b.ts, nowMs);
+}
+
+float PolarHistogram::energy(int bin, uint64_t nowMs) const {
+	if (bin < 0 || bin >= kBins) return 0.0f;
+	float e = decayed(bins_[bin], bin, nowMs);
+	return e >= cutoff_ ? e : 0.0f;
+}
+
+size_t PolarHistogram::activeBins(uint64_t nowMs) const {
+	size_t n = 0;
+	for (int i = 0; i < kBins; ++i) {
+		if (energy(i, nowMs) > 0.0f) ++n;
+	}
+	return n;
+}
+
+void PolarHistogram::clear() {
+	for (Bin& b : bins_) b = Bin();
+}
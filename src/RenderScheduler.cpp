@@ -0,0 +1,58 @@
+﻿#include "RenderScheduler.h"
+
+RenderScheduler::RenderScheduler(OverlayRenderer& renderer, uint64_t frameIntervalNs)
+	: renderer_(renderer), frameIntervalNs_(frameIntervalNs ? frameIntervalNs : 1) {
+	pending_.reserve(64);
+	frameEvents_.reserve(64);
+}
+
+void RenderScheduler::setFrameInterval(uint64_t ns) {
+	frameIntervalNs_ = ns ? ns : 1;
+}
+
+bool RenderScheduler::submit(float angleDeg, uint64_t eventId, uint64_t nowNs) {
+	pending_.push_back({ angleDeg, eventId, nowNs });
+	if (active_) return false;
+	// 空闲后的第一个事件不等节拍，下一次定时器触发即合成
+	active_ = true;
+	nextFrameNs_ = nowNs;
+	return true;
+}
+
+bool RenderScheduler::tick(uint64_t nowNs) {
+	if (!active_ || nowNs < nextFrameNs_) return false;
+
+	// 下一帧对齐到节拍网格；定时器迟到时跳过错过的节拍，不补帧
+	uint64_t missed = (nowNs - nextFrameNs_) / frameIntervalNs_;
+	nextFrameNs_ += (missed + 1) * frameIntervalNs_;
+
+	frameEvents_.clear();
+	for (const PendingEvent& e : pending_) {
+		renderer_.addEvent(e.angle, e.timeNs / 1000000);
+		frameEvents_.push_back(e.id);
+	}
+	if (pending_.size() > 1) eventsCoalesced_ += pending_.size() - 1;
+	bool hadPending = !pending_.empty();
+	pending_.clear();
+
+	// 上一帧为空且没有新事件：无需重绘
+	if (!hadPending && !visible_) {
+		active_ = false;
+		return false;
+	}
+
+	visible_ = renderer_.render(nowNs / 1000000);
+	++framesRendered_;
+	// 画面已空：这一帧（透明画面）呈现后即可停止定时器
+	if (!visible_) active_ = false;
+	return true;
+}
+
+void RenderScheduler::reset() {
+	pending_.clear();
+	frameEvents_.clear();
+	renderer_.reset();
+	renderer_.clear();
+	active_ = false;
+	visible_ = false;
+}
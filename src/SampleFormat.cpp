@@ -0,0 +1,145 @@
+﻿#include "SampleFormat.h"
+#include "PcmKernels.h"
+#include <cstring>
+
+namespace {
+	// 每种采样类型的读取方式，编译期确定字节数与缩放系数
+	struct S16 {
+		static const size_t kBytes = 2;
+		static float load(const uint8_t* p) {
+			int16_t v;
+			std::memcpy(&v, p, sizeof(v));
+			return v * (1.0f / 32768.0f);
+		}
+	};
+
+	struct S24 {
+		static const size_t kBytes = 3;
+		static float load(const uint8_t* p) {
+			// 小端 3 字节，放到 32 位高位再算术右移完成符号扩展
+			int32_t v = static_cast<int32_t>((static_cast<uint32_t>(p[0]) << 8) |
+				(static_cast<uint32_t>(p[1]) << 16) |
+				(static_cast<uint32_t>(p[2]) << 24)) >> 8;
+			return v * (1.0f / 8388608.0f);
+		}
+	};
+
+	struct S32 {
+		static const size_t kBytes = 4;
+		static float load(const uint8_t* p) {
+			int32_t v;
+			std::memcpy(&v, p, sizeof(v));
+			return static_cast<float>(v) * (1.0f / 2147483648.0f);
+		}
+	};
+
+	struct F32 {
+		static const size_t kBytes = 4;
+		static float load(const uint8_t* p) {
+			float v;
+			std::memcpy(&v, p, sizeof(v));
+			return v;
+		}
+	};
+
+	// 声道数为编译期常量：步长固定，内层循环没有格式分支
+	template <typename Sample, uint32_t Channels>
+	void decodeStereo(const uint8_t* src, size_t frames, float* left, float* right) {
+		const size_t stride = Sample::kBytes * Channels;
+		const size_t rightOffset = Channels >= 2 ? Sample::kBytes : 0;
+		for (size_t i = 0; i < frames; ++i) {
+			const uint8_t* p = src + i * stride;
+			left[i] = Sample::load(p);
+			right[i] = Sample::load(p + rightOffset);
+		}
+	}
+
+	// 16 位与浮点的常见布局直接走 SIMD 内核
+	template <uint32_t Channels>
+	void decodeStereoS16Simd(const uint8_t* src, size_t frames, float* left, float* right) {
+		PcmKernels::best().deinterleaveS16(reinterpret_cast<const int16_t*>(src), Channels, frames, left, right);
+	}
+
+	template <uint32_t Channels>
+	void decodeStereoF32Simd(const uint8_t* src, size_t frames, float* left, float* right) {
+		PcmKernels::best().deinterleaveF32(reinterpret_cast<const float*>(src), Channels, frames, left, right);
+	}
+
+	template <typename Sample>
+	DecodeStereoFn selectForSample(uint32_t channels) {
+		switch (channels) {
+		case 1: return decodeStereo<Sample, 1>;
+		case 2: return decodeStereo<Sample, 2>;
+		case 3: return decodeStereo<Sample, 3>;
+		case 4: return decodeStereo<Sample, 4>;
+		case 5: return decodeStereo<Sample, 5>;
+		case 6: return decodeStereo<Sample, 6>;
+		case 7: return decodeStereo<Sample, 7>;
+		case 8: return decodeStereo<Sample, 8>;
+		default: return nullptr;
+		}
+	}
+
+	template <>
+	DecodeStereoFn selectForSample<S16>(uint32_t channels) {
+		switch (channels) {
+		case 1: return decodeStereoS16Simd<1>;
+		case 2: return decodeStereoS16Simd<2>;
+		case 3: return decodeStereo<S16, 3>;
+		case 4: return decodeStereo<S16, 4>;
+		case 5: return decodeStereo<S16, 5>;
+		case 6: return decodeStereo<S16, 6>;
+		case 7: return decodeStereo<S16, 7>;
+		case 8: return decodeStereo<S16, 8>;
+		default: return nullptr;
+		}
+	}
+
+	template <>
+	DecodeStereoFn selectForSample<F32>(uint32_t channels) {
+		switch (channels) {
+		case 1: return decodeStereoF32Simd<1>;
+		case 2: return decodeStereoF32Simd<2>;
+		case 3: return decodeStereoF32Simd<3>;
+		case 4: return decodeStereoF32Simd<4>;
+		case 5: return decodeStereoF32Simd<5>;
+		case 6: return decodeStereoF32Simd<6>;
+		case 7: return decodeStereoF32Simd<7>;
+		case 8: return decodeStereoF32Simd<8>;
+		default: return nullptr;
+		}
+	}
+}
+
+// 根据位深推断采样类型；validBits 为 0 时视为与容器位深相同
+SampleType sampleTypeFrom(uint32_t bitsPerSample, uint32_t validBits, bool isFloat) {
+	(void)validBits;  // 有效位只影响精度，24-in-32 左对齐后按 32 位整数读取即可
+	if (isFloat) return bitsPerSample == 32 ? SampleType::Float32 : SampleType::Unknown;
+	switch (bitsPerSample) {
+	case 16: return SampleType::Int16;
+	case 24: return SampleType::Int24;
+	case 32: return SampleType::Int32;
+	default: return SampleType::Unknown;
+	}
+}
+
+// 选择特化解码函数（支持 1~8 声道）
+DecodeStereoFn selectStereoDecoder(const StreamFormat& fmt) {
+	switch (fmt.type) {
+	case SampleType::Int16: return selectForSample<S16>(fmt.channels);
+	case SampleType::Int24: return selectForSample<S24>(fmt.channels);
+	case SampleType::Int32: return selectForSample<S32>(fmt.channels);
+	case SampleType::Float32: return selectForSample<F32>(fmt.channels);
+	default: return nullptr;
+	}
+}
+
+const char* sampleTypeName(SampleType type) {
+	switch (type) {
+	case SampleType::Int16: return "s16";
+	case SampleType::Int24: return "s24";
+	case SampleType::Int32: return "s32";
+	case SampleType::Float32: return "f32";
+	default: return "unknown";
+	}
+}
@@ -0,0 +1,68 @@
+﻿#include "StftFramer.h"
+#include <algorithm>
+#include <cmath>
+
+StftFramer::StftFramer(size_t frameSize, size_t hopSize) {
+	configure(frameSize, hopSize);
+}
+
+// 设置帧长与跳步，预分配环形缓冲和窗函数
+void StftFramer::configure(size_t frameSize, size_t hopSize) {
+	frameSize_ = std::max<size_t>(frameSize, 1);
+	hopSize_ = std::min(std::max<size_t>(hopSize, 1), frameSize_);
+
+	// 容量至少两帧，保证一次写入后总能凑出下一帧
+	size_t capacity = 1;
+	while (capacity < frameSize_ * 2) capacity <<= 1;
+	mask_ = capacity - 1;
+	ringLeft_.assign(capacity, 0.0f);
+	ringRight_.assign(capacity, 0.0f);
+
+	// 周期 Hann 窗，跳步为帧长一半时满足 COLA
+	const double kPi = 3.14159265358979323846;
+	window_.resize(frameSize_);
+	double windowSum = 0.0;
+	for (size_t i = 0; i < frameSize_; ++i) {
+		window_[i] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * kPi * i / frameSize_));
+		windowSum += window_[i];
+	}
+
+	frame_.left.assign(frameSize_, 0.0f);
+	frame_.right.assign(frameSize_, 0.0f);
+	frame_.windowSum = static_cast<float>(windowSum);
+	reset();
+}
+
+// 清空状态
+void StftFramer::reset() {
+	written_ = 0;
+	nextOffset_ = 0;
+	frame_.offset = 0;
+}
+
+// 写入环形缓冲，最多写到缓冲满为止
+size_t StftFramer::write(const float* left, const float* right, size_t count) {
+	size_t pending = static_cast<size_t>(written_ - nextOffset_);
+	size_t n = std::min(count, (mask_ + 1) - pending);
+
+	for (size_t i = 0; i < n; ++i) {
+		size_t pos = static_cast<size_t>(written_ + i) & mask_;
+		float l = left ? left[i] : 0.0f;
+		ringLeft_[pos] = l;
+		ringRight_[pos] = right ? right[i] : l;
+	}
+	written_ += n;
+	return n;
+}
+
+// 取出从 nextOffset_ 开始的一帧，乘窗后前移一个跳步
+const AnalysisFrame& StftFramer::emit() {
+	frame_.offset = nextOffset_;
+	for (size_t i = 0; i < frameSize_; ++i) {
+		size_t pos = static_cast<size_t>(nextOffset_ + i) & mask_;
+		frame_.left[i] = ringLeft_[pos] * window_[i];
+		frame_.right[i] = ringRight_[pos] * window_[i];
+	}
+	nextOffset_ += hopSize_;
+	return frame_;
+}
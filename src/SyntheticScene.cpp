@@ -0,0 +1,315 @@
+﻿#include "SyntheticScene.h"
+#include "DetectorPipeline.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+
+namespace {
+	const double kPi = 3.14159265358979323846;
+
+	// 随机数只取 mt19937 的原始输出，均匀分布与正态分布自行换算
+	class SceneRandom {
+	public:
+		explicit SceneRandom(uint32_t seed) : rng_(seed) {}
+
+		double uniform() { return (rng_() >> 8) * (1.0 / 16777216.0); }   // [0, 1)
+		double uniform(double lo, double hi) { return lo + (hi - lo) * uniform(); }
+
+		// Box-Muller，成对生成
+		double gaussian() {
+			if (hasSpare_) {
+				hasSpare_ = false;
+				return spare_;
+			}
+			const double r = std::sqrt(-2.0 * std::log(1.0 - uniform()));
+			const double theta = 2.0 * kPi * uniform();
+			spare_ = r * std::sin(theta);
+			hasSpare_ = true;
+			return r * std::cos(theta);
+		}
+
+	private:
+		std::mt19937 rng_;
+		double spare_ = 0.0;
+		bool hasSpare_ = false;
+	};
+
+	double dbToGain(double db) { return std::pow(10.0, db / 20.0); }
+	bool enabledLevel(float db) { return db > -120.0f; }
+
+	// 与 ildAngle 互逆的左右增益，较响的一侧为 1
+	void panGains(double angle, double& gainLeft, double& gainRight) {
+		const double db = angle / 90.0 * 20.0;
+		gainLeft = std::min(1.0, dbToGain(-db));
+		gainRight = std::min(1.0, dbToGain(db));
+	}
+
+	void addNoise(SceneRandom& rng, float db, std::vector<float>& left, std::vector<float>& right) {
+		const double sigma = dbToGain(db);
+		for (size_t i = 0; i < left.size(); ++i) {
+			left[i] += static_cast<float>(sigma * rng.gaussian());
+			right[i] += static_cast<float>(sigma * rng.gaussian());
+		}
+	}
+
+	// 音乐：每 2 秒换一个三和弦（根音 110 ~ 220 Hz，每音 8 次谐波、幅度 1/h，不超过 3.5 kHz），
+	// 和弦之间 50 ms 升余弦交叉淡化，声像随机；整体按 RMS 缩放到 db
+	void addMusic(SceneRandom& rng, uint32_t sampleRate, float db, std::vector<float>& left, std::vector<float>& right) {
+		const double roots[] = { 110.0, 130.81, 146.83, 164.81, 196.0, 220.0 };
+		const double major[] = { 1.0, 1.2599, 1.4983 }, minor[] = { 1.0, 1.1892, 1.4983 };
+		const size_t total = left.size();
+		const size_t chordFrames = static_cast<size_t>(2.0 * sampleRate);
+		const size_t fadeFrames = static_cast<size_t>(0.05 * sampleRate);
+		std::vector<float> ml(total, 0.0f), mr(total, 0.0f);
+
+		for (size_t chordStart = 0; chordStart < total; chordStart += chordFrames) {
+			const double root = roots[static_cast<size_t>(rng.uniform() * 6.0)];
+			const double* intervals = rng.uniform() < 0.5 ? major : minor;
+			double gainLeft, gainRight;
+			panGains(rng.uniform(-50.0, 50.0), gainLeft, gainRight);
+			// 和弦持续 [chordStart, chordEnd + fadeFrames)：开头与上一和弦的结尾重叠，sin² 淡入与 cos² 淡出之和为 1
+			const size_t chordEnd = chordStart + chordFrames;
+			const size_t end = std::min(total, chordEnd + fadeFrames);
+			for (int note = 0; note < 3; ++note) {
+				const double f0 = root * intervals[note];
+				for (int h = 1; h <= 8 && f0 * h <= 3500.0; ++h) {
+					const double w = 2.0 * kPi * f0 * h / sampleRate;
+					const double phase = rng.uniform(0.0, 2.0 * kPi);
+					for (size_t i = chordStart; i < end; ++i) {
+						double fade = 1.0;
+						if (chordStart > 0 && i < chordStart + fadeFrames) fade = std::pow(std::sin(0.5 * kPi * (i - chordStart) / fadeFrames), 2);
+						else if (i >= chordEnd) fade = std::pow(std::cos(0.5 * kPi * (i - chordEnd) / fadeFrames), 2);
+						// 相位按绝对样本号计算（双精度），长场景不累积误差
+						const double v = fade * std::sin(w * static_cast<double>(i) + phase) / h;
+						ml[i] += static_cast<float>(gainLeft * v);
+						mr[i] += static_cast<float>(gainRight * v);
+					}
+				}
+			}
+		}
+
+		double energy = 0.0;
+		for (size_t i = 0; i < total; ++i) energy += 0.5 * (static_cast<double>(ml[i]) * ml[i] + static_cast<double>(mr[i]) * mr[i]);
+		if (energy <= 0.0) return;
+		const double scale = dbToGain(db) / std::sqrt(energy / total);
+		for (size_t i = 0; i < total; ++i) {
+			left[i] += static_cast<float>(scale * ml[i]);
+			right[i] += static_cast<float>(scale * mr[i]);
+		}
+	}
+
+	// 一个脉冲：倾斜滤波后的白噪声 × 包络（0.5 ms 线性起音 + 指数衰减），按真值的 ILD / ITD 写入左右声道
+	void addEvent(SceneRandom& rng, const SceneEvent& e, uint32_t sampleRate, double maxItdSeconds,
+		std::vector<float>& left, std::vector<float>& right) {
+		const double attack = 0.0005 * sampleRate;
+		const double decay = std::max(1.0, e.length / 5.0);
+		const double amplitude = dbToGain(e.peakDb) / std::sqrt(1.0 + static_cast<double>(e.tilt) * e.tilt);
+		std::vector<double> burst(e.length + 1, 0.0);   // burst[0] 为插值用的前导零
+		double previous = 0.0;
+		for (uint32_t n = 0; n < e.length; ++n) {
+			const double x = rng.gaussian();
+			const double envelope = std::min(1.0, (n + 1) / attack) * std::exp(-static_cast<double>(n) / decay);
+			burst[n + 1] = amplitude * envelope * (x + e.tilt * previous);
+			previous = x;
+		}
+
+		double gainLeft, gainRight;
+		panGains(e.angle, gainLeft, gainRight);
+		// 左声道延迟 base + d/2，右声道 base - d/2；base 为整数，两侧的小数部分互补，线性插值的幅频响应相同
+		const double maxDelay = maxItdSeconds * sampleRate;
+		const double base = std::ceil(maxDelay / 2.0) + 1.0;
+		const double d = maxDelay * std::sin(e.angle * kPi / 180.0);
+		auto write = [&](double delay, double gain, std::vector<float>& out) {
+			const double whole = std::floor(delay);
+			const double frac = delay - whole;
+			const uint64_t first = e.start + static_cast<uint64_t>(whole);
+			// out[first + k] = (1 - frac)·burst[k] + frac·burst[k - 1]（burst 下标含前导零偏移）
+			for (uint32_t k = 0; k <= e.length; ++k) {
+				const uint64_t at = first + k;
+				if (at >= out.size()) break;
+				const double current = k < e.length ? burst[k + 1] : 0.0;
+				out[at] += static_cast<float>(gain * ((1.0 - frac) * current + frac * burst[k]));
+			}
+		};
+		write(base + d / 2.0, gainLeft, left);
+		write(base - d / 2.0, gainRight, right);
+	}
+
+	template <typename T>
+	void putSample(uint8_t*& p, T v) {
+		std::memcpy(p, &v, sizeof(T));
+		p += sizeof(T);
+	}
+
+	uint32_t bytesPerSample(SampleType type) {
+		switch (type) {
+		case SampleType::Int16: return 2;
+		case SampleType::Int24: return 3;
+		case SampleType::Int32: return 4;
+		case SampleType::Float32: return 4;
+		default: return 0;
+		}
+	}
+
+	double clampUnit(double v, double maxValue) { return v < -1.0 ? -1.0 : (v > maxValue ? maxValue : v); }
+}
+
+void renderScene(const SceneConfig& config, SyntheticScene& scene) {
+	SceneRandom rng(config.seed);
+	const uint32_t sr = config.sampleRate;
+	const size_t total = static_cast<size_t>(std::max(0.0, config.seconds) * sr);
+	scene.sampleRate = sr;
+	scene.left.assign(total, 0.0f);
+	scene.right.assign(total, 0.0f);
+	scene.events.clear();
+
+	// 前 0.5 秒不放事件，留给噪声底收敛；事件在等分的时隙内随机起始
+	const uint32_t length = static_cast<uint32_t>(std::max(1.0, 5.0 * config.decaySeconds * sr));
+	const size_t lead = sr / 2;
+	const size_t overlapSpan = sr / 500;   // 重叠事件在 2 ms 内开始
+	if (config.events > 0 && total > lead + length + overlapSpan) {
+		const double slot = static_cast<double>(total - lead - length - overlapSpan) / config.events;
+		for (uint32_t i = 0; i < config.events; ++i) {
+			SceneEvent e;
+			e.start = lead + static_cast<uint64_t>(slot * (i + rng.uniform()));
+			e.length = length;
+			e.angle = static_cast<float>(rng.uniform(-config.maxAngle, config.maxAngle));
+			e.peakDb = static_cast<float>(rng.uniform(config.minPeakDb, config.maxPeakDb));
+			e.tilt = static_cast<float>(rng.uniform(-0.8, 0.8));
+			scene.events.push_back(e);
+			if (rng.uniform() < config.overlapProbability) {
+				// 第二个事件在另一侧（至少隔开 15°），频谱倾斜方向相反（另一种武器）
+				SceneEvent other = e;
+				other.start = e.start + static_cast<uint64_t>(rng.uniform() * overlapSpan);
+				const double side = e.angle >= 0.0f ? -1.0 : 1.0;
+				other.angle = static_cast<float>(side * rng.uniform(std::min(15.0, static_cast<double>(config.maxAngle)), config.maxAngle));
+				other.peakDb = static_cast<float>(std::min<double>(config.maxPeakDb, e.peakDb + rng.uniform(-3.0, 3.0)));
+				other.tilt = static_cast<float>(e.tilt >= 0.0f ? -rng.uniform(0.5, 0.9) : rng.uniform(0.5, 0.9));
+				scene.events.push_back(other);
+			}
+		}
+	}
+
+	if (enabledLevel(config.musicDb)) addMusic(rng, sr, config.musicDb, scene.left, scene.right);
+	if (enabledLevel(config.noiseDb)) addNoise(rng, config.noiseDb, scene.left, scene.right);
+	for (const SceneEvent& e : scene.events) addEvent(rng, e, sr, config.maxItdSeconds, scene.left, scene.right);
+	std::stable_sort(scene.events.begin(), scene.events.end(),
+		[](const SceneEvent& a, const SceneEvent& b) { return a.start < b.start; });
+}
+
+StreamFormat encodeScene(const SyntheticScene& scene, SampleType type, std::vector<uint8_t>& pcm) {
+	StreamFormat fmt;
+	fmt.type = type;
+	fmt.channels = 2;
+	fmt.sampleRate = scene.sampleRate;
+	fmt.blockAlign = 2 * bytesPerSample(type);
+	pcm.resize(scene.left.size() * fmt.blockAlign);
+	uint8_t* p = pcm.data();
+	for (size_t i = 0; i < scene.left.size(); ++i) {
+		const float channels[2] = { scene.left[i], scene.right[i] };
+		for (float v : channels) {
+			switch (type) {
+			case SampleType::Int16:
+				putSample(p, static_cast<int16_t>(std::lrint(clampUnit(v, 32767.0 / 32768.0) * 32768.0)));
+				break;
+			case SampleType::Int24: {
+				const int32_t s = static_cast<int32_t>(std::lrint(clampUnit(v, 8388607.0 / 8388608.0) * 8388608.0));
+				p[0] = static_cast<uint8_t>(s);
+				p[1] = static_cast<uint8_t>(s >> 8);
+				p[2] = static_cast<uint8_t>(s >> 16);
+				p += 3;
+				break;
+			}
+			case SampleType::Int32:
+				putSample(p, static_cast<int32_t>(std::llrint(clampUnit(v, 2147483647.0 / 2147483648.0) * 2147483648.0)));
+				break;
+			case SampleType::Float32:
+				putSample(p, v);
+				break;
+			default:
+				break;
+			}
+		}
+	}
+	return fmt;
+}
+
+bool runScene(const StreamFormat& fmt, const std::vector<uint8_t>& pcm, const SceneRunConfig& config,
+	std::vector<SceneDetection>& detections) {
+	detections.clear();
+	DetectorPipeline pipeline;
+	if (config.packetFrames == 0 || !pipeline.configure(fmt, config.frameSize, config.hopSize, config.params, config.packetFrames)) return false;
+	DirectionEstimator direction;
+	direction.mode = config.mode;
+	direction.maxSources = config.maxSources;
+	direction.prepare(config.frameSize);
+
+	const size_t frames = pcm.size() / fmt.blockAlign;
+	for (size_t at = 0; at < frames; at += config.packetFrames) {
+		const uint32_t n = static_cast<uint32_t>(std::min<size_t>(config.packetFrames, frames - at));
+		const AnalyzedFrame* frame = pipeline.processPacket(pcm.data() + at * fmt.blockAlign, n, false);
+		if (!frame) continue;
+		const DirectionResult result = direction.estimate(*frame);
+		SceneDetection d;
+		d.frameOffset = frame->offset;
+		d.reportedAt = pipeline.streamPosition();
+		d.angle = result.angle;
+		d.sourceCount = result.sourceCount;
+		for (size_t i = 0; i < result.sourceCount; ++i) d.sources[i] = result.sources[i].angle;
+		detections.push_back(d);
+	}
+	return true;
+}
+
+SceneScore scoreScene(const std::vector<SceneEvent>& events, const std::vector<SceneDetection>& detections,
+	uint32_t frameSize) {
+	SceneScore score;
+	score.events = events.size();
+	score.detections = detections.size();
+	std::vector<const SceneDetection*> first(events.size(), nullptr);
+	for (const SceneDetection& d : detections) {
+		bool matched = false, isFirst = false;
+		for (size_t e = 0; e < events.size(); ++e) {
+			const SceneEvent& ev = events[e];
+			if (d.frameOffset + frameSize <= ev.start || d.frameOffset >= ev.start + ev.length) continue;
+			matched = true;
+			if (!first[e] || first[e]->frameOffset > d.frameOffset) {
+				if (!first[e]) isFirst = true;
+				first[e] = &d;
+			}
+		}
+		if (!matched) ++score.falseAlarms;
+		else if (!isFirst) ++score.duplicates;
+	}
+
+	std::vector<double> errors;
+	double latencySum = 0.0;
+	for (size_t e = 0; e < events.size(); ++e) {
+		const SceneDetection* d = first[e];
+		if (!d) continue;
+		++score.detected;
+		double error = std::fabs(d->angle - events[e].angle);
+		if (d->sourceCount >= 2) {
+			error = 180.0;
+			for (size_t i = 0; i < d->sourceCount; ++i) error = std::min(error, std::fabs(static_cast<double>(d->sources[i]) - events[e].angle));
+		}
+		errors.push_back(error);
+		const double latency = d->reportedAt > events[e].start ? static_cast<double>(d->reportedAt - events[e].start) : 0.0;
+		latencySum += latency;
+		score.latencyMax = std::max(score.latencyMax, latency);
+	}
+
+	score.recall = score.events ? static_cast<double>(score.detected) / score.events : 1.0;
+	score.precision = score.detections ? static_cast<double>(score.detections - score.falseAlarms) / score.detections : 1.0;
+	if (!errors.empty()) {
+		std::sort(errors.begin(), errors.end());
+		double sum = 0.0;
+		for (double e : errors) sum += e;
+		score.angleErrorMean = sum / errors.size();
+		score.angleErrorP90 = errors[(errors.size() * 9 + 9) / 10 - 1];
+		score.angleErrorMax = errors.back();
+		score.latencyMean = latencySum / errors.size();
+	}
+	return score;
+}
@@ -0,0 +1,180 @@
+﻿#include "WavFile.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace {
+	uint16_t readU16(const uint8_t* p) {
+		return static_cast<uint16_t>(p[0] | (p[1] << 8));
+	}
+
+	uint32_t readU32(const uint8_t* p) {
+		return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+			(static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+	}
+
+	uint64_t readU64(const uint8_t* p) {
+		return readU32(p) | (static_cast<uint64_t>(readU32(p + 4)) << 32);
+	}
+
+	// KSDATAFORMAT_SUBTYPE_* 的后 12 字节相同，前 4 字节为格式码
+	const uint8_t kSubtypeTail[12] = { 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71 };
+
+	void setError(std::string* error, const char* message) {
+		if (error) *error = message;
+	}
+}
+
+// 解析 fmt 块：字段偏移与 WAVEFORMATEX 一致
+StreamFormat streamFormatFromFmtChunk(const uint8_t* fmt, size_t size) {
+	StreamFormat out;
+	if (!fmt || size < 16) return out;
+
+	uint16_t tag = readU16(fmt);
+	uint16_t channels = readU16(fmt + 2);
+	uint32_t sampleRate = readU32(fmt + 4);
+	uint16_t blockAlign = readU16(fmt + 12);
+	uint16_t bits = readU16(fmt + 14);
+	out.channels = channels;
+	out.sampleRate = sampleRate;
+	out.blockAlign = blockAlign;
+
+	bool isFloat = (tag == kWaveFormatIeeeFloat);
+	uint32_t validBits = bits;
+	if (tag == kWaveFormatExtensible) {
+		// cbSize(2) + wValidBitsPerSample(2) + dwChannelMask(4) + SubFormat(16)
+		if (size < 40) return out;
+		const uint8_t* sub = fmt + 24;
+		if (std::memcmp(sub + 4, kSubtypeTail, sizeof(kSubtypeTail)) != 0) return out;
+		uint32_t subTag = readU32(sub);
+		if (subTag == kWaveFormatIeeeFloat) isFloat = true;
+		else if (subTag != kWaveFormatPcm) return out;
+		if (readU16(fmt + 18)) validBits = readU16(fmt + 18);
+	}
+	else if (tag != kWaveFormatPcm && tag != kWaveFormatIeeeFloat) {
+		return out;
+	}
+
+	// 帧长必须与声道数和位深一致，否则不是紧密排列的交错 PCM
+	if (blockAlign != channels * (bits / 8)) return out;
+
+	out.type = sampleTypeFrom(bits, validBits, isFloat);
+	return out;
+}
+
+// 读取 RIFF/WAVE（或 RF64）文件：逐块扫描，取 fmt 与 data 块
+bool readWavFile(const std::string& path, StreamFormat& format, std::vector<uint8_t>& data, std::string* error) {
+	std::ifstream ifs(path, std::ios::binary);
+	if (!ifs.is_open()) {
+		setError(error, "cannot open file");
+		return false;
+	}
+
+	uint8_t header[12];
+	if (!ifs.read(reinterpret_cast<char*>(header), 12) ||
+		(std::memcmp(header, "RIFF", 4) != 0 && std::memcmp(header, "RF64", 4) != 0) ||
+		std::memcmp(header + 8, "WAVE", 4) != 0) {
+		setError(error, "not a RIFF/WAVE file");
+		return false;
+	}
+
+	bool haveFmt = false, haveData = false;
+	uint64_t ds64DataSize = 0;  // RF64 的 64 位 data 长度（data 块头中为 0xFFFFFFFF）
+	uint8_t chunk[8];
+	while (!haveData && ifs.read(reinterpret_cast<char*>(chunk), 8)) {
+		uint32_t size = readU32(chunk + 4);
+		if (std::memcmp(chunk, "fmt ", 4) == 0) {
+			std::vector<uint8_t> fmt(size);
+			if (!ifs.read(reinterpret_cast<char*>(fmt.data()), size)) break;
+			format = streamFormatFromFmtChunk(fmt.data(), fmt.size());
+			haveFmt = true;
+		}
+		else if (std::memcmp(chunk, "ds64", 4) == 0 && size >= 16) {
+			uint8_t ds64[16];
+			if (!ifs.read(reinterpret_cast<char*>(ds64), 16)) break;
+			ds64DataSize = readU64(ds64 + 8);
+			ifs.seekg(size - 16, std::ios::cur);
+		}
+		else if (std::memcmp(chunk, "data", 4) == 0) {
+			// 录制中断的文件 data 长度可能为 0 或超出文件：0 / 0xFFFFFFFF（无 ds64）时读到文件尾，否则按实际可读长度截取
+			std::streampos begin = ifs.tellg();
+			ifs.seekg(0, std::ios::end);
+			uint64_t remaining = static_cast<uint64_t>(ifs.tellg() - begin);
+			ifs.seekg(begin);
+			uint64_t dataSize = size;
+			if (size == 0xFFFFFFFFu && ds64DataSize) dataSize = ds64DataSize;
+			else if (size == 0 || size == 0xFFFFFFFFu) dataSize = remaining;
+			dataSize = std::min(dataSize, remaining);
+			data.resize(static_cast<size_t>(dataSize));
+			ifs.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(dataSize));
+			data.resize(static_cast<size_t>(ifs.gcount()));
+			haveData = true;
+		}
+		else {
+			ifs.seekg(size, std::ios::cur);
+		}
+		if (size & 1) ifs.seekg(1, std::ios::cur);  // 块按偶数字节对齐
+	}
+
+	if (!haveFmt || !haveData) {
+		setError(error, "missing fmt or data chunk");
+		return false;
+	}
+	if (format.type == SampleType::Unknown || format.blockAlign == 0) {
+		setError(error, "unsupported sample format");
+		return false;
+	}
+	data.resize(data.size() - data.size() % format.blockAlign);
+	return true;
+}
+
+bool locateWavData(const uint8_t* image, size_t size, StreamFormat& format, size_t& dataOffset, size_t& dataSize,
+	std::string* error) {
+	if (!image || size < 12 || (std::memcmp(image, "RIFF", 4) != 0 && std::memcmp(image, "RF64", 4) != 0) ||
+		std::memcmp(image + 8, "WAVE", 4) != 0) {
+		setError(error, "not a RIFF/WAVE file");
+		return false;
+	}
+
+	bool haveFmt = false, haveData = false;
+	uint64_t ds64DataSize = 0;
+	size_t pos = 12;
+	while (!haveData && size - pos >= 8) {
+		const uint8_t* chunk = image + pos;
+		uint32_t chunkSize = readU32(chunk + 4);
+		size_t body = pos + 8;
+		size_t available = size - body;
+		if (std::memcmp(chunk, "fmt ", 4) == 0) {
+			if (chunkSize > available) break;
+			format = streamFormatFromFmtChunk(image + body, chunkSize);
+			haveFmt = true;
+		}
+		else if (std::memcmp(chunk, "ds64", 4) == 0 && chunkSize >= 16 && available >= 16) {
+			ds64DataSize = readU64(image + body + 8);
+		}
+		else if (std::memcmp(chunk, "data", 4) == 0) {
+			uint64_t length = chunkSize;
+			if (chunkSize == 0xFFFFFFFFu && ds64DataSize) length = ds64DataSize;
+			else if (chunkSize == 0 || chunkSize == 0xFFFFFFFFu) length = available;
+			dataOffset = body;
+			dataSize = static_cast<size_t>(std::min<uint64_t>(length, available));
+			haveData = true;
+			break;
+		}
+		// 块按偶数字节对齐；最后一块缺少填充字节（或长度超出映像）时结束，pos 不越过 size
+		const uint64_t padded = static_cast<uint64_t>(chunkSize) + (chunkSize & 1);
+		if (padded > available) break;
+		pos = body + static_cast<size_t>(padded);
+	}
+
+	if (!haveFmt || !haveData) {
+		setError(error, "missing fmt or data chunk");
+		return false;
+	}
+	if (format.type == SampleType::Unknown || format.blockAlign == 0) {
+		setError(error, "unsupported sample format");
+		return false;
+	}
+	dataSize -= dataSize % format.blockAlign;
+	return true;
+}
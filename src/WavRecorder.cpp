@@ -0,0 +1,283 @@
+﻿#include "WavRecorder.h"
+#include "WavFile.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace {
+	const size_t kAlign = 4096;            // 批大小与缓冲起点的对齐（页大小 / 扇区大小的公倍数）
+	const uint32_t kDs64BodySize = 28;     // riffSize(8) + dataSize(8) + sampleCount(8) + tableLength(4)
+
+	void put16(uint8_t* p, uint32_t x) {
+		p[0] = static_cast<uint8_t>(x);
+		p[1] = static_cast<uint8_t>(x >> 8);
+	}
+
+	void put32(uint8_t* p, uint32_t x) {
+		put16(p, x & 0xFFFF);
+		put16(p + 2, x >> 16);
+	}
+
+	void put64(uint8_t* p, uint64_t x) {
+		put32(p, static_cast<uint32_t>(x));
+		put32(p + 4, static_cast<uint32_t>(x >> 32));
+	}
+
+	uint32_t readU16(const uint8_t* p) {
+		return static_cast<uint32_t>(p[0] | (p[1] << 8));
+	}
+
+	uint32_t readU32(const uint8_t* p) {
+		return readU16(p) | (readU16(p + 2) << 16);
+	}
+
+	size_t roundUp(size_t x, size_t to) {
+		return (x + to - 1) / to * to;
+	}
+}
+
+// 布局：RIFF/RF64 | WAVE | JUNK/ds64(28) | fmt | data；RIFF 长度不含前 8 字节
+void buildWavHeader(const uint8_t* fmt, size_t fmtSize, uint64_t dataBytes, std::vector<uint8_t>& out) {
+	size_t fmtPadded = fmtSize + (fmtSize & 1);
+	size_t headerSize = 12 + (8 + kDs64BodySize) + (8 + fmtPadded) + 8;
+	out.assign(headerSize, 0);
+	uint8_t* p = out.data();
+
+	uint64_t riffSize = headerSize - 8 + dataBytes;
+	bool rf64 = riffSize > 0xFFFFFFFFull;
+	uint32_t blockAlign = fmtSize >= 14 ? readU16(fmt + 12) : 0;
+
+	std::memcpy(p, rf64 ? "RF64" : "RIFF", 4);
+	put32(p + 4, rf64 ? 0xFFFFFFFFu : static_cast<uint32_t>(riffSize));
+	std::memcpy(p + 8, "WAVE", 4);
+	p += 12;
+
+	// 预留块：普通 WAV 中读取方按未知块跳过，升级为 RF64 时原地改写为 ds64
+	std::memcpy(p, rf64 ? "ds64" : "JUNK", 4);
+	put32(p + 4, kDs64BodySize);
+	if (rf64) {
+		put64(p + 8, riffSize);
+		put64(p + 16, dataBytes);
+		put64(p + 24, blockAlign ? dataBytes / blockAlign : 0);
+	}
+	p += 8 + kDs64BodySize;
+
+	std::memcpy(p, "fmt ", 4);
+	put32(p + 4, static_cast<uint32_t>(fmtSize));
+	if (fmtSize) std::memcpy(p + 8, fmt, fmtSize);
+	p += 8 + fmtPadded;
+
+	std::memcpy(p, "data", 4);
+	put32(p + 4, rf64 ? 0xFFFFFFFFu : static_cast<uint32_t>(dataBytes));
+}
+
+std::string WavRecorder::segmentPath(const std::string& base, uint32_t index) {
+	if (index == 0) return base;
+	size_t dot = base.find_last_of('.');
+	size_t slash = base.find_last_of("/\\");
+	if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) dot = base.size();
+	return base.substr(0, dot) + "_" + std::to_string(index) + base.substr(dot);
+}
+
+bool WavRecorder::start(const std::string& path, const uint8_t* fmt, size_t fmtSize, const WavRecorderConfig& config) {
+	stop();
+	if (!fmt || fmtSize < 16) return false;
+
+	config_ = config;
+	basePath_ = path;
+	fmt_.assign(fmt, fmt + fmtSize);
+	blockAlign_ = std::max<uint32_t>(1, readU16(fmt + 12));
+	if (config.lossless) {
+		format_ = streamFormatFromFmtChunk(fmt, fmtSize);
+		if (format_.type == SampleType::Unknown) return false;
+	}
+
+	// 分段上限：字节与时长取较小者，向下取整到采样帧
+	uint64_t limit = config.segmentBytes;
+	if (config.segmentSeconds) {
+		uint64_t bySeconds = static_cast<uint64_t>(readU32(fmt + 4)) * blockAlign_ * config.segmentSeconds;
+		limit = limit ? std::min(limit, bySeconds) : bySeconds;
+	}
+	segmentLimit_ = limit ? std::max<uint64_t>(blockAlign_, limit - limit % blockAlign_) : 0;
+
+	batch_ = roundUp(std::max<size_t>(config.batchBytes, 1), kAlign);
+	capacity_ = batch_;
+	while (capacity_ < config.bufferBytes || capacity_ < 2 * batch_) capacity_ *= 2;
+	storage_.assign(capacity_ + kAlign, 0);
+	uintptr_t raw = reinterpret_cast<uintptr_t>(storage_.data());
+	buffer_ = storage_.data() + (roundUp(raw, kAlign) - raw);
+
+	head_.store(0, std::memory_order_relaxed);
+	tail_.store(0, std::memory_order_relaxed);
+	tailCache_ = 0;
+	dropped_.store(0, std::memory_order_relaxed);
+	highWater_.store(0, std::memory_order_relaxed);
+	segments_.store(0, std::memory_order_relaxed);
+	failed_.store(false, std::memory_order_relaxed);
+	stopping_.store(false, std::memory_order_relaxed);
+
+	// 第一个文件同步创建，路径不可写时直接失败
+	segmentIndex_ = 0;
+	if (!openSegment()) {
+		buffer_ = nullptr;
+		return false;
+	}
+	thread_ = std::thread(&WavRecorder::ioThread, this);
+	return true;
+}
+
+void WavRecorder::stop() {
+	if (!thread_.joinable()) return;
+	stopping_.store(true, std::memory_order_release);
+	wake_.notify_one();
+	thread_.join();
+	buffer_ = nullptr;
+	storage_.clear();
+	storage_.shrink_to_fit();
+}
+
+bool WavRecorder::append(const void* data, size_t bytes) {
+	if (!buffer_) return false;
+	if (bytes == 0) return true;
+
+	uint64_t head = head_.load(std::memory_order_relaxed);
+	if (head + bytes - tailCache_ > capacity_) {
+		tailCache_ = tail_.load(std::memory_order_acquire);
+		if (head + bytes - tailCache_ > capacity_) {
+			dropped_.fetch_add(1, std::memory_order_relaxed);
+			if (metrics_) metrics_->add(Metric::RecorderDrops);
+			return false;
+		}
+	}
+
+	size_t pos = static_cast<size_t>(head & (capacity_ - 1));
+	size_t first = std::min(bytes, capacity_ - pos);
+	const uint8_t* src = static_cast<const uint8_t*>(data);
+	std::memcpy(buffer_ + pos, src, first);
+	if (first < bytes) std::memcpy(buffer_, src + first, bytes - first);
+	head_.store(head + bytes, std::memory_order_release);
+
+	size_t backlog = static_cast<size_t>(head + bytes - tail_.load(std::memory_order_relaxed));
+	if (backlog > highWater_.load(std::memory_order_relaxed)) highWater_.store(backlog, std::memory_order_relaxed);
+	if (metrics_) {
+		metrics_->set(Metric::RecorderBacklog, backlog);
+		metrics_->raise(Metric::RecorderBacklogHighWater, backlog);
+	}
+
+	// 凑满一批时唤醒写盘线程；不足一批的数据由检查点定时写出
+	if (head / batch_ != (head + bytes) / batch_) wake_.notify_one();
+	return true;
+}
+
+// 写盘线程：整批写出，检查点或停止时把不足一批的剩余数据也写出并回填文件头
+void WavRecorder::ioThread() {
+	typedef std::chrono::steady_clock Clock;
+	const Clock::duration interval = std::chrono::milliseconds(std::max<uint32_t>(config_.checkpointMs, 1));
+	Clock::time_point nextCheckpoint = Clock::now() + interval;
+	uint64_t tail = tail_.load(std::memory_order_relaxed);
+
+	while (true) {
+		bool stopping = stopping_.load(std::memory_order_acquire);  // 先读停止标志，再读写入位置
+		uint64_t avail = head_.load(std::memory_order_acquire) - tail;
+		Clock::time_point now = Clock::now();
+		bool due = now >= nextCheckpoint;
+
+		uint64_t want = (due || stopping) ? avail : avail - avail % batch_;
+		while (want) {
+			size_t pos = static_cast<size_t>(tail & (capacity_ - 1));
+			size_t chunk = static_cast<size_t>(std::min<uint64_t>(want, capacity_ - pos));
+			if (segmentLimit_ && !failed_.load(std::memory_order_relaxed)) {
+				if (!file_.is_open()) openSegment();
+				if (file_.is_open()) chunk = static_cast<size_t>(std::min<uint64_t>(chunk, segmentLimit_ - segmentData_));
+			}
+			writeChunk(buffer_ + pos, chunk);
+			tail += chunk;
+			want -= chunk;
+			tail_.store(tail, std::memory_order_release);
+
+			// 当前文件写满：回填最终长度后关闭，下一个文件在有数据时再创建
+			if (segmentLimit_ && segmentData_ >= segmentLimit_ && file_.is_open()) {
+				closeSegment();
+				++segmentIndex_;
+			}
+		}
+		if (metrics_) metrics_->set(Metric::RecorderBacklog, head_.load(std::memory_order_relaxed) - tail);
+
+		if (due) {
+			if (segmentData_ != headerData_) writeHeader();
+			nextCheckpoint = now + interval;
+		}
+		if (stopping) break;
+		if (head_.load(std::memory_order_acquire) - tail < batch_) {
+			std::unique_lock<std::mutex> lock(mutex_);
+			wake_.wait_for(lock, std::min<Clock::duration>(std::chrono::milliseconds(10), interval));
+		}
+	}
+
+	closeSegment();
+}
+
+bool WavRecorder::openSegment() {
+	file_.open(segmentPath(basePath_, segmentIndex_), std::ios::binary | std::ios::trunc);
+	if (!file_.is_open()) {
+		failed_.store(true, std::memory_order_release);
+		return false;
+	}
+	segmentData_ = 0;
+	headerData_ = 0;
+	segments_.fetch_add(1, std::memory_order_release);
+	if (config_.lossless) return encoder_.open(file_, format_, config_.losslessConfig) && file_.good();
+	buildWavHeader(fmt_.data(), fmt_.size(), 0, header_);
+	file_.write(reinterpret_cast<const char*>(header_.data()), header_.size());
+	file_.flush();
+	return file_.good();
+}
+
+void WavRecorder::closeSegment() {
+	if (!file_.is_open()) return;
+	if (config_.lossless) {
+		encoder_.finish();
+		file_.flush();
+	}
+	else {
+		writeHeader();
+	}
+	file_.close();
+}
+
+bool WavRecorder::writeHeader() {
+	if (!file_.is_open()) return false;
+	if (config_.lossless) {
+		// 压缩文件的检查点：刷出不足一块的数据并回填文件头中的总帧数
+		bool ok = encoder_.checkpoint();
+		file_.flush();
+		headerData_ = segmentData_;
+		return ok && file_.good();
+	}
+	buildWavHeader(fmt_.data(), fmt_.size(), segmentData_, header_);
+	file_.seekp(0, std::ios::beg);
+	file_.write(reinterpret_cast<const char*>(header_.data()), header_.size());
+	file_.seekp(0, std::ios::end);
+	file_.flush();  // 交给操作系统：进程被结束后文件内容与文件头仍然一致
+	headerData_ = segmentData_;
+	return file_.good();
+}
+
+// 写入失败（磁盘满等）后不再写文件，但继续消费缓冲，生产者不会因此积压
+bool WavRecorder::writeChunk(const uint8_t* data, size_t bytes) {
+	if (!file_.is_open() || failed_.load(std::memory_order_relaxed)) return false;
+	uint64_t start = PipelineMetrics::nowNs();
+	if (config_.lossless) encoder_.write(data, bytes);
+	else file_.write(reinterpret_cast<const char*>(data), bytes);
+	if (!file_.good()) {
+		failed_.store(true, std::memory_order_release);
+		file_.close();
+		return false;
+	}
+	segmentData_ += bytes;
+	if (metrics_) {
+		metrics_->add(Metric::RecorderBytes, bytes);
+		metrics_->add(Metric::RecorderWriteNs, PipelineMetrics::nowNs() - start);
+	}
+	return true;
+}
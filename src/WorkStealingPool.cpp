@@ -0,0 +1,86 @@
+﻿#include "WorkStealingPool.h"
+#include <algorithm>
+
+namespace {
+	// 当前线程所属的线程池与队列号，工作线程内提交的任务进入自己的队列
+	thread_local WorkStealingPool* tlsPool = nullptr;
+	thread_local unsigned tlsIndex = 0;
+}
+
+WorkStealingPool::WorkStealingPool(unsigned threads) {
+	if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+	for (unsigned i = 0; i < threads; ++i) queues_.emplace_back(new Queue());
+	for (unsigned i = 0; i < threads; ++i) threads_.emplace_back(&WorkStealingPool::run, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool() {
+	wait();
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex_);
+		stopping_ = true;
+	}
+	wake_.notify_all();
+	for (std::thread& t : threads_) t.join();
+}
+
+void WorkStealingPool::submit(Task task) {
+	unsigned index = tlsPool == this ? tlsIndex
+		: nextQueue_.fetch_add(1, std::memory_order_relaxed) % static_cast<unsigned>(queues_.size());
+	pending_.fetch_add(1, std::memory_order_acq_rel);
+	{
+		std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+		queues_[index]->tasks.push_back(std::move(task));
+	}
+	// 计数在加锁通知之前增加：等待中的线程在 sleepMutex_ 下检查计数，不会错过唤醒
+	queued_.fetch_add(1, std::memory_order_release);
+	std::lock_guard<std::mutex> lock(sleepMutex_);
+	wake_.notify_one();
+}
+
+void WorkStealingPool::wait() {
+	std::unique_lock<std::mutex> lock(sleepMutex_);
+	idle_.wait(lock, [this]() { return pending_.load(std::memory_order_acquire) == 0; });
+}
+
+// 先取自己队尾，再从下一个线程开始依次窃取其他队头
+bool WorkStealingPool::take(unsigned index, Task& task) {
+	const unsigned n = static_cast<unsigned>(queues_.size());
+	for (unsigned k = 0; k < n; ++k) {
+		Queue& q = *queues_[(index + k) % n];
+		std::lock_guard<std::mutex> lock(q.mutex);
+		if (q.tasks.empty()) continue;
+		if (k == 0) {
+			task = std::move(q.tasks.back());
+			q.tasks.pop_back();
+		}
+		else {
+			task = std::move(q.tasks.front());
+			q.tasks.pop_front();
+			steals_.fetch_add(1, std::memory_order_relaxed);
+		}
+		queued_.fetch_sub(1, std::memory_order_relaxed);
+		return true;
+	}
+	return false;
+}
+
+void WorkStealingPool::run(unsigned index) {
+	tlsPool = this;
+	tlsIndex = index;
+	Task task;
+	while (true) {
+		if (take(index, task)) {
+			task();
+			task = nullptr;
+			executed_.fetch_add(1, std::memory_order_relaxed);
+			if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+				std::lock_guard<std::mutex> lock(sleepMutex_);
+				idle_.notify_all();
+			}
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(sleepMutex_);
+		wake_.wait(lock, [this]() { return stopping_ || queued_.load(std::memory_order_acquire) > 0; });
+		if (stopping_) break;
+	}
+}
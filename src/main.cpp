@@ -1,4 +1,6 @@
 ﻿#include <windows.h>
+#include <cstring>
+#include <cstdlib>
 #include "AudioCapture.h"
 #include "Canvas.h"
 
@@ -42,20 +44,58 @@ int WINAPI WinMain(
     AudioCapture ac;
     ac.setMainWindowHandle(hwnd);
     ac.outputWavFile = "high_freq_audio.wav";
-    ac.start();
+    ac.recordAudio = lpCmdLine && std::strstr(lpCmdLine, "--record") != nullptr;  // 录制触发检测的数据包
+    if (lpCmdLine && std::strstr(lpCmdLine, "--lossless") != nullptr) {           // 录音无损压缩写盘
+        ac.recorderConfig.lossless = true;
+        ac.outputWavFile = "high_freq_audio.aclc";
+    }
+    ac.clipCapture = lpCmdLine && std::strstr(lpCmdLine, "--clips") != nullptr;   // 每个事件写一段带前后文的片段
+    ac.adaptiveNoiseFloor = !(lpCmdLine && std::strstr(lpCmdLine, "--fixed-threshold") != nullptr);  // 关闭自适应噪声底
+    ac.latencyTracing = lpCmdLine && std::strstr(lpCmdLine, "--trace-latency") != nullptr;  // 退出时导出延迟跟踪
+    if (const char* deadline = lpCmdLine ? std::strstr(lpCmdLine, "--deadline-ms=") : nullptr) {  // 事件从采集到显示的最长时间
+        ac.analysisDeadline.maxAgeNs = std::strtoull(deadline + 14, nullptr, 10) * 1000000ull;
+    }
+    if (!ac.start()) {
+        MessageBox(nullptr, L"无法初始化音频捕获设备，程序将退出。", L"错误", MB_OK | MB_ICONERROR);
+        delete g_canvas;
+        ReleaseMutex(_mutex);
+        CloseHandle(_mutex);
+        return 1;
+    }
+
+    // 合成并呈现一帧（渲染节拍或空闲后的第一个事件），记录延迟跟踪与指标
+    auto renderFrame = [&]() {
+        uint64_t renderStart = PipelineMetrics::nowNs();
+        if (!g_canvas->onRenderTimer()) return;
+        for (uint64_t id : g_canvas->presentedEvents()) ac.tracer().mark(id, TraceStage::Rendered);
+        ac.metrics().add(Metric::RenderBusyNs, PipelineMetrics::nowNs() - renderStart);
+        ac.metrics().add(Metric::RenderCount);
+        ac.metrics().set(Metric::RenderCoalesced, g_canvas->eventsCoalesced());
+    };
 
-    // 消息循环
+    // 消息循环：事件只提交给调度器，绘制由渲染定时器按显示刷新率合并进行
     MSG msg;
     while (GetMessage(&msg, nullptr, 0, 0)) {
         if (msg.message == WM_USER + 100) {
-            auto event = reinterpret_cast<AudioCapture::AudioEvent*>(msg.lParam);
-            if (event->highFreq && g_canvas) {
-                g_canvas->drawArc(event->angle);
-            }
-            delete event;
+            // 唤醒消息不带数据：一次取完邮箱中累积的全部事件
+            bool startRender = false;
+            ac.events().drain([&](const OverlayEvent& event) {
+                if (!event.highFreq || !g_canvas) return;
+                // 多个声源同时发声时各画一段弧，融合角度只会落在它们中间
+                if (event.sourceCount >= 2) {
+                    for (uint8_t i = 0; i < event.sourceCount; ++i) {
+                        if (g_canvas->submitArc(event.sources[i].angle, event.streamOffset)) startRender = true;
+                    }
+                }
+                else if (g_canvas->submitArc(event.angle, event.streamOffset)) {
+                    startRender = true;
+                }
+            });
+            if (startRender) renderFrame();
         }
-        else if (msg.message == WM_USER + 101) {
-            g_canvas->clear();
+        else if (msg.message == WM_TIMER && msg.hwnd == hwnd && msg.wParam == Canvas::kRenderTimerId) {
+            renderFrame();
+            continue;  // 渲染定时器没有回调，无需分发
         }
         TranslateMessage(&msg);
         DispatchMessage(&msg);
@@ -0,0 +1,198 @@
+﻿// 批量离线分析：扫描目录下的录音，用与实时程序相同的检测流水线逐包检测并估计方位，
+// 每个输入文件输出一份事件时间线（时间、方位、高频占比），并汇总每组阈值的事件数
+// 多组阈值（--min / --eps / --ratio / --adaptive 各给一个逗号分隔列表，取笛卡尔积）在同一次解码中同时评估，
+// 例如 --adaptive off,on 对比固定阈值与自适应噪声底在同一批录音上的事件数
+//
+// 用法：BatchAnalyze <dir|file.wav>... --out <dir> [--format csv|bin] [--threads n] [--direction ild|itd]
+//                    [--min hz,...] [--eps x,...] [--ratio x,...] [--adaptive off|on,...] [--margin db]
+//                    [--packet frames] [--chunk packets]
+#include "BatchAnalyzer.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+	struct AnalyzeOptions {
+		std::vector<std::string> inputs;
+		std::string out;
+		bool binary = false;
+		std::vector<float> mins, epsilons, ratios;
+		std::vector<bool> adaptive;
+		float marginDb = DetectorParams().floorMarginDb;
+		BatchConfig config;
+	};
+
+	bool parseList(const char* text, std::vector<float>& out) {
+		out.clear();
+		std::string s = text;
+		size_t start = 0;
+		while (start <= s.size()) {
+			size_t comma = s.find(',', start);
+			std::string item = s.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+			char* end = nullptr;
+			float v = std::strtof(item.c_str(), &end);
+			if (item.empty() || *end != '\0') return false;
+			out.push_back(v);
+			if (comma == std::string::npos) break;
+			start = comma + 1;
+		}
+		return !out.empty();
+	}
+
+	bool parseSwitches(const char* text, std::vector<bool>& out) {
+		out.clear();
+		std::string s = text;
+		size_t start = 0;
+		while (start <= s.size()) {
+			size_t comma = s.find(',', start);
+			std::string item = s.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+			if (item == "on") out.push_back(true);
+			else if (item == "off") out.push_back(false);
+			else return false;
+			if (comma == std::string::npos) break;
+			start = comma + 1;
+		}
+		return !out.empty();
+	}
+
+	bool parseArgs(int argc, char** argv, AnalyzeOptions& opt) {
+		for (int i = 1; i < argc; ++i) {
+			std::string arg = argv[i];
+			bool hasValue = (i + 1 < argc);
+			if (arg == "--out" && hasValue) opt.out = argv[++i];
+			else if (arg == "--format" && hasValue) {
+				std::string format = argv[++i];
+				if (format != "csv" && format != "bin") return false;
+				opt.binary = format == "bin";
+			}
+			else if (arg == "--threads" && hasValue) opt.config.threads = static_cast<unsigned>(std::atoi(argv[++i]));
+			else if (arg == "--packet" && hasValue) opt.config.packetFrames = static_cast<uint32_t>(std::atoi(argv[++i]));
+			else if (arg == "--chunk" && hasValue) opt.config.chunkPackets = static_cast<uint32_t>(std::atoi(argv[++i]));
+			else if (arg == "--min" && hasValue) { if (!parseList(argv[++i], opt.mins)) return false; }
+			else if (arg == "--eps" && hasValue) { if (!parseList(argv[++i], opt.epsilons)) return false; }
+			else if (arg == "--ratio" && hasValue) { if (!parseList(argv[++i], opt.ratios)) return false; }
+			else if (arg == "--adaptive" && hasValue) { if (!parseSwitches(argv[++i], opt.adaptive)) return false; }
+			else if (arg == "--margin" && hasValue) opt.marginDb = std::strtof(argv[++i], nullptr);
+			else if (arg == "--direction" && hasValue) {
+				std::string mode = argv[++i];
+				if (mode == "ild") opt.config.directionMode = DirectionMode::Ild;
+				else if (mode == "itd") opt.config.directionMode = DirectionMode::ItdIld;
+				else return false;
+			}
+			else if (!arg.empty() && arg[0] != '-') opt.inputs.push_back(arg);
+			else return false;
+		}
+		if (opt.inputs.empty() || opt.out.empty() || opt.config.packetFrames == 0 || opt.config.chunkPackets == 0) return false;
+
+		// 未指定的维度取默认参数
+		DetectorParams defaults;
+		if (opt.mins.empty()) opt.mins.push_back(defaults.highFreqMin);
+		if (opt.epsilons.empty()) opt.epsilons.push_back(defaults.highFreqEpsilon);
+		if (opt.ratios.empty()) opt.ratios.push_back(defaults.highFreqRatio);
+		if (opt.adaptive.empty()) opt.adaptive.push_back(defaults.adaptiveFloor);
+		for (float m : opt.mins) {
+			for (float e : opt.epsilons) {
+				for (float r : opt.ratios) {
+					for (bool a : opt.adaptive) {
+						DetectorParams p;
+						p.highFreqMin = m;
+						p.highFreqEpsilon = e;
+						p.highFreqRatio = r;
+						p.adaptiveFloor = a;
+						p.floorMarginDb = opt.marginDb;
+						opt.config.paramSets.push_back(p);
+					}
+				}
+			}
+		}
+		return true;
+	}
+
+	// 输出文件名：输入路径去掉扩展名，目录分隔符换成 '_'，不同目录下的同名录音不会互相覆盖
+	std::string outputName(const std::string& path, const char* suffix) {
+		std::string name = path;
+		size_t dot = name.find_last_of('.');
+		if (dot != std::string::npos && name.find_first_of("/\\", dot) == std::string::npos) name.resize(dot);
+		size_t start = name.find_first_not_of("./\\");
+		name = start == std::string::npos ? "input" : name.substr(start);
+		for (char& c : name) {
+			if (c == '/' || c == '\\' || c == ':') c = '_';
+		}
+		return name + suffix;
+	}
+}
+
+int main(int argc, char** argv) {
+	AnalyzeOptions opt;
+	if (!parseArgs(argc, argv, opt)) {
+		std::fprintf(stderr, "usage: BatchAnalyze <dir|file.wav>... --out <dir> [--format csv|bin] [--threads n] "
+			"[--direction ild|itd] [--min hz,...] [--eps x,...] [--ratio x,...] [--adaptive off|on,...] [--margin db] "
+			"[--packet frames] [--chunk packets]\n");
+		return 2;
+	}
+
+	std::vector<std::string> files;
+	for (const std::string& input : opt.inputs) collectWavFiles(input, files);
+	if (files.empty()) {
+		std::fprintf(stderr, "no .wav files found\n");
+		return 1;
+	}
+
+	const size_t sets = opt.config.paramSets.size();
+	std::mutex mutex;
+	std::vector<uint64_t> eventsPerSet(sets, 0);
+	double analyzedSeconds = 0.0;
+	uint32_t writeErrors = 0;
+	auto onFile = [&](const BatchFileResult& result) {
+		std::string path = opt.out + "/" + outputName(result.path, opt.binary ? ".events.bin" : ".events.csv");
+		bool written = false;
+		if (result.ok) {
+			std::ofstream out(path, opt.binary ? std::ios::binary : std::ios::out);
+			if (out.is_open()) {
+				if (opt.binary) writeEventsBinary(out, result, static_cast<uint32_t>(sets));
+				else writeEventsCsv(out, result);
+				written = out.good();
+			}
+		}
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!result.ok) std::fprintf(stderr, "%s: %s\n", result.path.c_str(), result.error.c_str());
+		else if (!written) {
+			std::fprintf(stderr, "cannot write %s\n", path.c_str());
+			++writeErrors;
+		}
+		for (const BatchEvent& e : result.events) ++eventsPerSet[e.paramSet];
+		if (result.ok && result.format.sampleRate) analyzedSeconds += static_cast<double>(result.frames) / result.format.sampleRate;
+	};
+
+	BatchStats stats;
+	if (!analyzeFiles(files, opt.config, onFile, &stats)) {
+		std::fprintf(stderr, "invalid analysis parameters\n");
+		return 2;
+	}
+
+	// 汇总：每组阈值的事件总数与每分钟事件数，用于比较不同阈值（以及是否启用自适应噪声底）
+	std::string summaryPath = opt.out + "/summary.csv";
+	std::ofstream summary(summaryPath);
+	if (summary.is_open()) {
+		summary << "param_set,high_freq_min,high_freq_epsilon,high_freq_ratio,adaptive_floor,floor_margin_db,events,events_per_minute\n";
+		for (size_t s = 0; s < sets; ++s) {
+			const DetectorParams& p = opt.config.paramSets[s];
+			summary << s << ',' << p.highFreqMin << ',' << p.highFreqEpsilon << ',' << p.highFreqRatio << ','
+				<< (p.adaptiveFloor ? 1 : 0) << ',' << p.floorMarginDb << ',' << eventsPerSet[s] << ',' << (analyzedSeconds > 0 ? eventsPerSet[s] * 60.0 / analyzedSeconds : 0.0) << '\n';
+		}
+	}
+	else {
+		std::fprintf(stderr, "cannot write %s\n", summaryPath.c_str());
+		++writeErrors;
+	}
+
+	std::printf("%u file(s) (%u failed), %zu parameter set(s), %.1f h of audio in %.2f s on %u thread(s): "
+		"%.0fx realtime, %u chunk(s), %llu steal(s)\n",
+		stats.files, stats.failed, sets, stats.audioSeconds / 3600.0, stats.seconds, stats.threads,
+		stats.seconds > 0 ? stats.audioSeconds / stats.seconds : 0.0, stats.chunks,
+		static_cast<unsigned long long>(stats.steals));
+	return stats.failed || writeErrors ? 1 : 0;
+}
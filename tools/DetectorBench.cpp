@@ -0,0 +1,808 @@
+﻿// 检测核心基准测试：FFT、PCM 内核、格式解码、帧分析、方位估计、端到端流水线吞吐、叠加层合成、无损压缩、批量分析的多线程扩展，
+// 以及合成场景上的检测准确率（召回、精度、方位误差、检测延迟），改动 DSP 时吞吐与准确率一并对比
+// 只依赖平台无关的核心代码，不包含 Win32 头文件，可在 Linux 上编译运行
+// 结果以 JSON 写到标准输出（或 --out 指定的文件），便于脚本对比不同提交
+//
+// 用法：DetectorBench [--out file.json] [--min-time ms] [--suite name] [--seconds s] [--input file.wav]
+//   suite: fft, kernels, decode, analyze, direction, pipeline, render, codec, batch, accuracy（默认全部）
+#include "FFT.h"
+#include "PcmKernels.h"
+#include "SampleFormat.h"
+#include "StftFramer.h"
+#include "FrameAnalyzer.h"
+#include "DirectionEstimator.h"
+#include "DetectorPipeline.h"
+#include "WavFile.h"
+#include "OverlayRenderer.h"
+#include "LosslessCodec.h"
+#include "BatchAnalyzer.h"
+#include "WavRecorder.h"
+#include "SyntheticScene.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <complex>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+	typedef std::chrono::steady_clock Clock;
+
+	// 单项结果：每次操作耗时与吞吐（items 为样本、变换或数据包，由 unit 说明）
+	struct BenchResult {
+		std::string suite;
+		std::string name;
+		std::vector<std::pair<std::string, std::string>> params;
+		double nsPerOp = 0.0;
+		double itemsPerOp = 1.0;
+		std::string unit;
+		std::vector<std::pair<std::string, double>> extra;  // 附加指标（实时倍率、触发数等）
+	};
+
+	struct BenchOptions {
+		double minSeconds = 0.2;     // 每项最少计时时长
+		double pipelineSeconds = 10; // 端到端测试的预录音频时长
+		std::string suite;           // 为空时运行全部
+		std::string out;             // 为空时输出到标准输出
+		std::string input;           // pipeline 测试回放的 WAV 文件，为空时用合成信号
+	};
+
+	volatile float g_sink = 0.0f;  // 防止结果被优化掉
+
+	// 反复调用 fn，直到累计时间超过 minSeconds，返回每次调用的平均纳秒数
+	template <typename Fn>
+	double measure(Fn&& fn, double minSeconds) {
+		fn();  // 预热：构建 FFT 计划、触发缓存
+		uint64_t iterations = 0;
+		uint64_t batch = 1;
+		double elapsed = 0.0;
+		while (elapsed < minSeconds) {
+			Clock::time_point t0 = Clock::now();
+			for (uint64_t i = 0; i < batch; ++i) fn();
+			elapsed += std::chrono::duration<double>(Clock::now() - t0).count();
+			iterations += batch;
+			if (batch < (1u << 20)) batch *= 2;
+		}
+		return elapsed * 1e9 / static_cast<double>(iterations);
+	}
+
+	std::string toString(double v) {
+		std::ostringstream ss;
+		ss << v;
+		return ss.str();
+	}
+
+	std::string jsonEscape(const std::string& s) {
+		std::string r;
+		for (char c : s) {
+			if (c == '"' || c == '\\') r += '\\';
+			r += c;
+		}
+		return r;
+	}
+
+	void writeJson(std::ostream& os, const std::vector<BenchResult>& results, const BenchOptions& opt) {
+		os << "{\n";
+		os << "  \"tool\": \"DetectorBench\",\n";
+		os << "  \"isa\": \"" << PcmKernels::best().name << "\",\n";
+		os << "  \"min_time_s\": " << opt.minSeconds << ",\n";
+		os << "  \"results\": [\n";
+		for (size_t i = 0; i < results.size(); ++i) {
+			const BenchResult& r = results[i];
+			os << "    {\"suite\": \"" << jsonEscape(r.suite) << "\", \"name\": \"" << jsonEscape(r.name) << "\"";
+			for (const auto& p : r.params) os << ", \"" << jsonEscape(p.first) << "\": \"" << jsonEscape(p.second) << "\"";
+			os << ", \"ns_per_op\": " << r.nsPerOp;
+			os << ", \"unit\": \"" << jsonEscape(r.unit) << "\"";
+			os << ", \"per_sec\": " << (r.nsPerOp > 0.0 ? r.itemsPerOp * 1e9 / r.nsPerOp : 0.0);
+			for (const auto& e : r.extra) os << ", \"" << jsonEscape(e.first) << "\": " << e.second;
+			os << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+		}
+		os << "  ]\n";
+		os << "}\n";
+	}
+
+	// 可复现的测试信号：低频正弦背景，按需叠加高频猝发（正弦 + 白噪声）
+	void makeSignal(std::vector<float>& left, std::vector<float>& right, size_t frames, uint32_t sampleRate,
+		bool bursts, uint32_t seed) {
+		std::mt19937 rng(seed);
+		std::normal_distribution<float> noise(0.0f, 0.1f);
+		left.resize(frames);
+		right.resize(frames);
+		const float kPi = 3.14159265f;
+		const size_t burstPeriod = sampleRate / 2;  // 每 0.5 秒一次猝发
+		const size_t burstLength = sampleRate / 50; // 持续 20 毫秒
+		for (size_t i = 0; i < frames; ++i) {
+			float base = 0.2f * std::sin(2.0f * kPi * 220.0f * i / sampleRate);
+			float l = base;
+			float r = base;
+			if (bursts && (i % burstPeriod) < burstLength) {
+				float hf = 0.3f * std::sin(2.0f * kPi * 12000.0f * i / sampleRate) + noise(rng);
+				l += hf;
+				r += 0.5f * hf;  // 偏左
+			}
+			left[i] = l;
+			right[i] = r;
+		}
+	}
+
+	size_t bytesPerSample(SampleType type) {
+		switch (type) {
+		case SampleType::Int16: return 2;
+		case SampleType::Int24: return 3;
+		case SampleType::Int32: return 4;
+		case SampleType::Float32: return 4;
+		default: return 0;
+		}
+	}
+
+	// 把左右声道编码为交错 PCM（声道 0/1 为左右，其余声道写入右声道的衰减副本）
+	std::vector<uint8_t> encodeInterleaved(const std::vector<float>& left, const std::vector<float>& right,
+		SampleType type, uint32_t channels) {
+		const size_t bytes = bytesPerSample(type);
+		std::vector<uint8_t> out(left.size() * channels * bytes);
+		uint8_t* p = out.data();
+		for (size_t i = 0; i < left.size(); ++i) {
+			for (uint32_t c = 0; c < channels; ++c) {
+				float v = (c == 0) ? left[i] : ((c == 1) ? right[i] : 0.5f * right[i]);
+				v = (v < -1.0f) ? -1.0f : ((v > 0.999f) ? 0.999f : v);
+				switch (type) {
+				case SampleType::Int16: {
+					int16_t s = static_cast<int16_t>(std::lrint(v * 32767.0f));
+					std::memcpy(p, &s, 2);
+					break;
+				}
+				case SampleType::Int24: {
+					int32_t s = static_cast<int32_t>(std::lrint(v * 8388607.0f));
+					p[0] = static_cast<uint8_t>(s);
+					p[1] = static_cast<uint8_t>(s >> 8);
+					p[2] = static_cast<uint8_t>(s >> 16);
+					break;
+				}
+				case SampleType::Int32: {
+					int32_t s = static_cast<int32_t>(std::lrint(static_cast<double>(v) * 2147483647.0));
+					std::memcpy(p, &s, 4);
+					break;
+				}
+				case SampleType::Float32:
+					std::memcpy(p, &v, 4);
+					break;
+				default:
+					break;
+				}
+				p += bytes;
+			}
+		}
+		return out;
+	}
+
+	StreamFormat makeFormat(SampleType type, uint32_t channels, uint32_t sampleRate) {
+		StreamFormat fmt;
+		fmt.type = type;
+		fmt.channels = channels;
+		fmt.sampleRate = sampleRate;
+		fmt.blockAlign = static_cast<uint32_t>(channels * bytesPerSample(type));
+		return fmt;
+	}
+
+	// 直接 DFT，作为 FFT 加速比的参照
+	void naiveDft(const std::vector<float>& in, std::vector<std::complex<float>>& out) {
+		const size_t n = in.size();
+		const double kPi = 3.14159265358979323846;
+		out.resize(n);
+		for (size_t k = 0; k < n; ++k) {
+			std::complex<double> sum(0.0, 0.0);
+			for (size_t t = 0; t < n; ++t) {
+				double a = -2.0 * kPi * static_cast<double>((k * t) % n) / n;
+				sum += std::complex<double>(in[t] * std::cos(a), in[t] * std::sin(a));
+			}
+			out[k] = std::complex<float>(static_cast<float>(sum.real()), static_cast<float>(sum.imag()));
+		}
+	}
+
+	const SampleType kTypes[] = { SampleType::Int16, SampleType::Int24, SampleType::Int32, SampleType::Float32 };
+	const uint32_t kChannels[] = { 1, 2, 6, 8 };
+	const uint32_t kPacketSizes[] = { 128, 441, 480, 1024 };  // 常见 WASAPI 数据包大小（采样帧）
+	const uint32_t kSampleRate = 48000;
+
+	// FFT：各长度的复数变换、实数变换，以及直接 DFT 参照
+	void benchFft(const BenchOptions& opt, std::vector<BenchResult>& results) {
+		const size_t sizes[] = { 128, 256, 441, 480, 512, 960, 1024, 2048 };
+		std::vector<float> l, r;
+		makeSignal(l, r, 2048, kSampleRate, true, 1);
+		for (size_t n : sizes) {
+			std::shared_ptr<const FFTPlan> plan = FFTPlan::get(n);
+			std::vector<float> in(l.begin(), l.begin() + n);
+			std::vector<std::complex<float>> data(n), half(n / 2 + 1), halfB(n / 2 + 1);
+
+			BenchResult complexRes;
+			complexRes.suite = "fft";
+			complexRes.name = "forward";
+			complexRes.params.push_back(std::make_pair("n", toString(static_cast<double>(n))));
+			complexRes.unit = "transforms";
+			complexRes.nsPerOp = measure([&]() {
+				for (size_t i = 0; i < n; ++i) data[i] = std::complex<float>(in[i], 0.0f);
+				plan->forward(data.data());
+				g_sink = data[1].real();
+			}, opt.minSeconds);
+			results.push_back(complexRes);
+
+			BenchResult realRes = complexRes;
+			realRes.name = "forwardReal";
+			realRes.nsPerOp = measure([&]() {
+				plan->forwardReal(in.data(), half.data());
+				g_sink = half[1].real();
+			}, opt.minSeconds);
+			results.push_back(realRes);
+
+			BenchResult pairRes = complexRes;
+			pairRes.name = "forwardRealPair";
+			pairRes.nsPerOp = measure([&]() {
+				plan->forwardRealPair(in.data(), in.data(), half.data(), halfB.data());
+				g_sink = halfB[1].real();
+			}, opt.minSeconds);
+			results.push_back(pairRes);
+
+			// 直接 DFT 为 O(n²)，只测到 1024 点
+			if (n <= 1024) {
+				std::vector<std::complex<float>> ref;
+				BenchResult dftRes = complexRes;
+				dftRes.name = "naiveDft";
+				dftRes.nsPerOp = measure([&]() {
+					naiveDft(in, ref);
+					g_sink = ref[1].real();
+				}, opt.minSeconds);
+				dftRes.extra.push_back(std::make_pair("fft_speedup", dftRes.nsPerOp / realRes.nsPerOp));
+				results.push_back(dftRes);
+			}
+		}
+	}
+
+	// PCM 内核：各指令集级别、各数据包大小
+	void benchKernels(const BenchOptions& opt, std::vector<BenchResult>& results) {
+		const PcmIsa isas[] = { PcmIsa::Scalar, PcmIsa::SSE2, PcmIsa::AVX2 };
+		std::vector<float> l, r;
+		makeSignal(l, r, 1024 * 8, kSampleRate, true, 2);
+		std::vector<int16_t> s16(l.size());
+		for (size_t i = 0; i < l.size(); ++i) s16[i] = static_cast<int16_t>(std::lrint(l[i] * 16000.0f));
+		std::vector<float> outL(1024), outR(1024), mono(1024);
+		std::vector<int16_t> outS16(1024 * 8);
+
+		for (PcmIsa isa : isas) {
+			if (!PcmKernels::supported(isa)) continue;
+			const PcmKernels& k = PcmKernels::forIsa(isa);
+			for (uint32_t n : kPacketSizes) {
+				auto add = [&](const char* name, uint32_t channels, double ns) {
+					BenchResult res;
+					res.suite = "kernels";
+					res.name = name;
+					res.params.push_back(std::make_pair("isa", std::string(k.name)));
+					res.params.push_back(std::make_pair("frames", toString(n)));
+					if (channels) res.params.push_back(std::make_pair("channels", toString(channels)));
+					res.nsPerOp = ns;
+					res.itemsPerOp = n;
+					res.unit = "frames";
+					results.push_back(res);
+				};
+				for (uint32_t ch : kChannels) {
+					add("deinterleaveS16", ch, measure([&]() {
+						k.deinterleaveS16(s16.data(), ch, n, outL.data(), outR.data());
+						g_sink = outL[0];
+					}, opt.minSeconds));
+					add("deinterleaveF32", ch, measure([&]() {
+						k.deinterleaveF32(l.data(), ch, n, outL.data(), outR.data());
+						g_sink = outL[0];
+					}, opt.minSeconds));
+				}
+				add("s16ToFloat", 0, measure([&]() {
+					k.s16ToFloat(s16.data(), n, outL.data());
+					g_sink = outL[0];
+				}, opt.minSeconds));
+				add("floatToS16", 0, measure([&]() {
+					k.floatToS16(l.data(), n, outS16.data());
+					g_sink = outS16[0];
+				}, opt.minSeconds));
+				add("downmixEnergy", 0, measure([&]() {
+					float sl = 0.0f, sr = 0.0f;
+					k.downmixEnergy(l.data(), r.data(), n, mono.data(), &sl, &sr);
+					g_sink = sl + sr;
+				}, opt.minSeconds));
+				add("sumSquares", 0, measure([&]() {
+					g_sink = k.sumSquares(l.data(), n);
+				}, opt.minSeconds));
+				add("peak", 0, measure([&]() {
+					g_sink = k.peak(l.data(), n);
+				}, opt.minSeconds));
+			}
+		}
+	}
+
+	// 格式解码：采样类型 × 声道数 × 数据包大小
+	void benchDecode(const BenchOptions& opt, std::vector<BenchResult>& results) {
+		std::vector<float> l, r;
+		makeSignal(l, r, 1024, kSampleRate, true, 3);
+		std::vector<float> outL(1024), outR(1024);
+		for (SampleType type : kTypes) {
+			for (uint32_t ch : kChannels) {
+				StreamFormat fmt = makeFormat(type, ch, kSampleRate);
+				DecodeStereoFn decode = selectStereoDecoder(fmt);
+				if (!decode) continue;
+				std::vector<uint8_t> pcm = encodeInterleaved(l, r, type, ch);
+				for (uint32_t n : kPacketSizes) {
+					BenchResult res;
+					res.suite = "decode";
+					res.name = "decodeStereo";
+					res.params.push_back(std::make_pair("format", std::string(sampleTypeName(type))));
+					res.params.push_back(std::make_pair("channels", toString(ch)));
+					res.params.push_back(std::make_pair("frames", toString(n)));
+					res.itemsPerOp = n;
+					res.unit = "frames";
+					res.nsPerOp = measure([&]() {
+						decode(pcm.data(), n, outL.data(), outR.data());
+						g_sink = outL[0];
+					}, opt.minSeconds);
+					results.push_back(res);
+				}
+			}
+		}
+	}
+
+	// 准备一个已加窗的分析帧
+	void makeAnalysisFrame(AnalysisFrame& frame, size_t frameSize, uint32_t seed) {
+		std::vector<float> l, r;
+		makeSignal(l, r, frameSize * 2, kSampleRate, true, seed);
+		StftFramer framer(frameSize, frameSize / 2);
+		bool done = false;
+		framer.push(l.data(), r.data(), l.size(), [&](const AnalysisFrame& f) {
+			if (!done) frame = f;
+			done = true;
+		});
+	}
+
+	// 单帧融合分析（下混、双声道频谱、频带能量与 RMS）
+	void benchAnalyze(const BenchOptions& opt, std::vector<BenchResult>& results) {
+		const size_t sizes[] = { 256, 512, 1024 };
+		for (size_t n : sizes) {
+			AnalysisFrame frame;
+			makeAnalysisFrame(frame, n, 4);
+			FrameAnalyzer analyzer;
+			AnalyzedFrame out;
+			reserveAnalyzedFrame(out, static_cast<uint32_t>(n));
+			BenchResult res;
+			res.suite = "analyze";
+			res.name = "FrameAnalyzer::analyze";
+			res.params.push_back(std::make_pair("frame", toString(static_cast<double>(n))));
+			res.unit = "frames";
+			res.nsPerOp = measure([&]() {
+				analyzer.analyze(frame, kSampleRate, out);
+				g_sink = out.highBandEnergy;
+			}, opt.minSeconds);
+			results.push_back(res);
+		}
+	}
+
+	// 方位估计（ILD 与 GCC-PHAT ITD+ILD），sources 为频点声像取峰的上限（0 为不统计）
+	void benchDirection(const BenchOptions& opt, std::vector<BenchResult>& results) {
+		const size_t sizes[] = { 256, 512, 1024 };
+		const DirectionMode modes[] = { DirectionMode::Ild, DirectionMode::ItdIld };
+		for (size_t n : sizes) {
+			AnalysisFrame frame;
+			makeAnalysisFrame(frame, n, 5);
+			FrameAnalyzer analyzer;
+			AnalyzedFrame analyzed;
+			analyzer.analyze(frame, kSampleRate, analyzed);
+			for (DirectionMode mode : modes) {
+				for (size_t sources : { 0, 3 }) {
+					DirectionEstimator direction;
+					direction.mode = mode;
+					direction.maxSources = sources;
+					direction.prepare(n);
+					BenchResult res;
+					res.suite = "direction";
+					res.name = "DirectionEstimator::estimate";
+					res.params.push_back(std::make_pair("mode", std::string(mode == DirectionMode::Ild ? "ild" : "itd_ild")));
+					res.params.push_back(std::make_pair("frame", toString(static_cast<double>(n))));
+					res.params.push_back(std::make_pair("sources", toString(static_cast<double>(sources))));
+					res.unit = "estimates";
+					res.nsPerOp = measure([&]() {
+						g_sink = direction.estimate(analyzed).angle;
+					}, opt.minSeconds);
+					results.push_back(res);
+				}
+			}
+		}
+	}
+
+	// 叠加层合成：1080p 与 1440p 屏幕对应的半径，之前到达过 events 个事件（残影按方位桶累积，开销与事件数无关）
+	void benchRender(const BenchOptions& opt, std::vector<BenchResult>& results) {
+		const float radii[] = { 270.0f, 360.0f };
+		const int eventCounts[] = { 0, 32, 1000 };
+		for (float radius : radii) {
+			for (int events : eventCounts) {
+				OverlayRenderer renderer;
+				renderer.configure(radius, std::max(2.0f, radius * 0.02f));
+				renderer.style.trailBaseDuration = 1e6f;  // 计时期间残影不衰减
+				renderer.style.trailMaxDuration = 1e6f;
+				uint64_t now = 0;
+				for (int i = 0; i < events; ++i) renderer.composeEvent(static_cast<float>(i * 5 % 160 - 80), now++);
+
+				BenchResult res;
+				res.suite = "render";
+				res.name = "OverlayRenderer::composeEvent";
+				res.params.push_back(std::make_pair("radius", toString(radius)));
+				res.params.push_back(std::make_pair("events", toString(events)));
+				res.unit = "frames";
+				res.nsPerOp = measure([&]() {
+					renderer.composeEvent(5.0f, now);  // 低于阈值，不改变残影
+					g_sink = static_cast<float>(renderer.pixel(0, 0));
+				}, opt.minSeconds);
+				results.push_back(res);
+			}
+		}
+	}
+
+	// 把一段交错 PCM 按固定大小的数据包反复送入检测流水线，触发帧再做方位估计
+	// gate 为 false 时关闭时域高通门限，与开启时对照级联省下的 FFT
+	void runPipeline(const StreamFormat& fmt, const std::vector<uint8_t>& pcm, uint32_t packet, bool gate,
+		const BenchOptions& opt, BenchResult& res) {
+		DetectorPipeline pipeline;
+		DirectionEstimator direction;
+		direction.mode = DirectionMode::ItdIld;
+		direction.prepare(256);
+		DetectorParams params;
+		params.highPassGate = gate;
+		pipeline.configure(fmt, 256, 128, params, packet);
+
+		const size_t packets = pcm.size() / fmt.blockAlign / packet;
+		uint64_t triggers = 0;
+		Clock::time_point t0 = Clock::now();
+		double elapsed = 0.0;
+		size_t processed = 0;
+		// 至少完整回放一遍预录音频，时间不足 minSeconds 时继续循环
+		do {
+			for (size_t i = 0; i < packets; ++i) {
+				const uint8_t* data = pcm.data() + i * packet * fmt.blockAlign;
+				if (const AnalyzedFrame* strongest = pipeline.processPacket(data, packet, false)) {
+					g_sink = direction.estimate(*strongest).angle;
+					++triggers;
+				}
+			}
+			processed += packets;
+			elapsed = std::chrono::duration<double>(Clock::now() - t0).count();
+		} while (elapsed < opt.minSeconds && packets > 0);
+
+		res.suite = "pipeline";
+		res.name = "DetectorPipeline";
+		res.params.push_back(std::make_pair("format", std::string(sampleTypeName(fmt.type))));
+		res.params.push_back(std::make_pair("channels", toString(fmt.channels)));
+		res.params.push_back(std::make_pair("sample_rate", toString(fmt.sampleRate)));
+		res.params.push_back(std::make_pair("frames", toString(packet)));
+		res.params.push_back(std::make_pair("gate", std::string(gate ? "on" : "off")));
+		res.unit = "packets";
+		res.nsPerOp = processed ? elapsed * 1e9 / static_cast<double>(processed) : 0.0;
+		double audioSeconds = static_cast<double>(processed) * packet / fmt.sampleRate;
+		res.extra.push_back(std::make_pair("realtime_factor", elapsed > 0.0 ? audioSeconds / elapsed : 0.0));
+		res.extra.push_back(std::make_pair("analysis_frames", static_cast<double>(pipeline.framesAnalyzed())));
+		res.extra.push_back(std::make_pair("skipped_frames", static_cast<double>(pipeline.framesSkipped())));
+		res.extra.push_back(std::make_pair("gated_frames", static_cast<double>(pipeline.framesGated())));
+		res.extra.push_back(std::make_pair("triggered_frames", static_cast<double>(pipeline.framesTriggered())));
+		res.extra.push_back(std::make_pair("triggered_packets", static_cast<double>(triggers)));
+	}
+
+	// 端到端：预录的交错 PCM 按数据包送入检测流水线（与捕获线程同一份代码）
+	// 指定 --input 时回放 WAV 文件（与捕获线程相同的格式解析），否则使用合成信号的多种格式
+	void benchPipeline(const BenchOptions& opt, std::vector<BenchResult>& results) {
+		if (!opt.input.empty()) {
+			StreamFormat fmt;
+			std::vector<uint8_t> pcm;
+			std::string error;
+			if (!readWavFile(opt.input, fmt, pcm, &error) || !selectStereoDecoder(fmt)) {
+				std::fprintf(stderr, "cannot load %s: %s\n", opt.input.c_str(), error.empty() ? "unsupported layout" : error.c_str());
+				std::exit(1);
+			}
+			for (uint32_t packet : kPacketSizes) {
+				for (bool gate : { true, false }) {
+					BenchResult res;
+					res.params.push_back(std::make_pair("input", opt.input));
+					runPipeline(fmt, pcm, packet, gate, opt, res);
+					results.push_back(res);
+				}
+			}
+			return;
+		}
+
+		struct Layout { SampleType type; uint32_t channels; };
+		const Layout layouts[] = {
+			{ SampleType::Float32, 2 }, { SampleType::Int16, 2 }, { SampleType::Int24, 2 },
+			{ SampleType::Float32, 8 },
+		};
+		const size_t totalFrames = static_cast<size_t>(opt.pipelineSeconds * kSampleRate);
+		std::vector<float> l, r;
+		makeSignal(l, r, totalFrames, kSampleRate, true, 6);
+
+		for (const Layout& layout : layouts) {
+			StreamFormat fmt = makeFormat(layout.type, layout.channels, kSampleRate);
+			std::vector<uint8_t> pcm = encodeInterleaved(l, r, layout.type, layout.channels);
+			for (uint32_t packet : kPacketSizes) {
+				for (bool gate : { true, false }) {
+					BenchResult res;
+					runPipeline(fmt, pcm, packet, gate, opt, res);
+					results.push_back(res);
+				}
+			}
+		}
+	}
+
+	// 无损压缩：整段 PCM 逐块编码 / 解码，吞吐按原始 PCM 字节计，ratio 为压缩后 / 原始大小
+	void runCodec(const StreamFormat& fmt, const std::vector<uint8_t>& pcm, const std::string& name,
+		const BenchOptions& opt, std::vector<BenchResult>& results) {
+		LosslessConfig config;
+		LosslessBlockCodec codec;
+		if (!codec.configure(fmt, config)) return;
+		const size_t blockBytes = static_cast<size_t>(config.blockFrames) * fmt.blockAlign;
+		std::vector<uint8_t> encoded;
+		std::vector<std::pair<size_t, uint32_t>> blocks;  // 每块的编码起点与帧数
+		auto encodeAll = [&]() {
+			encoded.clear();
+			blocks.clear();
+			for (size_t at = 0; at < pcm.size(); at += blockBytes) {
+				uint32_t frames = static_cast<uint32_t>(std::min(blockBytes, pcm.size() - at) / fmt.blockAlign);
+				blocks.push_back(std::make_pair(encoded.size(), frames));
+				codec.encode(pcm.data() + at, frames, encoded);
+			}
+		};
+		std::vector<uint8_t> decoded(pcm.size());
+		auto decodeAll = [&]() {
+			for (size_t i = 0; i < blocks.size(); ++i) {
+				size_t end = i + 1 < blocks.size() ? blocks[i + 1].first : encoded.size();
+				codec.decode(encoded.data() + blocks[i].first, end - blocks[i].first, blocks[i].second,
+					decoded.data() + i * blockBytes);
+			}
+		};
+
+		BenchResult enc;
+		enc.suite = "codec";
+		enc.name = "LosslessBlockCodec::encode";
+		enc.params.push_back(std::make_pair("signal", name));
+		enc.params.push_back(std::make_pair("format", std::string(sampleTypeName(fmt.type))));
+		enc.params.push_back(std::make_pair("channels", toString(fmt.channels)));
+		enc.unit = "bytes";
+		enc.itemsPerOp = static_cast<double>(pcm.size());
+		enc.nsPerOp = measure(encodeAll, opt.minSeconds);
+		double ratio = pcm.empty() ? 0.0 : static_cast<double>(encoded.size()) / pcm.size();
+		enc.extra.push_back(std::make_pair("ratio", ratio));
+		enc.extra.push_back(std::make_pair("realtime_factor",
+			static_cast<double>(pcm.size()) / fmt.blockAlign / fmt.sampleRate / (enc.nsPerOp * 1e-9)));
+		results.push_back(enc);
+
+		BenchResult dec = enc;
+		dec.name = "LosslessBlockCodec::decode";
+		dec.extra.clear();
+		dec.nsPerOp = measure(decodeAll, opt.minSeconds);
+		dec.extra.push_back(std::make_pair("ratio", ratio));
+		dec.extra.push_back(std::make_pair("lossless", decoded == pcm ? 1.0 : 0.0));
+		results.push_back(dec);
+	}
+
+	// --input 时压缩 WAV 文件，否则压缩合成信号：任意浮点、16 位精度的浮点（混音器输出的常见情况）与整数格式
+	void benchCodec(const BenchOptions& opt, std::vector<BenchResult>& results) {
+		if (!opt.input.empty()) {
+			StreamFormat fmt;
+			std::vector<uint8_t> pcm;
+			std::string error;
+			if (!readWavFile(opt.input, fmt, pcm, &error)) {
+				std::fprintf(stderr, "cannot load %s: %s\n", opt.input.c_str(), error.c_str());
+				std::exit(1);
+			}
+			runCodec(fmt, pcm, opt.input, opt, results);
+			return;
+		}
+
+		std::vector<float> l, r;
+		makeSignal(l, r, kSampleRate * 5, kSampleRate, true, 7);
+		runCodec(makeFormat(SampleType::Float32, 2, kSampleRate), encodeInterleaved(l, r, SampleType::Float32, 2),
+			"synthetic", opt, results);
+		for (size_t i = 0; i < l.size(); ++i) {
+			l[i] = std::round(l[i] * 32768.0f) / 32768.0f;
+			r[i] = std::round(r[i] * 32768.0f) / 32768.0f;
+		}
+		runCodec(makeFormat(SampleType::Float32, 2, kSampleRate), encodeInterleaved(l, r, SampleType::Float32, 2),
+			"synthetic_16bit_float", opt, results);
+		runCodec(makeFormat(SampleType::Int16, 2, kSampleRate), encodeInterleaved(l, r, SampleType::Int16, 2),
+			"synthetic", opt, results);
+		runCodec(makeFormat(SampleType::Int24, 2, kSampleRate), encodeInterleaved(l, r, SampleType::Int24, 2),
+			"synthetic", opt, results);
+	}
+
+	// 批量分析的线程扩展：同一批文件（--seconds 秒的合成录音 × 8，或 --input 指定的 WAV × 8）
+	// 分别用 1、2、4 ... 个线程分析，per_sec 为每秒处理的音频秒数，speedup / efficiency 相对单线程
+	void benchBatch(const BenchOptions& opt, std::vector<BenchResult>& results) {
+		const int kFiles = 8;
+		std::vector<std::string> paths;
+		if (!opt.input.empty()) {
+			paths.assign(kFiles, opt.input);
+		}
+		else {
+			std::vector<float> l, r;
+			makeSignal(l, r, static_cast<size_t>(kSampleRate * opt.pipelineSeconds), kSampleRate, true, 9);
+			std::vector<uint8_t> pcm = encodeInterleaved(l, r, SampleType::Float32, 2);
+			uint8_t fmt[16];
+			uint32_t fields[] = { 3u | (2u << 16), kSampleRate, kSampleRate * 8, 8u | (32u << 16) };
+			for (int i = 0; i < 4; ++i) {
+				for (int b = 0; b < 4; ++b) fmt[i * 4 + b] = static_cast<uint8_t>(fields[i] >> (8 * b));
+			}
+			std::vector<uint8_t> header;
+			buildWavHeader(fmt, sizeof(fmt), pcm.size(), header);
+			for (int i = 0; i < kFiles; ++i) {
+				paths.push_back("DetectorBench_batch_" + toString(i) + ".wav");
+				std::ofstream ofs(paths.back(), std::ios::binary);
+				ofs.write(reinterpret_cast<const char*>(header.data()), header.size());
+				ofs.write(reinterpret_cast<const char*>(pcm.data()), pcm.size());
+			}
+		}
+
+		const unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+		double single = 0.0;
+		for (unsigned threads = 1; ; threads = std::min(threads * 2, hardware)) {
+			BatchConfig config;
+			config.threads = threads;
+			BatchStats stats;
+			analyzeFiles(paths, config, nullptr, &stats);  // 预热：页缓存与 FFT 计划
+			double seconds = 0.0, audio = 0.0;
+			while (seconds < opt.minSeconds) {
+				analyzeFiles(paths, config, nullptr, &stats);
+				seconds += stats.seconds;
+				audio += stats.audioSeconds;
+			}
+			BenchResult res;
+			res.suite = "batch";
+			res.name = "analyzeFiles";
+			res.params.push_back(std::make_pair("threads", toString(threads)));
+			res.params.push_back(std::make_pair("files", toString(kFiles)));
+			res.unit = "audio_seconds";
+			res.itemsPerOp = audio;
+			res.nsPerOp = seconds * 1e9;
+			double rate = seconds > 0 ? audio / seconds : 0.0;
+			if (threads == 1) single = rate;
+			res.extra.push_back(std::make_pair("speedup", single > 0 ? rate / single : 0.0));
+			res.extra.push_back(std::make_pair("efficiency", single > 0 ? rate / single / threads : 0.0));
+			results.push_back(res);
+			if (threads >= hardware) break;
+		}
+		if (opt.input.empty()) {
+			for (const std::string& p : paths) std::remove(p.c_str());
+		}
+	}
+
+	// 准确率：合成场景（已知方位与起始位置的脉冲）按数据包送入与实时程序相同的检测流水线与方位估计，
+	// 按 SceneScore 评分；场景时长取 --seconds，每秒 2 个事件。nsPerOp 为每个数据包的耗时
+	void benchAccuracy(const BenchOptions& opt, std::vector<BenchResult>& results) {
+		struct Scene { const char* name; float noiseDb; float musicDb; float overlap; };
+		const Scene scenes[] = {
+			{ "clean", -120.0f, -120.0f, 0.0f },
+			{ "noise", -45.0f, -120.0f, 0.0f },
+			{ "music", -60.0f, -20.0f, 0.0f },
+			{ "overlap", -60.0f, -120.0f, 1.0f },
+			{ "mixed", -50.0f, -24.0f, 0.3f },
+		};
+		const SampleType types[] = { SampleType::Float32, SampleType::Int16 };
+		const DirectionMode modes[] = { DirectionMode::Ild, DirectionMode::ItdIld };
+
+		for (const Scene& s : scenes) {
+			SceneConfig config;
+			config.sampleRate = kSampleRate;
+			config.seconds = opt.pipelineSeconds;
+			config.events = static_cast<uint32_t>(std::max(1.0, 2.0 * opt.pipelineSeconds));
+			config.noiseDb = s.noiseDb;
+			config.musicDb = s.musicDb;
+			config.overlapProbability = s.overlap;
+			SyntheticScene scene;
+			renderScene(config, scene);
+			for (SampleType type : types) {
+				std::vector<uint8_t> pcm;
+				StreamFormat fmt = encodeScene(scene, type, pcm);
+				for (DirectionMode mode : modes) {
+					SceneRunConfig run;
+					run.mode = mode;
+					std::vector<SceneDetection> detections;
+					// 每遍结果相同，时间不足 minSeconds 时重复
+					Clock::time_point t0 = Clock::now();
+					double elapsed = 0.0;
+					size_t passes = 0;
+					do {
+						runScene(fmt, pcm, run, detections);
+						++passes;
+						elapsed = std::chrono::duration<double>(Clock::now() - t0).count();
+					} while (elapsed < opt.minSeconds);
+					const SceneScore score = scoreScene(scene.events, detections, run.frameSize);
+
+					BenchResult res;
+					res.suite = "accuracy";
+					res.name = "SyntheticScene";
+					res.params.push_back(std::make_pair("scene", std::string(s.name)));
+					res.params.push_back(std::make_pair("format", std::string(sampleTypeName(type))));
+					res.params.push_back(std::make_pair("mode", std::string(mode == DirectionMode::Ild ? "ild" : "itd_ild")));
+					res.unit = "packets";
+					const double packets = static_cast<double>(passes) * ((scene.left.size() + run.packetFrames - 1) / run.packetFrames);
+					res.nsPerOp = packets > 0.0 ? elapsed * 1e9 / packets : 0.0;
+					res.extra.push_back(std::make_pair("events", static_cast<double>(score.events)));
+					res.extra.push_back(std::make_pair("detections", static_cast<double>(score.detections)));
+					res.extra.push_back(std::make_pair("recall", score.recall));
+					res.extra.push_back(std::make_pair("precision", score.precision));
+					res.extra.push_back(std::make_pair("false_alarms", static_cast<double>(score.falseAlarms)));
+					res.extra.push_back(std::make_pair("duplicates", static_cast<double>(score.duplicates)));
+					res.extra.push_back(std::make_pair("angle_error_mean", score.angleErrorMean));
+					res.extra.push_back(std::make_pair("angle_error_p90", score.angleErrorP90));
+					res.extra.push_back(std::make_pair("angle_error_max", score.angleErrorMax));
+					res.extra.push_back(std::make_pair("latency_mean_samples", score.latencyMean));
+					res.extra.push_back(std::make_pair("latency_max_samples", score.latencyMax));
+					results.push_back(res);
+				}
+			}
+		}
+	}
+
+	bool parseArgs(int argc, char** argv, BenchOptions& opt) {
+		for (int i = 1; i < argc; ++i) {
+			std::string arg = argv[i];
+			bool hasValue = (i + 1 < argc);
+			if (arg == "--out" && hasValue) opt.out = argv[++i];
+			else if (arg == "--min-time" && hasValue) opt.minSeconds = std::atof(argv[++i]) / 1000.0;
+			else if (arg == "--suite" && hasValue) opt.suite = argv[++i];
+			else if (arg == "--seconds" && hasValue) opt.pipelineSeconds = std::atof(argv[++i]);
+			else if (arg == "--input" && hasValue) opt.input = argv[++i];
+			else return false;
+		}
+		return opt.minSeconds > 0.0 && opt.pipelineSeconds > 0.0;
+	}
+}
+
+int main(int argc, char** argv) {
+	BenchOptions opt;
+	if (!parseArgs(argc, argv, opt)) {
+		std::fprintf(stderr, "usage: DetectorBench [--out file.json] [--min-time ms] [--suite name] [--seconds s] [--input file.wav]\n");
+		return 2;
+	}
+
+	struct Suite { const char* name; void (*run)(const BenchOptions&, std::vector<BenchResult>&); };
+	const Suite suites[] = {
+		{ "fft", benchFft }, { "kernels", benchKernels }, { "decode", benchDecode },
+		{ "analyze", benchAnalyze }, { "direction", benchDirection }, { "pipeline", benchPipeline },
+		{ "render", benchRender }, { "codec", benchCodec },
+		{ "batch", benchBatch }, { "accuracy", benchAccuracy },
+	};
+
+	std::vector<BenchResult> results;
+	bool matched = false;
+	for (const Suite& s : suites) {
+		if (!opt.suite.empty() && opt.suite != s.name) continue;
+		matched = true;
+		std::fprintf(stderr, "[DetectorBench] %s\n", s.name);
+		s.run(opt, results);
+	}
+	if (!matched) {
+		std::fprintf(stderr, "unknown suite: %s\n", opt.suite.c_str());
+		return 2;
+	}
+
+	if (opt.out.empty()) {
+		writeJson(std::cout, results, opt);
+	}
+	else {
+		std::ofstream ofs(opt.out);
+		if (!ofs.is_open()) {
+			std::fprintf(stderr, "cannot open %s\n", opt.out.c_str());
+			return 1;
+		}
+		writeJson(ofs, results, opt);
+	}
+	return 0;
+}
@@ -0,0 +1,117 @@
+﻿// 运行指标读取工具：只读映射 AudioCompass 发布的统计文件并定期打印，不影响捕获进程
+// 计数每次打印增量速率，耗时指标换算为占用率（每秒忙碌的毫秒数）；另按 frames_* 计数给出检测级联各级的通过率
+//
+// 用法：MetricsReader <stats file> [--interval ms] [--count n] [--once]
+#include "MappedFile.h"
+#include "PipelineMetrics.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+	struct ReaderOptions {
+		std::string path;
+		int intervalMs = 1000;
+		int count = 0;  // 0 表示一直轮询
+	};
+
+	bool parseArgs(int argc, char** argv, ReaderOptions& opt) {
+		for (int i = 1; i < argc; ++i) {
+			std::string arg = argv[i];
+			if (arg == "--interval" && i + 1 < argc) opt.intervalMs = std::atoi(argv[++i]);
+			else if (arg == "--count" && i + 1 < argc) opt.count = std::atoi(argv[++i]);
+			else if (arg == "--once") opt.count = 1;
+			else if (!arg.empty() && arg[0] != '-' && opt.path.empty()) opt.path = arg;
+			else return false;
+		}
+		return !opt.path.empty() && opt.intervalMs > 0 && opt.count >= 0;
+	}
+
+	void snapshot(const MetricsPage& page, std::vector<uint64_t>& values) {
+		values.resize(page.metricCount);
+		for (uint32_t i = 0; i < page.metricCount; ++i) values[i] = page.cells[i].value.load(std::memory_order_relaxed);
+	}
+
+	// 按名称查找指标（统计页可能来自另一版本的程序），不存在时返回 -1
+	int findMetric(const MetricsPage& page, const char* name) {
+		for (uint32_t i = 0; i < page.metricCount; ++i) {
+			if (std::strncmp(page.names[i], name, MetricsPage::kNameLength) == 0) return static_cast<int>(i);
+		}
+		return -1;
+	}
+
+	// 检测级联：静音跳过 → 时域高通门限 → 频谱判定，通过率按本次打印间隔的增量计算（首次为累计值）
+	void printCascade(const MetricsPage& page, const std::vector<uint64_t>& now, const std::vector<uint64_t>& prev) {
+		const int ids[4] = { findMetric(page, "frames_silent"), findMetric(page, "frames_gated"),
+			findMetric(page, "frames_analyzed"), findMetric(page, "frames_triggered") };
+		double v[4];
+		for (int k = 0; k < 4; ++k) {
+			if (ids[k] < 0) return;
+			uint64_t base = prev.empty() || now[ids[k]] < prev[ids[k]] ? 0 : prev[ids[k]];
+			v[k] = static_cast<double>(now[ids[k]] - base);
+		}
+		const double total = v[0] + v[1] + v[2];
+		if (total <= 0) return;
+		std::printf("  cascade: %.1f%% of frames audible, gate passed %.1f%% of audible, spectral test passed %.1f%% of analyzed\n",
+			100.0 * (v[1] + v[2]) / total, v[1] + v[2] > 0 ? 100.0 * v[2] / (v[1] + v[2]) : 0.0,
+			v[2] > 0 ? 100.0 * v[3] / v[2] : 0.0);
+	}
+
+	void print(const MetricsPage& page, const std::vector<uint64_t>& now, const std::vector<uint64_t>& prev, double seconds) {
+		std::printf("pid %u\n", page.processId);
+		std::printf("  %-24s %16s %14s\n", "metric", "value", "rate");
+		for (uint32_t i = 0; i < page.metricCount; ++i) {
+			char name[MetricsPage::kNameLength + 1] = {};
+			std::memcpy(name, page.names[i], MetricsPage::kNameLength);
+			uint64_t delta = prev.empty() || now[i] < prev[i] ? 0 : now[i] - prev[i];
+			switch (static_cast<MetricKind>(page.kinds[i])) {
+			case MetricKind::Gauge:
+				std::printf("  %-24s %16llu\n", name, static_cast<unsigned long long>(now[i]));
+				break;
+			case MetricKind::TimeNs:
+				std::printf("  %-24s %13.3f ms %11.3f ms/s\n", name, now[i] / 1e6, seconds > 0 ? delta / 1e6 / seconds : 0.0);
+				break;
+			default:
+				std::printf("  %-24s %16llu %12.1f/s\n", name, static_cast<unsigned long long>(now[i]), seconds > 0 ? delta / seconds : 0.0);
+				break;
+			}
+		}
+		printCascade(page, now, prev);
+		std::fflush(stdout);
+	}
+}
+
+int main(int argc, char** argv) {
+	ReaderOptions opt;
+	if (!parseArgs(argc, argv, opt)) {
+		std::fprintf(stderr, "usage: MetricsReader <stats file> [--interval ms] [--count n] [--once]\n");
+		return 2;
+	}
+
+	MappedFile file;
+	if (!file.openReadOnly(opt.path)) {
+		std::fprintf(stderr, "cannot map %s\n", opt.path.c_str());
+		return 1;
+	}
+	const MetricsPage* page = metricsPageFromMapping(file.data(), file.size());
+	if (!page) {
+		std::fprintf(stderr, "%s is not an AudioCompass stats file (or has another version)\n", opt.path.c_str());
+		return 1;
+	}
+
+	std::vector<uint64_t> prev, now;
+	auto last = std::chrono::steady_clock::now();
+	for (int n = 0; opt.count == 0 || n < opt.count; ++n) {
+		if (n > 0) std::this_thread::sleep_for(std::chrono::milliseconds(opt.intervalMs));
+		auto t = std::chrono::steady_clock::now();
+		snapshot(*page, now);
+		print(*page, now, prev, n > 0 ? std::chrono::duration<double>(t - last).count() : 0.0);
+		prev.swap(now);
+		last = t;
+	}
+	return 0;
+}
@@ -0,0 +1,204 @@
+﻿// AnalysisScheduler：过期帧丢弃、积压帧合并、最新帧优先；负载注入下事件延迟有界，而按 FIFO 取队列时延迟随积压增长
+// 负载注入用可注入的假时钟模拟到达与处理耗时，延迟与主机负载无关
+#include "AnalysisScheduler.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+namespace {
+	void push(SpscRing<AnalyzedFrame>& ring, uint64_t offset, uint64_t captureNs, float energy = 1.0f) {
+		AnalyzedFrame* slot = ring.acquire();
+		CHECK(slot != nullptr);
+		if (!slot) return;
+		slot->offset = offset;
+		slot->captureNs = captureNs;
+		slot->highBandEnergy = energy;
+		ring.publish();
+	}
+
+	void testPeek() {
+		SpscRing<AnalyzedFrame> ring(4);
+		CHECK(ring.peek(0) == nullptr);
+		push(ring, 1, 10);
+		push(ring, 2, 20);
+		CHECK(ring.peek(0) == ring.front());
+		CHECK(ring.peek(1) && ring.peek(1)->offset == 2);
+		CHECK(ring.peek(2) == nullptr);
+		ring.pop();
+		CHECK(ring.peek(0) && ring.peek(0)->offset == 2);
+		CHECK(ring.peek(1) == nullptr);
+	}
+
+	// 假时钟：process 每帧推进固定耗时
+	void testDeadlineRules() {
+		SpscRing<AnalyzedFrame> ring(8);
+		AnalysisScheduler scheduler;
+		scheduler.deadline.maxAgeNs = 100;
+		scheduler.deadline.mergeWindowNs = 5;
+		uint64_t t = 1000;
+		std::vector<uint64_t> done;
+		auto now = [&]() { return t; };
+		auto process = [&](const AnalyzedFrame& frame, uint64_t) {
+			done.push_back(frame.offset);
+			t += 60;
+		};
+
+		// 跟得上：逐帧处理；最后一帧是最新的，预计超时也照常处理，完成时超时计入 late
+		push(ring, 1, 1000);
+		push(ring, 2, 1050);
+		push(ring, 3, 1060);
+		CHECK(scheduler.drain(ring, now, process) == 3);
+		CHECK(done.size() == 3 && done[2] == 3);
+		CHECK(scheduler.serviceEstimateNs() == 60);
+		CHECK(scheduler.lateEvents() == 1);
+		CHECK(scheduler.maxLatencyNs() == 120);
+		CHECK(scheduler.staleDrops() == 0);
+
+		// 后面还有更新的帧且预计赶不上：丢弃，时间让给新帧
+		done.clear();
+		t = 2050;
+		push(ring, 4, 2000);
+		push(ring, 5, 2030);
+		CHECK(scheduler.drain(ring, now, process) == 1);
+		CHECK(done.size() == 1 && done[0] == 5);
+		CHECK(scheduler.staleDrops() == 1);
+
+		// 已过期的帧即使是最新的也丢弃
+		done.clear();
+		t = 3200;
+		push(ring, 6, 3000);
+		CHECK(scheduler.drain(ring, now, process) == 0);
+		CHECK(done.empty());
+		CHECK(scheduler.staleDrops() == 2);
+
+		// 积压的相邻帧合并，保留高频能量更强的一帧（含其流位置与时间戳）
+		done.clear();
+		t = 4000;
+		push(ring, 7, 4000, 3.0f);
+		push(ring, 8, 4004, 1.0f);
+		push(ring, 9, 4005, 2.0f);
+		push(ring, 10, 4040, 1.0f);
+		CHECK(scheduler.drain(ring, now, process) == 2);
+		CHECK(done.size() == 2 && done[0] == 7 && done[1] == 10);
+		CHECK(scheduler.mergedFrames() == 2);
+		CHECK(ring.empty());
+
+		// 没有时间戳的帧不过期也不合并
+		done.clear();
+		t = 1000000;
+		push(ring, 11, 0);
+		push(ring, 12, 0);
+		CHECK(scheduler.drain(ring, now, process) == 2);
+		CHECK(done.size() == 2);
+	}
+
+	struct LoadResult {
+		uint64_t maxLatencyNs = 0;
+		uint64_t maxLatencyAfterNs = 0;  // 负载结束之后采集的帧的最大延迟
+		size_t processed = 0;
+		uint64_t overflow = 0;
+	};
+
+	// 每 5 ms 到达一帧，共 2 秒；平时每帧处理 1 ms，0.4 ~ 1.6 秒之间每帧 15 ms（3 倍过载）
+	// 用注入的假时钟模拟：process 把时钟推进一帧的处理耗时，期间到达的帧随即入队，结果与主机负载无关
+	LoadResult runLoad(bool scheduled, const AnalysisDeadline& deadline, AnalysisScheduler* stats) {
+		const uint64_t kIntervalNs = 5000000;
+		const uint64_t kFrames = 400;
+		const uint64_t kSpikeBegin = 400000000, kSpikeEnd = 1600000000;
+		const uint64_t t0 = 1000000000;   // 时间戳为 0 表示没有时间戳，时钟从非零值开始
+		SpscRing<AnalyzedFrame> ring(64);
+		uint64_t t = t0;
+		uint64_t next = 0;   // 下一个到达的帧号
+
+		auto arrive = [&]() {
+			for (; next < kFrames && t0 + next * kIntervalNs <= t; ++next) {
+				if (AnalyzedFrame* slot = ring.acquire()) {
+					slot->offset = next;
+					slot->captureNs = t0 + next * kIntervalNs;
+					slot->highBandEnergy = static_cast<float>((next * 7) % 11);
+					ring.publish();
+				}
+			}
+		};
+
+		LoadResult result;
+		AnalysisScheduler scheduler;
+		scheduler.deadline = deadline;
+		auto now = [&]() { return t; };
+		auto process = [&](const AnalyzedFrame& frame, uint64_t) {
+			const uint64_t elapsed = t - t0;
+			t += elapsed >= kSpikeBegin && elapsed < kSpikeEnd ? 15000000 : 1000000;
+			const uint64_t latency = t - frame.captureNs;
+			result.maxLatencyNs = std::max(result.maxLatencyNs, latency);
+			if (frame.captureNs - t0 >= kSpikeEnd) result.maxLatencyAfterNs = std::max(result.maxLatencyAfterNs, latency);
+			++result.processed;
+			arrive();
+		};
+
+		while (next < kFrames || !ring.empty()) {
+			arrive();
+			if (ring.empty()) {
+				t = t0 + next * kIntervalNs;   // 空闲到下一帧到达
+				continue;
+			}
+			if (scheduled) {
+				scheduler.drain(ring, now, process);
+			}
+			else {
+				process(*ring.front(), 0);
+				ring.pop();
+			}
+		}
+		result.overflow = ring.overflowCount();
+		if (stats) *stats = scheduler;
+		return result;
+	}
+
+	void report(const char* name, const LoadResult& r, const AnalysisScheduler* stats) {
+		std::printf("%s: max latency %.1f ms (%.1f ms after the spike), %zu processed", name, r.maxLatencyNs / 1e6,
+			r.maxLatencyAfterNs / 1e6, r.processed);
+		if (stats) {
+			std::printf(", %llu stale, %llu merged, %llu late", static_cast<unsigned long long>(stats->staleDrops()),
+				static_cast<unsigned long long>(stats->mergedFrames()), static_cast<unsigned long long>(stats->lateEvents()));
+		}
+		std::printf(", %llu overflow\n", static_cast<unsigned long long>(r.overflow));
+	}
+
+	void testLoadInjection() {
+		const uint64_t kSpikeServiceNs = 15000000;
+		AnalysisDeadline deadline;
+		deadline.maxAgeNs = 60000000;
+		AnalysisDeadline noMerge = deadline;
+		noMerge.mergeWindowNs = 0;   // 只靠截止时间丢弃
+		AnalysisScheduler mergeStats, dropStats;
+		LoadResult merged = runLoad(true, deadline, &mergeStats);
+		LoadResult dropped = runLoad(true, noMerge, &dropStats);
+		LoadResult fifo = runLoad(false, deadline, nullptr);
+		report("deadline 60 ms, merge 20 ms", merged, &mergeStats);
+		report("deadline 60 ms, no merge", dropped, &dropStats);
+		report("fifo", fifo, nullptr);
+
+		for (const LoadResult* r : { &merged, &dropped }) {
+			// 延迟不超过截止时间加一帧过载时的处理耗时
+			CHECK(r->maxLatencyNs <= deadline.maxAgeNs + kSpikeServiceNs);
+			CHECK(r->overflow == 0);
+			CHECK(r->processed > 50);
+			// 负载结束后至多再等一帧过载时的处理就恢复到正常延迟；FIFO 则要先消化积压
+			CHECK(r->maxLatencyAfterNs <= kSpikeServiceNs);
+			CHECK(fifo.maxLatencyNs > 3 * r->maxLatencyNs);
+		}
+		CHECK(mergeStats.mergedFrames() > 0);
+		CHECK(dropStats.staleDrops() > 0);
+		CHECK(dropStats.mergedFrames() == 0);
+		CHECK(fifo.maxLatencyAfterNs > merged.maxLatencyAfterNs);
+		CHECK(fifo.overflow > 0);
+	}
+}
+
+int main() {
+	testPeek();
+	testDeadlineRules();
+	testLoadInjection();
+	return testResult("AnalysisSchedulerTest");
+}
@@ -0,0 +1,336 @@
+﻿// BatchAnalyzer：工作窃取线程池、多组阈值（含自适应噪声底）判定与 FrameAnalyzer 逐位一致、切块并行的事件时间线与逐包实时检测相同
+#include "BatchAnalyzer.h"
+#include "WavRecorder.h"
+#include "WorkStealingPool.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#if !defined(_WIN32)
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+	const uint32_t kRate = 48000;
+	const uint32_t kFrameSize = 256;
+	const uint32_t kHopSize = 128;
+	const uint32_t kPacket = 480;
+
+	// 交错 float32 立体声：噪声背景上随机位置、随机声像、随机强度的高频猝发
+	std::vector<float> makeSignal(uint32_t frames, uint32_t seed) {
+		const float kPi = 3.14159265f;
+		std::mt19937 rng(seed);
+		std::uniform_real_distribution<float> uni(0.0f, 1.0f);
+		std::vector<float> pcm(frames * 2);
+		for (uint32_t i = 0; i < frames; ++i) {
+			float bg = 0.1f * std::sin(2.0f * kPi * 200.0f * i / kRate) + 0.0005f * (uni(rng) - 0.5f);
+			pcm[2 * i] = bg;
+			pcm[2 * i + 1] = bg;
+		}
+		for (uint32_t start = 1000; start + 3000 < frames; start += 2000 + static_cast<uint32_t>(uni(rng) * 6000)) {
+			float pan = uni(rng), gain = 0.02f + 0.3f * uni(rng), freq = 9000.0f + 8000.0f * uni(rng);
+			uint32_t length = 200 + static_cast<uint32_t>(uni(rng) * 2500);
+			for (uint32_t i = 0; i < length; ++i) {
+				float v = gain * std::sin(2.0f * kPi * freq * i / kRate) * std::exp(-3.0f * i / length);
+				pcm[2 * (start + i)] += (1.0f - pan) * v;
+				pcm[2 * (start + i) + 1] += pan * v;
+			}
+		}
+		return pcm;
+	}
+
+	StreamFormat stereoF32() {
+		StreamFormat fmt;
+		fmt.type = SampleType::Float32;
+		fmt.channels = 2;
+		fmt.sampleRate = kRate;
+		fmt.blockAlign = 8;
+		return fmt;
+	}
+
+	void writeWav(const std::string& path, const std::vector<float>& pcm) {
+		uint8_t fmt[16];
+		uint32_t fields[] = { 3u | (2u << 16), kRate, kRate * 8, 8u | (32u << 16) };
+		for (int i = 0; i < 4; ++i) {
+			for (int b = 0; b < 4; ++b) fmt[i * 4 + b] = static_cast<uint8_t>(fields[i] >> (8 * b));
+		}
+		std::vector<uint8_t> header;
+		buildWavHeader(fmt, sizeof(fmt), pcm.size() * 4, header);
+		std::ofstream ofs(path, std::ios::binary);
+		ofs.write(reinterpret_cast<const char*>(header.data()), header.size());
+		ofs.write(reinterpret_cast<const char*>(pcm.data()), pcm.size() * 4);
+	}
+
+	std::vector<DetectorParams> sweepSets() {
+		std::vector<DetectorParams> sets;
+		const float mins[] = { 8000.0f, 10000.0f, 12000.0f };
+		const float epsilons[] = { 0.001f / 480.0f, 0.004f / 480.0f };
+		const float ratios[] = { 0.05f, 0.1f, 0.3f };
+		for (float m : mins) {
+			for (float e : epsilons) {
+				for (float r : ratios) {
+					DetectorParams p;
+					p.highFreqMin = m;
+					p.highFreqEpsilon = e;
+					p.highFreqRatio = r;
+					sets.push_back(p);
+				}
+			}
+		}
+		return sets;
+	}
+
+	// 自适应噪声底的参数组：前两组共用同一噪声底，第三组单独跟踪
+	std::vector<DetectorParams> adaptiveSets() {
+		std::vector<DetectorParams> sets(3);
+		for (DetectorParams& p : sets) p.adaptiveFloor = true;
+		sets[1].highFreqRatio = 0.05f;
+		sets[2].highFreqMin = 8000.0f;
+		sets[2].floorMarginDb = 6.0f;
+		return sets;
+	}
+
+	// 参照：与捕获线程 / 分析线程相同的逐包检测，得到某组参数的事件
+	std::vector<BatchEvent> liveEvents(const std::vector<float>& pcm, const DetectorParams& params, uint32_t set) {
+		DetectorPipeline pipeline;
+		pipeline.configure(stereoF32(), kFrameSize, kHopSize, params, kPacket);
+		DirectionEstimator direction;
+		direction.prepare(kFrameSize);
+		std::vector<BatchEvent> events;
+		const uint32_t frames = static_cast<uint32_t>(pcm.size() / 2);
+		for (uint32_t pos = 0; pos < frames; pos += kPacket) {
+			uint32_t n = std::min(kPacket, frames - pos);
+			const AnalyzedFrame* hit = pipeline.processPacket(reinterpret_cast<const uint8_t*>(&pcm[2 * pos]), n, false);
+			if (!hit) continue;
+			BatchEvent e;
+			e.paramSet = set;
+			e.frame = hit->offset;
+			DirectionResult dir = direction.estimate(*hit);
+			e.angle = dir.angle;
+			e.confidence = dir.confidence;
+			e.highFreqRatio = hit->highFreqRatio;
+			e.highBandEnergy = hit->highBandEnergy;
+			e.lowBandEnergy = hit->lowBandEnergy;
+			events.push_back(e);
+		}
+		return events;
+	}
+
+	bool sameEvent(const BatchEvent& a, const BatchEvent& b) {
+		return a.paramSet == b.paramSet && a.frame == b.frame && a.angle == b.angle && a.confidence == b.confidence &&
+			a.highFreqRatio == b.highFreqRatio && a.highBandEnergy == b.highBandEnergy && a.lowBandEnergy == b.lowBandEnergy;
+	}
+
+	// 批量分析应得的时间线：按数据包顺序，同一数据包内按参数组顺序
+	std::vector<BatchEvent> expectedEvents(const std::vector<float>& pcm, const std::vector<DetectorParams>& sets) {
+		std::vector<std::vector<BatchEvent>> perSet;
+		for (size_t s = 0; s < sets.size(); ++s) perSet.push_back(liveEvents(pcm, sets[s], static_cast<uint32_t>(s)));
+		std::vector<BatchEvent> expected;
+		std::vector<size_t> next(perSet.size(), 0);
+		for (uint64_t packet = 0; packet * kPacket < pcm.size() / 2; ++packet) {
+			for (size_t s = 0; s < perSet.size(); ++s) {
+				while (next[s] < perSet[s].size() && (perSet[s][next[s]].frame + kFrameSize - 1) / kPacket == packet)
+					expected.push_back(perSet[s][next[s]++]);
+			}
+		}
+		return expected;
+	}
+
+	// 递归拆分的任务：工作线程内提交的子任务都会执行，wait() 等到整棵任务树完成
+	void testPool() {
+		WorkStealingPool pool(4);
+		CHECK(pool.threadCount() == 4);
+		std::atomic<uint64_t> sum{ 0 };
+		std::function<void(uint64_t, uint64_t)> split = [&](uint64_t begin, uint64_t end) {
+			if (end - begin <= 64) {
+				uint64_t s = 0;
+				for (uint64_t i = begin; i < end; ++i) s += i;
+				sum += s;
+				return;
+			}
+			uint64_t mid = (begin + end) / 2;
+			pool.submit([&split, begin, mid]() { split(begin, mid); });
+			pool.submit([&split, mid, end]() { split(mid, end); });
+		};
+		for (int round = 0; round < 3; ++round) {
+			sum = 0;
+			uint64_t before = pool.executed();
+			pool.submit([&]() { split(0, 100000); });
+			pool.wait();
+			CHECK(sum == 100000ull * 99999ull / 2);
+			CHECK(pool.executed() - before > 1000);
+		}
+		pool.wait();  // 没有任务时立即返回
+	}
+
+	// 每组参数的判定、频带能量与占比都与用该参数运行 FrameAnalyzer 逐位相同
+	void testSweepMatchesAnalyzer() {
+		std::vector<float> pcm = makeSignal(kRate * 2, 3);
+		std::vector<DetectorParams> sets = sweepSets();
+		std::vector<DetectorParams> adaptive = adaptiveSets();
+		sets.insert(sets.end(), adaptive.begin(), adaptive.end());
+		DetectorPipeline pipeline;
+		CHECK(pipeline.configure(stereoF32(), kFrameSize, kHopSize, DetectorParams(), kRate * 2));
+		double windowSum = 0.0;
+		for (float w : pipeline.window()) windowSum += w;
+		DetectorSweep sweep;
+		sweep.configure(sets, kFrameSize, kRate, static_cast<float>(windowSum));
+		CHECK(sweep.size() == sets.size());
+
+		std::vector<FrameAnalyzer> analyzers(sets.size());
+		for (size_t s = 0; s < sets.size(); ++s) analyzers[s].params = sets[s];
+		StftFramer framer(kFrameSize, kHopSize);
+		std::vector<float> left(kRate * 2), right(kRate * 2);
+		for (size_t i = 0; i < left.size(); ++i) {
+			left[i] = pcm[2 * i];
+			right[i] = pcm[2 * i + 1];
+		}
+		uint64_t mismatches = 0, triggers = 0;
+		AnalyzedFrame reference;
+		AnalysisFrame positioned;
+		pipeline.analyzePacket(reinterpret_cast<const uint8_t*>(pcm.data()), kRate * 2, [&](const AnalyzedFrame& frame) {
+			sweep.evaluate(frame);
+			// 同一帧用独立的分帧器重新切出（恢复流位置，噪声底按实际间隔更新），逐组运行 FrameAnalyzer
+			bool found = false;
+			framer.push(left.data() + frame.offset, right.data() + frame.offset, kFrameSize,
+				[&](const AnalysisFrame& f) {
+					positioned = f;
+					positioned.offset = frame.offset;
+					for (size_t s = 0; s < sets.size(); ++s) {
+						analyzers[s].analyze(positioned, kRate, reference);
+						const DetectorSweep::Decision& d = sweep.decision(s);
+						if (d.highFreq != reference.highFreq || d.highFreqRatio != reference.highFreqRatio ||
+							d.highBandEnergy != reference.highBandEnergy || d.lowBandEnergy != reference.lowBandEnergy) ++mismatches;
+						triggers += d.highFreq;
+					}
+					found = true;
+				});
+			framer.reset();
+			CHECK(found);
+		});
+		CHECK(mismatches == 0);
+		CHECK(triggers > 0);
+	}
+
+	// 切成很多块、多线程处理的事件时间线与逐包实时检测完全相同；每组参数的事件各自与单独运行一致
+	void testBatchMatchesLive() {
+		const std::string a = "BatchAnalyzerTest_a.wav", b = "BatchAnalyzerTest_b.wav", bad = "BatchAnalyzerTest_bad.wav";
+		std::vector<float> pcmA = makeSignal(kRate * 6 + 333, 11);
+		std::vector<float> pcmB = makeSignal(kRate * 2, 12);
+		writeWav(a, pcmA);
+		writeWav(b, pcmB);
+		{
+			std::ofstream ofs(bad, std::ios::binary);
+			ofs << "not a wav file";
+		}
+
+		BatchConfig config;
+		config.paramSets = sweepSets();
+		config.chunkPackets = 7;   // 块边界很多，且不与跳步对齐
+		config.threads = 4;
+		std::mutex mutex;
+		std::vector<BatchFileResult> results;
+		BatchStats stats;
+		CHECK(analyzeFiles({ a, bad, b }, config, [&](const BatchFileResult& r) {
+			std::lock_guard<std::mutex> lock(mutex);
+			results.push_back(r);
+		}, &stats));
+		CHECK(results.size() == 3);
+		CHECK(stats.files == 2 && stats.failed == 1);
+		CHECK(stats.chunks > 100);
+		CHECK(stats.threads == 4);
+		CHECK(std::fabs(stats.audioSeconds - (pcmA.size() + pcmB.size()) / 2.0 / kRate) < 1e-3);
+
+		for (const BatchFileResult& r : results) {
+			if (r.path == bad) {
+				CHECK(!r.ok && !r.error.empty());
+				continue;
+			}
+			const std::vector<float>& pcm = r.path == a ? pcmA : pcmB;
+			CHECK(r.ok);
+			CHECK(r.frames == pcm.size() / 2);
+
+			std::vector<BatchEvent> expected = expectedEvents(pcm, config.paramSets);
+			CHECK(expected.size() > 50);
+			CHECK(r.events.size() == expected.size());
+			size_t mismatches = 0;
+			for (size_t i = 0; i < expected.size() && i < r.events.size(); ++i) mismatches += !sameEvent(expected[i], r.events[i]);
+			CHECK(mismatches == 0);
+			if (!r.events.empty()) CHECK(r.events[0].timeSeconds == static_cast<double>(r.events[0].frame) / kRate);
+		}
+
+		// 时间线输出
+		for (const BatchFileResult& r : results) {
+			if (!r.ok) continue;
+			std::ostringstream csv;
+			writeEventsCsv(csv, r);
+			std::string text = csv.str();
+			CHECK(text.compare(0, 16, "param_set,frame,") == 0);
+			CHECK(static_cast<size_t>(std::count(text.begin(), text.end(), '\n')) == r.events.size() + 1);
+			std::ostringstream bin;
+			writeEventsBinary(bin, r, static_cast<uint32_t>(config.paramSets.size()));
+			CHECK(bin.str().size() == 24 + 32 * r.events.size());
+			CHECK(bin.str().compare(0, 4, "ACEV") == 0);
+		}
+
+		// 含自适应参数组：噪声底依赖此前的全部帧，每个文件只有一块，结果仍与逐包实时检测相同
+		config.paramSets.insert(config.paramSets.begin(), adaptiveSets().front());
+		results.clear();
+		CHECK(analyzeFiles({ a, b }, config, [&](const BatchFileResult& r) {
+			std::lock_guard<std::mutex> lock(mutex);
+			results.push_back(r);
+		}, &stats));
+		CHECK(stats.chunks == 2);
+		for (const BatchFileResult& r : results) {
+			std::vector<BatchEvent> expected = expectedEvents(r.path == a ? pcmA : pcmB, config.paramSets);
+			CHECK(r.events.size() == expected.size());
+			size_t mismatches = 0;
+			for (size_t i = 0; i < expected.size() && i < r.events.size(); ++i) mismatches += !sameEvent(expected[i], r.events[i]);
+			CHECK(mismatches == 0);
+		}
+
+		std::remove(a.c_str());
+		std::remove(b.c_str());
+		std::remove(bad.c_str());
+	}
+
+	void testCollectFiles() {
+		std::vector<std::string> files;
+		collectWavFiles("BatchAnalyzerTest_missing_dir", files);
+		CHECK(files.empty());
+#if !defined(_WIN32)
+		const std::string root = "BatchAnalyzerTest_dir";
+		mkdir(root.c_str(), 0755);
+		mkdir((root + "/sub").c_str(), 0755);
+		const char* names[] = { "/b.wav", "/a.WAV", "/notes.txt", "/sub/c.wav" };
+		for (const char* n : names) std::ofstream(root + n) << "x";
+		collectWavFiles(root, files);
+		CHECK(files.size() == 3);
+		if (files.size() == 3) {
+			CHECK(files[0] == root + "/a.WAV");
+			CHECK(files[1] == root + "/b.wav");
+			CHECK(files[2] == root + "/sub/c.wav");
+		}
+		for (const char* n : names) std::remove((root + n).c_str());
+		rmdir((root + "/sub").c_str());
+		rmdir(root.c_str());
+#endif
+	}
+}
+
+int main() {
+	testPool();
+	testSweepMatchesAnalyzer();
+	testBatchMatchesLive();
+	testCollectFiles();
+	return testResult("BatchAnalyzerTest");
+}
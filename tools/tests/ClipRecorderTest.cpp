@@ -0,0 +1,159 @@
+﻿// ClipRecorder：片段包含 preRoll / postRoll、相邻事件合并、历史不足时截断、附表内容，以及跨线程送数据
+#include "ClipRecorder.h"
+#include "WavFile.h"
+#include "TestCheck.h"
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+	const uint32_t kRate = 1000;         // 小采样率便于按帧核对
+	const uint32_t kBlockAlign = 4;      // 16 位立体声
+	const uint32_t kPacketFrames = 50;
+	const std::string kPrefix = "ClipRecorderTest_";
+	const std::string kSidecar = "ClipRecorderTest_events.csv";
+
+	std::vector<uint8_t> makeFmt() {
+		std::vector<uint8_t> f(16, 0);
+		uint32_t fields[] = { kWaveFormatPcm | (2u << 16), kRate, kRate * kBlockAlign, kBlockAlign | (16u << 16) };
+		for (int i = 0; i < 4; ++i) {
+			for (int b = 0; b < 4; ++b) f[i * 4 + b] = static_cast<uint8_t>(fields[i] >> (8 * b));
+		}
+		return f;
+	}
+
+	uint8_t patternAt(uint64_t byte) {
+		return static_cast<uint8_t>(byte * 7 + (byte >> 8));
+	}
+
+	void feed(ClipRecorder& clips, uint64_t from, uint64_t to) {
+		std::vector<uint8_t> packet(kPacketFrames * kBlockAlign);
+		for (uint64_t f = from; f < to; f += kPacketFrames) {
+			for (size_t i = 0; i < packet.size(); ++i) packet[i] = patternAt(f * kBlockAlign + i);
+			while (!clips.pushAudio(packet.data(), kPacketFrames, f)) std::this_thread::yield();
+		}
+	}
+
+	OverlayEvent makeEvent(uint64_t trigger, float angle) {
+		OverlayEvent e;
+		e.streamOffset = trigger;
+		e.angle = angle;
+		e.highBandEnergy = 0.25f;
+		e.highFreq = true;
+		return e;
+	}
+
+	// 读回片段并核对：长度为 frames，内容从流位置 begin 开始
+	void checkClip(uint64_t id, uint64_t begin, uint64_t frames) {
+		StreamFormat f;
+		std::vector<uint8_t> data;
+		std::string path = ClipRecorder::clipPath(kPrefix, id);
+		CHECK(readWavFile(path, f, data));
+		CHECK(data.size() == frames * kBlockAlign);
+		bool same = true;
+		for (size_t i = 0; i < data.size(); ++i) {
+			if (data[i] != patternAt(begin * kBlockAlign + i)) same = false;
+		}
+		CHECK(same);
+		std::remove(path.c_str());
+	}
+
+	std::vector<std::string> readLines(const std::string& path) {
+		std::ifstream ifs(path);
+		std::vector<std::string> lines;
+		std::string line;
+		while (std::getline(ifs, line)) lines.push_back(line);
+		return lines;
+	}
+
+	ClipConfig makeConfig() {
+		ClipConfig config;
+		config.preRollSeconds = 0.1;   // 100 帧
+		config.postRollSeconds = 0.2;  // 200 帧
+		config.historySeconds = 2.0;
+		config.maxClipSeconds = 0.5;
+		config.pathPrefix = kPrefix;
+		config.sidecarPath = kSidecar;
+		return config;
+	}
+
+	void testClips() {
+		std::vector<uint8_t> fmt = makeFmt();
+		ClipRecorder clips;
+		CHECK(clips.start(fmt.data(), fmt.size(), kPacketFrames, makeConfig()));
+
+		// 事件在触发帧所在数据包之后、postRoll 到齐之前提交（与实际的分析延迟一致）
+		feed(clips, 0, 600);
+		clips.pushEvent(makeEvent(500, -30.0f));   // [400, 700)
+		clips.pushEvent(makeEvent(550, -28.0f));   // 重叠：合并为 [400, 750)
+		feed(clips, 600, 850);
+		clips.pushEvent(makeEvent(800, 10.0f));    // 合并后将超过 0.5 秒：新片段 [700, 1000)
+		feed(clips, 850, 4000);
+		while (clips.queuedPackets()) std::this_thread::yield();
+		clips.pushEvent(makeEvent(500, 45.0f));    // 历史已覆盖（只保留最近 2 秒）：无数据可写
+		clips.pushEvent(makeEvent(3950, 60.0f));   // 停止时 postRoll 未到齐：截断为 [3850, 4000)
+		clips.stop();
+
+		CHECK(clips.clipsWritten() == 3);
+		CHECK(clips.truncatedClips() == 2);
+		CHECK(clips.audioDrops() == 0);
+		checkClip(0, 400, 350);
+		checkClip(1, 700, 300);
+		checkClip(3, 3850, 150);
+
+		std::vector<std::string> lines = readLines(kSidecar);
+		CHECK(lines.size() == 5);  // 表头 + 4 个写出的事件
+		if (lines.size() == 5) {
+			CHECK(lines[0].compare(0, 10, "clip,file,") == 0);
+			CHECK(lines[1].compare(0, 2, "0,") == 0);
+			CHECK(lines[2].compare(0, 2, "0,") == 0);
+			CHECK(lines[3].compare(0, 2, "1,") == 0);
+			CHECK(lines[4].compare(0, 2, "3,") == 0);
+			CHECK(lines[1].find(",500,0.5,400,350,") != std::string::npos);
+			CHECK(lines[2].find(",-28,") != std::string::npos);
+		}
+		std::remove(kSidecar.c_str());
+	}
+
+	// 捕获线程与分析线程分别送数据；缺口补静音，片段长度不变
+	void testThreads() {
+		std::vector<uint8_t> fmt = makeFmt();
+		ClipConfig config = makeConfig();
+		config.historySeconds = 10.0;  // 两个线程互不等待：历史覆盖全部数据，事件晚到也不会截断
+		ClipRecorder clips;
+		CHECK(clips.start(fmt.data(), fmt.size(), kPacketFrames, config));
+
+		std::thread capture([&]() {
+			feed(clips, 0, 3000);
+			feed(clips, 3500, 5000);  // 500 帧的缺口
+		});
+		std::thread analysis([&]() {
+			for (uint64_t t = 300; t < 5000; t += 600) {
+				while (!clips.pushEvent(makeEvent(t, 0.0f))) std::this_thread::yield();
+			}
+		});
+		capture.join();
+		analysis.join();
+		clips.stop();
+
+		CHECK(clips.clipsWritten() == 8);
+		for (uint64_t id = 0; id < 8; ++id) {
+			uint64_t trigger = 300 + id * 600;
+			StreamFormat f;
+			std::vector<uint8_t> data;
+			std::string path = ClipRecorder::clipPath(kPrefix, id);
+			CHECK(readWavFile(path, f, data));
+			if (trigger + 200 <= 5000) CHECK(data.size() == 300 * kBlockAlign);
+			std::remove(path.c_str());
+		}
+		std::remove(kSidecar.c_str());
+	}
+}
+
+int main() {
+	testClips();
+	testThreads();
+	return testResult("ClipRecorderTest");
+}
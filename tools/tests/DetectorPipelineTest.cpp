@@ -0,0 +1,267 @@
+﻿// DetectorPipeline：每个分析帧恰好变换一次；静音包保持流位置连续且不做变换；
+// 时域高通门限只排除不可能触发的帧，级联的判定与逐帧频谱判定一致
+#include "DetectorPipeline.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+	const uint32_t kSampleRate = 48000;
+	const uint32_t kFrameSize = 256;
+	const uint32_t kHopSize = 128;
+
+	StreamFormat stereoF32() {
+		StreamFormat fmt;
+		fmt.type = SampleType::Float32;
+		fmt.channels = 2;
+		fmt.sampleRate = kSampleRate;
+		fmt.blockAlign = 8;
+		return fmt;
+	}
+
+	// 交错立体声：12 kHz 正弦 + 低频正弦
+	std::vector<float> makePacket(uint32_t frames, uint64_t start) {
+		const float kPi = 3.14159265f;
+		std::vector<float> pcm(frames * 2);
+		for (uint32_t i = 0; i < frames; ++i) {
+			float t = static_cast<float>(start + i) / kSampleRate;
+			float v = 0.3f * std::sin(2.0f * kPi * 12000.0f * t) + 0.2f * std::sin(2.0f * kPi * 300.0f * t);
+			pcm[2 * i] = v;
+			pcm[2 * i + 1] = 0.5f * v;
+		}
+		return pcm;
+	}
+
+	// 整数帧个数：前 total 个样本中能凑出的分析帧数
+	uint64_t expectedFrames(uint64_t total) {
+		return total < kFrameSize ? 0 : (total - kFrameSize) / kHopSize + 1;
+	}
+
+	// 任意大小的数据包序列：FFT 次数等于独立 StftFramer 切出的帧数，不随数据包数量变化
+	void testEachFrameTransformedOnce() {
+		std::mt19937 rng(7);
+		std::uniform_int_distribution<uint32_t> packetSize(1, 1100);
+
+		DetectorPipeline pipeline;
+		CHECK(pipeline.configure(stereoF32(), kFrameSize, kHopSize, DetectorParams(), 1100));
+		StftFramer reference(kFrameSize, kHopSize);
+		uint64_t referenceFrames = 0;
+		uint64_t pos = 0;
+
+		for (int i = 0; i < 2000; ++i) {
+			uint32_t frames = packetSize(rng);
+			std::vector<float> pcm = makePacket(frames, pos);
+			std::vector<float> left(frames), right(frames);
+			for (uint32_t k = 0; k < frames; ++k) {
+				left[k] = pcm[2 * k];
+				right[k] = pcm[2 * k + 1];
+			}
+			reference.push(left.data(), right.data(), frames, [&](const AnalysisFrame&) { ++referenceFrames; });
+			pipeline.processPacket(reinterpret_cast<const uint8_t*>(pcm.data()), frames, false);
+			pos += frames;
+		}
+
+		CHECK(pipeline.streamPosition() == pos);
+		CHECK(referenceFrames == expectedFrames(pos));
+		CHECK(pipeline.framesAnalyzed() == referenceFrames);
+		CHECK(pipeline.analyzer().transformCount() == referenceFrames);
+		CHECK(pipeline.framesSkipped() == 0);
+	}
+
+	// 静音包不做变换，但流位置连续；静音之后的有声数据照常分析
+	void testSilenceSkipped() {
+		DetectorPipeline pipeline;
+		CHECK(pipeline.configure(stereoF32(), kFrameSize, kHopSize, DetectorParams(), 480));
+
+		const uint32_t kPacket = 480;
+		uint64_t pos = 0;
+		for (int i = 0; i < 100; ++i) {
+			CHECK(pipeline.processPacket(nullptr, kPacket, true) == nullptr);
+			pos += kPacket;
+		}
+		CHECK(pipeline.streamPosition() == pos);
+		CHECK(pipeline.framesAnalyzed() == 0);
+		CHECK(pipeline.framesSkipped() == expectedFrames(pos));
+
+		// 有声数据包：与之重叠的分析帧（包括跨越静音尾部的帧）都要分析
+		std::vector<float> pcm = makePacket(kPacket, pos);
+		const AnalyzedFrame* hit = pipeline.processPacket(reinterpret_cast<const uint8_t*>(pcm.data()), kPacket, false);
+		pos += kPacket;
+		CHECK(hit != nullptr);
+		CHECK(pipeline.framesAnalyzed() + pipeline.framesSkipped() + pipeline.framesGated() == expectedFrames(pos));
+		CHECK(pipeline.framesAnalyzed() > 0);
+
+		// 再次静音：只有仍覆盖有声数据的帧被分析
+		uint64_t analyzedBefore = pipeline.framesAnalyzed();
+		for (int i = 0; i < 10; ++i) {
+			pipeline.processPacket(nullptr, kPacket, true);
+			pos += kPacket;
+		}
+		CHECK(pipeline.framesAnalyzed() - analyzedBefore <= kFrameSize / kHopSize);
+		CHECK(pipeline.framesAnalyzed() + pipeline.framesSkipped() + pipeline.framesGated() == expectedFrames(pos));
+	}
+
+	// 参照语料：交错立体声的若干场景，覆盖门限附近的各种情况
+	//   0：频带受限的背景（语音 / 环境声，和弦与泛音到 2.6 kHz，响度起伏）上偶发的高频猝发
+	//   1：宽带嘶声，电平按对数从远低于 ε 扫到远高于 ε（频谱判定的边界）
+	//   2：highFreqMin 附近的正弦与窄带噪声，幅度扫过阈值
+	//   3：强低频（低频泄漏）叠加弱高频噪声
+	//   4：满幅正弦从 2 kHz 扫到 7 kHz（窗函数泄漏触发与高通过渡带的边界）
+	const int kScenes = 5;
+
+	std::vector<float> makeCorpus(int scene, uint32_t frames, uint32_t seed) {
+		const double kPi = 3.14159265358979323846;
+		std::mt19937 rng(seed);
+		std::normal_distribution<float> gauss(0.0f, 1.0f);
+		std::uniform_real_distribution<float> uni(0.0f, 1.0f);
+		std::vector<float> pcm(frames * 2, 0.0f);
+		double phase = 0.0;
+		for (uint32_t i = 0; i < frames; ++i) {
+			// 相位按 double 计算，避免 float 相位误差本身带来宽带噪声
+			const double t = static_cast<double>(i) / kSampleRate;
+			const float progress = static_cast<float>(i) / frames;
+			float l = 0.0f, r = 0.0f;
+			if (scene == 0) {
+				const double chord[] = { 110.0, 220.0, 330.0, 440.0, 660.0, 880.0, 1320.0, 2640.0 };
+				double swell = 0.5 + 0.5 * std::sin(2.0 * kPi * 0.5 * t);
+				for (int k = 0; k < 8; ++k) l += static_cast<float>(swell * 0.15 / (k + 1) * std::sin(2.0 * kPi * chord[k] * t + k));
+				r = 0.8f * l;
+			}
+			else if (scene == 1) {
+				float level = 1e-6f * std::pow(10.0f, 3.0f * progress);
+				l = level * gauss(rng);
+				r = level * gauss(rng);
+			}
+			else if (scene == 2) {
+				float amplitude = 1e-6f * std::pow(10.0f, 3.5f * progress);
+				phase += 2.0 * kPi * (9500.0 + 1000.0 * progress) / kSampleRate;
+				l = amplitude * static_cast<float>(std::sin(phase)) + 0.3f * amplitude * gauss(rng);
+				r = l;
+			}
+			else if (scene == 3) {
+				l = static_cast<float>(0.6 * std::sin(2.0 * kPi * 60.0 * t) + 0.3 * std::sin(2.0 * kPi * 180.0 * t));
+				r = l + 2e-5f * gauss(rng);
+				l += 2e-5f * gauss(rng);
+			}
+			else {
+				phase += 2.0 * kPi * (2000.0 + 5000.0 * progress) / kSampleRate;
+				l = static_cast<float>(0.99 * std::sin(phase));
+				r = l;
+			}
+			pcm[2 * i] = l;
+			pcm[2 * i + 1] = r;
+		}
+		if (scene == 0) {
+			for (uint32_t start = 2000; start + 2000 < frames; start += 12000 + static_cast<uint32_t>(uni(rng) * 24000)) {
+				float gain = 0.001f + 0.1f * uni(rng);
+				for (uint32_t i = 0; i < 1500; ++i) {
+					float v = gain * gauss(rng) * std::exp(-5.0f * i / 1500);
+					pcm[2 * (start + i)] += v;
+					pcm[2 * (start + i) + 1] += 0.7f * v;
+				}
+			}
+		}
+		return pcm;
+	}
+
+	struct Agreement {
+		uint64_t packets = 0;
+		uint64_t triggered = 0;       // 不经门限时触发的数据包
+		uint64_t mismatches = 0;      // 级联与不经门限的结果不同的数据包
+		uint64_t frames = 0;
+		uint64_t gated = 0;
+	};
+
+	// 同一段数据按随机大小的数据包分别送入带门限与不带门限的流水线，逐包比较返回的触发帧
+	void compareCascade(const std::vector<float>& pcm, DetectorParams params, uint32_t frameSize, uint32_t hopSize,
+		Agreement& result) {
+		DetectorPipeline cascade, reference;
+		params.highPassGate = true;
+		CHECK(cascade.configure(stereoF32(), frameSize, hopSize, params, 1100));
+		params.highPassGate = false;
+		CHECK(reference.configure(stereoF32(), frameSize, hopSize, params, 1100));
+		std::mt19937 rng(frameSize + hopSize);
+		std::uniform_int_distribution<uint32_t> packetSize(32, 1100);
+		const uint32_t frames = static_cast<uint32_t>(pcm.size() / 2);
+		for (uint32_t pos = 0; pos < frames;) {
+			uint32_t n = std::min(packetSize(rng), frames - pos);
+			const uint8_t* data = reinterpret_cast<const uint8_t*>(&pcm[2 * pos]);
+			const AnalyzedFrame* a = cascade.processPacket(data, n, false);
+			const AnalyzedFrame* b = reference.processPacket(data, n, false);
+			++result.packets;
+			result.triggered += b != nullptr;
+			if ((a == nullptr) != (b == nullptr) || (a && (a->offset != b->offset || a->highBandEnergy != b->highBandEnergy)))
+				++result.mismatches;
+			pos += n;
+		}
+		CHECK(reference.framesGated() == 0);
+		result.frames += cascade.framesAnalyzed() + cascade.framesGated();
+		result.gated += cascade.framesGated();
+	}
+
+	// 固定阈值：门限只排除不可能触发的帧，在参照语料与各组参数、帧长、跳步上与逐帧频谱判定完全一致
+	void testCascadeAgrees() {
+		const uint32_t sizes[][2] = { { 256, 128 }, { 512, 128 }, { 256, 100 } };
+		Agreement total;
+		for (int scene = 0; scene < kScenes; ++scene) {
+			std::vector<float> pcm = makeCorpus(scene, kSampleRate * 4, 40 + scene);
+			for (const auto& size : sizes) {
+				for (float ratio : { 0.05f, 0.1f, 0.3f }) {
+					for (float minHz : { 8000.0f, 10000.0f, 14000.0f }) {
+						DetectorParams params;
+						params.highFreqRatio = ratio;
+						params.highFreqMin = minHz;
+						Agreement a;
+						compareCascade(pcm, params, size[0], size[1], a);
+						CHECK(a.mismatches == 0);
+						total.packets += a.packets;
+						total.triggered += a.triggered;
+						total.mismatches += a.mismatches;
+						total.frames += a.frames;
+						total.gated += a.gated;
+					}
+				}
+			}
+		}
+		CHECK(total.triggered > 1000);
+		CHECK(total.gated > 0);
+		std::printf("cascade (fixed): %llu packets, %llu triggered, %llu mismatches, %.1f%% of frames gated\n",
+			static_cast<unsigned long long>(total.packets), static_cast<unsigned long long>(total.triggered),
+			static_cast<unsigned long long>(total.mismatches), 100.0 * total.gated / total.frames);
+
+		// 频带受限的背景：多数帧在门限处被排除
+		Agreement background;
+		compareCascade(makeCorpus(0, kSampleRate * 4, 40), DetectorParams(), kFrameSize, kHopSize, background);
+		CHECK(background.gated > background.frames / 2);
+		std::printf("cascade (band-limited background): %.1f%% of frames gated, %llu of %llu packets triggered\n",
+			100.0 * background.gated / background.frames, static_cast<unsigned long long>(background.triggered),
+			static_cast<unsigned long long>(background.packets));
+	}
+
+	// 自适应噪声底：被门限排除的帧按全零帧推进噪声底，判定与逐帧分析基本一致
+	void testCascadeAdaptive() {
+		Agreement total;
+		for (int scene = 0; scene < kScenes; ++scene) {
+			DetectorParams params;
+			params.adaptiveFloor = true;
+			compareCascade(makeCorpus(scene, kSampleRate * 4, 50 + scene), params, kFrameSize, kHopSize, total);
+		}
+		CHECK(total.triggered > 10);
+		CHECK(total.mismatches * 100 <= total.triggered);
+		std::printf("cascade (adaptive floor): %llu packets, %llu triggered, %llu mismatches, %.1f%% of frames gated\n",
+			static_cast<unsigned long long>(total.packets), static_cast<unsigned long long>(total.triggered),
+			static_cast<unsigned long long>(total.mismatches), 100.0 * total.gated / total.frames);
+	}
+}
+
+int main() {
+	testEachFrameTransformedOnce();
+	testSilenceSkipped();
+	testCascadeAgrees();
+	testCascadeAdaptive();
+	return testResult("DetectorPipelineTest");
+}
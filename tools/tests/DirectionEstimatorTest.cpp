@@ -0,0 +1,118 @@
+﻿// DirectionEstimator 频点声像：单声源的峰与宽带 ILD 一致；两侧同时发声时分出两个峰，而宽带 RMS 只给出中间的角度
+#include "DirectionEstimator.h"
+#include "FrameAnalyzer.h"
+#include "StftFramer.h"
+#include "TestCheck.h"
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+	const uint32_t kSampleRate = 48000;
+	const size_t kFrameSize = 512;
+
+	// 一个声源：频点 [firstBin, lastBin] 上随机相位的正弦之和，按 ildAngle 的映射平移到 angle
+	struct Source {
+		float angle;
+		size_t firstBin, lastBin;
+		float amplitude;
+	};
+
+	void addSource(const Source& s, std::mt19937& rng, std::vector<float>& left, std::vector<float>& right) {
+		const double kPi = 3.14159265358979323846;
+		std::uniform_real_distribution<double> phase(0.0, 2.0 * kPi);
+		const double db = s.angle / 90.0 * 20.0;
+		const double gainRight = std::pow(10.0, db / 40.0), gainLeft = 1.0 / gainRight;
+		for (size_t k = s.firstBin; k <= s.lastBin; ++k) {
+			const double p = phase(rng);
+			for (size_t i = 0; i < left.size(); ++i) {
+				const double v = s.amplitude * std::sin(2.0 * kPi * k * i / kFrameSize + p);
+				left[i] += static_cast<float>(gainLeft * v);
+				right[i] += static_cast<float>(gainRight * v);
+			}
+		}
+	}
+
+	AnalyzedFrame analyzeScene(const std::vector<Source>& sources, uint32_t seed) {
+		std::mt19937 rng(seed);
+		std::vector<float> left(kFrameSize, 0.0f), right(kFrameSize, 0.0f);
+		for (const Source& s : sources) addSource(s, rng, left, right);
+		StftFramer framer(kFrameSize, kFrameSize / 2);
+		FrameAnalyzer analyzer;
+		AnalyzedFrame out;
+		framer.push(left.data(), right.data(), kFrameSize, [&](const AnalysisFrame& frame) {
+			analyzer.analyze(frame, kSampleRate, out);
+		});
+		return out;
+	}
+
+	void testSingleSource() {
+		DirectionEstimator direction;
+		direction.prepare(kFrameSize);
+		const float angles[] = { -70.0f, -25.0f, 0.0f, 10.0f, 45.0f, 85.0f };
+		for (float angle : angles) {
+			AnalyzedFrame frame = analyzeScene({ { angle, 20, 200, 0.01f } }, 1);
+			DirectionResult r = direction.estimate(frame);
+			CHECK(r.sourceCount >= 1);
+			CHECK_NEAR(r.sources[0].angle, angle, 1.5);
+			CHECK_NEAR(r.sources[0].angle, r.ildAngle, 1.5);
+			CHECK(r.sources[0].confidence > 0.9f);
+		}
+	}
+
+	void testTwoSources() {
+		DirectionEstimator direction;
+		direction.prepare(kFrameSize);
+		struct Scene { float a, b; };
+		const Scene scenes[] = { { -50.0f, 50.0f }, { -60.0f, 30.0f }, { -20.0f, 40.0f }, { 15.0f, 70.0f } };
+		for (uint32_t seed = 1; seed <= 3; ++seed) {
+			for (const Scene& scene : scenes) {
+				// 两种武器的频谱不同：一个集中在 2 ~ 7.5 kHz，一个在 8.4 ~ 21.5 kHz，能量相当
+				AnalyzedFrame frame = analyzeScene({ { scene.a, 25, 80, 0.01f }, { scene.b, 90, 230, 0.0066f } }, seed);
+				DirectionResult r = direction.estimate(frame);
+				CHECK(r.sourceCount >= 2);
+				if (r.sourceCount < 2) continue;
+				float lo = std::fmin(r.sources[0].angle, r.sources[1].angle);
+				float hi = std::fmax(r.sources[0].angle, r.sources[1].angle);
+				CHECK_NEAR(lo, scene.a, 2.0);
+				CHECK_NEAR(hi, scene.b, 2.0);
+				CHECK(r.sources[0].confidence >= r.sources[1].confidence);
+				CHECK(r.sources[0].confidence + r.sources[1].confidence > 0.85f);
+				// 宽带 RMS 落在两者之间，离两个声源都远
+				CHECK(std::fabs(r.ildAngle - scene.a) > 10.0f && std::fabs(r.ildAngle - scene.b) > 10.0f);
+			}
+		}
+	}
+
+	void testLimits() {
+		DirectionEstimator direction;
+		direction.prepare(kFrameSize);
+
+		// 全静音帧没有声源
+		AnalyzedFrame silent = analyzeScene({}, 1);
+		CHECK(direction.estimate(silent).sourceCount == 0);
+
+		// maxSources 限制峰数；为 0 时不统计
+		AnalyzedFrame frame = analyzeScene({ { -60.0f, 20, 60, 0.01f }, { 0.0f, 70, 120, 0.01f }, { 60.0f, 130, 200, 0.01f } }, 2);
+		CHECK(direction.estimate(frame).sourceCount == 3);
+		direction.maxSources = 2;
+		CHECK(direction.estimate(frame).sourceCount == 2);
+		direction.maxSources = 0;
+		CHECK(direction.estimate(frame).sourceCount == 0);
+
+		// sourceMinFrequency 以下的低频不计入：响亮的低音在另一侧也不影响高频声源
+		direction.maxSources = 3;
+		AnalyzedFrame bass = analyzeScene({ { -60.0f, 2, 8, 0.05f }, { 40.0f, 30, 200, 0.005f } }, 3);
+		DirectionResult r = direction.estimate(bass);
+		CHECK(r.sourceCount == 1);
+		CHECK_NEAR(r.sources[0].angle, 40.0, 1.5);
+		CHECK(r.ildAngle < 0.0f);
+	}
+}
+
+int main() {
+	testSingleSource();
+	testTwoSources();
+	testLimits();
+	return testResult("DirectionEstimatorTest");
+}
@@ -0,0 +1,105 @@
+﻿// EventMailbox：事件按序完整送达，唤醒只在批次边界发出且不会丢失，满时丢弃并计数
+// 消费者线程模拟界面消息队列：只有收到唤醒才取邮箱；可配合 -DAC_SANITIZE_THREAD=ON 运行
+#include "EventMailbox.h"
+#include "TestCheck.h"
+#include <atomic>
+#include <thread>
+
+namespace {
+	void testBatchWake() {
+		EventMailbox box(16);
+		OverlayEvent e;
+		e.angle = 12.5f;
+		CHECK(box.push(e));   // 第一条：需要唤醒
+		CHECK(!box.push(e));  // 唤醒尚未处理：同一批次
+		CHECK(!box.push(e));
+
+		uint64_t expected = 0;
+		size_t n = box.drain([&](const OverlayEvent& got) {
+			CHECK(got.sequence == expected++);
+			CHECK(got.angle == 12.5f);
+		});
+		CHECK(n == 3);
+		CHECK(box.push(e));  // 取完后的新事件重新唤醒
+
+		// 唤醒发送失败后下一条事件重试
+		box.cancelWake();
+		CHECK(box.push(e));
+	}
+
+	void testOverflow() {
+		EventMailbox box(4);
+		OverlayEvent e;
+		int wakes = 0;
+		for (int i = 0; i < 10; ++i) {
+			if (box.push(e)) ++wakes;
+		}
+		CHECK(wakes == 1);
+		CHECK(box.droppedCount() == 6);
+		uint64_t last = 0;
+		size_t n = box.drain([&](const OverlayEvent& got) { last = got.sequence; });
+		CHECK(n == 4);
+		CHECK(last == 3);
+		// 丢弃的事件也占用序号，消费者可以看到缺口
+		box.push(e);
+		box.drain([&](const OverlayEvent& got) { CHECK(got.sequence == 10); });
+	}
+
+	// 生产者高速写入，消费者只在唤醒时取：全部事件按序到达，没有丢失的唤醒；
+	// drain 清除标志后到达的事件可能在同一次 drain 中取走，其唤醒随后取到空队列，因此空唤醒不多于非空批次
+	void testConcurrent() {
+		const uint64_t kEvents = 200000;
+		EventMailbox box(kEvents);  // 足够大，不丢弃
+		std::atomic<uint64_t> wakes{ 0 };
+		std::atomic<bool> done{ false };
+
+		std::thread producer([&]() {
+			OverlayEvent e;
+			for (uint64_t i = 0; i < kEvents; ++i) {
+				e.streamOffset = i;
+				if (box.push(e)) wakes.fetch_add(1);  // “PostMessage”
+			}
+			done.store(true);
+		});
+
+		uint64_t received = 0;
+		uint64_t batches = 0;
+		bool inOrder = true;
+		uint64_t handled = 0;
+		while (received < kEvents) {
+			// 只有未处理的唤醒多于已处理的才去取，模拟消息队列
+			if (wakes.load() == handled) {
+				if (done.load() && wakes.load() == handled) break;  // 丢失唤醒：退出并由下面的检查报告
+				std::this_thread::yield();
+				continue;
+			}
+			++handled;
+			size_t n = box.drain([&](const OverlayEvent& e) {
+				if (e.sequence != received || e.streamOffset != received) inOrder = false;
+				++received;
+			});
+			if (n) ++batches;
+		}
+		producer.join();
+		// 最后一条事件的唤醒可能在消费者取完之后才计数
+		while (handled < wakes.load()) {
+			++handled;
+			if (box.drain([&](const OverlayEvent&) { ++received; })) ++batches;
+		}
+
+		CHECK(received == kEvents);
+		CHECK(inOrder);
+		CHECK(box.droppedCount() == 0);
+		CHECK(batches > 0);
+		CHECK(handled - batches <= batches);
+		std::printf("events %llu, wake-ups %llu\n", static_cast<unsigned long long>(kEvents),
+			static_cast<unsigned long long>(wakes.load()));
+	}
+}
+
+int main() {
+	testBatchWake();
+	testOverflow();
+	testConcurrent();
+	return testResult("EventMailboxTest");
+}
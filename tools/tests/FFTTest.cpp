@@ -0,0 +1,99 @@
+﻿// FFTPlan 与直接 DFT（原 simpleFFT 的算法）逐频点比较：2 的幂、Bluestein 长度与 n = 1..8
+#include "FFT.h"
+#include "TestCheck.h"
+#include <complex>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace {
+	typedef std::complex<double> cd;
+	typedef std::complex<float> cf;
+
+	// 双精度直接 DFT 作为参照
+	std::vector<cd> referenceDft(const std::vector<cd>& in) {
+		const size_t n = in.size();
+		const double kPi = 3.14159265358979323846;
+		std::vector<cd> out(n);
+		for (size_t k = 0; k < n; ++k) {
+			cd sum(0.0, 0.0);
+			for (size_t t = 0; t < n; ++t) {
+				double a = -2.0 * kPi * static_cast<double>((k * t) % n) / n;
+				sum += in[t] * cd(std::cos(a), std::sin(a));
+			}
+			out[k] = sum;
+		}
+		return out;
+	}
+
+	// 误差按参照频谱的最大幅度归一化
+	double relativeError(const cf* got, const std::vector<cd>& ref, size_t count) {
+		double peak = 1e-30, err = 0.0;
+		for (size_t k = 0; k < ref.size(); ++k) peak = std::max(peak, std::abs(ref[k]));
+		for (size_t k = 0; k < count; ++k) err = std::max(err, std::abs(cd(got[k]) - ref[k]));
+		return err / peak;
+	}
+
+	void checkSize(size_t n, std::mt19937& rng) {
+		const double kTol = 1e-5;  // 实测最大约 1e-6
+		std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+		std::shared_ptr<const FFTPlan> plan = FFTPlan::get(n);
+		CHECK(plan->size() == n);
+
+		std::vector<float> a(n), b(n);
+		for (size_t i = 0; i < n; ++i) {
+			a[i] = dist(rng);
+			b[i] = dist(rng);
+		}
+		std::vector<cd> ca(n), cb(n), cz(n);
+		for (size_t i = 0; i < n; ++i) {
+			ca[i] = cd(a[i], 0.0);
+			cb[i] = cd(b[i], 0.0);
+			cz[i] = cd(a[i], b[i]);
+		}
+		const std::vector<cd> refA = referenceDft(ca);
+		const std::vector<cd> refB = referenceDft(cb);
+		const std::vector<cd> refZ = referenceDft(cz);
+		const size_t bins = n / 2 + 1;
+
+		// 复数正变换
+		std::vector<cf> z(n);
+		for (size_t i = 0; i < n; ++i) z[i] = cf(a[i], b[i]);
+		plan->forward(z.data());
+		double errForward = relativeError(z.data(), refZ, n);
+
+		// 逆变换回到原信号
+		plan->inverse(z.data());
+		double errInverse = 0.0;
+		for (size_t i = 0; i < n; ++i) errInverse = std::max(errInverse, std::abs(cd(z[i]) - cz[i]));
+
+		// 实数变换与双路实数变换
+		std::vector<cf> outA(bins), outB(bins);
+		plan->forwardReal(a.data(), outA.data());
+		double errReal = relativeError(outA.data(), refA, bins);
+		plan->forwardRealPair(a.data(), b.data(), outA.data(), outB.data());
+		double errPair = std::max(relativeError(outA.data(), refA, bins), relativeError(outB.data(), refB, bins));
+
+		if (errForward > kTol || errInverse > kTol || errReal > kTol || errPair > kTol) {
+			std::fprintf(stderr, "n=%zu forward=%g inverse=%g real=%g pair=%g\n",
+				n, errForward, errInverse, errReal, errPair);
+		}
+		CHECK(errForward <= kTol);
+		CHECK(errInverse <= kTol);
+		CHECK(errReal <= kTol);
+		CHECK(errPair <= kTol);
+	}
+}
+
+int main() {
+	std::mt19937 rng(12345);
+	for (size_t n = 1; n <= 8; ++n) checkSize(n, rng);
+	const size_t pow2[] = { 16, 64, 128, 256, 512, 1024, 2048, 4096 };
+	for (size_t n : pow2) checkSize(n, rng);
+	const size_t bluestein[] = { 11, 100, 441, 480, 882, 960, 1023 };
+	for (size_t n : bluestein) checkSize(n, rng);
+
+	// 同一长度的计划只构建一次
+	CHECK(FFTPlan::get(480) == FFTPlan::get(480));
+	return testResult("FFTTest");
+}
@@ -0,0 +1,235 @@
+﻿// FeatureExtractor：逐帧特征与实时检测流水线一致、多线程切块结果与单线程逐位相同、张量文件的索引与列
+#include "FeatureExtractor.h"
+#include "WavRecorder.h"
+#include "TestCheck.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+	const uint32_t kFrameSize = 256;
+	const uint32_t kHopSize = 128;
+
+	// 交错 PCM：低频背景 + 间歇的右偏 12 kHz 猝发
+	std::vector<float> makeSignal(uint32_t frames, uint32_t rate, uint32_t seed) {
+		const float kPi = 3.14159265f;
+		std::mt19937 rng(seed);
+		std::uniform_real_distribution<float> noise(-0.01f, 0.01f);
+		std::vector<float> pcm(frames * 2);
+		for (uint32_t i = 0; i < frames; ++i) {
+			float t = static_cast<float>(i) / rate;
+			float bg = 0.2f * std::sin(2.0f * kPi * 220.0f * t) + noise(rng);
+			bool burst = (i / (rate / 10)) % 4 == 1;
+			float hf = burst ? 0.3f * std::sin(2.0f * kPi * 12000.0f * t) : 0.0f;
+			pcm[2 * i] = bg + 0.3f * hf;
+			pcm[2 * i + 1] = bg + hf;
+		}
+		return pcm;
+	}
+
+	StreamFormat makeFormat(SampleType type, uint32_t rate) {
+		StreamFormat fmt;
+		fmt.type = type;
+		fmt.channels = 2;
+		fmt.sampleRate = rate;
+		fmt.blockAlign = type == SampleType::Int16 ? 4 : 8;
+		return fmt;
+	}
+
+	std::vector<uint8_t> encode(const std::vector<float>& pcm, SampleType type) {
+		std::vector<uint8_t> out;
+		if (type == SampleType::Int16) {
+			out.resize(pcm.size() * 2);
+			for (size_t i = 0; i < pcm.size(); ++i) {
+				int16_t s = static_cast<int16_t>(std::lround(pcm[i] * 32767.0f));
+				std::memcpy(&out[i * 2], &s, 2);
+			}
+		}
+		else {
+			out.resize(pcm.size() * 4);
+			std::memcpy(out.data(), pcm.data(), out.size());
+		}
+		return out;
+	}
+
+	void writeWav(const std::string& path, const StreamFormat& fmt, const std::vector<uint8_t>& data) {
+		uint8_t chunk[16];
+		uint32_t fields[] = {
+			(fmt.type == SampleType::Int16 ? 1u : 3u) | (fmt.channels << 16), fmt.sampleRate,
+			fmt.sampleRate * fmt.blockAlign, fmt.blockAlign | ((fmt.blockAlign / fmt.channels * 8) << 16),
+		};
+		for (int i = 0; i < 4; ++i) {
+			for (int b = 0; b < 4; ++b) chunk[i * 4 + b] = static_cast<uint8_t>(fields[i] >> (8 * b));
+		}
+		std::vector<uint8_t> header;
+		buildWavHeader(chunk, sizeof(chunk), data.size(), header);
+		std::ofstream ofs(path, std::ios::binary);
+		ofs.write(reinterpret_cast<const char*>(header.data()), header.size());
+		ofs.write(reinterpret_cast<const char*>(data.data()), data.size());
+	}
+
+	struct Source {
+		std::string path;
+		StreamFormat format;
+		std::vector<uint8_t> data;
+	};
+
+	std::vector<Source> makeSources() {
+		std::vector<Source> sources(2);
+		sources[0].path = "FeatureExtractorTest_a.wav";
+		sources[0].format = makeFormat(SampleType::Float32, 48000);
+		sources[0].data = encode(makeSignal(48000 * 3 + 77, 48000, 1), SampleType::Float32);
+		sources[1].path = "FeatureExtractorTest_b.wav";
+		sources[1].format = makeFormat(SampleType::Int16, 44100);
+		sources[1].data = encode(makeSignal(44100 * 2, 44100, 2), SampleType::Int16);
+		for (const Source& s : sources) writeWav(s.path, s.format, s.data);
+		return sources;
+	}
+
+	FeatureConfig testConfig() {
+		FeatureConfig config;
+		config.frameSize = kFrameSize;
+		config.hopSize = kHopSize;
+		config.chunkFrames = 100;   // 切成很多块，覆盖块边界
+		config.threads = 4;
+		return config;
+	}
+
+	// 与捕获线程相同的方式逐包（480 帧）处理，离线导出的每一行都与之逐位相同；processPacket 的触发帧在对应行标记为 high_freq
+	void testMatchesLivePipeline() {
+		std::vector<Source> sources = makeSources();
+		FeatureConfig config = testConfig();
+		std::vector<std::string> inputs = { sources[0].path, "FeatureExtractorTest_missing.wav", sources[1].path };
+		FeatureExportStats stats;
+		std::string error;
+		CHECK(exportFeatures(inputs, "FeatureExtractorTest.actf", config, &stats, &error));
+		CHECK(stats.files == 2 && stats.skipped == 1);
+		CHECK(stats.chunks > 10);
+
+		FeatureDataset dataset;
+		CHECK(dataset.open("FeatureExtractorTest.actf", &error));
+		CHECK(dataset.dimension() == config.melBands + FrameFeatures::kScalarColumns);
+		CHECK(dataset.columns() == FrameFeatures::columnNames(config));
+		CHECK(dataset.frameSize() == kFrameSize && dataset.hopSize() == kHopSize);
+		CHECK(dataset.files().size() == 2);
+		CHECK(dataset.rows() == stats.rows);
+		const int highFreqCol = dataset.column("high_freq");
+		const int highEnergyCol = dataset.column("high_band_energy");
+		const int ildCol = dataset.column("ild_db");
+		CHECK(highFreqCol >= 0 && highEnergyCol >= 0 && ildCol >= 0);
+		CHECK(dataset.column("no_such_column") == -1);
+
+		for (size_t f = 0; f < sources.size() && f < dataset.files().size(); ++f) {
+			const Source& s = sources[f];
+			const FeatureFileEntry& entry = dataset.files()[f];
+			uint64_t samples = s.data.size() / s.format.blockAlign;
+			CHECK(entry.path == s.path);
+			CHECK(entry.sampleRate == s.format.sampleRate && entry.channels == 2);
+			CHECK(entry.rows == (samples - kFrameSize) / kHopSize + 1);
+
+			DetectorPipeline features, live;
+			CHECK(features.configure(s.format, kFrameSize, kHopSize, config.params, 480));
+			CHECK(live.configure(s.format, kFrameSize, kHopSize, config.params, 480));
+			FrameFeatures extractor;
+			extractor.configure(config, s.format.sampleRate, features.window());
+			std::vector<float> row(extractor.dimension());
+			uint64_t index = 0, mismatches = 0, triggers = 0, louderRight = 0, highRows = 0;
+			for (uint64_t pos = 0; pos < samples; pos += 480) {
+				uint32_t n = static_cast<uint32_t>(std::min<uint64_t>(480, samples - pos));
+				const uint8_t* packet = s.data.data() + pos * s.format.blockAlign;
+				features.analyzePacket(packet, n, [&](const AnalyzedFrame& frame) {
+					extractor.compute(frame, row.data());
+					if (index >= entry.rows ||
+						std::memcmp(row.data(), dataset.row(entry.firstRow + index), row.size() * sizeof(float)) != 0) ++mismatches;
+					++index;
+				});
+				const AnalyzedFrame* hit = live.processPacket(packet, n, false);
+				if (hit) {
+					++triggers;
+					const float* r = dataset.row(entry.firstRow + hit->offset / kHopSize);
+					CHECK(r[highFreqCol] == 1.0f);
+					CHECK(r[highEnergyCol] == hit->highBandEnergy);
+				}
+			}
+			CHECK(index == entry.rows);
+			CHECK(mismatches == 0);
+			CHECK(triggers > 0);
+
+			for (uint64_t i = 0; i < entry.rows; ++i) {
+				const float* r = dataset.row(entry.firstRow + i);
+				if (r[highEnergyCol] > 1e-3f) {
+					++highRows;
+					if (r[highFreqCol] == 1.0f && r[ildCol] > 0.0f) ++louderRight;
+				}
+			}
+			CHECK(highRows > 0 && louderRight == highRows);  // 猝发帧都触发，且右声道更响
+		}
+		dataset.close();
+
+		// 单线程、不切块导出的数据与多线程逐位相同
+		config.threads = 1;
+		config.chunkFrames = 1u << 30;
+		CHECK(exportFeatures(inputs, "FeatureExtractorTest_serial.actf", config, &stats, &error));
+		CHECK(stats.chunks == 2);
+		FeatureDataset a, b;
+		CHECK(a.open("FeatureExtractorTest.actf") && b.open("FeatureExtractorTest_serial.actf"));
+		CHECK(a.rows() == b.rows());
+		CHECK(std::memcmp(a.row(0), b.row(0), static_cast<size_t>(a.rows()) * a.dimension() * sizeof(float)) == 0);
+		a.close();
+		b.close();
+
+		std::remove("FeatureExtractorTest.actf");
+		std::remove("FeatureExtractorTest_serial.actf");
+		for (const Source& s : sources) std::remove(s.path.c_str());
+	}
+
+	// 12 kHz 正弦的 log-mel 峰值落在包含 12 kHz 的频带
+	void testMelBands() {
+		const uint32_t rate = 48000;
+		FeatureConfig config = testConfig();
+		DetectorPipeline pipeline;
+		CHECK(pipeline.configure(makeFormat(SampleType::Float32, rate), kFrameSize, kHopSize, config.params, 4096));
+		FrameFeatures extractor;
+		extractor.configure(config, rate, pipeline.window());
+
+		std::vector<float> pcm(4096 * 2);
+		for (size_t i = 0; i < 4096; ++i) pcm[2 * i] = pcm[2 * i + 1] = 0.5f * std::sin(2.0f * 3.14159265f * 12000.0f * i / rate);
+		std::vector<float> row(extractor.dimension());
+		pipeline.analyzePacket(reinterpret_cast<const uint8_t*>(pcm.data()), 4096, [&](const AnalyzedFrame& frame) {
+			extractor.compute(frame, row.data());
+		});
+
+		uint32_t peak = 0;
+		for (uint32_t b = 1; b < config.melBands; ++b) {
+			if (row[b] > row[peak]) peak = b;
+		}
+		float mel12k = 2595.0f * std::log10(1.0f + 12000.0f / 700.0f);
+		float melMax = 2595.0f * std::log10(1.0f + rate / 2.0f / 700.0f);
+		float expected = mel12k / melMax * (config.melBands + 1) - 1.0f;
+		CHECK(std::fabs(peak - expected) <= 1.0f);
+		CHECK(row[peak] > row[0] + 10.0f);
+
+		// 静音帧：mel 为下限，标量为 0
+		std::vector<float> silent(kFrameSize * 2, 0.0f);
+		DetectorPipeline quiet;
+		CHECK(quiet.configure(makeFormat(SampleType::Float32, rate), kFrameSize, kHopSize, config.params, kFrameSize));
+		bool seen = false;
+		quiet.analyzePacket(reinterpret_cast<const uint8_t*>(silent.data()), kFrameSize, [&](const AnalyzedFrame& frame) {
+			extractor.compute(frame, row.data());
+			seen = true;
+		});
+		CHECK(seen);
+		CHECK_NEAR(row[0], std::log(1e-10f), 1e-3);
+		CHECK(row[config.melBands] == 0.0f && row[config.melBands + 3] == 0.0f);
+	}
+}
+
+int main() {
+	testMatchesLivePipeline();
+	testMelBands();
+	return testResult("FeatureExtractorTest");
+}
@@ -0,0 +1,45 @@
+﻿// FrameAnalyzer 阈值归一化：同一幅度的正弦在不同帧长下得到相同的判定
+#include "FrameAnalyzer.h"
+#include "StftFramer.h"
+#include "TestCheck.h"
+#include <cmath>
+#include <vector>
+
+namespace {
+	const uint32_t kSampleRate = 48000;
+
+	// 用 StftFramer 取出一帧加窗后的正弦（频率落在频点中心）
+	AnalyzedFrame analyzeTone(size_t frameSize, float amplitude, float freq) {
+		const float kPi = 3.14159265f;
+		std::vector<float> tone(frameSize);
+		for (size_t i = 0; i < frameSize; ++i) tone[i] = amplitude * std::sin(2.0f * kPi * freq * i / kSampleRate);
+
+		StftFramer framer(frameSize, frameSize / 2);
+		FrameAnalyzer analyzer;
+		AnalyzedFrame out;
+		framer.push(tone.data(), tone.data(), frameSize, [&](const AnalysisFrame& frame) {
+			analyzer.analyze(frame, kSampleRate, out);
+		});
+		return out;
+	}
+}
+
+int main() {
+	// 默认阈值对应的正弦幅度：归一化频点幅度 = A / 2
+	const float epsilon = DetectorParams().highFreqEpsilon;
+	const float thresholdAmplitude = 2.0f * epsilon;
+	const size_t sizes[] = { 256, 512, 1024 };
+
+	for (size_t n : sizes) {
+		// 高于阈值的正弦点亮高频段频点，低于阈值的不点亮，与帧长无关
+		AnalyzedFrame above = analyzeTone(n, 1.5f * thresholdAmplitude, 12000.0f);
+		AnalyzedFrame below = analyzeTone(n, 0.5f * thresholdAmplitude, 12000.0f);
+		CHECK(above.highFreqRatio > 0.0f);
+		CHECK(below.highFreqRatio == 0.0f);
+
+		// 归一化后的高频能量约为 (A/2)²，与帧长无关（主瓣能量 = 1.5 倍峰值功率）
+		AnalyzedFrame loud = analyzeTone(n, 0.5f, 12000.0f);
+		CHECK_NEAR(loud.highBandEnergy, 1.5 * 0.25 * 0.25, 0.01);
+	}
+	return testResult("FrameAnalyzerTest");
+}
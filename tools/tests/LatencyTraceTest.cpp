@@ -0,0 +1,275 @@
+﻿// LatencyTracer：注入时钟下的精确百分位、多线程分环、Chrome trace 输出，以及 WAV 文件驱动的端到端跟踪
+#include "LatencyTrace.h"
+#include "DetectorPipeline.h"
+#include "WavFile.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+	const LatencyStats* findStats(const std::vector<LatencyStats>& stats, TraceStage from, TraceStage to) {
+		for (const LatencyStats& st : stats) {
+			if (st.from == from && st.to == to) return &st;
+		}
+		return nullptr;
+	}
+
+	size_t countOf(const std::string& text, const std::string& needle) {
+		size_t n = 0;
+		for (size_t pos = text.find(needle); pos != std::string::npos; pos = text.find(needle, pos + 1)) ++n;
+		return n;
+	}
+
+	// 延迟为 1..100 微秒：最近秩 p50 = 50 µs，p99 = 99 µs，max = 100 µs
+	void testPercentiles() {
+		uint64_t fakeNow = 0;
+		LatencyTracer tracer;
+		tracer.setClock([&]() { return fakeNow; });
+
+		for (uint64_t i = 0; i < 100; ++i) {
+			fakeNow = i * 1000000;
+			tracer.mark(i, TraceStage::DeviceCapture);
+			fakeNow += (i + 1) * 1000;
+			tracer.mark(i, TraceStage::Detected);
+		}
+
+		std::vector<TraceRecord> records;
+		tracer.collect(records);
+		CHECK(records.size() == 200);
+		CHECK(tracer.droppedCount() == 0);
+
+		std::vector<LatencyStats> stats = computeLatencyStats(records);
+		CHECK(stats.size() == 1);
+		const LatencyStats* st = findStats(stats, TraceStage::DeviceCapture, TraceStage::Detected);
+		CHECK(st != nullptr);
+		if (!st) return;
+		CHECK(st->count == 100);
+		CHECK_NEAR(st->p50Ms, 0.050, 1e-12);
+		CHECK_NEAR(st->p99Ms, 0.099, 1e-12);
+		CHECK_NEAR(st->maxMs, 0.100, 1e-12);
+
+		uint64_t total = 0;
+		for (uint64_t c : st->histogram) total += c;
+		CHECK(total == 100);
+		CHECK(st->histogram[1] == 1);  // [1, 2) µs
+		CHECK(st->histogram[7] == 37); // [64, 128) µs
+
+		// 再次导出时环已清空
+		records.clear();
+		tracer.collect(records);
+		CHECK(records.empty());
+	}
+
+	// 缺失的阶段被跳过：相邻统计连接到前一个存在的阶段，端到端取到最后一个阶段
+	void testMissingStages() {
+		LatencyTracer tracer;
+		tracer.markAt(7, TraceStage::DeviceCapture, 1000000);
+		tracer.markAt(7, TraceStage::Detected, 3000000);
+		tracer.markAt(7, TraceStage::Posted, 4000000);
+		tracer.markAt(7, TraceStage::Rendered, 9000000);
+
+		std::vector<TraceRecord> records;
+		tracer.collect(records);
+		std::vector<LatencyStats> stats = computeLatencyStats(records);
+		CHECK(stats.size() == 4);
+		const LatencyStats* skip = findStats(stats, TraceStage::Detected, TraceStage::Posted);
+		CHECK(skip && skip->count == 1 && std::fabs(skip->maxMs - 1.0) < 1e-12);
+		const LatencyStats* total = findStats(stats, TraceStage::DeviceCapture, TraceStage::Rendered);
+		CHECK(total && total->count == 1 && std::fabs(total->p50Ms - 8.0) < 1e-12);
+	}
+
+	// 每个线程写自己的环；环满时丢弃并计数
+	void testThreadRings() {
+		const int kThreads = 4;
+		const int kPerThread = 1000;
+		std::atomic<uint64_t> fakeNow{ 0 };
+		LatencyTracer tracer(kPerThread);
+		tracer.setClock([&]() { return fakeNow.fetch_add(1); });
+
+		std::vector<std::thread> threads;
+		for (int t = 0; t < kThreads; ++t) {
+			threads.emplace_back([&, t]() {
+				for (int i = 0; i < kPerThread; ++i) tracer.mark(static_cast<uint64_t>(t) * kPerThread + i, TraceStage::Detected);
+			});
+		}
+		for (auto& th : threads) th.join();
+
+		std::vector<TraceRecord> records;
+		tracer.collect(records);
+		CHECK(records.size() == static_cast<size_t>(kThreads * kPerThread));
+		CHECK(tracer.droppedCount() == 0);
+		std::set<uint32_t> threadIds;
+		std::set<uint64_t> eventIds;
+		for (const TraceRecord& r : records) {
+			threadIds.insert(r.thread);
+			eventIds.insert(r.eventId);
+		}
+		CHECK(threadIds.size() == static_cast<size_t>(kThreads));
+		CHECK(eventIds.size() == records.size());
+
+		LatencyTracer small(16);
+		for (int i = 0; i < 20; ++i) small.mark(i, TraceStage::Detected);
+		CHECK(small.droppedCount() == 4);
+
+		small.enabled = false;
+		small.mark(99, TraceStage::Detected);
+		records.clear();
+		small.collect(records);
+		CHECK(records.size() == 16);
+	}
+
+	void testChromeTrace() {
+		LatencyTracer tracer;
+		tracer.markAt(1, TraceStage::DeviceCapture, 5000000);
+		tracer.markAt(1, TraceStage::Detected, 5250000);
+		tracer.markAt(1, TraceStage::Rendered, 9000000);
+
+		std::vector<TraceRecord> records;
+		tracer.collect(records);
+		std::ostringstream os;
+		writeChromeTrace(os, records);
+		std::string json = os.str();
+		CHECK(json.find("\"traceEvents\"") != std::string::npos);
+		CHECK(countOf(json, "\"ph\": \"i\"") == 3);
+		CHECK(countOf(json, "\"ph\": \"X\"") == 2);
+		CHECK(json.find("\"name\": \"DeviceCapture -> Detected\", \"ph\": \"X\", \"ts\": 0.000, \"dur\": 250.000") != std::string::npos);
+		CHECK(countOf(json, "{") == countOf(json, "}"));
+
+		std::ostringstream report;
+		writeLatencyReport(report, computeLatencyStats(records));
+		CHECK(report.str().find("Detected       -> Rendered") != std::string::npos);
+	}
+
+	void put16(std::vector<uint8_t>& v, uint32_t x) {
+		v.push_back(static_cast<uint8_t>(x));
+		v.push_back(static_cast<uint8_t>(x >> 8));
+	}
+
+	void put32(std::vector<uint8_t>& v, uint32_t x) {
+		put16(v, x & 0xFFFF);
+		put16(v, x >> 16);
+	}
+
+	// 16 位立体声 WAV：低频背景上每 100 ms 一次 5 ms 的 12 kHz 短脉冲
+	std::string writeBurstWav(uint32_t rate, uint32_t frames) {
+		const float kPi = 3.14159265f;
+		std::vector<uint8_t> wav;
+		wav.insert(wav.end(), { 'R', 'I', 'F', 'F' });
+		put32(wav, 36 + frames * 4);
+		wav.insert(wav.end(), { 'W', 'A', 'V', 'E', 'f', 'm', 't', ' ' });
+		put32(wav, 16);
+		put16(wav, kWaveFormatPcm);
+		put16(wav, 2);
+		put32(wav, rate);
+		put32(wav, rate * 4);
+		put16(wav, 4);
+		put16(wav, 16);
+		wav.insert(wav.end(), { 'd', 'a', 't', 'a' });
+		put32(wav, frames * 4);
+		for (uint32_t i = 0; i < frames; ++i) {
+			float t = static_cast<float>(i) / rate;
+			float v = 0.2f * std::sin(2.0f * kPi * 220.0f * t);
+			if (i % (rate / 10) < rate / 200) v += 0.4f * std::sin(2.0f * kPi * 12000.0f * t);
+			int16_t s = static_cast<int16_t>(std::lround(v * 32767.0f));
+			put16(wav, static_cast<uint16_t>(s));
+			put16(wav, static_cast<uint16_t>(s / 2));
+		}
+		std::string path = "LatencyTraceTest_bursts.wav";
+		std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(wav.data()), wav.size());
+		return path;
+	}
+
+	// 文件驱动：捕获线程按包回放 WAV 并以流时间作为设备时钟，分析线程经 SpscRing 取出后记录后续阶段
+	void testFileDrivenPipeline() {
+		const uint32_t kRate = 48000;
+		const uint32_t kPacket = 480;
+		std::string path = writeBurstWav(kRate, kRate);
+
+		StreamFormat fmt;
+		std::vector<uint8_t> data;
+		CHECK(readWavFile(path, fmt, data));
+		std::remove(path.c_str());
+		if (data.empty()) return;
+
+		DetectorPipeline pipeline;
+		CHECK(pipeline.configure(fmt, 256, 128, DetectorParams(), kPacket));
+
+		std::atomic<uint64_t> fakeNow{ 0 };
+		LatencyTracer tracer;
+		tracer.setClock([&]() { return fakeNow.fetch_add(1000); });
+
+		SpscRing<uint64_t> queue(1024);
+		std::atomic<bool> done{ false };
+		uint64_t detected = 0;
+		std::thread consumer([&]() {
+			while (true) {
+				uint64_t* id = queue.front();
+				if (!id) {
+					if (done.load()) {
+						if (queue.empty()) break;
+						continue;
+					}
+					std::this_thread::yield();
+					continue;
+				}
+				uint64_t eventId = *id;
+				queue.pop();
+				tracer.mark(eventId, TraceStage::Dequeued);
+				tracer.mark(eventId, TraceStage::Located);
+				tracer.mark(eventId, TraceStage::Posted);
+				tracer.mark(eventId, TraceStage::Rendered);
+			}
+		});
+
+		const uint32_t totalFrames = static_cast<uint32_t>(data.size() / fmt.blockAlign);
+		for (uint32_t pos = 0; pos < totalFrames; pos += kPacket) {
+			uint32_t frames = std::min(kPacket, totalFrames - pos);
+			// 设备时间戳：数据包首样本的流时间
+			uint64_t deviceNs = static_cast<uint64_t>(pos) * 1000000000ull / kRate;
+			fakeNow.store(deviceNs + 2000000);
+			const AnalyzedFrame* strongest = pipeline.processPacket(data.data() + static_cast<size_t>(pos) * fmt.blockAlign, frames, false);
+			if (!strongest) continue;
+			tracer.markAt(strongest->offset, TraceStage::DeviceCapture, deviceNs);
+			tracer.mark(strongest->offset, TraceStage::Detected);
+			if (uint64_t* slot = queue.acquire()) {
+				*slot = strongest->offset;
+				queue.publish();
+			}
+			++detected;
+		}
+		done.store(true);
+		consumer.join();
+
+		CHECK(detected >= 10);  // 每 100 ms 一次脉冲
+		std::vector<TraceRecord> records;
+		tracer.collect(records);
+		CHECK(records.size() == detected * 6);
+		CHECK(tracer.droppedCount() == 0);
+
+		std::vector<LatencyStats> stats = computeLatencyStats(records);
+		const LatencyStats* total = findStats(stats, TraceStage::DeviceCapture, TraceStage::Rendered);
+		CHECK(total && total->count == detected);
+		const LatencyStats* detect = findStats(stats, TraceStage::DeviceCapture, TraceStage::Detected);
+		CHECK(detect && detect->count == detected && detect->p50Ms >= 2.0);
+		for (size_t s = 0; s + 1 < static_cast<size_t>(TraceStage::Count); ++s) {
+			CHECK(findStats(stats, static_cast<TraceStage>(s), static_cast<TraceStage>(s + 1)) != nullptr);
+		}
+	}
+}
+
+int main() {
+	testPercentiles();
+	testMissingStages();
+	testThreadRings();
+	testChromeTrace();
+	testFileDrivenPipeline();
+	return testResult("LatencyTraceTest");
+}
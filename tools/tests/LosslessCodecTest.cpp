@@ -0,0 +1,282 @@
+﻿// LosslessCodec：各采样格式逐字节往返（含非有限浮点与 -0）、立体声去相关、按帧定位、无索引文件的扫描恢复与压缩率，
+// 以及损坏的文件头、索引与块数据（不按损坏的长度分配内存，解码不越界、不发生有符号溢出）
+#include "LosslessCodec.h"
+#include "TestCheck.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+	const uint32_t kRate = 48000;
+
+	StreamFormat makeFormat(SampleType type, uint32_t channels) {
+		StreamFormat f;
+		f.type = type;
+		f.channels = channels;
+		f.sampleRate = kRate;
+		uint32_t bytes = type == SampleType::Int16 ? 2 : type == SampleType::Int24 ? 3 : 4;
+		f.blockAlign = bytes * channels;
+		return f;
+	}
+
+	// 正弦 + 噪声，声道间相位不同；exactFloat 时浮点量化到 16 位精度
+	std::vector<uint8_t> makePcm(const StreamFormat& f, size_t frames, float noise, bool exactFloat, uint32_t seed) {
+		std::mt19937 rng(seed);
+		std::normal_distribution<float> n(0.0f, noise);
+		std::vector<uint8_t> pcm(frames * f.blockAlign);
+		uint32_t bps = f.blockAlign / f.channels;
+		for (size_t i = 0; i < frames; ++i) {
+			for (uint32_t c = 0; c < f.channels; ++c) {
+				float v = 0.5f * std::sin(2.0f * 3.14159265f * 440.0f * i / kRate + 0.3f * c) + n(rng);
+				v = std::max(-1.0f, std::min(v, 0.999f));
+				uint8_t* p = &pcm[(i * f.channels + c) * bps];
+				switch (f.type) {
+				case SampleType::Int16: {
+					int16_t s = static_cast<int16_t>(v * 32767.0f);
+					std::memcpy(p, &s, 2);
+					break;
+				}
+				case SampleType::Int24: {
+					int32_t s = static_cast<int32_t>(v * 8388607.0f);
+					p[0] = static_cast<uint8_t>(s);
+					p[1] = static_cast<uint8_t>(s >> 8);
+					p[2] = static_cast<uint8_t>(s >> 16);
+					break;
+				}
+				case SampleType::Int32: {
+					int32_t s = static_cast<int32_t>(v * 2147483000.0f);
+					std::memcpy(p, &s, 4);
+					break;
+				}
+				default: {
+					if (exactFloat) v = std::round(v * 32768.0f) / 32768.0f;
+					std::memcpy(p, &v, 4);
+					break;
+				}
+				}
+			}
+		}
+		return pcm;
+	}
+
+	size_t roundTrip(const StreamFormat& f, const std::vector<uint8_t>& pcm, const LosslessConfig& config, const char* name) {
+		const std::string path = std::string("LosslessCodecTest_") + name + ".aclc";
+		CHECK(encodeLosslessFile(path, f, pcm.data(), pcm.size(), config));
+		LosslessDecoder decoder;
+		std::string error;
+		CHECK(decoder.open(path, &error));
+		CHECK(decoder.hadIndex());
+		CHECK(decoder.totalFrames() == pcm.size() / f.blockAlign);
+		std::vector<uint8_t> out(pcm.size());
+		CHECK(decoder.read(out.data(), decoder.totalFrames() + 10) == decoder.totalFrames());
+		if (out != pcm) {
+			std::fprintf(stderr, "round trip mismatch: %s\n", name);
+			CHECK(out == pcm);
+		}
+		std::ifstream ifs(path, std::ios::binary | std::ios::ate);
+		size_t size = static_cast<size_t>(ifs.tellg());
+		std::remove(path.c_str());
+		return size;
+	}
+
+	void testFormats() {
+		LosslessConfig config;
+		const SampleType types[] = { SampleType::Int16, SampleType::Int24, SampleType::Int32, SampleType::Float32 };
+		const uint32_t channelCounts[] = { 1, 2, 6 };
+		for (SampleType type : types) {
+			for (uint32_t channels : channelCounts) {
+				StreamFormat f = makeFormat(type, channels);
+				std::vector<uint8_t> pcm = makePcm(f, 10000, 0.01f, false, channels);  // 最后一块不满
+				roundTrip(f, pcm, config, sampleTypeName(type));
+			}
+		}
+
+		// 静音、全幅方波与单帧
+		StreamFormat f16 = makeFormat(SampleType::Int16, 2);
+		roundTrip(f16, std::vector<uint8_t>(4096 * 4, 0), config, "silence");
+		std::vector<uint8_t> square(5000 * 4);
+		for (size_t i = 0; i < square.size() / 2; ++i) {
+			int16_t s = (i / 50) % 2 ? 32767 : -32768;
+			std::memcpy(&square[i * 2], &s, 2);
+		}
+		roundTrip(f16, square, config, "square");
+		roundTrip(f16, std::vector<uint8_t>{ 1, 2, 3, 4 }, config, "one_frame");
+
+		// 浮点特殊值：-0、非规格化数、无穷与 NaN 只能按位模式编码
+		StreamFormat ff = makeFormat(SampleType::Float32, 2);
+		std::vector<uint8_t> special = makePcm(ff, 3000, 0.0f, true, 9);
+		const float values[] = { -0.0f, std::numeric_limits<float>::denorm_min(), std::numeric_limits<float>::infinity(),
+			-std::numeric_limits<float>::infinity(), std::numeric_limits<float>::quiet_NaN(), 1e30f, -1e-30f };
+		for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); ++i) std::memcpy(&special[i * 40 + 4], &values[i], 4);
+		roundTrip(ff, special, config, "float_special");
+
+		// 分块与阶数参数
+		LosslessConfig small;
+		small.blockFrames = 333;
+		small.maxLpcOrder = 32;
+		roundTrip(makeFormat(SampleType::Int24, 2), makePcm(makeFormat(SampleType::Int24, 2), 2000, 0.001f, false, 3), small, "small_blocks");
+	}
+
+	// 压缩率：16 位精度的浮点立体声（混音器输出的常见情况）与带噪声的 16 位
+	void testRatio() {
+		LosslessConfig config;
+		StreamFormat ff = makeFormat(SampleType::Float32, 2);
+		std::vector<uint8_t> exact = makePcm(ff, 48000, 0.001f, true, 1);
+		size_t size = roundTrip(ff, exact, config, "ratio_float");
+		double ratio = static_cast<double>(size) / exact.size();
+		std::printf("float32 (16-bit content): ratio %.3f\n", ratio);
+		CHECK(ratio < 0.35);
+
+		StreamFormat f16 = makeFormat(SampleType::Int16, 2);
+		std::vector<uint8_t> pcm = makePcm(f16, 48000, 0.001f, false, 2);
+		size = roundTrip(f16, pcm, config, "ratio_int16");
+		ratio = static_cast<double>(size) / pcm.size();
+		std::printf("int16: ratio %.3f\n", ratio);
+		CHECK(ratio < 0.7);
+
+		// 任意浮点（非整数倍）仍然无损，且不应明显膨胀
+		std::vector<uint8_t> raw = makePcm(ff, 48000, 0.01f, false, 3);
+		size = roundTrip(ff, raw, config, "ratio_float_raw");
+		std::printf("float32 (arbitrary): ratio %.3f\n", static_cast<double>(size) / raw.size());
+		CHECK(size < raw.size() * 1.05);
+	}
+
+	void testSeek() {
+		StreamFormat f = makeFormat(SampleType::Int16, 2);
+		std::vector<uint8_t> pcm = makePcm(f, 20000, 0.01f, false, 4);
+		LosslessConfig config;
+		config.blockFrames = 1024;
+		const std::string path = "LosslessCodecTest_seek.aclc";
+		CHECK(encodeLosslessFile(path, f, pcm.data(), pcm.size(), config));
+		LosslessDecoder decoder;
+		CHECK(decoder.open(path));
+		const uint64_t positions[] = { 0, 1, 1023, 1024, 1500, 19999, 5000, 100 };
+		std::vector<uint8_t> out(300 * f.blockAlign);
+		for (uint64_t pos : positions) {
+			CHECK(decoder.seek(pos));
+			size_t n = decoder.read(out.data(), 300);
+			size_t expected = static_cast<size_t>(std::min<uint64_t>(300, 20000 - pos));
+			CHECK(n == expected);
+			CHECK(std::memcmp(out.data(), &pcm[pos * f.blockAlign], n * f.blockAlign) == 0);
+		}
+		CHECK(decoder.seek(20000));
+		CHECK(decoder.read(out.data(), 1) == 0);
+		CHECK(!decoder.seek(20001));
+		std::remove(path.c_str());
+	}
+
+	// 没有 finish()（进程被结束）：检查点之前的块可按块头扫描恢复，末尾不完整的块被忽略
+	void testRecovery() {
+		StreamFormat f = makeFormat(SampleType::Float32, 2);
+		std::vector<uint8_t> pcm = makePcm(f, 10000, 0.01f, true, 5);
+		LosslessConfig config;
+		config.blockFrames = 2048;
+		const std::string path = "LosslessCodecTest_killed.aclc";
+		{
+			std::ofstream out(path, std::ios::binary | std::ios::trunc);
+			LosslessEncoder encoder;
+			CHECK(encoder.open(out, f, config));
+			CHECK(encoder.write(pcm.data(), 7000 * f.blockAlign + 3));  // 不是整数个采样帧
+			CHECK(encoder.checkpoint());   // 6144 帧的整块 + 856 帧的短块
+			CHECK(encoder.framesWritten() == 7000);
+			const char partial[] = "\x40\x00\x00\x00\x00\x08\x00\x00garbage";
+			out.write(partial, sizeof(partial) - 1);  // 写到一半的块
+		}
+		LosslessDecoder decoder;
+		CHECK(decoder.open(path));
+		CHECK(!decoder.hadIndex());
+		CHECK(decoder.totalFrames() == 7000);
+		std::vector<uint8_t> out(7000 * f.blockAlign);
+		CHECK(decoder.read(out.data(), 7000) == 7000);
+		CHECK(std::memcmp(out.data(), pcm.data(), out.size()) == 0);
+		std::remove(path.c_str());
+
+		CHECK(!decoder.open("LosslessCodecTest_missing.aclc"));
+	}
+
+	std::vector<uint8_t> readAll(const std::string& path) {
+		std::ifstream ifs(path, std::ios::binary);
+		return std::vector<uint8_t>((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+	}
+
+	void writeAll(const std::string& path, const std::vector<uint8_t>& bytes) {
+		std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+		ofs.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+	}
+
+	void put32At(std::vector<uint8_t>& v, size_t at, uint32_t x) {
+		for (int i = 0; i < 4; ++i) v[at + i] = static_cast<uint8_t>(x >> (8 * i));
+	}
+
+	void testCorruption() {
+		StreamFormat f = makeFormat(SampleType::Int16, 2);
+		std::vector<uint8_t> pcm = makePcm(f, 10000, 0.01f, false, 6);
+		LosslessConfig config;
+		config.blockFrames = 1024;
+		const std::string path = "LosslessCodecTest_corrupt.aclc";
+		CHECK(encodeLosslessFile(path, f, pcm.data(), pcm.size(), config));
+		const std::vector<uint8_t> good = readAll(path);
+		CHECK(good.size() > 40);
+		LosslessDecoder decoder;
+		std::string error;
+
+		// 文件头中的块长、声道数超出上限：拒绝打开，不按其分配工作缓冲
+		std::vector<uint8_t> bad = good;
+		put32At(bad, 20, 0x80000000u);
+		writeAll(path, bad);
+		CHECK(!decoder.open(path, &error));
+		bad = good;
+		bad[8] = 0xFF;
+		bad[9] = 0x00;   // 255 声道，blockAlign 与之一致
+		put32At(bad, 16, 255 * 2);
+		writeAll(path, bad);
+		CHECK(!decoder.open(path, &error));
+
+		// 索引条目数超出文件：不按其分配，改为扫描块头
+		uint64_t indexOffset = 0;
+		for (int i = 7; i >= 0; --i) indexOffset = (indexOffset << 8) | good[32 + i];
+		CHECK(indexOffset + 8 <= good.size());
+		bad = good;
+		put32At(bad, static_cast<size_t>(indexOffset) + 4, 0xFFFFFFFFu);
+		writeAll(path, bad);
+		CHECK(decoder.open(path, &error));
+		CHECK(!decoder.hadIndex());
+		CHECK(decoder.totalFrames() == 10000);
+		std::remove(path.c_str());
+
+		// 块数据逐位翻转：解码返回成功或失败均可，但不得越界或溢出（配合 -fsanitize=address,undefined 运行）
+		const SampleType types[] = { SampleType::Int16, SampleType::Int32, SampleType::Float32 };
+		std::mt19937 rng(7);
+		for (SampleType type : types) {
+			StreamFormat bf = makeFormat(type, 2);
+			std::vector<uint8_t> blockPcm = makePcm(bf, 1024, 0.01f, type == SampleType::Float32, 8);
+			LosslessBlockCodec codec;
+			CHECK(codec.configure(bf, config));
+			std::vector<uint8_t> encoded;
+			codec.encode(blockPcm.data(), 1024, encoded);
+			std::vector<uint8_t> out(blockPcm.size());
+			CHECK(codec.decode(encoded.data(), encoded.size(), 1024, out.data()) && out == blockPcm);
+			for (int trial = 0; trial < 2000; ++trial) {
+				std::vector<uint8_t> flipped = encoded;
+				const int flips = 1 + trial % 3;
+				for (int k = 0; k < flips; ++k) flipped[rng() % flipped.size()] ^= static_cast<uint8_t>(1u << (rng() % 8));
+				codec.decode(flipped.data(), flipped.size(), 1024, out.data());
+			}
+		}
+	}
+}
+
+int main() {
+	testFormats();
+	testRatio();
+	testSeek();
+	testRecovery();
+	testCorruption();
+	return testResult("LosslessCodecTest");
+}
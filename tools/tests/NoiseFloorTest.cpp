@@ -0,0 +1,139 @@
+﻿// 自适应噪声底：持续的宽带嘶声不再逐包触发，叠加其上的瞬态仍逐个检出；嘶声停止后噪声底迅速回落；
+// 跳过静音帧与逐帧分析全零帧的结果相同
+#include "DetectorPipeline.h"
+#include "NoiseFloor.h"
+#include "TestCheck.h"
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+	const uint32_t kRate = 48000;
+	const uint32_t kFrameSize = 256;
+	const uint32_t kHopSize = 128;
+	const uint32_t kPacket = 480;
+
+	StreamFormat stereoF32() {
+		StreamFormat fmt;
+		fmt.type = SampleType::Float32;
+		fmt.channels = 2;
+		fmt.sampleRate = kRate;
+		fmt.blockAlign = 8;
+		return fmt;
+	}
+
+	// 交错 float32 立体声：[0, hissEnd) 为持续的白噪声嘶声，burstStarts 处叠加衰减的宽带猝发（模拟枪声）
+	std::vector<float> makeScene(uint32_t frames, uint32_t hissEnd, float hiss, const std::vector<uint32_t>& burstStarts,
+		float burst, uint32_t seed) {
+		std::mt19937 rng(seed);
+		std::normal_distribution<float> gauss(0.0f, 1.0f);
+		std::vector<float> pcm(frames * 2, 0.0f);
+		for (uint32_t i = 0; i < hissEnd && i < frames; ++i) {
+			pcm[2 * i] = hiss * gauss(rng);
+			pcm[2 * i + 1] = hiss * gauss(rng);
+		}
+		const uint32_t length = 960;
+		for (uint32_t start : burstStarts) {
+			for (uint32_t i = 0; i < length && start + i < frames; ++i) {
+				float v = burst * gauss(rng) * std::exp(-4.0f * i / length);
+				pcm[2 * (start + i)] += v;
+				pcm[2 * (start + i) + 1] += 0.5f * v;
+			}
+		}
+		return pcm;
+	}
+
+	// 逐包实时检测，返回触发帧的位置；[silentFrom, silentTo) 内的数据包按 WASAPI 静音包送入
+	std::vector<uint64_t> detect(const std::vector<float>& pcm, const DetectorParams& params,
+		uint32_t silentFrom = 0, uint32_t silentTo = 0) {
+		DetectorPipeline pipeline;
+		pipeline.configure(stereoF32(), kFrameSize, kHopSize, params, kPacket);
+		std::vector<uint64_t> hits;
+		const uint32_t frames = static_cast<uint32_t>(pcm.size() / 2);
+		for (uint32_t pos = 0; pos < frames; pos += kPacket) {
+			uint32_t n = std::min(kPacket, frames - pos);
+			bool silent = pos >= silentFrom && pos < silentTo;
+			const AnalyzedFrame* hit = pipeline.processPacket(reinterpret_cast<const uint8_t*>(&pcm[2 * pos]), n, silent);
+			if (hit) hits.push_back(hit->offset);
+		}
+		return hits;
+	}
+
+	DetectorParams adaptiveParams() {
+		DetectorParams p;
+		p.adaptiveFloor = true;
+		return p;
+	}
+
+	void testHysteresis() {
+		TriggerHysteresis h;
+		CHECK(!h.update(0.05f, 0.1f, 0.05f));
+		CHECK(h.update(0.2f, 0.1f, 0.05f));    // 上升沿触发一次
+		CHECK(!h.update(0.5f, 0.1f, 0.05f));   // 持续期间不再触发
+		CHECK(!h.update(0.07f, 0.1f, 0.05f));  // 未回落到释放阈值以下
+		CHECK(!h.update(0.2f, 0.1f, 0.05f));
+		CHECK(!h.update(0.01f, 0.1f, 0.05f));  // 释放
+		CHECK(h.update(0.1f, 0.1f, 0.05f));
+	}
+
+	// 噪声底跟踪稳态功率，超过噪声底 floorMarginDb 的频点才计数
+	void testFloorTracking() {
+		DetectorParams p = adaptiveParams();
+		NoiseFloor floor;
+		floor.prepare(8);
+		std::vector<float> power(8, 1e-6f);
+		uint64_t offset = 0;
+		for (int i = 0; i < 2000; ++i, offset += kHopSize)
+			CHECK(floor.countAbove(power.data(), power.size(), 0.0f, offset, kRate, kFrameSize, p) == 0);
+		CHECK_NEAR(floor.floor()[3], 1e-6, 1e-9);
+		power[2] = 1e-6f * std::pow(10.0f, (p.floorMarginDb + 1.0f) / 10.0f);
+		power[5] = 1e-6f * std::pow(10.0f, (p.floorMarginDb - 1.0f) / 10.0f);
+		CHECK(floor.countAbove(power.data(), power.size(), 0.0f, offset, kRate, kFrameSize, p) == 1);
+		// 绝对阈值仍然生效
+		offset += kHopSize;
+		CHECK(floor.countAbove(power.data(), power.size(), 1.0f, offset, kRate, kFrameSize, p) == 0);
+	}
+
+	// 持续嘶声：固定阈值几乎每个数据包都触发，自适应噪声底只剩猝发；每个猝发都被检出且只产生一个事件
+	void testHissSuppressed() {
+		std::vector<uint32_t> bursts;
+		for (uint32_t t = kRate * 3; t + kRate / 2 < kRate * 10; t += kRate / 2) bursts.push_back(t);
+		std::vector<float> pcm = makeScene(kRate * 10, kRate * 10, 0.01f, bursts, 0.3f, 1);
+
+		const size_t packets = pcm.size() / 2 / kPacket;
+		std::vector<uint64_t> fixed = detect(pcm, DetectorParams());
+		std::vector<uint64_t> adaptive = detect(pcm, adaptiveParams());
+		CHECK(fixed.size() > packets * 9 / 10);
+		CHECK(adaptive.size() >= bursts.size() && adaptive.size() <= bursts.size() + 2);
+		for (uint32_t start : bursts) {
+			size_t n = 0;
+			for (uint64_t hit : adaptive) n += hit + kFrameSize > start && hit < start + 960;
+			CHECK(n == 1);
+		}
+		std::printf("hiss scene: %zu packets, %zu burst(s), fixed %zu event(s), adaptive %zu event(s)\n",
+			packets, bursts.size(), fixed.size(), adaptive.size());
+	}
+
+	// 嘶声停止（之后为静音包）后噪声底迅速回落，比嘶声弱的猝发也能检出；
+	// 跳过静音帧的实时路径与逐帧分析全零数据的结果相同
+	void testRecoveryAndSilence() {
+		std::vector<uint32_t> bursts = { kRate * 6, kRate * 6 + kRate / 2 };
+		std::vector<float> pcm = makeScene(kRate * 7, kRate * 4, 0.01f, bursts, 0.003f, 2);
+		std::vector<uint64_t> analyzed = detect(pcm, adaptiveParams());
+		size_t late = 0;
+		for (uint64_t hit : analyzed) late += hit + kFrameSize > kRate * 6;
+		CHECK(late == bursts.size());
+
+		// 4 s 到 6 s 之间全为静音：按静音包送入时帧被跳过，噪声底与迟滞仍按全零帧推进
+		std::vector<uint64_t> skipped = detect(pcm, adaptiveParams(), kRate * 4 + kPacket * 2, kRate * 6 - kPacket * 2);
+		CHECK(skipped == analyzed);
+	}
+}
+
+int main() {
+	testHysteresis();
+	testFloorTracking();
+	testHissSuppressed();
+	testRecoveryAndSilence();
+	return testResult("NoiseFloorTest");
+}
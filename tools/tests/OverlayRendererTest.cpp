@@ -0,0 +1,211 @@
+﻿// OverlayRenderer：与金样图像逐像素比较（允许 ±1 的舍入差），并检查对称性、峰值覆盖率、脏区清空与外部缓冲跨度
+// 金样为 PAM（RGB_ALPHA，预乘）；渲染逻辑有意改变时用 --update-golden 重新生成并随提交检入
+#include "OverlayRenderer.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef AC_GOLDEN_DIR
+#define AC_GOLDEN_DIR "golden"
+#endif
+
+namespace {
+	const float kRadius = 40.0f;
+	const float kPenWidth = 3.0f;
+	bool g_updateGolden = false;
+
+	uint8_t channel(uint32_t p, int shift) { return static_cast<uint8_t>((p >> shift) & 0xFF); }
+
+	void writePam(const std::string& path, const OverlayRenderer& r) {
+		std::ofstream ofs(path, std::ios::binary);
+		ofs << "P7\nWIDTH " << r.size() << "\nHEIGHT " << r.size() << "\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n";
+		for (int y = 0; y < r.size(); ++y) {
+			for (int x = 0; x < r.size(); ++x) {
+				uint32_t p = r.pixel(x, y);
+				const char px[4] = { static_cast<char>(channel(p, 16)), static_cast<char>(channel(p, 8)),
+					static_cast<char>(channel(p, 0)), static_cast<char>(channel(p, 24)) };
+				ofs.write(px, 4);
+			}
+		}
+	}
+
+	bool readPam(const std::string& path, int& size, std::vector<uint8_t>& rgba) {
+		std::ifstream ifs(path, std::ios::binary);
+		if (!ifs.is_open()) return false;
+		std::string line;
+		int width = 0, height = 0;
+		while (std::getline(ifs, line) && line != "ENDHDR") {
+			std::istringstream ls(line);
+			std::string key;
+			ls >> key;
+			if (key == "WIDTH") ls >> width;
+			else if (key == "HEIGHT") ls >> height;
+		}
+		if (width <= 0 || width != height) return false;
+		size = width;
+		rgba.resize(static_cast<size_t>(width) * height * 4);
+		ifs.read(reinterpret_cast<char*>(rgba.data()), rgba.size());
+		return static_cast<size_t>(ifs.gcount()) == rgba.size();
+	}
+
+	// 与金样比较：每个通道允许 ±1（不同编译器的浮点舍入），并报告差异像素数
+	void checkGolden(const char* name, const OverlayRenderer& r) {
+		std::string path = std::string(AC_GOLDEN_DIR) + "/" + name + ".pam";
+		if (g_updateGolden) {
+			writePam(path, r);
+			std::printf("updated %s\n", path.c_str());
+			return;
+		}
+		int size = 0;
+		std::vector<uint8_t> golden;
+		bool loaded = readPam(path, size, golden);
+		CHECK(loaded);
+		CHECK(size == r.size());
+		if (!loaded || size != r.size()) return;
+
+		int mismatched = 0;
+		for (int y = 0; y < size; ++y) {
+			for (int x = 0; x < size; ++x) {
+				uint32_t p = r.pixel(x, y);
+				const uint8_t* g = &golden[(static_cast<size_t>(y) * size + x) * 4];
+				const int shifts[4] = { 16, 8, 0, 24 };
+				for (int c = 0; c < 4; ++c) {
+					if (std::abs(channel(p, shifts[c]) - g[c]) > 1) {
+						++mismatched;
+						break;
+					}
+				}
+			}
+		}
+		if (mismatched) std::fprintf(stderr, "%s: %d pixel(s) differ from golden\n", name, mismatched);
+		CHECK(mismatched == 0);
+	}
+
+	uint32_t maxAlpha(const OverlayRenderer& r) {
+		uint32_t m = 0;
+		for (int y = 0; y < r.size(); ++y)
+			for (int x = 0; x < r.size(); ++x) m = std::max(m, r.pixel(x, y) >> 24);
+		return m;
+	}
+
+	bool allClear(const OverlayRenderer& r) {
+		for (int y = 0; y < r.size(); ++y)
+			for (int x = 0; x < r.size(); ++x)
+				if (r.pixel(x, y)) return false;
+		return true;
+	}
+
+	void testSingleArc() {
+		OverlayRenderer r;
+		r.configure(kRadius, kPenWidth);
+		CHECK(r.size() == OverlayRenderer::surfaceSize(kRadius, kPenWidth));
+		CHECK(allClear(r));
+
+		r.drawArc(0.0f, OverlayColor(255, 255, 255, 255), 1.0f);
+		// 正上方的弧线中心完全覆盖：圆心 (pen/2 + R)，弧线在 y = pen/2 处
+		int c = static_cast<int>(kPenWidth / 2 + kRadius);
+		CHECK(r.pixel(c, 1) == 0xFFFFFFFFu);
+		CHECK(r.pixel(c, c) == 0);
+		checkGolden("arc_0", r);
+
+		// 预乘：半透明红色的 RGB 不超过 alpha
+		r.clear();
+		CHECK(allClear(r));
+		r.drawArc(45.0f, OverlayColor(255, 255, 0, 0), 0.5f);
+		CHECK(maxAlpha(r) == 128);
+		for (int y = 0; y < r.size(); ++y)
+			for (int x = 0; x < r.size(); ++x) CHECK(channel(r.pixel(x, y), 16) <= channel(r.pixel(x, y), 24));
+	}
+
+	// ±θ 的弧形关于竖直中线镜像对称
+	void testSymmetry() {
+		OverlayRenderer left, right;
+		left.configure(kRadius, kPenWidth);
+		right.configure(kRadius, kPenWidth);
+		left.drawArc(-30.0f, OverlayColor(255, 255, 255, 255), 1.0f);
+		right.drawArc(30.0f, OverlayColor(255, 255, 255, 255), 1.0f);
+		const int mirror = static_cast<int>(2 * (kPenWidth / 2 + kRadius)) - 1;
+		int worst = 0;
+		for (int y = 0; y < left.size(); ++y) {
+			for (int x = 0; x <= mirror; ++x) {
+				int a = left.pixel(x, y) >> 24;
+				int b = right.pixel(mirror - x, y) >> 24;
+				worst = std::max(worst, std::abs(a - b));
+			}
+		}
+		CHECK(worst <= 1);
+	}
+
+	// 合成：三个事件后残影按年龄衰减，阈值内的角度不留残影，文字在左上区域
+	void testCompose() {
+		OverlayRenderer r;
+		r.configure(kRadius, kPenWidth);
+		r.composeEvent(-60.0f, 1000);
+		r.composeEvent(5.0f, 1100);   // 低于阈值，不加入残影
+		r.composeEvent(45.0f, 1150);
+		CHECK(r.trailBins(1150) == 2);
+		checkGolden("compose", r);
+
+		// 最长残影 (-60°) 约 0.73 秒后衰减到不可见
+		r.composeEvent(0.0f, 3000);
+		CHECK(r.trailBins(3000) == 0);
+
+		// 实时弧形在 liveDuration 之后消失，画面为空
+		CHECK(r.render(3000 + 1000));
+		CHECK(!r.render(3000 + 1001));
+		CHECK(allClear(r));
+
+		r.composeEvent(20.0f, 5000);
+		r.reset();
+		CHECK(r.trailBins(5000) == 0);
+		CHECK(!r.render(5000));
+		CHECK(allClear(r));
+	}
+
+	void testText() {
+		OverlayRenderer r;
+		r.configure(kRadius, kPenWidth);
+		r.drawText(2, 2, "Angle: -90\xC2\xB0", OverlayColor(255, 255, 255, 0), 1);
+		checkGolden("text", r);
+		// '-' 的横线位于第 4 行
+		int dash = 2 + 7 * 6;
+		CHECK(r.pixel(dash, 2 + 3) == 0xFFFFFF00u);
+		CHECK(r.pixel(dash, 2 + 2) == 0);
+	}
+
+	// 外部缓冲（模拟 DIB section）：行跨度大于画布宽度时不写入行尾填充
+	void testExternalStride() {
+		const int size = OverlayRenderer::surfaceSize(kRadius, kPenWidth);
+		const size_t stride = static_cast<size_t>(size) + 7;
+		std::vector<uint32_t> buffer(stride * size, 0xDEADBEEFu);
+		OverlayRenderer r;
+		r.configure(kRadius, kPenWidth, buffer.data(), stride * sizeof(uint32_t));
+		CHECK(r.pixels() == buffer.data());
+		for (int i = 0; i < 50; ++i) r.composeEvent(static_cast<float>(i * 3 - 75), 1000 + i * 10);
+		r.clear();
+		for (int y = 0; y < size; ++y) {
+			for (size_t x = 0; x < stride; ++x) {
+				uint32_t expected = x < static_cast<size_t>(size) ? 0u : 0xDEADBEEFu;
+				if (buffer[y * stride + x] != expected) {
+					CHECK(buffer[y * stride + x] == expected);
+					return;
+				}
+			}
+		}
+	}
+}
+
+int main(int argc, char** argv) {
+	g_updateGolden = argc > 1 && std::strcmp(argv[1], "--update-golden") == 0;
+	testSingleArc();
+	testSymmetry();
+	testCompose();
+	testText();
+	testExternalStride();
+	return testResult("OverlayRendererTest");
+}
@@ -0,0 +1,123 @@
+﻿// PcmKernels：各指令集实现与标量实现对比（逐位一致或在约定误差内），含 NaN / Inf / 饱和边界
+#include "PcmKernels.h"
+#include "TestCheck.h"
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace {
+	const size_t kCount = 1027;  // 非向量宽度整数倍，覆盖尾部
+
+	bool sameBits(float a, float b) {
+		return std::memcmp(&a, &b, sizeof(float)) == 0;
+	}
+
+	void compare(const PcmKernels& ref, const PcmKernels& k, const std::vector<float>& f, const std::vector<int16_t>& s16) {
+		const size_t n = f.size();
+		std::vector<float> refL(n), refR(n), outL(n), outR(n);
+		std::vector<int16_t> refS(n), outS(n);
+
+		// 解交错（1、2、6 声道）
+		const uint32_t channels[] = { 1, 2, 6 };
+		for (uint32_t ch : channels) {
+			size_t frames = n / ch;
+			ref.deinterleaveS16(s16.data(), ch, frames, refL.data(), refR.data());
+			k.deinterleaveS16(s16.data(), ch, frames, outL.data(), outR.data());
+			CHECK(std::memcmp(refL.data(), outL.data(), frames * sizeof(float)) == 0);
+			CHECK(std::memcmp(refR.data(), outR.data(), frames * sizeof(float)) == 0);
+			ref.deinterleaveF32(f.data(), ch, frames, refL.data(), refR.data());
+			k.deinterleaveF32(f.data(), ch, frames, outL.data(), outR.data());
+			CHECK(std::memcmp(refL.data(), outL.data(), frames * sizeof(float)) == 0);
+			CHECK(std::memcmp(refR.data(), outR.data(), frames * sizeof(float)) == 0);
+		}
+
+		// int16 <-> float 逐位一致（含 NaN、±Inf 与超出满量程的值）
+		ref.s16ToFloat(s16.data(), n, refL.data());
+		k.s16ToFloat(s16.data(), n, outL.data());
+		CHECK(std::memcmp(refL.data(), outL.data(), n * sizeof(float)) == 0);
+		ref.floatToS16(f.data(), n, refS.data());
+		k.floatToS16(f.data(), n, outS.data());
+		size_t mismatches = 0;
+		for (size_t i = 0; i < n; ++i) mismatches += (refS[i] != outS[i]);
+		CHECK(mismatches == 0);
+
+		// 峰值逐位一致，平方和相对误差 < 1e-5（只用有限值）
+		std::vector<float> finite(f);
+		for (float& v : finite) if (!std::isfinite(v)) v = 0.25f;
+		CHECK(sameBits(ref.peak(finite.data(), n), k.peak(finite.data(), n)));
+		float refSum = ref.sumSquares(finite.data(), n);
+		CHECK_NEAR(k.sumSquares(finite.data(), n), refSum, 1e-5 * refSum);
+		float refSl = 0, refSr = 0, sl = 0, sr = 0;
+		ref.downmixEnergy(finite.data(), finite.data() + 1, n - 1, refL.data(), &refSl, &refSr);
+		k.downmixEnergy(finite.data(), finite.data() + 1, n - 1, outL.data(), &sl, &sr);
+		CHECK(std::memcmp(refL.data(), outL.data(), (n - 1) * sizeof(float)) == 0);
+		CHECK_NEAR(sl, refSl, 1e-5 * refSl);
+		CHECK_NEAR(sr, refSr, 1e-5 * refSr);
+
+		// 频点声像逐位一致（f 按交错复数解释，左右错开一个数；含全零频点）
+		const size_t bins = (n - 2) / 2;
+		std::vector<float> refE(bins), outE(bins);
+		std::vector<int32_t> refI(bins), outI(bins);
+		finite[8] = finite[9] = finite[10] = finite[11] = 0.0f;
+		ref.panBins(finite.data(), finite.data() + 2, bins, 1024, refE.data(), refI.data());
+		k.panBins(finite.data(), finite.data() + 2, bins, 1024, outE.data(), outI.data());
+		CHECK(std::memcmp(refE.data(), outE.data(), bins * sizeof(float)) == 0);
+		CHECK(std::memcmp(refI.data(), outI.data(), bins * sizeof(int32_t)) == 0);
+	}
+
+	// 标量实现的声像量化：只有左声道 → 0，只有右声道 → levels - 1，等功率或全零 → 中间值
+	void testPanBins() {
+		const float left[8] = { 1.0f, 0.0f, 0.0f, 0.0f, 0.6f, 0.8f, 0.0f, 0.0f };
+		const float right[8] = { 0.0f, 0.0f, 0.0f, 2.0f, 0.8f, -0.6f, 0.0f, 0.0f };
+		float energy[4];
+		int32_t index[4];
+		PcmKernels::forIsa(PcmIsa::Scalar).panBins(left, right, 4, 1025, energy, index);
+		CHECK(index[0] == 0 && energy[0] == 1.0f);
+		CHECK(index[1] == 1024 && energy[1] == 4.0f);
+		CHECK(index[2] == 512);
+		CHECK(index[3] == 512 && energy[3] == 0.0f);
+	}
+}
+
+int main() {
+	std::mt19937 rng(99);
+	std::uniform_real_distribution<float> dist(-1.2f, 1.2f);
+	std::uniform_int_distribution<int> s16dist(-32768, 32767);
+	std::vector<float> f(kCount);
+	std::vector<int16_t> s16(kCount);
+	for (size_t i = 0; i < kCount; ++i) {
+		f[i] = dist(rng);
+		s16[i] = static_cast<int16_t>(s16dist(rng));
+	}
+
+	// 边界值：NaN、±Inf、饱和边界、舍入中点
+	const float specials[] = {
+		std::numeric_limits<float>::quiet_NaN(), -std::numeric_limits<float>::quiet_NaN(),
+		std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(),
+		1.0f, -1.0f, 32767.0f / 32768.0f, 32767.5f / 32768.0f, -32768.5f / 32768.0f,
+		0.5f / 32768.0f, 1.5f / 32768.0f, -2.5f / 32768.0f, 0.0f, -0.0f,
+	};
+	for (size_t i = 0; i < sizeof(specials) / sizeof(specials[0]); ++i) {
+		f[i * 37] = specials[i];
+		f[kCount - 1 - i] = specials[i];  // 同时落在向量主体与标量尾部
+	}
+	s16[0] = -32768;
+	s16[1] = 32767;
+
+	// 标量实现的 NaN 约定
+	int16_t nanOut = 1;
+	PcmKernels::forIsa(PcmIsa::Scalar).floatToS16(specials, 1, &nanOut);
+	CHECK(nanOut == -32768);
+
+	testPanBins();
+
+	const PcmKernels& scalar = PcmKernels::forIsa(PcmIsa::Scalar);
+	const PcmIsa isas[] = { PcmIsa::SSE2, PcmIsa::AVX2 };
+	for (PcmIsa isa : isas) {
+		if (!PcmKernels::supported(isa)) continue;
+		compare(scalar, PcmKernels::forIsa(isa), f, s16);
+	}
+	return testResult("PcmKernelsTest");
+}
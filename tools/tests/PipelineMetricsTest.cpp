@@ -0,0 +1,95 @@
+﻿// PipelineMetrics：槽位独占缓存行、多线程计数不丢失、发布后第二个映射（读取工具视角）可见
+#include "PipelineMetrics.h"
+#include "MappedFile.h"
+#include "TestCheck.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+	void testLayout() {
+		MetricsPage page;
+		for (size_t i = 0; i + 1 < MetricsPage::kMetricCount; ++i) {
+			uintptr_t a = reinterpret_cast<uintptr_t>(&page.cells[i].value);
+			uintptr_t b = reinterpret_cast<uintptr_t>(&page.cells[i + 1].value);
+			CHECK(a % 64 == 0);
+			CHECK(b - a == 64);
+		}
+		CHECK(std::strcmp(metricName(Metric::Discontinuities), "discontinuities") == 0);
+		CHECK(metricKind(Metric::ModelQueueHighWater) == MetricKind::Gauge);
+		CHECK(metricKind(Metric::RenderBusyNs) == MetricKind::TimeNs);
+		CHECK(std::strcmp(metricName(Metric::Count), "unknown") == 0);
+	}
+
+	void testConcurrentCounters() {
+		const int kThreads = 4;
+		const int kPerThread = 100000;
+		PipelineMetrics metrics;
+		std::vector<std::thread> threads;
+		for (int t = 0; t < kThreads; ++t) {
+			threads.emplace_back([&, t]() {
+				for (int i = 0; i < kPerThread; ++i) {
+					metrics.add(Metric::PacketsCaptured);
+					metrics.add(static_cast<Metric>(t), 2);
+				}
+			});
+		}
+		for (auto& th : threads) th.join();
+		CHECK(metrics.get(Metric::PacketsCaptured) == static_cast<uint64_t>(kThreads + 2) * kPerThread);
+		CHECK(metrics.get(Metric::SilentPackets) == 2u * kPerThread);
+		CHECK(metrics.get(Metric::DetectorHits) == 2u * kPerThread);
+
+		metrics.raise(Metric::ModelQueueHighWater, 5);
+		metrics.raise(Metric::ModelQueueHighWater, 3);
+		CHECK(metrics.get(Metric::ModelQueueHighWater) == 5);
+		metrics.set(Metric::ModelQueueDepth, 7);
+		metrics.set(Metric::ModelQueueDepth, 1);
+		CHECK(metrics.get(Metric::ModelQueueDepth) == 1);
+	}
+
+	// 发布前的值迁移到文件；之后的更新通过独立的只读映射可见
+	void testPublishedFile() {
+		const std::string path = "PipelineMetricsTest.stats";
+		PipelineMetrics metrics;
+		metrics.add(Metric::PacketsCaptured, 10);
+		CHECK(!metrics.isPublished());
+		CHECK(metrics.publish(path));
+		CHECK(metrics.isPublished());
+		CHECK(metrics.get(Metric::PacketsCaptured) == 10);
+
+		MappedFile view;
+		CHECK(view.openReadOnly(path));
+		CHECK(view.size() == sizeof(MetricsPage));
+		const MetricsPage* page = metricsPageFromMapping(view.data(), view.size());
+		CHECK(page != nullptr);
+		if (page) {
+			CHECK(page->metricCount == MetricsPage::kMetricCount);
+			CHECK(std::strcmp(page->names[static_cast<size_t>(Metric::RenderCount)], "render_count") == 0);
+			const auto& packets = page->cells[static_cast<size_t>(Metric::PacketsCaptured)].value;
+			CHECK(packets.load() == 10);
+			metrics.add(Metric::PacketsCaptured, 5);
+			metrics.add(Metric::Discontinuities);
+			CHECK(packets.load() == 15);
+			CHECK(page->cells[static_cast<size_t>(Metric::Discontinuities)].value.load() == 1);
+		}
+
+		// 截断或不认识的文件被拒绝
+		CHECK(metricsPageFromMapping(view.data(), 16) == nullptr);
+		std::vector<uint8_t> junk(sizeof(MetricsPage), 0);
+		CHECK(metricsPageFromMapping(junk.data(), junk.size()) == nullptr);
+		view.close();
+		std::remove(path.c_str());
+
+		MappedFile missing;
+		CHECK(!missing.openReadOnly("PipelineMetricsTest.missing"));
+	}
+}
+
+int main() {
+	testLayout();
+	testConcurrentCounters();
+	testPublishedFile();
+	return testResult("PipelineMetricsTest");
+}
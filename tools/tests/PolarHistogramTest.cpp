@@ -0,0 +1,83 @@
+﻿// PolarHistogram：惰性指数衰减、可见时长与旧版残影时长一致、能量封顶、桶数与事件数无关
+#include "PolarHistogram.h"
+#include "TestCheck.h"
+#include <cmath>
+
+namespace {
+	void testBinning() {
+		CHECK(PolarHistogram::binOf(-90.0f) == 0);
+		CHECK(PolarHistogram::binOf(0.4f) == 90);
+		CHECK(PolarHistogram::binOf(90.0f) == 180);
+		CHECK(PolarHistogram::binOf(-135.0f) == 0);   // 超出范围的角度落到边缘桶
+		CHECK(PolarHistogram::binOf(1000.0f) == 180);
+		CHECK(PolarHistogram::binAngle(PolarHistogram::binOf(-37.0f)) == -37.0f);
+	}
+
+	// 单位能量在 trailBaseDuration（正前方）/ trailMaxDuration（±90°）后降到 cutoff 以下
+	void testVisibleDuration() {
+		PolarHistogram h;
+		h.configure(0.2f, 1.0f, 1.0f / 32.0f);
+		h.add(0.0f, 1000);
+		h.add(90.0f, 1000);
+		h.add(-45.0f, 1000);  // 0.2 + 0.5 × 0.8 = 0.6 秒
+
+		const int front = PolarHistogram::binOf(0.0f);
+		const int side = PolarHistogram::binOf(90.0f);
+		const int mid = PolarHistogram::binOf(-45.0f);
+		CHECK_NEAR(h.energy(front, 1000), 1.0, 1e-6);
+		CHECK_NEAR(h.energy(front, 1100), 1.0 / std::sqrt(32.0), 1e-4);  // 半程衰减到 cutoff 的平方根
+		CHECK(h.energy(front, 1195) > 0.0f);
+		CHECK(h.energy(front, 1205) == 0.0f);
+		CHECK(h.energy(mid, 1595) > 0.0f);
+		CHECK(h.energy(mid, 1605) == 0.0f);
+		CHECK(h.energy(side, 1995) > 0.0f);
+		CHECK(h.energy(side, 2005) == 0.0f);
+		CHECK(h.activeBins(1500) == 2);
+		CHECK(h.activeBins(3000) == 0);
+	}
+
+	// 先衰减再累加；单桶能量封顶
+	void testAccumulate() {
+		PolarHistogram h;
+		h.configure(1.0f, 1.0f);
+		const int bin = PolarHistogram::binOf(30.0f);
+		h.add(30.0f, 0);
+		float half = h.energy(bin, 200);
+		h.add(30.2f, 200);
+		CHECK_NEAR(h.energy(bin, 200), half + 1.0f, 1e-5);
+
+		for (int i = 0; i < 100; ++i) h.add(30.0f, 200);
+		CHECK_NEAR(h.energy(bin, 200), h.maxEnergy, 1e-6);
+
+		// 时间戳倒退的事件不会让能量“回到过去”
+		h.add(30.0f, 100);
+		CHECK_NEAR(h.energy(bin, 200), h.maxEnergy, 1e-6);
+
+		h.clear();
+		CHECK(h.activeBins(200) == 0);
+	}
+
+	// 任意多事件：可见桶数不超过 kBins，逐桶回调的次数也一样
+	void testBoundedByBins() {
+		PolarHistogram h;
+		h.configure(10.0f, 10.0f);
+		for (int i = 0; i < 100000; ++i) h.add(static_cast<float>(i % 200 - 100), 5000 + i / 100);
+		size_t visited = 0;
+		float peak = 0.0f;
+		h.forEachActive(6000, [&](float, float e) {
+			++visited;
+			peak = std::fmax(peak, e);
+		});
+		CHECK(visited == static_cast<size_t>(PolarHistogram::kBins));
+		CHECK(visited == h.activeBins(6000));
+		CHECK(peak <= h.maxEnergy);
+	}
+}
+
+int main() {
+	testBinning();
+	testVisibleDuration();
+	testAccumulate();
+	testBoundedByBins();
+	return testResult("PolarHistogramTest");
+}
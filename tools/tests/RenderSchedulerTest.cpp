@@ -0,0 +1,136 @@
+﻿// RenderScheduler：假时钟下的事件合并、固定节拍、残影衰减后转空闲、迟到定时器不补帧
+#include "RenderScheduler.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <vector>
+
+namespace {
+	const uint64_t kMs = 1000000;
+	const uint64_t kInterval = 16666667;  // 60 Hz
+
+	struct Fixture {
+		OverlayRenderer renderer;
+		RenderScheduler scheduler;
+		Fixture() : scheduler(renderer, kInterval) { renderer.configure(40.0f, 3.0f); }
+	};
+
+	bool canvasEmpty(const OverlayRenderer& r) {
+		for (int y = 0; y < r.size(); ++y)
+			for (int x = 0; x < r.size(); ++x)
+				if (r.pixel(x, y)) return false;
+		return true;
+	}
+
+	// 3 毫秒内的 20 个事件只触发一次重绘，帧内包含全部事件
+	void testBurstCoalesced() {
+		Fixture f;
+		uint64_t now = 1000 * kMs;
+		CHECK(f.scheduler.idle());
+		int timerStarts = 0;
+		for (int i = 0; i < 20; ++i) {
+			if (f.scheduler.submit(static_cast<float>(i * 4 - 40), i, now + i * 150000)) ++timerStarts;
+		}
+		CHECK(timerStarts == 1);
+		CHECK(!f.scheduler.idle());
+
+		CHECK(f.scheduler.tick(now + 3 * kMs));
+		CHECK(f.scheduler.framesRendered() == 1);
+		CHECK(f.scheduler.frameEvents().size() == 20);
+		CHECK(f.scheduler.eventsCoalesced() == 19);
+		CHECK(!canvasEmpty(f.renderer));
+
+		// 同一节拍内再次触发不重绘
+		CHECK(!f.scheduler.tick(now + 4 * kMs));
+		CHECK(f.scheduler.framesRendered() == 1);
+	}
+
+	// 定时器每 1 ms 触发一次：帧只在节拍网格上合成，相邻两帧间隔不小于一个节拍
+	void testFramePacing() {
+		Fixture f;
+		f.renderer.style.liveDuration = 10.0f;  // 保持画面有内容，调度器持续出帧
+		uint64_t start = 0;
+		f.scheduler.submit(30.0f, 1, start);
+		std::vector<uint64_t> frames;
+		for (uint64_t t = start; t <= start + 200 * kMs; t += kMs) {
+			if (f.scheduler.tick(t)) frames.push_back(t);
+		}
+		// 0 ~ 200 ms：t = 0 以及第 1 ~ 11 个节拍之后的第一个整毫秒，共 12 帧
+		CHECK(frames.size() == 12);
+		for (size_t i = 1; i < frames.size(); ++i) {
+			CHECK(frames[i] - frames[i - 1] >= 16 * kMs);
+			CHECK(frames[i] - frames[i - 1] <= 17 * kMs);
+			CHECK(frames[i] >= start + i * kInterval);
+		}
+		CHECK(f.scheduler.frameEvents().empty());  // 后续帧只做动画，没有新事件
+	}
+
+	// 残影按时钟衰减：无新事件也持续出帧，全部消失后输出一帧透明画面并转为空闲
+	void testDecayThenIdle() {
+		Fixture f;
+		f.renderer.style.liveDuration = 0.1f;
+		uint64_t t0 = 5000 * kMs;
+		f.scheduler.submit(60.0f, 7, t0);  // 残影时长 0.2 + 0.8 × 2/3 ≈ 0.733 秒
+
+		uint64_t lastFrame = 0;
+		uint32_t lastAlpha = 255;
+		bool faded = true;
+		uint64_t t = t0;
+		for (; t < t0 + 2000 * kMs && !f.scheduler.idle(); t += kMs) {
+			if (!f.scheduler.tick(t)) continue;
+			lastFrame = t;
+			// 残影最亮像素单调变暗
+			uint32_t maxAlpha = 0;
+			for (int y = 0; y < f.renderer.size(); ++y)
+				for (int x = 0; x < f.renderer.size(); ++x) maxAlpha = std::max(maxAlpha, f.renderer.pixel(x, y) >> 24);
+			if (t > t0 + 150 * kMs && maxAlpha > lastAlpha) faded = false;
+			if (t > t0 + 150 * kMs) lastAlpha = maxAlpha;
+		}
+		CHECK(faded);
+		CHECK(f.scheduler.idle());
+		CHECK(lastFrame > t0 + 733 * kMs);
+		CHECK(lastFrame < t0 + 733 * kMs + 2 * kInterval);
+		CHECK(canvasEmpty(f.renderer));
+
+		// 空闲时定时器触发不重绘；新事件再次激活
+		uint64_t frames = f.scheduler.framesRendered();
+		CHECK(!f.scheduler.tick(t + 100 * kMs));
+		CHECK(f.scheduler.framesRendered() == frames);
+		CHECK(f.scheduler.submit(-20.0f, 8, t + 200 * kMs));
+		CHECK(f.scheduler.tick(t + 200 * kMs));
+	}
+
+	// 定时器迟到 100 ms：只出一帧，下一帧时刻仍落在节拍网格上
+	void testLateTimerSkipsFrames() {
+		Fixture f;
+		f.renderer.style.liveDuration = 10.0f;
+		f.scheduler.submit(10.0f, 1, 0);
+		CHECK(f.scheduler.tick(0));
+		CHECK(f.scheduler.nextFrameTime() == kInterval);
+		CHECK(f.scheduler.tick(100 * kMs));
+		CHECK(f.scheduler.framesRendered() == 2);
+		CHECK(f.scheduler.nextFrameTime() == 6 * kInterval);  // 100 ms 之后的第一个节拍
+		CHECK(!f.scheduler.tick(6 * kInterval - 1));
+		CHECK(f.scheduler.tick(6 * kInterval));
+	}
+
+	void testReset() {
+		Fixture f;
+		f.scheduler.submit(45.0f, 1, 0);
+		CHECK(f.scheduler.tick(0));
+		f.scheduler.submit(50.0f, 2, kMs);
+		f.scheduler.reset();
+		CHECK(f.scheduler.idle());
+		CHECK(canvasEmpty(f.renderer));
+		CHECK(f.renderer.trailBins(kMs) == 0);
+		CHECK(!f.scheduler.tick(kInterval));
+	}
+}
+
+int main() {
+	testBurstCoalesced();
+	testFramePacing();
+	testDecayThenIdle();
+	testLateTimerSkipsFrames();
+	testReset();
+	return testResult("RenderSchedulerTest");
+}
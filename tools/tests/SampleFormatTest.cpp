@@ -0,0 +1,109 @@
+﻿// 格式解码：同一信号编码为 s16 / s24 / s32 / f32 × 1、2、6、8 声道，解码结果与原信号相差不超过 1 LSB
+#include "SampleFormat.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+	struct TypeInfo {
+		SampleType type;
+		size_t bytes;
+		double scale;   // 满量程整数值（浮点为 0）
+	};
+
+	const TypeInfo kTypes[] = {
+		{ SampleType::Int16, 2, 32768.0 },
+		{ SampleType::Int24, 3, 8388608.0 },
+		{ SampleType::Int32, 4, 2147483648.0 },
+		{ SampleType::Float32, 4, 0.0 },
+	};
+
+	// 按解码器的缩放约定量化并写入一个采样（就近舍入，饱和到整数范围）
+	void store(uint8_t* p, const TypeInfo& info, float v) {
+		if (info.type == SampleType::Float32) {
+			std::memcpy(p, &v, 4);
+			return;
+		}
+		double q = std::floor(static_cast<double>(v) * info.scale + 0.5);
+		q = std::max(-info.scale, std::min(info.scale - 1.0, q));
+		int64_t s = static_cast<int64_t>(q);
+		for (size_t b = 0; b < info.bytes; ++b) p[b] = static_cast<uint8_t>(s >> (8 * b));
+	}
+
+	void checkLayout(const TypeInfo& info, uint32_t channels, const std::vector<float>& left, const std::vector<float>& right) {
+		const size_t frames = left.size();
+		StreamFormat fmt;
+		fmt.type = info.type;
+		fmt.channels = channels;
+		fmt.sampleRate = 48000;
+		fmt.blockAlign = static_cast<uint32_t>(channels * info.bytes);
+		DecodeStereoFn decode = selectStereoDecoder(fmt);
+		CHECK(decode != nullptr);
+		if (!decode) return;
+
+		// 声道 0/1 为左右，其余声道写入干扰值，确认解码只取前两个声道
+		std::vector<uint8_t> pcm(frames * fmt.blockAlign);
+		for (size_t i = 0; i < frames; ++i) {
+			for (uint32_t c = 0; c < channels; ++c) {
+				float v = (c == 0) ? left[i] : ((c == 1) ? right[i] : -0.75f);
+				store(&pcm[i * fmt.blockAlign + c * info.bytes], info, v);
+			}
+		}
+
+		// 奇数帧数，覆盖 SIMD 尾部处理
+		std::vector<float> outL(frames), outR(frames);
+		decode(pcm.data(), frames, outL.data(), outR.data());
+
+		const double lsb = info.scale > 0.0 ? 1.0 / info.scale : 0.0;
+		double errL = 0.0, errR = 0.0;
+		for (size_t i = 0; i < frames; ++i) {
+			const float expectR = channels >= 2 ? right[i] : left[i];  // 单声道时右声道复制左声道
+			errL = std::max(errL, std::fabs(static_cast<double>(outL[i]) - left[i]));
+			errR = std::max(errR, std::fabs(static_cast<double>(outR[i]) - expectR));
+		}
+		if (errL > lsb || errR > lsb) {
+			std::fprintf(stderr, "%s x%u: errL=%g errR=%g lsb=%g\n", sampleTypeName(info.type), channels, errL, errR, lsb);
+		}
+		CHECK(errL <= lsb);
+		CHECK(errR <= lsb);
+	}
+}
+
+int main() {
+	// 左右声道不同的测试信号，覆盖满量程两端
+	const size_t kFrames = 1001;
+	const float kPi = 3.14159265f;
+	std::vector<float> left(kFrames), right(kFrames);
+	for (size_t i = 0; i < kFrames; ++i) {
+		left[i] = 0.9f * std::sin(2.0f * kPi * 440.0f * i / 48000.0f);
+		right[i] = 0.5f * std::cos(2.0f * kPi * 1234.0f * i / 48000.0f);
+	}
+	left[0] = -1.0f;
+	right[1] = 0.999f;
+
+	const uint32_t kChannels[] = { 1, 2, 6, 8 };
+	for (const TypeInfo& info : kTypes) {
+		for (uint32_t ch : kChannels) checkLayout(info, ch, left, right);
+	}
+
+	// 格式推断与不支持的格式
+	CHECK(sampleTypeFrom(16, 16, false) == SampleType::Int16);
+	CHECK(sampleTypeFrom(24, 0, false) == SampleType::Int24);
+	CHECK(sampleTypeFrom(32, 24, false) == SampleType::Int32);
+	CHECK(sampleTypeFrom(32, 32, true) == SampleType::Float32);
+	CHECK(sampleTypeFrom(64, 64, true) == SampleType::Unknown);
+	CHECK(sampleTypeFrom(8, 8, false) == SampleType::Unknown);
+
+	StreamFormat tooMany;
+	tooMany.type = SampleType::Int16;
+	tooMany.channels = 9;
+	CHECK(selectStereoDecoder(tooMany) == nullptr);
+	StreamFormat unknown;
+	unknown.channels = 2;
+	CHECK(selectStereoDecoder(unknown) == nullptr);
+
+	return testResult("SampleFormatTest");
+}
@@ -0,0 +1,155 @@
+﻿// SpscRing 生产者/消费者压力测试：顺序、载荷完整性与溢出计数
+// 建议以 -DAC_SANITIZE_THREAD=ON 构建，在 ThreadSanitizer 下运行
+#include "SpscRing.h"
+#include "TestCheck.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstdint>
+
+namespace {
+	// 载荷跨多个缓存行，发布顺序出错时能读到半写的槽位
+	struct Item {
+		uint64_t seq = 0;
+		uint64_t payload[15] = {};
+	};
+
+	uint64_t payloadOf(uint64_t seq, size_t i) {
+		return seq * 0x9E3779B97F4A7C15ull + i;
+	}
+
+	void fill(Item& item, uint64_t seq) {
+		item.seq = seq;
+		for (size_t i = 0; i < 15; ++i) item.payload[i] = payloadOf(seq, i);
+	}
+
+	bool intact(const Item& item) {
+		for (size_t i = 0; i < 15; ++i) {
+			if (item.payload[i] != payloadOf(item.seq, i)) return false;
+		}
+		return true;
+	}
+
+	// 容量取整与单线程回绕
+	void testSingleThread() {
+		SpscRing<Item> ring(5);
+		CHECK(ring.capacity() == 8);
+		CHECK(ring.empty());
+		CHECK(ring.front() == nullptr);
+
+		uint64_t next = 0, expect = 0;
+		for (int round = 0; round < 100; ++round) {
+			for (int i = 0; i < 5; ++i) {
+				Item* slot = ring.acquire();
+				CHECK(slot != nullptr);
+				if (!slot) return;
+				fill(*slot, next++);
+				ring.publish();
+			}
+			CHECK(ring.size() == 5);
+			for (int i = 0; i < 5; ++i) {
+				Item* item = ring.front();
+				CHECK(item != nullptr);
+				if (!item) return;
+				CHECK(item->seq == expect++);
+				CHECK(intact(*item));
+				ring.pop();
+			}
+		}
+		CHECK(ring.overflowCount() == 0);
+
+		// 写满后 acquire 返回 nullptr 并计数，读出一个后恢复
+		for (size_t i = 0; i < ring.capacity(); ++i) {
+			fill(*ring.acquire(), next++);
+			ring.publish();
+		}
+		CHECK(ring.acquire() == nullptr);
+		CHECK(ring.acquire() == nullptr);
+		CHECK(ring.overflowCount() == 2);
+		ring.pop();
+		CHECK(ring.acquire() != nullptr);
+		CHECK(ring.overflowCount() == 2);
+	}
+
+	// 生产者满时自旋重试：消费者必须按序收到每一项，溢出计数等于生产者失败次数
+	void testOrderedStress() {
+		const uint64_t kItems = 1000000;
+		SpscRing<Item> ring(64);
+		uint64_t producerFailures = 0;
+
+		std::thread producer([&]() {
+			for (uint64_t seq = 0; seq < kItems; ++seq) {
+				Item* slot;
+				while ((slot = ring.acquire()) == nullptr) {
+					++producerFailures;
+					std::this_thread::yield();
+				}
+				fill(*slot, seq);
+				ring.publish();
+			}
+		});
+
+		uint64_t expect = 0;
+		uint64_t bad = 0;
+		while (expect < kItems) {
+			Item* item = ring.front();
+			if (!item) {
+				std::this_thread::yield();
+				continue;
+			}
+			if (item->seq != expect || !intact(*item)) ++bad;
+			++expect;
+			ring.pop();
+		}
+		producer.join();
+
+		CHECK(bad == 0);
+		CHECK(ring.empty());
+		CHECK(ring.overflowCount() == producerFailures);
+	}
+
+	// 生产者满时直接丢弃：收到的序号严格递增，收到数 + 溢出数 = 发送尝试数
+	void testLossyStress() {
+		const uint64_t kAttempts = 1000000;
+		SpscRing<Item> ring(16);
+		bool done = false;
+		std::atomic<bool> producerDone{ false };
+
+		std::thread producer([&]() {
+			for (uint64_t seq = 0; seq < kAttempts; ++seq) {
+				if (Item* slot = ring.acquire()) {
+					fill(*slot, seq);
+					ring.publish();
+				}
+			}
+			producerDone.store(true, std::memory_order_release);
+		});
+
+		uint64_t received = 0;
+		uint64_t last = 0;
+		uint64_t bad = 0;
+		while (!done) {
+			Item* item = ring.front();
+			if (!item) {
+				// 生产者结束后再确认一次队列已空
+				if (producerDone.load(std::memory_order_acquire) && !ring.front()) done = true;
+				continue;
+			}
+			if ((received > 0 && item->seq <= last) || !intact(*item)) ++bad;
+			last = item->seq;
+			++received;
+			ring.pop();
+		}
+		producer.join();
+
+		CHECK(bad == 0);
+		CHECK(received + ring.overflowCount() == kAttempts);
+	}
+}
+
+int main() {
+	testSingleThread();
+	testOrderedStress();
+	testLossyStress();
+	return testResult("SpscRingTest");
+}
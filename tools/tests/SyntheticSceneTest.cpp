@@ -0,0 +1,198 @@
+﻿// SyntheticScene：同一 seed 的场景逐位相同；脉冲的 ILD / ITD 与真值一致；评分规则；真实检测与方位代码在干净、噪声与重叠场景上的准确率下限
+#include "SyntheticScene.h"
+#include "SampleFormat.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace {
+	const double kPi = 3.14159265358979323846;
+
+	void testDeterminism() {
+		SceneConfig config;
+		config.seconds = 4.0;
+		config.events = 8;
+		config.noiseDb = -50.0f;
+		config.musicDb = -30.0f;
+		config.overlapProbability = 0.5f;
+		SyntheticScene a, b, c;
+		renderScene(config, a);
+		renderScene(config, b);
+		CHECK(a.left == b.left && a.right == b.right);
+		CHECK(a.events.size() == b.events.size() && a.events.size() > 8);
+		for (size_t i = 1; i < a.events.size(); ++i) CHECK(a.events[i - 1].start <= a.events[i].start);
+		for (const SceneEvent& e : a.events) CHECK(e.start + e.length <= a.left.size() && std::fabs(e.angle) <= config.maxAngle);
+
+		config.seed = 2;
+		renderScene(config, c);
+		CHECK(c.left != a.left);
+	}
+
+	// 单个脉冲（无背景）：整段能量差按 ildAngle 的映射还原出真值角度，互相关峰在 maxItd × sin(angle) 处
+	void testEventTruth() {
+		for (uint32_t seed = 1; seed <= 6; ++seed) {
+			SceneConfig config;
+			config.seconds = 1.0;
+			config.events = 1;
+			config.seed = seed;
+			SyntheticScene scene;
+			renderScene(config, scene);
+			CHECK(scene.events.size() == 1);
+			if (scene.events.size() != 1) continue;
+			const SceneEvent& e = scene.events[0];
+
+			double el = 0.0, er = 0.0;
+			for (size_t i = 0; i < scene.left.size(); ++i) {
+				el += static_cast<double>(scene.left[i]) * scene.left[i];
+				er += static_cast<double>(scene.right[i]) * scene.right[i];
+			}
+			const double ild = 10.0 * std::log10(er / el) / 20.0 * 90.0;
+			CHECK_NEAR(ild, e.angle, 0.5);
+
+			// 左声道相对右声道的延迟
+			const double expected = config.maxItdSeconds * config.sampleRate * std::sin(e.angle * kPi / 180.0);
+			int bestLag = 0;
+			double best = -1.0;
+			for (int lag = -45; lag <= 45; ++lag) {
+				double sum = 0.0;
+				for (size_t i = e.start + 100; i < e.start + e.length / 2; ++i) sum += static_cast<double>(scene.left[i + lag]) * scene.right[i];
+				if (sum > best) {
+					best = sum;
+					bestLag = lag;
+				}
+			}
+			CHECK(std::fabs(bestLag - expected) <= 1.0);
+		}
+	}
+
+	void testEncoding() {
+		SceneConfig config;
+		config.seconds = 1.0;
+		config.events = 2;
+		config.noiseDb = -40.0f;
+		SyntheticScene scene;
+		renderScene(config, scene);
+		const SampleType types[] = { SampleType::Float32, SampleType::Int16, SampleType::Int24 };
+		for (SampleType type : types) {
+			std::vector<uint8_t> pcm;
+			StreamFormat fmt = encodeScene(scene, type, pcm);
+			DecodeStereoFn decode = selectStereoDecoder(fmt);
+			CHECK(decode != nullptr && fmt.channels == 2 && fmt.sampleRate == config.sampleRate);
+			if (!decode) continue;
+			const size_t frames = pcm.size() / fmt.blockAlign;
+			CHECK(frames == scene.left.size());
+			std::vector<float> left(frames), right(frames);
+			decode(pcm.data(), frames, left.data(), right.data());
+			const double tol = type == SampleType::Float32 ? 0.0 : (type == SampleType::Int16 ? 0.5 / 32768.0 : 0.5 / 8388608.0);
+			double worst = 0.0;
+			for (size_t i = 0; i < frames; ++i) {
+				worst = std::max(worst, std::fabs(static_cast<double>(left[i]) - scene.left[i]));
+				worst = std::max(worst, std::fabs(static_cast<double>(right[i]) - scene.right[i]));
+			}
+			CHECK(worst <= tol * 1.0001);
+		}
+	}
+
+	SceneDetection detection(uint64_t offset, float angle, std::vector<float> sources = {}) {
+		SceneDetection d;
+		d.frameOffset = offset;
+		d.reportedAt = offset + 480;
+		d.angle = angle;
+		d.sourceCount = sources.size();
+		std::copy(sources.begin(), sources.end(), d.sources);
+		return d;
+	}
+
+	void testScoring() {
+		std::vector<SceneEvent> events(3);
+		events[0].start = 1000;
+		events[0].length = 2000;
+		events[0].angle = 30.0f;
+		events[1].start = 10000;
+		events[1].length = 2000;
+		events[1].angle = -40.0f;
+		events[2].start = 10010;
+		events[2].length = 2000;
+		events[2].angle = 50.0f;
+
+		std::vector<SceneDetection> detections;
+		detections.push_back(detection(800, 25.0f));                      // 帧尾与事件 0 重叠：命中
+		detections.push_back(detection(1500, 30.0f));                     // 事件 0 的重复
+		detections.push_back(detection(5000, 0.0f));                      // 误报
+		detections.push_back(detection(9900, 5.0f, { -38.0f, 47.0f }));   // 同时命中重叠的事件 1、2，各取最近的声源
+		detections.push_back(detection(20000, 0.0f));                     // 误报
+		SceneScore score = scoreScene(events, detections, 256);
+		CHECK(score.events == 3 && score.detected == 3 && score.detections == 5);
+		CHECK(score.falseAlarms == 2 && score.duplicates == 1);
+		CHECK_NEAR(score.recall, 1.0, 1e-12);
+		CHECK_NEAR(score.precision, 0.6, 1e-12);
+		CHECK_NEAR(score.angleErrorMean, (5.0 + 2.0 + 3.0) / 3.0, 1e-6);
+		CHECK_NEAR(score.angleErrorMax, 5.0, 1e-6);
+		CHECK_NEAR(score.angleErrorP90, 5.0, 1e-6);
+		CHECK_NEAR(score.latencyMean, (280.0 + 380.0 + 370.0) / 3.0, 1e-9);
+		CHECK_NEAR(score.latencyMax, 380.0, 1e-9);
+
+		// 帧在事件开始之前结束：不算命中
+		std::vector<SceneDetection> early(1, detection(1000 - 256, 30.0f));
+		score = scoreScene(events, early, 256);
+		CHECK(score.detected == 0 && score.falseAlarms == 1 && score.recall == 0.0);
+	}
+
+	SceneScore run(const SceneConfig& config, SampleType type, DirectionMode mode, const char* name) {
+		SyntheticScene scene;
+		renderScene(config, scene);
+		std::vector<uint8_t> pcm;
+		StreamFormat fmt = encodeScene(scene, type, pcm);
+		SceneRunConfig run;
+		run.mode = mode;
+		std::vector<SceneDetection> detections;
+		CHECK(runScene(fmt, pcm, run, detections));
+		SceneScore s = scoreScene(scene.events, detections, run.frameSize);
+		std::printf("%s %s %s: recall %.3f, precision %.3f, %zu duplicates, angle error mean %.1f / p90 %.1f, latency mean %.0f / max %.0f samples\n",
+			name, sampleTypeName(type), mode == DirectionMode::Ild ? "ild" : "itd_ild", s.recall, s.precision, s.duplicates,
+			s.angleErrorMean, s.angleErrorP90, s.latencyMean, s.latencyMax);
+		return s;
+	}
+
+	// 实时程序的默认参数（自适应噪声底、256 点帧、480 帧数据包）下的准确率下限
+	// 触发帧多半落在起音处，此时滞后一侧的声道还没有（或只有很少的）信号，ILD 偏向领先一侧；ITD 融合后误差明显减小
+	void testAccuracyFloor() {
+		const uint32_t kMaxLatency = 480 + 256 + 40;   // 一个数据包 + 一帧 + 最大耳间延迟
+		SceneConfig clean;
+		clean.noiseDb = -60.0f;
+		SceneConfig music = clean;
+		music.musicDb = -20.0f;
+		for (SampleType type : { SampleType::Float32, SampleType::Int16 }) {
+			SceneScore ild = run(clean, type, DirectionMode::Ild, "clean");
+			SceneScore itd = run(clean, type, DirectionMode::ItdIld, "clean");
+			SceneScore withMusic = run(music, type, DirectionMode::ItdIld, "music");
+			for (const SceneScore* s : { &ild, &itd, &withMusic }) {
+				CHECK(s->recall >= 0.99);
+				CHECK(s->precision >= 0.97);
+				CHECK(s->latencyMax <= kMaxLatency);
+			}
+			CHECK(ild.angleErrorMean < 15.0);
+			CHECK(itd.angleErrorMean < 10.0);
+			CHECK(itd.angleErrorMean < ild.angleErrorMean);
+			CHECK(withMusic.angleErrorMean < 20.0);
+		}
+
+		// 两侧几乎同时开火：事件仍全部被检测到（同一次检测可命中两个事件）
+		SceneConfig overlap = clean;
+		overlap.overlapProbability = 1.0f;
+		SceneScore s = run(overlap, SampleType::Float32, DirectionMode::ItdIld, "overlap");
+		CHECK(s.recall >= 0.95);
+		CHECK(s.events == 2 * clean.events);
+	}
+}
+
+int main() {
+	testDeterminism();
+	testEventTruth();
+	testEncoding();
+	testScoring();
+	testAccuracyFloor();
+	return testResult("SyntheticSceneTest");
+}
@@ -0,0 +1,37 @@
+﻿#pragma once
+#include <cstdio>
+#include <cmath>
+
+// 极简断言：失败时打印位置并计数，不中断后续检查
+inline int& testFailureCount() {
+    static int count = 0;
+    return count;
+}
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            ++testFailureCount(); \
+        } \
+    } while (0)
+
+#define CHECK_NEAR(a, b, tol) \
+    do { \
+        double va_ = (a), vb_ = (b); \
+        if (!(std::fabs(va_ - vb_) <= (tol))) { \
+            std::fprintf(stderr, "%s:%d: CHECK_NEAR failed: %s = %g, %s = %g, tol %g\n", \
+                __FILE__, __LINE__, #a, va_, #b, vb_, static_cast<double>(tol)); \
+            ++testFailureCount(); \
+        } \
+    } while (0)
+
+// main 的返回值：有失败时为 1
+inline int testResult(const char* name) {
+    if (testFailureCount()) {
+        std::fprintf(stderr, "[%s] %d check(s) failed\n", name, testFailureCount());
+        return 1;
+    }
+    std::printf("[%s] ok\n", name);
+    return 0;
+}
@@ -0,0 +1,202 @@
+﻿// WavFile：fmt 块解析（PCM / 浮点 / EXTENSIBLE）与 WAV 读取（奇数长度块、未回填的 data 长度），以及内存映像中的 data 定位
+#include "WavFile.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+	void put16(std::vector<uint8_t>& v, uint32_t x) {
+		v.push_back(static_cast<uint8_t>(x));
+		v.push_back(static_cast<uint8_t>(x >> 8));
+	}
+
+	void put32(std::vector<uint8_t>& v, uint32_t x) {
+		put16(v, x & 0xFFFF);
+		put16(v, x >> 16);
+	}
+
+	void putTag(std::vector<uint8_t>& v, const char* tag) {
+		v.insert(v.end(), tag, tag + 4);
+	}
+
+	// fmt 块；subTag 非 0 时写 EXTENSIBLE 扩展
+	std::vector<uint8_t> makeFmt(uint16_t tag, uint16_t channels, uint32_t rate, uint16_t bits,
+		uint16_t validBits = 0, uint32_t subTag = 0) {
+		std::vector<uint8_t> f;
+		uint16_t blockAlign = static_cast<uint16_t>(channels * bits / 8);
+		put16(f, tag);
+		put16(f, channels);
+		put32(f, rate);
+		put32(f, rate * blockAlign);
+		put16(f, blockAlign);
+		put16(f, bits);
+		if (tag == kWaveFormatExtensible) {
+			const uint8_t tail[12] = { 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71 };
+			put16(f, 22);
+			put16(f, validBits);
+			put32(f, 3);
+			put32(f, subTag);
+			f.insert(f.end(), tail, tail + 12);
+		}
+		return f;
+	}
+
+	void testFmtChunk() {
+		std::vector<uint8_t> pcm16 = makeFmt(kWaveFormatPcm, 2, 48000, 16);
+		StreamFormat f = streamFormatFromFmtChunk(pcm16.data(), pcm16.size());
+		CHECK(f.type == SampleType::Int16);
+		CHECK(f.channels == 2);
+		CHECK(f.sampleRate == 48000);
+		CHECK(f.blockAlign == 4);
+
+		std::vector<uint8_t> float32 = makeFmt(kWaveFormatIeeeFloat, 2, 44100, 32);
+		CHECK(streamFormatFromFmtChunk(float32.data(), float32.size()).type == SampleType::Float32);
+
+		std::vector<uint8_t> extFloat = makeFmt(kWaveFormatExtensible, 8, 48000, 32, 32, kWaveFormatIeeeFloat);
+		f = streamFormatFromFmtChunk(extFloat.data(), extFloat.size());
+		CHECK(f.type == SampleType::Float32);
+		CHECK(f.channels == 8);
+
+		std::vector<uint8_t> ext24in32 = makeFmt(kWaveFormatExtensible, 2, 48000, 32, 24, kWaveFormatPcm);
+		CHECK(streamFormatFromFmtChunk(ext24in32.data(), ext24in32.size()).type == SampleType::Int32);
+
+		std::vector<uint8_t> ext24 = makeFmt(kWaveFormatExtensible, 6, 48000, 24, 24, kWaveFormatPcm);
+		CHECK(streamFormatFromFmtChunk(ext24.data(), ext24.size()).type == SampleType::Int24);
+
+		// 不支持：未知子格式、截断的扩展、非紧密排列、未知格式码
+		std::vector<uint8_t> extUnknown = makeFmt(kWaveFormatExtensible, 2, 48000, 16, 16, 0x0092);
+		CHECK(streamFormatFromFmtChunk(extUnknown.data(), extUnknown.size()).type == SampleType::Unknown);
+		CHECK(streamFormatFromFmtChunk(extFloat.data(), 30).type == SampleType::Unknown);
+		std::vector<uint8_t> padded = makeFmt(kWaveFormatPcm, 2, 48000, 16);
+		padded[12] = 6;
+		CHECK(streamFormatFromFmtChunk(padded.data(), padded.size()).type == SampleType::Unknown);
+		std::vector<uint8_t> adpcm = makeFmt(0x0002, 2, 48000, 16);
+		CHECK(streamFormatFromFmtChunk(adpcm.data(), adpcm.size()).type == SampleType::Unknown);
+	}
+
+	std::string writeFile(const char* name, const std::vector<uint8_t>& bytes) {
+		std::string path = std::string("WavFileTest_") + name + ".wav";
+		std::ofstream ofs(path, std::ios::binary);
+		ofs.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+		return path;
+	}
+
+	// RIFF 文件：fmt 之前插入一个奇数长度的块，dataSize 为写入 data 头的长度
+	std::vector<uint8_t> makeWav(const std::vector<uint8_t>& fmt, const std::vector<uint8_t>& pcm, uint32_t dataSize) {
+		std::vector<uint8_t> w;
+		putTag(w, "RIFF");
+		put32(w, 0);
+		putTag(w, "WAVE");
+		putTag(w, "junk");
+		put32(w, 3);
+		w.push_back(1);
+		w.push_back(2);
+		w.push_back(3);
+		w.push_back(0);  // 对齐填充
+		putTag(w, "fmt ");
+		put32(w, static_cast<uint32_t>(fmt.size()));
+		w.insert(w.end(), fmt.begin(), fmt.end());
+		putTag(w, "data");
+		put32(w, dataSize);
+		w.insert(w.end(), pcm.begin(), pcm.end());
+		return w;
+	}
+
+	void testReadWav() {
+		std::vector<uint8_t> fmt = makeFmt(kWaveFormatPcm, 2, 48000, 16);
+		std::vector<uint8_t> pcm;
+		for (uint32_t i = 0; i < 100; ++i) put32(pcm, i * 0x00010001u);
+
+		StreamFormat f;
+		std::vector<uint8_t> data;
+		std::string error;
+		std::string path = writeFile("ok", makeWav(fmt, pcm, static_cast<uint32_t>(pcm.size())));
+		CHECK(readWavFile(path, f, data, &error));
+		CHECK(f.type == SampleType::Int16);
+		CHECK(data == pcm);
+		std::remove(path.c_str());
+
+		// 录制中断：data 长度未回填（0），读到文件尾
+		path = writeFile("unpatched", makeWav(fmt, pcm, 0));
+		CHECK(readWavFile(path, f, data, &error));
+		CHECK(data == pcm);
+		std::remove(path.c_str());
+
+		// data 长度超出文件：按可读长度截取并对齐到整帧
+		std::vector<uint8_t> truncated = makeWav(fmt, pcm, 100000);
+		truncated.pop_back();
+		path = writeFile("truncated", truncated);
+		CHECK(readWavFile(path, f, data, &error));
+		CHECK(data.size() == pcm.size() - 4);
+		std::remove(path.c_str());
+
+		CHECK(!readWavFile("WavFileTest_missing.wav", f, data, &error));
+		CHECK(!error.empty());
+	}
+
+	// locateWavData 与 readWavFile 的长度规则一致，且直接指向映像中的 PCM
+	void testLocateData() {
+		std::vector<uint8_t> fmt = makeFmt(kWaveFormatPcm, 2, 48000, 16);
+		std::vector<uint8_t> pcm;
+		for (uint32_t i = 0; i < 100; ++i) put32(pcm, i * 0x00010001u);
+
+		StreamFormat f;
+		size_t offset = 0, size = 0;
+		std::vector<uint8_t> image = makeWav(fmt, pcm, static_cast<uint32_t>(pcm.size()));
+		CHECK(locateWavData(image.data(), image.size(), f, offset, size));
+		CHECK(f.type == SampleType::Int16 && f.channels == 2);
+		CHECK(size == pcm.size());
+		CHECK(std::equal(pcm.begin(), pcm.end(), image.begin() + offset));
+
+		image = makeWav(fmt, pcm, 0);
+		CHECK(locateWavData(image.data(), image.size(), f, offset, size));
+		CHECK(size == pcm.size());
+
+		image = makeWav(fmt, pcm, 100000);
+		image.pop_back();
+		CHECK(locateWavData(image.data(), image.size(), f, offset, size));
+		CHECK(size == pcm.size() - 4);
+
+		std::string error;
+		CHECK(!locateWavData(image.data(), 20, f, offset, size, &error));
+		CHECK(!error.empty());
+
+		// 奇数长度块之后有填充字节：跳过填充找到 data
+		std::vector<uint8_t> junk;
+		putTag(junk, "RIFF");
+		put32(junk, 0);
+		putTag(junk, "WAVE");
+		putTag(junk, "fmt ");
+		put32(junk, static_cast<uint32_t>(fmt.size()));
+		junk.insert(junk.end(), fmt.begin(), fmt.end());
+		putTag(junk, "junk");
+		put32(junk, 3);
+		junk.insert(junk.end(), { 1, 2, 3 });
+		std::vector<uint8_t> padded = junk;
+		padded.push_back(0);
+		putTag(padded, "data");
+		put32(padded, static_cast<uint32_t>(pcm.size()));
+		padded.insert(padded.end(), pcm.begin(), pcm.end());
+		CHECK(locateWavData(padded.data(), padded.size(), f, offset, size));
+		CHECK(size == pcm.size() && std::equal(pcm.begin(), pcm.end(), padded.begin() + offset));
+
+		// 文件以缺少填充字节的奇数长度块结尾：不能越过映像末尾继续找块
+		// 复制到恰好等长的堆缓冲，AddressSanitizer 下越界读会直接报错
+		std::unique_ptr<uint8_t[]> exact(new uint8_t[junk.size()]);
+		std::copy(junk.begin(), junk.end(), exact.get());
+		error.clear();
+		CHECK(!locateWavData(exact.get(), junk.size(), f, offset, size, &error));
+		CHECK(!error.empty());
+	}
+}
+
+int main() {
+	testFmtChunk();
+	testReadWav();
+	testLocateData();
+	return testResult("WavFileTest");
+}
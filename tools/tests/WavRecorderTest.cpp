@@ -0,0 +1,317 @@
+﻿// WavRecorder：文件头（RIFF / RF64）、完整写入、无损压缩写入、分段、持续吞吐，以及写入中途被强制结束后文件仍可读取
+#include "WavRecorder.h"
+#include "WavFile.h"
+#include "TestCheck.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#if !defined(_WIN32)
+#include <csignal>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace {
+	const uint32_t kRate = 48000;
+	const uint32_t kBlockAlign = 4;        // 16 位立体声
+	const size_t kPacketBytes = 480 * kBlockAlign;
+
+	std::vector<uint8_t> makeFmt() {
+		std::vector<uint8_t> f(16, 0);
+		uint32_t fields[] = { kWaveFormatPcm | (2u << 16), kRate, kRate * kBlockAlign, kBlockAlign | (16u << 16) };
+		for (int i = 0; i < 4; ++i) {
+			for (int b = 0; b < 4; ++b) f[i * 4 + b] = static_cast<uint8_t>(fields[i] >> (8 * b));
+		}
+		return f;
+	}
+
+	// 按流位置生成的字节，读回后可逐字节核对
+	uint8_t patternAt(uint64_t pos) {
+		return static_cast<uint8_t>(pos * 31 + (pos >> 9));
+	}
+
+	void fillPacket(std::vector<uint8_t>& packet, uint64_t pos) {
+		for (size_t i = 0; i < packet.size(); ++i) packet[i] = patternAt(pos + i);
+	}
+
+	bool matchesPattern(const std::vector<uint8_t>& data, uint64_t start) {
+		for (size_t i = 0; i < data.size(); ++i) {
+			if (data[i] != patternAt(start + i)) return false;
+		}
+		return true;
+	}
+
+	uint32_t readU32(const std::vector<uint8_t>& v, size_t at) {
+		return v[at] | (v[at + 1] << 8) | (v[at + 2] << 16) | (static_cast<uint32_t>(v[at + 3]) << 24);
+	}
+
+	std::vector<uint8_t> readBytes(const std::string& path) {
+		std::ifstream ifs(path, std::ios::binary);
+		return std::vector<uint8_t>((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+	}
+
+	// 只读文件开头 bytes 字节（文件仍在增长时轮询文件头用）
+	std::vector<uint8_t> readHead(const std::string& path, size_t bytes) {
+		std::vector<uint8_t> head(bytes);
+		std::ifstream ifs(path, std::ios::binary);
+		ifs.read(reinterpret_cast<char*>(head.data()), bytes);
+		head.resize(static_cast<size_t>(ifs.gcount()));
+		return head;
+	}
+
+	void testHeader() {
+		std::vector<uint8_t> fmt = makeFmt();
+		std::vector<uint8_t> small, large;
+		buildWavHeader(fmt.data(), fmt.size(), 1000, small);
+		buildWavHeader(fmt.data(), fmt.size(), 5000000000ull, large);
+		CHECK(small.size() == large.size());  // 升级 RF64 不移动数据
+		CHECK(std::memcmp(small.data(), "RIFF", 4) == 0);
+		CHECK(std::memcmp(small.data() + 12, "JUNK", 4) == 0);
+		CHECK(readU32(small, 4) == small.size() - 8 + 1000);
+		CHECK(readU32(small, small.size() - 4) == 1000);
+
+		CHECK(std::memcmp(large.data(), "RF64", 4) == 0);
+		CHECK(std::memcmp(large.data() + 12, "ds64", 4) == 0);
+		CHECK(readU32(large, 4) == 0xFFFFFFFFu);
+		CHECK(readU32(large, large.size() - 4) == 0xFFFFFFFFu);
+		CHECK(readU32(large, 28) == static_cast<uint32_t>(5000000000ull));  // ds64 dataSize 低 32 位
+		CHECK(readU32(large, 32) == 1);                                       // 高 32 位：5e9 >> 32
+
+		// RF64 文件：ds64 中的长度超出实际数据时按文件截取
+		std::vector<uint8_t> pcm(4096);
+		fillPacket(pcm, 0);
+		const std::string path = "WavRecorderTest_rf64.wav";
+		{
+			std::ofstream ofs(path, std::ios::binary);
+			ofs.write(reinterpret_cast<const char*>(large.data()), large.size());
+			ofs.write(reinterpret_cast<const char*>(pcm.data()), pcm.size());
+		}
+		StreamFormat f;
+		std::vector<uint8_t> data;
+		std::string error;
+		CHECK(readWavFile(path, f, data, &error));
+		CHECK(f.type == SampleType::Int16);
+		CHECK(data == pcm);
+		std::remove(path.c_str());
+	}
+
+	void testRoundTrip() {
+		std::vector<uint8_t> fmt = makeFmt();
+		WavRecorderConfig config;
+		config.bufferBytes = 64 * 1024;
+		config.batchBytes = 8 * 1024;
+		config.checkpointMs = 20;
+		const std::string path = "WavRecorderTest_roundtrip.wav";
+		WavRecorder recorder;
+		CHECK(recorder.start(path, fmt.data(), fmt.size(), config));
+		CHECK(recorder.isRecording());
+
+		std::vector<uint8_t> packet(kPacketBytes);
+		uint64_t pos = 0;
+		for (int i = 0; i < 200; ++i) {
+			fillPacket(packet, pos);
+			while (!recorder.append(packet.data(), packet.size())) std::this_thread::yield();
+			pos += packet.size();
+		}
+		recorder.stop();
+		CHECK(!recorder.isRecording());
+		CHECK(recorder.bytesWritten() == pos);
+		CHECK(recorder.segmentCount() == 1);
+		CHECK(!recorder.failed());
+
+		StreamFormat f;
+		std::vector<uint8_t> data;
+		CHECK(readWavFile(path, f, data));
+		CHECK(data.size() == pos);
+		CHECK(matchesPattern(data, 0));
+		std::remove(path.c_str());
+
+		CHECK(!recorder.start("no_such_dir/WavRecorderTest.wav", fmt.data(), fmt.size(), config));
+	}
+
+	// lossless 模式：检查点刷出的短块与分段后的每个文件都能逐字节解码还原
+	void testLossless() {
+		std::vector<uint8_t> fmt = makeFmt();
+		WavRecorderConfig config;
+		config.bufferBytes = 64 * 1024;
+		config.batchBytes = 8 * 1024;
+		config.checkpointMs = 5;
+		config.segmentBytes = 100000;
+		config.lossless = true;
+		config.losslessConfig.blockFrames = 1024;
+		const std::string path = "WavRecorderTest_lossless.aclc";
+		WavRecorder recorder;
+		CHECK(recorder.start(path, fmt.data(), fmt.size(), config));
+
+		std::vector<uint8_t> packet(kPacketBytes);
+		uint64_t pos = 0;
+		for (int i = 0; i < 150; ++i) {
+			fillPacket(packet, pos);
+			while (!recorder.append(packet.data(), packet.size())) std::this_thread::yield();
+			pos += packet.size();
+			if (i % 20 == 0) std::this_thread::sleep_for(std::chrono::milliseconds(10));  // 让检查点落在块中间
+		}
+		recorder.stop();
+		CHECK(recorder.bytesWritten() == pos);
+		CHECK(!recorder.failed());
+		uint32_t segments = recorder.segmentCount();
+		CHECK(segments == (pos + 99999) / 100000);
+
+		uint64_t start = 0;
+		for (uint32_t s = 0; s < segments; ++s) {
+			std::string file = WavRecorder::segmentPath(path, s);
+			LosslessDecoder decoder;
+			CHECK(decoder.open(file));
+			CHECK(decoder.hadIndex());
+			CHECK(decoder.format().type == SampleType::Int16 && decoder.format().channels == 2);
+			std::vector<uint8_t> data(static_cast<size_t>(decoder.totalFrames()) * kBlockAlign);
+			CHECK(decoder.read(data.data(), static_cast<size_t>(decoder.totalFrames())) == decoder.totalFrames());
+			CHECK(matchesPattern(data, start));
+			start += data.size();
+			std::remove(file.c_str());
+		}
+		CHECK(start == pos);
+	}
+
+	void testSegments() {
+		std::vector<uint8_t> fmt = makeFmt();
+		WavRecorderConfig config;
+		config.bufferBytes = 64 * 1024;
+		config.batchBytes = 4096;
+		config.segmentBytes = 10002;  // 向下取整到 10000（整数个采样帧）
+		const std::string base = "WavRecorderTest_seg.wav";
+		CHECK(WavRecorder::segmentPath(base, 2) == "WavRecorderTest_seg_2.wav");
+		CHECK(WavRecorder::segmentPath("dir.v1/rec", 1) == "dir.v1/rec_1");
+
+		WavRecorder recorder;
+		CHECK(recorder.start(base, fmt.data(), fmt.size(), config));
+		std::vector<uint8_t> packet(kPacketBytes);
+		uint64_t pos = 0;
+		for (int i = 0; i < 30; ++i) {  // 57600 字节 → 6 个文件
+			fillPacket(packet, pos);
+			while (!recorder.append(packet.data(), packet.size())) std::this_thread::yield();
+			pos += packet.size();
+		}
+		recorder.stop();
+		CHECK(recorder.segmentCount() == 6);
+
+		uint64_t offset = 0;
+		for (uint32_t i = 0; i < recorder.segmentCount(); ++i) {
+			std::string path = WavRecorder::segmentPath(base, i);
+			StreamFormat f;
+			std::vector<uint8_t> data;
+			CHECK(readWavFile(path, f, data));
+			CHECK(data.size() == (i + 1 < recorder.segmentCount() ? 10000u : pos - 5 * 10000));
+			CHECK(matchesPattern(data, offset));
+			offset += data.size();
+			std::remove(path.c_str());
+		}
+		CHECK(offset == pos);
+	}
+
+	// 持续吞吐：生产者不限速写入，满时让出 CPU 重试；报告写盘速度
+	void testThroughput() {
+		std::vector<uint8_t> fmt = makeFmt();
+		const std::string path = "WavRecorderTest_throughput.wav";
+		const uint64_t total = 64ull << 20;
+		WavRecorder recorder;
+		CHECK(recorder.start(path, fmt.data(), fmt.size()));
+
+		std::vector<uint8_t> packet(kPacketBytes * 8);
+		auto begin = std::chrono::steady_clock::now();
+		uint64_t pos = 0;
+		uint64_t retries = 0;
+		while (pos < total) {
+			fillPacket(packet, pos);
+			while (!recorder.append(packet.data(), packet.size())) {
+				++retries;
+				std::this_thread::yield();
+			}
+			pos += packet.size();
+		}
+		recorder.stop();
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+		std::printf("throughput: %.1f MiB/s (%llu MiB, backlog high water %zu KiB, full-buffer retries %llu)\n",
+			pos / seconds / (1 << 20), static_cast<unsigned long long>(pos >> 20),
+			recorder.backlogHighWater() >> 10, static_cast<unsigned long long>(retries));
+		CHECK(recorder.bytesWritten() == pos);
+		CHECK(recorder.droppedPackets() == retries);
+
+		StreamFormat f;
+		std::vector<uint8_t> data;
+		CHECK(readWavFile(path, f, data));
+		CHECK(data.size() == pos);
+		CHECK(matchesPattern(data, 0));
+		std::remove(path.c_str());
+	}
+
+#if !defined(_WIN32)
+	// 子进程以实时速率的 50 倍持续录音，父进程在写入途中 SIGKILL；文件头应记录最近一次检查点的长度
+	void testKillMidWrite() {
+		const std::string path = "WavRecorderTest_killed.wav";
+		std::remove(path.c_str());
+		const pid_t parent = getpid();
+		pid_t child = fork();
+		if (child == 0) {
+			std::vector<uint8_t> fmt = makeFmt();
+			WavRecorderConfig config;
+			config.checkpointMs = 50;
+			WavRecorder recorder;
+			if (!recorder.start(path, fmt.data(), fmt.size(), config)) _exit(2);
+			std::vector<uint8_t> packet(kPacketBytes);
+			for (uint64_t pos = 0;; pos += packet.size()) {
+				if (getppid() != parent) _exit(3);  // 测试进程异常退出时不留下一直写文件的子进程
+				fillPacket(packet, pos);
+				while (!recorder.append(packet.data(), packet.size())) std::this_thread::yield();
+				std::this_thread::sleep_for(std::chrono::microseconds(200));
+			}
+		}
+		CHECK(child > 0);
+		// 等到文件头记录了第一次检查点（负载高时子进程启动可能很慢，最多等 30 秒），再继续写一段后结束
+		const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+		while (std::chrono::steady_clock::now() < deadline) {
+			std::vector<uint8_t> head = readHead(path, 80);
+			if (head.size() == 80 && readU32(head, 76) > 0) break;
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(200));
+		kill(child, SIGKILL);
+		int status = 0;
+		waitpid(child, &status, 0);
+		CHECK(WIFSIGNALED(status));
+
+		std::vector<uint8_t> raw = readBytes(path);
+		CHECK(raw.size() > 80);
+		if (raw.size() <= 80) return;
+		uint32_t declared = readU32(raw, 76);  // data 块长度（fmt 16 字节时的文件头布局）
+		CHECK(declared > 0);
+		CHECK(declared % kBlockAlign == 0);
+		CHECK(readU32(raw, 4) == 72 + declared);
+		CHECK(raw.size() >= 80 + static_cast<size_t>(declared));
+
+		StreamFormat f;
+		std::vector<uint8_t> data;
+		CHECK(readWavFile(path, f, data));
+		CHECK(data.size() == declared);
+		CHECK(matchesPattern(data, 0));
+		std::printf("killed mid-write: %u bytes in header, %zu bytes on disk\n", declared, raw.size() - 80);
+		std::remove(path.c_str());
+	}
+#endif
+}
+
+int main() {
+	testHeader();
+	testRoundTrip();
+	testLossless();
+	testSegments();
+	testThroughput();
+#if !defined(_WIN32)
+	testKillMidWrite();
+#endif
+	return testResult("WavRecorderTest");
+}